@@ -16,6 +16,7 @@
 #define SPIRV_TOOLS_OPTIMIZER_HPP_
 
 #include <memory>
+#include <ostream>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -77,6 +78,17 @@ class Optimizer {
   // method.
   Optimizer& RegisterPass(PassToken&& pass);
 
+  // Makes the passes registered from now on, up to the next call to
+  // EndFixedPointGroup() or BeginFixedPointGroup(), a group that Run()
+  // repeats until it leaves the module unchanged, at most |max_iterations|
+  // times. Function-local passes of the group only process again the
+  // functions that changed since they last left them unchanged, so that
+  // repeating them costs little once most functions are optimized.
+  Optimizer& BeginFixedPointGroup(uint32_t max_iterations = 4);
+
+  // Ends the group of passes started by BeginFixedPointGroup(), if any.
+  Optimizer& EndFixedPointGroup();
+
   // Registers passes that attempt to improve performance of generated code.
   // This sequence of passes is subject to constant review and will change
   // from time to time.
@@ -95,9 +107,44 @@ class Optimizer {
   // executed and the contents in |optimized_binary| may be invalid.
   //
   // It's allowed to alias |original_binary| to the start of |optimized_binary|.
+  // Run() may be called several times, each running all the registered
+  // passes.
   bool Run(const uint32_t* original_binary, size_t original_binary_size,
            std::vector<uint32_t>* optimized_binary) const;
 
+  // Sets the stream to which Run() reports the wall time of building the
+  // module, of each pass, and of writing the result, or disables the report
+  // if |out| is null. When the executable counts its heap allocations, the
+  // report includes the number and size of the allocations of each phase.
+  Optimizer& SetTimeReport(std::ostream* out);
+
+  // Sets the number of threads on which function-local passes process the
+  // functions of the module. With 0 or 1, the default, every pass runs on
+  // the calling thread. The ids of the optimized module may then differ from
+  // those of a run on the calling thread, but not with the number of threads.
+  // The message consumer may be called from several threads at once.
+  Optimizer& SetNumThreads(uint32_t num_threads);
+
+  // Makes Run() look up its result in a cache of results stored in the
+  // directory |directory|, and store the result there after optimizing. The
+  // cache holds up to |max_size| bytes, removing the least recently used
+  // results first. A result is only reused for the same input binary, target
+  // environment, registered passes and parameters of the passes, use of
+  // several threads, and version of this library, so that Run() returns the
+  // binary it would have produced. Messages of the passes are not reported
+  // again when the result is found. An empty |directory| disables the cache.
+  Optimizer& SetResultCache(const std::string& directory, uint64_t max_size);
+
+  // Makes Run() also store in the result cache the result of each sequence
+  // of consecutive function-local passes on each function, and reuse it for
+  // the functions that are identical to one optimized before, along with the
+  // types, constants, global variables and decorations they refer to. The
+  // passes then only run on the functions that changed, which suits small
+  // edits of large modules. The ids of the result may differ from those of a
+  // run that is not incremental, but not between incremental runs. Does
+  // nothing without a result cache, or for modules with decoration groups.
+  Optimizer& SetIncremental(bool incremental);
+
   // Returns a vector of strings with all the pass names added to this
   // optimizer's pass manager. These strings are valid until the associated
   // pass manager is destroyed.
@@ -406,6 +453,178 @@ Optimizer::PassToken CreateCFGCleanupPass();
 // that are not referenced.
 Optimizer::PassToken CreateDeadVariableEliminationPass();
 
+// Creates a sparse conditional constant propagation pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass propagates constants through integer and boolean
+// arithmetic, comparisons, OpSelect, OpPhi, OpCopyObject, and composite
+// construction, extraction, insertion and shuffles, while following only the
+// control flow edges that can be taken given the constants found so far.
+// Results found to be constant are replaced by constants, conditional
+// branches and switches on constants are replaced by branches to the taken
+// target, and blocks that are no longer reachable are removed.
+//
+// The function must be in SSA form, for example after the local load/store
+// elimination passes. Specialization constants are not constants for this
+// pass; freeze them first to fold on their default values. Floating point
+// arithmetic is not folded.
+Optimizer::PassToken CreateSCCPPass();
+
+// Creates a value numbering pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass walks the dominator tree and gives the same value
+// number to instructions computing the same value: those with the same
+// opcode, result type and operand value numbers, up to the order of the
+// operands of commutative integer and logical operations. An instruction
+// equal to one in a dominating position is replaced by it.
+//
+// Only instructions without side effects and that do not access memory are
+// numbered: arithmetic, bit, relational and logical operations, conversions,
+// composite instructions, access chains, and phis within the same block.
+// Instructions with different decorations are not considered equal.
+Optimizer::PassToken CreateValueNumberingPass();
+
+// Creates a loop-invariant code motion pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass moves the instructions of each loop whose operands
+// are all defined outside the loop to the end of the loop's preheader, the
+// block that branches unconditionally to the loop header and is its only
+// predecessor outside the loop. Loops without a preheader are left alone.
+// Innermost loops are processed first, so an instruction can be moved out of
+// several nested loops.
+//
+// Only instructions without side effects and that do not access memory are
+// moved (see CreateValueNumberingPass). Integer divisions and remainders are
+// only moved out of the loop header, as elsewhere in the loop they might
+// only execute for a divisor found to be safe.
+Optimizer::PassToken CreateLICMPass();
+
+// Creates a loop unrolling pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass unrolls the structured loops entered from a preheader
+// (see CreateLICMPass), whose continue target is the only block branching
+// back to the header and whose only exit is a conditional branch to the merge
+// block at the end of the header or of the block following it.
+//
+// A loop is fully unrolled if the exit test compares an induction variable
+// with a constant, where the induction variable is a header phi starting at
+// a 32-bit integer constant and incremented or decremented by a constant, and
+// the copies of the loop have at most |size_budget| instructions in total.
+// Its OpLoopMerge is removed and the copies follow each other, so values
+// depending on the induction variable become constants that later passes
+// can fold. Otherwise an innermost loop is partially unrolled: up to four
+// copies of its body, each keeping the exit test, are made within the budget
+// and the last copy of the continue target becomes the continue target.
+//
+// Inner loops are processed first, and a loop is considered again once its
+// inner loops are fully unrolled. Loops defining decorated ids are left
+// alone; the names of the ids of fully unrolled loops are removed.
+Optimizer::PassToken CreateLoopUnrollPass(uint32_t size_budget = 256);
+
+// Creates a scalar replacement of aggregates pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass replaces each function scope variable of struct,
+// array, vector or matrix type by one variable per element, when the
+// variable is only loaded, stored, and used as the base of access chains
+// whose first index is a constant, at least one of them. Access chains then
+// start from the element variables, and loads and stores of the whole
+// variable load or store each element. The element variables are split in
+// turn, so that only variables of scalar type or with non-constant accesses
+// remain, which the local store elimination passes can then replace by SSA
+// values.
+//
+// Arrays with more than 64 elements, decorated variables and variables
+// whose initializer is not a constant composite are not split.
+Optimizer::PassToken CreateScalarReplacementPass();
+
+// Creates a selective inline pass.
+// A selective inline pass builds the call graph of the entry point call
+// trees and inlines function calls bottom-up, so that the size of a callee
+// includes the code already inlined into it. A call is inlined if:
+//  - the called function has an opaque type in its parameter types or
+//    return type (see CreateInlineOpaquePass), or
+//  - inlining it does not grow the module: the callee is smaller than the
+//    call, or the call is the only call site of a function that is not an
+//    entry point, which becomes dead (see CreateEliminateDeadFunctionsPass).
+//    Each constant argument is assumed to fold away a few instructions of
+//    the inlined code, or
+//  - the growth fits in the remaining budget, which starts at
+//    |growth_percent| percent of the number of instructions of the entry
+//    point call trees.
+// The intent is to get most of the benefit of exhaustive inlining without
+// duplicating large functions called from many places. Functions that are
+// not in the call tree of an entry point are not changed.
+Optimizer::PassToken CreateInlineSelectivePass(uint32_t growth_percent = 25);
+
+// Creates a merge identical functions pass.
+// This pass finds functions with the same body up to the renaming of the ids
+// they define, such as copies of a helper coming from several modules
+// linked together, and makes the calls to all of them call the first one.
+// Debug line instructions are ignored. Entry points and functions with
+// decorated ids are not merged. The other copies are left in the module,
+// without calls, for dead function elimination to remove (see
+// CreateEliminateDeadFunctionsPass).
+Optimizer::PassToken CreateMergeIdenticalFunctionsPass();
+
+// Creates a dead store elimination pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass removes the stores to function and private variables
+// that are overwritten on every path before being read, or never read. The
+// variables must only be loaded, stored, and accessed through access chains
+// with constant indices, so that each store writes a known part of the
+// variable: a store is removed if the parts it writes are not read before
+// stores covering them on every path. The liveness of the parts is computed
+// backward over the control flow graph, visiting the blocks in the order of
+// the post-dominator tree.
+//
+// Function variables are dead after a return. Private variables are assumed
+// to be read by function calls and after a return, unless the function is
+// an entry point. Volatile stores are kept. The access chains and function
+// variables left without uses are removed.
+Optimizer::PassToken CreateDeadStoreElimPass();
+
+// Creates an if-conversion pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass replaces the structured selections whose arms are at
+// most one block, without side effects, by OpSelect instructions choosing
+// between the values computed by the arms. The instructions of the arms are
+// moved before the selection, which must have at most |size_limit| of them,
+// and the phis of the merge block become OpSelects, using a vector of the
+// condition for vector values. Only the values of boolean, integer, float
+// and vector types are selected. The merge block is then merged into the
+// header of the selection, unless it is the merge block or continue target
+// of another construct, so that the enclosing selections can be converted
+// in turn.
+//
+// This removes branches which diverge on SIMT hardware, at the cost of
+// executing both arms.
+Optimizer::PassToken CreateIfConversionPass(uint32_t size_limit = 8);
+
+// Creates a copy propagation pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass replaces the uses of OpCopyObject instructions by the
+// copied value, and the uses of redundant phis by the only value they take.
+// A phi is redundant when its values, ignoring itself, are all the same, or
+// more generally when it and the phis it takes values from, such as the
+// phis of a loop which does not change a value, only take one value from
+// other instructions. The phis using a replaced instruction are checked
+// again, so that a single sweep removes chains of copies and phis. The
+// names and decorations of the replaced instructions are removed.
+Optimizer::PassToken CreateCopyPropagationPass();
+
+// Creates an instruction combining pass.
+// For each function in the call trees rooted at entry points and exported
+// functions, this pass replaces the arithmetic, logical, comparison and
+// conversion instructions whose operands are constants, not specialization
+// constants, by the constant they evaluate to. Only 32-bit integers, 32-bit
+// floats and booleans, and vectors of them, are folded. It also replaces
+// instructions by an equal value given by an algebraic identity, such as
+// x + 0, x * 1, x & x, -(-x), an OpSelect with a constant condition or equal
+// operands, and the extraction of an element of an OpCompositeConstruct or
+// OpCompositeInsert. Floating point identities are only applied when they
+// hold for all values, including negative zero and NaN. The users of the
+// replaced instructions are combined again until nothing changes.
+Optimizer::PassToken CreateInstCombinePass();
+
 }  // namespace spvtools
 
 #endif  // SPIRV_TOOLS_OPTIMIZER_HPP_
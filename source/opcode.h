@@ -87,4 +87,14 @@ bool spvOpcodeReturnsLogicalVariablePointer(const SpvOp opcode);
 // non-zero otherwise.
 int32_t spvOpcodeGeneratesType(SpvOp opcode);
 
+// Returns true if an instruction with the given opcode computes its result
+// from its operands alone: it does not access memory, does not depend on
+// control flow or on other invocations, and has no other side effect.
+bool spvOpcodeIsPure(const SpvOp opcode);
+
+// Returns true if the behavior of an instruction with the given opcode is
+// undefined for some operand values, so that it must not be executed where
+// it was not before.
+bool spvOpcodeMayBeUndefined(const SpvOp opcode);
+
 #endif  // LIBSPIRV_OPCODE_H_
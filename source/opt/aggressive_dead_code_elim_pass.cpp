@@ -36,6 +36,8 @@ const uint32_t kLoopMergeMergeBlockIdInIdx = 0;
 
 }  // namespace anonymous
 
+const uint32_t AggressiveDCEPass::kNoInst;
+
 bool AggressiveDCEPass::IsVarOfStorage(uint32_t varId, 
       uint32_t storageClass) {
   const ir::Instruction* varInst = get_def_use_mgr()->GetDef(varId);
@@ -107,8 +109,8 @@ bool AggressiveDCEPass::AllExtensionsSupported() const {
 
 bool AggressiveDCEPass::KillInstIfTargetDead(ir::Instruction* inst) {
   const uint32_t tId = inst->GetSingleWordInOperand(0);
-  const ir::Instruction* tInst = get_def_use_mgr()->GetDef(tId);
-  if (dead_insts_.find(tInst) != dead_insts_.end()) {
+  const uint32_t tIndex = tId < id2inst_.size() ? id2inst_[tId] : kNoInst;
+  if (tIndex < dead_insts_.size() && dead_insts_[tIndex]) {
     get_def_use_mgr()->KillInst(inst);
     return true;
   }
@@ -120,12 +122,15 @@ void AggressiveDCEPass::ProcessLoad(uint32_t varId) {
   if (!IsLocalVar(varId))
     return;
   // Return if already processed
-  if (live_local_vars_.find(varId) != live_local_vars_.end()) 
+  if (varId >= live_local_vars_.size())
+    live_local_vars_.resize(varId + 1, false);
+  if (live_local_vars_[varId])
     return;
   // Mark all stores to varId as live
   AddStores(varId);
   // Cache varId as processed
-  live_local_vars_.insert(varId);
+  live_local_vars_[varId] = true;
+  live_local_var_ids_.push_back(varId);
 }
 
 bool AggressiveDCEPass::IsStructuredIfHeader(ir::BasicBlock* bp,
@@ -149,41 +154,103 @@ bool AggressiveDCEPass::IsStructuredIfHeader(ir::BasicBlock* bp,
   return true;
 }
 
-void AggressiveDCEPass::ComputeBlock2HeaderMaps(
-      std::list<ir::BasicBlock*>& structuredOrder) {
-  block2headerMerge_.clear();
-  block2headerBranch_.clear();
-  std::stack<ir::Instruction*> currentMergeInst;
-  std::stack<ir::Instruction*> currentBranchInst;
+void AggressiveDCEPass::ComputeBlock2HeaderMaps() {
+  block2headerMerge_.assign(blocks_.size(), kNoInst);
+  block2headerBranch_.assign(blocks_.size(), kNoInst);
+  std::stack<uint32_t> currentMergeInst;
+  std::stack<uint32_t> currentBranchInst;
   std::stack<uint32_t> currentMergeBlockId;
-  currentMergeInst.push(nullptr);
-  currentBranchInst.push(nullptr);
+  currentMergeInst.push(kNoInst);
+  currentBranchInst.push(kNoInst);
   currentMergeBlockId.push(0);
-  for (auto bi = structuredOrder.begin(); bi != structuredOrder.end(); ++bi) {
-    if ((*bi)->id() == currentMergeBlockId.top()) {
+  for (uint32_t b = 0; b < blocks_.size(); ++b) {
+    if (blocks_[b]->id() == currentMergeBlockId.top()) {
       currentMergeBlockId.pop();
       currentMergeInst.pop();
       currentBranchInst.pop();
     }
-    block2headerMerge_[*bi] = currentMergeInst.top();
-    block2headerBranch_[*bi] = currentBranchInst.top();
-    ir::Instruction* mergeInst;
-    ir::Instruction* branchInst;
+    block2headerMerge_[b] = currentMergeInst.top();
+    block2headerBranch_[b] = currentBranchInst.top();
     uint32_t mergeBlockId;
-    if (IsStructuredIfHeader(*bi, &mergeInst, &branchInst, &mergeBlockId)) {
+    if (IsStructuredIfHeader(blocks_[b], nullptr, nullptr, &mergeBlockId)) {
+      // The merge and the branch are the last two instructions of the block.
       currentMergeBlockId.push(mergeBlockId);
-      currentMergeInst.push(mergeInst);
-      currentBranchInst.push(branchInst);
+      currentMergeInst.push(block_starts_[b + 1] - 2);
+      currentBranchInst.push(block_starts_[b + 1] - 1);
     }
   }
 }
 
-void AggressiveDCEPass::ComputeInst2BlockMap(ir::Function* func) {
-  for (auto& blk : *func) {
-    blk.ForEachInst([&blk,this](ir::Instruction* ip) {
-      inst2block_[ip] = &blk;
+void AggressiveDCEPass::NumberInstructions(
+    const std::list<ir::BasicBlock*>& structuredOrder) {
+  blocks_.assign(structuredOrder.begin(), structuredOrder.end());
+  block_starts_.clear();
+  insts_.clear();
+  inst2block_.clear();
+  no_result_insts_.clear();
+  // Only reset the entries set for the previous function, so that numbering
+  // a function takes time in its size rather than in the id bound.
+  for (auto id : numbered_ids_) id2inst_[id] = kNoInst;
+  numbered_ids_.clear();
+  for (auto id : live_local_var_ids_) live_local_vars_[id] = false;
+  live_local_var_ids_.clear();
+  for (uint32_t b = 0; b < blocks_.size(); ++b) {
+    block_starts_.push_back(static_cast<uint32_t>(insts_.size()));
+    blocks_[b]->ForEachInst([b, this](ir::Instruction* ip) {
+      const uint32_t index = static_cast<uint32_t>(insts_.size());
+      insts_.push_back(ip);
+      inst2block_.push_back(b);
+      const uint32_t id = ip->result_id();
+      if (id != 0) {
+        if (id >= id2inst_.size()) id2inst_.resize(id + 1, kNoInst);
+        id2inst_[id] = index;
+        numbered_ids_.push_back(id);
+      } else {
+        no_result_insts_.push_back({ip, index});
+      }
     });
   }
+  block_starts_.push_back(static_cast<uint32_t>(insts_.size()));
+  std::sort(no_result_insts_.begin(), no_result_insts_.end());
+  live_insts_.assign(insts_.size(), false);
+  dead_insts_.assign(insts_.size(), false);
+}
+
+uint32_t AggressiveDCEPass::AppendInst(ir::Instruction* inst) {
+  const uint32_t index = static_cast<uint32_t>(insts_.size());
+  insts_.push_back(inst);
+  live_insts_.push_back(false);
+  return index;
+}
+
+uint32_t AggressiveDCEPass::InstIndex(ir::Instruction* inst) {
+  const uint32_t id = inst->result_id();
+  if (id != 0) {
+    if (id >= id2inst_.size()) id2inst_.resize(id + 1, kNoInst);
+    if (id2inst_[id] == kNoInst) {
+      id2inst_[id] = AppendInst(inst);
+      numbered_ids_.push_back(id);
+    }
+    return id2inst_[id];
+  }
+  const auto it = std::lower_bound(
+      no_result_insts_.begin(), no_result_insts_.end(),
+      std::make_pair(static_cast<const ir::Instruction*>(inst), 0u));
+  if (it != no_result_insts_.end() && it->first == inst) return it->second;
+  // An instruction outside the blocks without a result id, such as a name or
+  // a decoration. These are reached at most once per variable, so they are
+  // not worth a lookup table.
+  return AppendInst(inst);
+}
+
+void AggressiveDCEPass::AddIdToWorklist(uint32_t id) {
+  const uint32_t index = id < id2inst_.size() ? id2inst_[id] : kNoInst;
+  if (index == kNoInst) {
+    AddToWorklist(get_def_use_mgr()->GetDef(id));
+  } else if (!live_insts_[index]) {
+    worklist_.push(index);
+    live_insts_[index] = true;
+  }
 }
 
 void AggressiveDCEPass::AddBranch(uint32_t labelId, ir::BasicBlock* bp) {
@@ -195,12 +262,12 @@ void AggressiveDCEPass::AddBranch(uint32_t labelId, ir::BasicBlock* bp) {
 }
 
 bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
-  // Compute map from instruction to block
-  ComputeInst2BlockMap(func);
-  // Compute map from block to controlling conditional branch
+  // Number the instructions and compute the map from instruction to block
   std::list<ir::BasicBlock*> structuredOrder;
   cfg()->ComputeStructuredOrder(func, &*func->begin(), &structuredOrder);
-  ComputeBlock2HeaderMaps(structuredOrder);
+  NumberInstructions(structuredOrder);
+  // Compute map from block to controlling conditional branch
+  ComputeBlock2HeaderMaps();
   bool modified = false;
   // Add instructions with external side effects to worklist. Also add branches
   // EXCEPT those immediately contained in an "if" selection construct.
@@ -215,29 +282,31 @@ bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
   // Push sentinel values on stack for when outside of any control flow.
   assume_branches_live.push(true);
   currentMergeBlockId.push(0);
-  for (auto bi = structuredOrder.begin(); bi != structuredOrder.end(); ++bi) {
-    if ((*bi)->id() == currentMergeBlockId.top()) {
+  for (uint32_t b = 0; b < blocks_.size(); ++b) {
+    if (blocks_[b]->id() == currentMergeBlockId.top()) {
       assume_branches_live.pop();
       currentMergeBlockId.pop();
     }
-    for (auto ii = (*bi)->begin(); ii != (*bi)->end(); ++ii) {
+    // Skip the label.
+    for (uint32_t i = block_starts_[b] + 1; i < block_starts_[b + 1]; ++i) {
+      ir::Instruction* ii = insts_[i];
       SpvOp op = ii->opcode();
       switch (op) {
         case SpvOpStore: {
           uint32_t varId;
-          (void) GetPtr(&*ii, &varId);
+          (void) GetPtr(ii, &varId);
           // Mark stores as live if their variable is not function scope
           // and is not private scope. Remember private stores for possible
           // later inclusion
           if (IsVarOfStorage(varId, SpvStorageClassPrivate))
-            private_stores_.push_back(&*ii);
+            private_stores_.push_back(ii);
           else if (!IsVarOfStorage(varId, SpvStorageClassFunction))
-            AddToWorklist(&*ii);
+            AddToWorklist(ii);
         } break;
         case SpvOpExtInst: {
           // eg. GLSL frexp, modf
-          if (!IsCombinatorExt(&*ii))
-            AddToWorklist(&*ii);
+          if (!IsCombinatorExt(ii))
+            AddToWorklist(ii);
         } break;
         case SpvOpLoopMerge: {
           // Assume loops live (for now)
@@ -245,28 +314,28 @@ bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
           assume_branches_live.push(true);
           currentMergeBlockId.push(
               ii->GetSingleWordInOperand(kLoopMergeMergeBlockIdInIdx));
-          AddToWorklist(&*ii);
+          AddToWorklist(ii);
         } break;
         case SpvOpSelectionMerge: {
-          auto brii = ii;
-          ++brii;
-          bool is_structured_if = brii->opcode() == SpvOpBranchConditional;
+          // The branch follows the merge in the same block.
+          bool is_structured_if =
+              insts_[i + 1]->opcode() == SpvOpBranchConditional;
           assume_branches_live.push(!is_structured_if);
           currentMergeBlockId.push(
               ii->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx));
           if (!is_structured_if)
-            AddToWorklist(&*ii);
+            AddToWorklist(ii);
         } break;
         case SpvOpBranch:
         case SpvOpBranchConditional: {
           if (assume_branches_live.top())
-            AddToWorklist(&*ii);
+            AddToWorklist(ii);
         } break;
         default: {
           // Function calls, atomics, function params, function returns, etc.
           // TODO(greg-lunarg): function calls live only if write to non-local
           if (!IsCombinator(op))
-            AddToWorklist(&*ii);
+            AddToWorklist(ii);
           // Remember function calls
           if (op == SpvOpFunctionCall)
             call_in_func_ = true;
@@ -298,21 +367,25 @@ bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
   }
   // Perform closure on live instruction set. 
   while (!worklist_.empty()) {
-    ir::Instruction* liveInst = worklist_.front();
+    const uint32_t liveIndex = worklist_.front();
+    ir::Instruction* liveInst = insts_[liveIndex];
     // Add all operand instructions if not already live
     liveInst->ForEachInId([this](const uint32_t* iid) {
-      ir::Instruction* inInst = get_def_use_mgr()->GetDef(*iid);
-      if (!IsLive(inInst))
-        AddToWorklist(inInst);
+      AddIdToWorklist(*iid);
     });
     // If in a structured if construct, add the controlling conditional branch
     // and its merge. Any containing if construct is marked live when the
     // the merge and branch are processed out of the worklist.
-    ir::BasicBlock* blk = inst2block_[liveInst];
-    ir::Instruction* branchInst = block2headerBranch_[blk];
-    if (branchInst != nullptr && !IsLive(branchInst)) {
-      AddToWorklist(branchInst);
-      AddToWorklist(block2headerMerge_[blk]);
+    if (liveIndex < inst2block_.size()) {
+      const uint32_t blk = inst2block_[liveIndex];
+      const uint32_t branchIndex = block2headerBranch_[blk];
+      if (branchIndex != kNoInst && !live_insts_[branchIndex]) {
+        const uint32_t mergeIndex = block2headerMerge_[blk];
+        worklist_.push(branchIndex);
+        live_insts_[branchIndex] = true;
+        worklist_.push(mergeIndex);
+        live_insts_[mergeIndex] = true;
+      }
     }
     // If local load, add all variable's stores if variable not already live
     if (liveInst->opcode() == SpvOpLoad) {
@@ -337,15 +410,17 @@ bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
     worklist_.pop();
   }
   // Mark all non-live instructions dead, except branches which are not
-  // at the end of an if-header, which indicate a dead if.
-  for (auto bi = structuredOrder.begin(); bi != structuredOrder.end(); ++bi) {
-    for (auto ii = (*bi)->begin(); ii != (*bi)->end(); ++ii) {
-      if (IsLive(&*ii))
+  // at the end of an if-header, which indicate a dead if. Instructions
+  // killed before are already OpNops, and killing them again would not
+  // change the function.
+  for (uint32_t b = 0; b < blocks_.size(); ++b) {
+    for (uint32_t i = block_starts_[b] + 1; i < block_starts_[b + 1]; ++i) {
+      if (live_insts_[i] || insts_[i]->opcode() == SpvOpNop)
         continue;
-      if (IsBranch(ii->opcode()) &&
-          !IsStructuredIfHeader(*bi, nullptr, nullptr, nullptr))
+      if (IsBranch(insts_[i]->opcode()) &&
+          !IsStructuredIfHeader(blocks_[b], nullptr, nullptr, nullptr))
         continue;
-      dead_insts_.insert(&*ii);
+      dead_insts_[i] = true;
     }
   }
   // Remove debug and annotation statements referencing dead instructions.
@@ -364,29 +439,30 @@ bool AggressiveDCEPass::AggressiveDCE(ir::Function* func) {
       modified = true;
   }
   // Kill dead instructions and remember dead blocks
-  for (auto bi = structuredOrder.begin(); bi != structuredOrder.end();) {
+  for (uint32_t b = 0; b < blocks_.size();) {
     uint32_t mergeBlockId = 0;
-    for (auto ii = (*bi)->begin(); ii != (*bi)->end(); ++ii) {
-      if (dead_insts_.find(&*ii) == dead_insts_.end())
+    for (uint32_t i = block_starts_[b] + 1; i < block_starts_[b + 1]; ++i) {
+      if (!dead_insts_[i])
         continue;
       // If dead instruction is selection merge, remember merge block
       // for new branch at end of block
+      ir::Instruction* ii = insts_[i];
       if (ii->opcode() == SpvOpSelectionMerge)
         mergeBlockId = 
             ii->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
-      get_def_use_mgr()->KillInst(&*ii);
+      get_def_use_mgr()->KillInst(ii);
       modified = true;
     }
     // If a structured if was deleted, add a branch to its merge block,
     // and traverse to the merge block, continuing processing there.
     // The block still exists as the OpLabel at least is still intact.
     if (mergeBlockId != 0) {
-      AddBranch(mergeBlockId, *bi);
-      for (++bi; (*bi)->id() != mergeBlockId; ++bi) {
+      AddBranch(mergeBlockId, blocks_[b]);
+      for (++b; blocks_[b]->id() != mergeBlockId; ++b) {
       }
     }
     else {
-      ++bi;
+      ++b;
     }
   }
   // Cleanup all CFG including all unreachable blocks
@@ -400,10 +476,11 @@ void AggressiveDCEPass::Initialize(ir::IRContext* c) {
   InitializeCFGCleanup(c);
 
   // Clear collections
-  worklist_ = std::queue<ir::Instruction*>{};
-  live_insts_.clear();
-  live_local_vars_.clear();
-  dead_insts_.clear();
+  worklist_ = std::queue<uint32_t>{};
+  id2inst_.assign(get_module()->IdBound(), kNoInst);
+  numbered_ids_.clear();
+  live_local_vars_.assign(get_module()->IdBound(), false);
+  live_local_var_ids_.clear();
   combinator_ops_shader_.clear();
   combinator_ops_glsl_std_450_.clear();
 
@@ -18,11 +18,10 @@
 #define LIBSPIRV_OPT_AGGRESSIVE_DCE_PASS_H_
 
 #include <algorithm>
-#include <map>
 #include <queue>
-#include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "basic_block.h"
 #include "def_use_manager.h"
@@ -44,8 +43,14 @@ class AggressiveDCEPass : public MemPass {
   AggressiveDCEPass();
   const char* name() const override { return "eliminate-dead-code-aggressive"; }
   Status Process(ir::IRContext* c) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new AggressiveDCEPass());
+  }
 
  private:
+  // Number of an instruction that is not numbered.
+  static const uint32_t kNoInst = ~0u;
+
   // Return true if |varId| is variable of |storageClass|.
   bool IsVarOfStorage(uint32_t varId, uint32_t storageClass);
 
@@ -60,16 +65,26 @@ class AggressiveDCEPass : public MemPass {
   }
 
   // Return true if |inst| is marked live
-  bool IsLive(ir::Instruction* inst) {
-    return live_insts_.find(inst) != live_insts_.end();
-  }
+  bool IsLive(ir::Instruction* inst) { return live_insts_[InstIndex(inst)]; }
 
-  // Add |inst| to worklist_ and live_insts_.
+  // Add |inst| to worklist_ and mark it live.
   void AddToWorklist(ir::Instruction* inst) {
-    worklist_.push(inst);
-    live_insts_.insert(inst);
+    const uint32_t index = InstIndex(inst);
+    worklist_.push(index);
+    live_insts_[index] = true;
   }
 
+  // Add the instruction defining |id| to worklist_ if it is not live.
+  void AddIdToWorklist(uint32_t id);
+
+  // Return the number of |inst|. Instructions outside the blocks numbered by
+  // NumberInstructions, such as types, constants and names, are numbered
+  // when first seen.
+  uint32_t InstIndex(ir::Instruction* inst);
+
+  // Append |inst| to insts_ and return its number.
+  uint32_t AppendInst(ir::Instruction* inst);
+
   // Add all store instruction which use |ptrId|, directly or indirectly,
   // to the live instruction worklist.
   void AddStores(uint32_t ptrId);
@@ -106,12 +121,13 @@ class AggressiveDCEPass : public MemPass {
     ir::Instruction** mergeInst, ir::Instruction** branchInst,
     uint32_t* mergeBlockId);
 
-  // Initialize block2branch_ and block2merge_ using |structuredOrder| to
-  // order blocks.
-  void ComputeBlock2HeaderMaps(std::list<ir::BasicBlock*>& structuredOrder);
+  // Initialize block2headerBranch_ and block2headerMerge_ for blocks_.
+  void ComputeBlock2HeaderMaps();
 
-  // Initialize inst2block_ for |func|.
-  void ComputeInst2BlockMap(ir::Function* func);
+  // Number the blocks in |structuredOrder| and, block by block, their
+  // instructions including labels. Initialize the tables indexed by
+  // instruction number and by id for the current function.
+  void NumberInstructions(const std::list<ir::BasicBlock*>& structuredOrder);
 
   // Add branch to |labelId| to end of block |bp|.
   void AddBranch(uint32_t labelId, ir::BasicBlock* bp);
@@ -139,43 +155,64 @@ class AggressiveDCEPass : public MemPass {
   // True if current function is entry point and has no function calls.
   bool private_like_local_;
 
-  // Live Instruction Worklist.  An instruction is added to this list
-  // if it might have a side effect, either directly or indirectly.
-  // If we don't know, then add it to this list.  Instructions are
-  // removed from this list as the algorithm traces side effects,
+  // Live Instruction Worklist, holding instruction numbers.  An instruction
+  // is added to this list if it might have a side effect, either directly or
+  // indirectly. If we don't know, then add it to this list.  Instructions
+  // are removed from this list as the algorithm traces side effects,
   // building up the live instructions set |live_insts_|.
-  std::queue<ir::Instruction*> worklist_;
+  std::queue<uint32_t> worklist_;
 
-  // Map from block to the branch instruction in the header of the most
-  // immediate controlling structured if.
-  std::unordered_map<ir::BasicBlock*, ir::Instruction*> block2headerBranch_;
+  // The tables below are rebuilt for each function, except for those indexed
+  // by id, which are sized once per run and of which only the entries set for
+  // the previous function are reset. Instructions are numbered densely so
+  // that liveness is a bit vector: the blocks of the function come first, in
+  // structured order, and other instructions follow as they are marked
+  // live.
 
-  // Map from block to the merge instruction in the header of the most
-  // immediate controlling structured if.
-  std::unordered_map<ir::BasicBlock*, ir::Instruction*> block2headerMerge_;
+  // Blocks of the current function in structured order.
+  std::vector<ir::BasicBlock*> blocks_;
 
-  // Map from instruction containing block
-  std::unordered_map<ir::Instruction*, ir::BasicBlock*> inst2block_;
+  // Number of the label of each block in blocks_, followed by the number of
+  // instructions in those blocks.
+  std::vector<uint32_t> block_starts_;
 
-  // Map from block's label id to block.
-  std::unordered_map<uint32_t, ir::BasicBlock*> id2block_;
+  // Instructions by number.
+  std::vector<ir::Instruction*> insts_;
 
-  // Map from block to its structured successor blocks. See 
-  // ComputeStructuredSuccessors() for definition.
-  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
-      block2structured_succs_;
+  // Number of the instruction defining each id, or kNoInst if not numbered.
+  std::vector<uint32_t> id2inst_;
+
+  // Ids whose entry in id2inst_ is set for the current function.
+  std::vector<uint32_t> numbered_ids_;
+
+  // Numbered block instructions without a result id, sorted by address.
+  std::vector<std::pair<const ir::Instruction*, uint32_t>> no_result_insts_;
+
+  // Index in blocks_ of the block holding each numbered block instruction.
+  std::vector<uint32_t> inst2block_;
+
+  // For each block in blocks_, the number of the branch instruction in the
+  // header of the most immediate controlling structured if, or kNoInst.
+  std::vector<uint32_t> block2headerBranch_;
+
+  // For each block in blocks_, the number of the merge instruction in the
+  // header of the most immediate controlling structured if, or kNoInst.
+  std::vector<uint32_t> block2headerMerge_;
 
   // Store instructions to variables of private storage
   std::vector<ir::Instruction*> private_stores_;
 
-  // Live Instructions
-  std::unordered_set<const ir::Instruction*> live_insts_;
+  // Live Instructions, by number.
+  std::vector<bool> live_insts_;
+
+  // Live Local Variables, by id.
+  std::vector<bool> live_local_vars_;
 
-  // Live Local Variables
-  std::unordered_set<uint32_t> live_local_vars_;
+  // Ids of the local variables set in live_local_vars_.
+  std::vector<uint32_t> live_local_var_ids_;
 
-  // Dead instructions. Use for debug cleanup.
-  std::unordered_set<const ir::Instruction*> dead_insts_;
+  // Dead block instructions, by number. Use for debug cleanup.
+  std::vector<bool> dead_insts_;
 
   // Opcodes of shader capability core executable instructions
   // without side-effect. This is a whitelist of operators
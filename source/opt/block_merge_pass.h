@@ -39,6 +39,9 @@ class BlockMergePass : public Pass {
   BlockMergePass();
   const char* name() const override { return "merge-blocks"; }
   Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new BlockMergePass());
+  }
 
  private:
   // Return true if |labId| has multiple refs. Do not count OpName.
@@ -36,6 +36,8 @@ CFG::CFG(ir::Module* module)
     for (auto& blk : fn) {
       uint32_t blkId = blk.id();
       id2block_[blkId] = &blk;
+      // Blocks without predecessors still get an (empty) entry.
+      label2preds_[blkId];
       blk.ForEachSuccessorLabel([&blkId, this](uint32_t sbid) {
         label2preds_[sbid].push_back(blkId);
       });
@@ -40,9 +40,8 @@ class CFG {
   // |blk_id|.
   ir::BasicBlock* block(uint32_t blk_id) const { return id2block_.at(blk_id); }
 
-  // Return the pseudo entry and exit blocks. TODO(dnovillo): Remove when
-  // LocalSingleStoreElimPass::CalculateImmediateDominators() is moved into this
-  // class.
+  // Return the pseudo entry and exit blocks. Dominance queries should use
+  // IRContext::GetDominatorAnalysis() instead.
   const ir::BasicBlock* pseudo_entry_block() const {
     return &pseudo_entry_block_;
   }
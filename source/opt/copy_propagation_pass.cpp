@@ -0,0 +1,124 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "copy_propagation_pass.h"
+
+#include <queue>
+#include <unordered_set>
+#include <vector>
+
+#include "ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kCopyObjectOperandInIdx = 0;
+
+}  // anonymous namespace
+
+uint32_t CopyPropagationPass::GetPhiValue(const ir::Instruction* phi) const {
+  // The phis reached through the values of |phi| only take values from each
+  // other and from |value|, so they all are equal to |value|.
+  uint32_t value = 0;
+  std::unordered_set<uint32_t> visited = {phi->result_id()};
+  std::vector<const ir::Instruction*> stack = {phi};
+  while (!stack.empty()) {
+    const ir::Instruction* p = stack.back();
+    stack.pop_back();
+    for (uint32_t i = 0; i < p->NumInOperands(); i += 2) {
+      const uint32_t id = p->GetSingleWordInOperand(i);
+      if (visited.count(id) != 0) continue;
+      const ir::Instruction* def = get_def_use_mgr()->GetDef(id);
+      if (def != nullptr && def->opcode() == SpvOpPhi) {
+        visited.insert(id);
+        stack.push_back(def);
+        continue;
+      }
+      if (value != 0 && value != id) return 0;
+      value = id;
+    }
+  }
+  return value;
+}
+
+uint32_t CopyPropagationPass::GetCopiedValue(
+    const ir::Instruction* inst) const {
+  switch (inst->opcode()) {
+    case SpvOpCopyObject:
+      return inst->GetSingleWordInOperand(kCopyObjectOperandInIdx);
+    case SpvOpPhi:
+      return GetPhiValue(inst);
+    default:
+      return 0;
+  }
+}
+
+bool CopyPropagationPass::PropagateCopies(ir::Function* func) {
+  std::queue<ir::Instruction*> worklist;
+  for (auto& blk : *func)
+    for (auto& inst : blk)
+      if (inst.opcode() == SpvOpCopyObject || inst.opcode() == SpvOpPhi)
+        worklist.push(&inst);
+  bool modified = false;
+  while (!worklist.empty()) {
+    ir::Instruction* inst = worklist.front();
+    worklist.pop();
+    // Already replaced.
+    if (inst->opcode() == SpvOpNop) continue;
+    const uint32_t value = GetCopiedValue(inst);
+    if (value == 0) continue;
+    // The phis using |inst| may become redundant once they use |value|.
+    const uint32_t id = inst->result_id();
+    const analysis::UseList* uses = get_def_use_mgr()->GetUses(id);
+    if (uses != nullptr)
+      for (const auto& u : *uses)
+        if (u.inst->opcode() == SpvOpPhi && u.inst != inst)
+          worklist.push(u.inst);
+    KillNamesAndDecorates(inst);
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(id, value);
+    get_def_use_mgr()->KillInst(inst);
+    modified = true;
+  }
+  return modified;
+}
+
+void CopyPropagationPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+}
+
+Pass::Status CopyPropagationPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return PropagateCopies(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+CopyPropagationPass::CopyPropagationPass() {}
+
+Pass::Status CopyPropagationPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,56 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_COPY_PROPAGATION_PASS_H_
+#define LIBSPIRV_OPT_COPY_PROPAGATION_PASS_H_
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class CopyPropagationPass : public MemPass {
+ public:
+  CopyPropagationPass();
+  const char* name() const override { return "copy-propagation"; }
+  Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new CopyPropagationPass());
+  }
+
+ private:
+  // Returns the id of the only value flowing into the phi |phi|, through the
+  // phis it takes values from, or 0 if there are several values.
+  uint32_t GetPhiValue(const ir::Instruction* phi) const;
+
+  // Returns the id of the value |inst| is a copy of, or 0 if it is not a
+  // copy or a redundant phi.
+  uint32_t GetCopiedValue(const ir::Instruction* inst) const;
+
+  // Replaces the copies and redundant phis of |func| by the values they
+  // copy. Returns true if |func| is modified.
+  bool PropagateCopies(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_COPY_PROPAGATION_PASS_H_
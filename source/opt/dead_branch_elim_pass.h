@@ -45,6 +45,9 @@ class DeadBranchElimPass : public MemPass {
   DeadBranchElimPass();
   const char* name() const override { return "eliminate-dead-branches"; }
   Status Process(ir::IRContext* context) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new DeadBranchElimPass());
+  }
 
  private:
   // If |condId| is boolean constant, return conditional value in |condVal| and
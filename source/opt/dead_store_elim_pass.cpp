@@ -0,0 +1,337 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dead_store_elim_pass.h"
+
+#include "dominator_analysis.h"
+#include "ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kTypePointerStorageClassInIdx = 0;
+const uint32_t kStorePtrIdInIdx = 0;
+const uint32_t kStoreMemoryAccessInIdx = 2;
+const uint32_t kLoadPtrIdInIdx = 0;
+const uint32_t kAccessChainPtrIdInIdx = 0;
+const uint32_t kConstantValueInIdx = 0;
+
+// Logical operand indices of the pointers of stores and access chains.
+const uint32_t kStorePtrIdIdx = 0;
+const uint32_t kAccessChainPtrIdIdx = 2;
+
+const uint32_t kNoLocation = ~0u;
+
+// Returns true if |a| is a prefix of |b|.
+bool IsPrefix(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+  return a.size() <= b.size() && std::equal(a.begin(), a.end(), b.begin());
+}
+
+}  // anonymous namespace
+
+bool DeadStoreElimPass::HasOnlyConstantAccesses(uint32_t ptrId) const {
+  const analysis::UseList* uses = get_def_use_mgr()->GetUses(ptrId);
+  if (uses == nullptr) return true;
+  for (const auto& u : *uses) {
+    const ir::Instruction* user = u.inst;
+    switch (user->opcode()) {
+      case SpvOpName:
+      case SpvOpDecorate:
+      case SpvOpDecorateId:
+      case SpvOpLoad:
+        break;
+      case SpvOpStore:
+        // Storing the pointer itself lets it escape.
+        if (u.operand_index != kStorePtrIdIdx) return false;
+        break;
+      case SpvOpAccessChain:
+      case SpvOpInBoundsAccessChain:
+        if (u.operand_index != kAccessChainPtrIdIdx) return false;
+        for (uint32_t i = kAccessChainPtrIdInIdx + 1;
+             i < user->NumInOperands(); ++i) {
+          const ir::Instruction* indexInst =
+              get_def_use_mgr()->GetDef(user->GetSingleWordInOperand(i));
+          if (indexInst->opcode() != SpvOpConstant ||
+              indexInst->NumInOperands() != 1)
+            return false;
+        }
+        if (!HasOnlyConstantAccesses(user->result_id())) return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+bool DeadStoreElimPass::IsTrackedVar(const ir::Instruction* varInst) const {
+  if (varInst->opcode() != SpvOpVariable) return false;
+  const ir::Instruction* varTypeInst =
+      get_def_use_mgr()->GetDef(varInst->type_id());
+  const uint32_t storageClass =
+      varTypeInst->GetSingleWordInOperand(kTypePointerStorageClassInIdx);
+  if (storageClass != SpvStorageClassFunction &&
+      storageClass != SpvStorageClassPrivate)
+    return false;
+  return HasOnlyConstantAccesses(varInst->result_id());
+}
+
+uint32_t DeadStoreElimPass::GetLocation(uint32_t ptrId) {
+  const auto pi = ptr_location_.find(ptrId);
+  if (pi != ptr_location_.end()) return pi->second;
+  const ir::Instruction* ptrInst = get_def_use_mgr()->GetDef(ptrId);
+  Location location;
+  bool found = false;
+  if (ptrInst->opcode() == SpvOpVariable) {
+    if (tracked_vars_.count(ptrId) != 0) {
+      location.first = ptrId;
+      found = true;
+    }
+  } else if (IsNonPtrAccessChain(ptrInst->opcode())) {
+    const uint32_t baseLocation =
+        GetLocation(ptrInst->GetSingleWordInOperand(kAccessChainPtrIdInIdx));
+    if (baseLocation != kNoLocation) {
+      // The indices of access chains of tracked variables are constants.
+      location = locations_[baseLocation];
+      for (uint32_t i = kAccessChainPtrIdInIdx + 1;
+           i < ptrInst->NumInOperands(); ++i) {
+        const ir::Instruction* indexInst =
+            get_def_use_mgr()->GetDef(ptrInst->GetSingleWordInOperand(i));
+        location.second.push_back(
+            indexInst->GetSingleWordInOperand(kConstantValueInIdx));
+      }
+      found = true;
+    }
+  }
+  uint32_t index = kNoLocation;
+  if (found) {
+    const auto li = location_index_.emplace(
+        location, static_cast<uint32_t>(locations_.size()));
+    if (li.second) locations_.push_back(location);
+    index = li.first->second;
+  }
+  ptr_location_[ptrId] = index;
+  return index;
+}
+
+void DeadStoreElimPass::ComputeOverlaps() {
+  const uint32_t numLocations = static_cast<uint32_t>(locations_.size());
+  overlaps_.assign(numLocations, {});
+  covers_.assign(numLocations, {});
+  // Locations of different variables do not overlap, and |location_index_|
+  // is ordered by variable.
+  for (auto li = location_index_.begin(); li != location_index_.end(); ++li) {
+    for (auto lj = li; lj != location_index_.end() &&
+                       lj->first.first == li->first.first;
+         ++lj) {
+      const uint32_t i = li->second;
+      const uint32_t j = lj->second;
+      const bool coversJ = IsPrefix(li->first.second, lj->first.second);
+      const bool coversI = IsPrefix(lj->first.second, li->first.second);
+      if (coversJ) covers_[i].push_back(j);
+      if (coversI && i != j) covers_[j].push_back(i);
+      if (coversI || coversJ) {
+        overlaps_[i].push_back(j);
+        if (i != j) overlaps_[j].push_back(i);
+      }
+    }
+  }
+}
+
+void DeadStoreElimPass::Transfer(ir::Instruction* inst, LocationSet* live,
+                                 std::vector<ir::Instruction*>* deadStores) {
+  switch (inst->opcode()) {
+    case SpvOpLoad: {
+      const uint32_t location =
+          GetLocation(inst->GetSingleWordInOperand(kLoadPtrIdInIdx));
+      if (location != kNoLocation) (*live)[location] = true;
+    } break;
+    case SpvOpStore: {
+      const uint32_t location =
+          GetLocation(inst->GetSingleWordInOperand(kStorePtrIdInIdx));
+      if (location == kNoLocation) break;
+      // Volatile stores are kept, and are not assumed to hide earlier ones.
+      if (inst->NumInOperands() > kStoreMemoryAccessInIdx &&
+          (inst->GetSingleWordInOperand(kStoreMemoryAccessInIdx) &
+           SpvMemoryAccessVolatileMask))
+        break;
+      if (deadStores != nullptr) {
+        bool isLive = false;
+        for (auto o : overlaps_[location]) isLive = isLive || (*live)[o];
+        if (!isLive) deadStores->push_back(inst);
+      }
+      for (auto c : covers_[location]) (*live)[c] = false;
+    } break;
+    case SpvOpFunctionCall:
+      // The callee may read private variables.
+      for (uint32_t i = 0; i < locations_.size(); ++i)
+        if (private_vars_.count(locations_[i].first) != 0) (*live)[i] = true;
+      break;
+    default:
+      break;
+  }
+}
+
+void DeadStoreElimPass::KillStore(ir::Instruction* storeInst) {
+  uint32_t ptrId = storeInst->GetSingleWordInOperand(kStorePtrIdInIdx);
+  get_def_use_mgr()->KillInst(storeInst);
+  ir::Instruction* ptrInst = get_def_use_mgr()->GetDef(ptrId);
+  while (IsNonPtrAccessChain(ptrInst->opcode()) &&
+         HasOnlyNamesAndDecorates(ptrId)) {
+    const uint32_t baseId =
+        ptrInst->GetSingleWordInOperand(kAccessChainPtrIdInIdx);
+    KillNamesAndDecorates(ptrInst);
+    get_def_use_mgr()->KillInst(ptrInst);
+    ptrId = baseId;
+    ptrInst = get_def_use_mgr()->GetDef(ptrId);
+  }
+  // Private variables are left for dead variable elimination.
+  if (ptrInst->opcode() == SpvOpVariable && !IsLiveVar(ptrId) &&
+      HasOnlyNamesAndDecorates(ptrId)) {
+    KillNamesAndDecorates(ptrInst);
+    get_def_use_mgr()->KillInst(ptrInst);
+  }
+}
+
+bool DeadStoreElimPass::EliminateDeadStores(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  tracked_vars_ = private_vars_;
+  for (auto& inst : *func->begin())
+    if (IsTrackedVar(&inst)) tracked_vars_.insert(inst.result_id());
+  locations_.clear();
+  location_index_.clear();
+  ptr_location_.clear();
+  for (auto& blk : *func) {
+    for (auto& inst : blk) {
+      if (inst.opcode() == SpvOpLoad)
+        (void)GetLocation(inst.GetSingleWordInOperand(kLoadPtrIdInIdx));
+      else if (inst.opcode() == SpvOpStore)
+        (void)GetLocation(inst.GetSingleWordInOperand(kStorePtrIdInIdx));
+    }
+  }
+  if (locations_.empty()) return false;
+  ComputeOverlaps();
+
+  // Function variables are dead after a return. Private variables are too
+  // when returning from an entry point, as the invocation ends.
+  const uint32_t numLocations = static_cast<uint32_t>(locations_.size());
+  LocationSet liveAtReturn(numLocations, false);
+  if (entry_points_.count(func->result_id()) == 0)
+    for (uint32_t i = 0; i < numLocations; ++i)
+      if (private_vars_.count(locations_[i].first) != 0) liveAtReturn[i] = true;
+
+  // Visiting blocks after the blocks post-dominating them visits most
+  // successors before their predecessors. Blocks without a node come last.
+  DominatorAnalysis* postDom = context()->GetPostDominatorAnalysis(func);
+  std::vector<ir::BasicBlock*> order(postDom->Preorder());
+  std::unordered_set<ir::BasicBlock*> ordered(order.begin(), order.end());
+  for (auto& blk : *func)
+    if (ordered.count(&blk) == 0) order.push_back(&blk);
+
+  std::unordered_map<uint32_t, LocationSet> liveIn;
+  const auto liveOut = [&liveIn, &liveAtReturn,
+                        numLocations](ir::BasicBlock* bp) {
+    LocationSet live(numLocations, false);
+    const SpvOp tailOp = bp->tail()->opcode();
+    if (tailOp == SpvOpReturn || tailOp == SpvOpReturnValue) {
+      live = liveAtReturn;
+    } else {
+      bp->ForEachSuccessorLabel([&liveIn, &live, numLocations](uint32_t succ) {
+        const auto si = liveIn.find(succ);
+        if (si == liveIn.end()) return;
+        for (uint32_t i = 0; i < numLocations; ++i)
+          if (si->second[i]) live[i] = true;
+      });
+    }
+    return live;
+  };
+  const auto blockInsts = [](ir::BasicBlock* bp) {
+    std::vector<ir::Instruction*> insts;
+    for (auto& inst : *bp) insts.push_back(&inst);
+    return insts;
+  };
+
+  // Compute the locations live on entry to each block.
+  bool changed = true;
+  while (changed) {
+    changed = false;
+    for (auto bp : order) {
+      LocationSet live = liveOut(bp);
+      const auto insts = blockInsts(bp);
+      for (auto ii = insts.rbegin(); ii != insts.rend(); ++ii)
+        Transfer(*ii, &live, nullptr);
+      auto& entryLive = liveIn[bp->id()];
+      if (entryLive != live) {
+        entryLive = std::move(live);
+        changed = true;
+      }
+    }
+  }
+
+  std::vector<ir::Instruction*> deadStores;
+  for (auto bp : order) {
+    LocationSet live = liveOut(bp);
+    const auto insts = blockInsts(bp);
+    for (auto ii = insts.rbegin(); ii != insts.rend(); ++ii)
+      Transfer(*ii, &live, &deadStores);
+  }
+  for (auto storeInst : deadStores) KillStore(storeInst);
+  return !deadStores.empty();
+}
+
+void DeadStoreElimPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+
+  entry_points_.clear();
+  for (auto& e : get_module()->entry_points())
+    entry_points_.insert(e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+
+  private_vars_.clear();
+  for (auto& inst : get_module()->types_values())
+    if (IsTrackedVar(&inst)) {
+      const ir::Instruction* varTypeInst =
+          get_def_use_mgr()->GetDef(inst.type_id());
+      if (varTypeInst->GetSingleWordInOperand(kTypePointerStorageClassInIdx) ==
+          SpvStorageClassPrivate)
+        private_vars_.insert(inst.result_id());
+    }
+}
+
+Pass::Status DeadStoreElimPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return EliminateDeadStores(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+DeadStoreElimPass::DeadStoreElimPass() {}
+
+Pass::Status DeadStoreElimPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
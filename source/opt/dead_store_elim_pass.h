@@ -0,0 +1,110 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_DEAD_STORE_ELIM_PASS_H_
+#define LIBSPIRV_OPT_DEAD_STORE_ELIM_PASS_H_
+
+#include <map>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class DeadStoreElimPass : public MemPass {
+ public:
+  DeadStoreElimPass();
+  const char* name() const override { return "eliminate-dead-stores"; }
+  Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new DeadStoreElimPass());
+  }
+
+ private:
+  // A part of a variable: the variable and the constant indices of the
+  // access chains leading to the part.
+  using Location = std::pair<uint32_t, std::vector<uint32_t>>;
+
+  // A set of locations, indexed as in |locations_|. A live location may be
+  // read as a whole, so a store is live if it overlaps any live location.
+  using LocationSet = std::vector<bool>;
+
+  // Returns true if the uses of the pointer |ptrId| are only loads, stores
+  // through it, names, decorations, and access chains with constant indices
+  // whose uses are similarly restricted.
+  bool HasOnlyConstantAccesses(uint32_t ptrId) const;
+
+  // Returns true if |varInst| is a function or private variable whose parts
+  // can be tracked, which are then its only accesses.
+  bool IsTrackedVar(const ir::Instruction* varInst) const;
+
+  // Returns the index of the location |ptrId| points to, or kNoLocation if
+  // it is not a part of a tracked variable. New locations are added to
+  // |locations_|.
+  uint32_t GetLocation(uint32_t ptrId);
+
+  // Fills |overlaps_| and |covers_| for the locations of |locations_|.
+  void ComputeOverlaps();
+
+  // Updates |live|, the locations live after |inst|, to those live before
+  // it. If |deadStores| is not null, adds |inst| to it if it is a store to
+  // a location that is not live.
+  void Transfer(ir::Instruction* inst, LocationSet* live,
+                std::vector<ir::Instruction*>* deadStores);
+
+  // Kills |storeInst|, and the access chains and the function variable it
+  // stores through if they have no other use.
+  void KillStore(ir::Instruction* storeInst);
+
+  // Removes the stores of |func| that are overwritten on every path before
+  // being read, or never read. Returns true if |func| is modified.
+  bool EliminateDeadStores(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Ids of entry point functions.
+  std::unordered_set<uint32_t> entry_points_;
+
+  // Private variables whose parts can be tracked.
+  std::unordered_set<uint32_t> private_vars_;
+
+  // Tracked variables of the current function.
+  std::unordered_set<uint32_t> tracked_vars_;
+
+  // The locations accessed in the current function, and their indices.
+  std::vector<Location> locations_;
+  std::map<Location, uint32_t> location_index_;
+
+  // Location of each pointer of the current function, or kNoLocation.
+  std::unordered_map<uint32_t, uint32_t> ptr_location_;
+
+  // For each location, the locations which share a part with it, and the
+  // locations which are a part of it, including itself.
+  std::vector<std::vector<uint32_t>> overlaps_;
+  std::vector<std::vector<uint32_t>> covers_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_DEAD_STORE_ELIM_PASS_H_
@@ -0,0 +1,272 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "dominator_analysis.h"
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "cfa.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Universal Limit of ResultID + 1
+const uint32_t kInvalidId = 0x400000;
+
+using BlockMap =
+    std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>;
+
+}  // namespace
+
+const uint32_t DominatorAnalysis::kNoNode;
+
+DominatorAnalysis::DominatorAnalysis(ir::Function* func, bool post_dominator)
+    : function_(func),
+      post_dominator_(post_dominator),
+      frontiers_computed_(false),
+      pseudo_entry_block_(std::unique_ptr<ir::Instruction>(
+          new ir::Instruction(SpvOpLabel, 0, 0, {}))),
+      pseudo_exit_block_(std::unique_ptr<ir::Instruction>(
+          new ir::Instruction(SpvOpLabel, 0, kInvalidId, {}))) {
+  std::vector<ir::BasicBlock*> ordered_blocks;
+  std::unordered_map<uint32_t, ir::BasicBlock*> id2block;
+  for (auto& blk : *func) {
+    ordered_blocks.push_back(&blk);
+    id2block[blk.id()] = &blk;
+  }
+  // Function declarations have no tree.
+  if (ordered_blocks.empty()) return;
+
+  // Compute the CFG, ignoring duplicate edges out of an OpSwitch.
+  BlockMap succs;
+  BlockMap preds;
+  for (auto blk : ordered_blocks) {
+    auto& blk_succs = succs[blk];
+    preds[blk];
+    blk->ForEachSuccessorLabel([blk, &blk_succs, &id2block,
+                                &preds](const uint32_t label) {
+      const auto it = id2block.find(label);
+      if (it == id2block.end()) return;
+      if (std::find(blk_succs.begin(), blk_succs.end(), it->second) !=
+          blk_succs.end())
+        return;
+      blk_succs.push_back(it->second);
+      preds[it->second].push_back(blk);
+    });
+  }
+
+  // The dominator tree is rooted at the entry block, so blocks unreachable
+  // from it get no node. A function can have many exits, or none, so the
+  // post-dominator tree is rooted at a pseudo exit block that is wired to
+  // every sink of the CFG.
+  BlockMap next;
+  const ir::BasicBlock* root;
+  if (post_dominator_) {
+    succs[&pseudo_exit_block_];
+    preds[&pseudo_entry_block_];
+    BlockMap augmented_succs;
+    BlockMap augmented_preds;
+    CFA<ir::BasicBlock>::ComputeAugmentedCFG(
+        ordered_blocks, &pseudo_entry_block_, &pseudo_exit_block_,
+        &augmented_succs, &augmented_preds,
+        [&succs](const ir::BasicBlock* b) { return &succs[b]; },
+        [&preds](const ir::BasicBlock* b) { return &preds[b]; });
+    for (auto& entry : augmented_succs)
+      succs[entry.first] = std::move(entry.second);
+    for (auto& entry : augmented_preds)
+      preds[entry.first] = std::move(entry.second);
+    // This is the dominator tree of the reverse CFG.
+    next = std::move(preds);
+    preds_ = std::move(succs);
+    root = &pseudo_exit_block_;
+  } else {
+    next = std::move(succs);
+    preds_ = std::move(preds);
+    root = ordered_blocks.front();
+  }
+
+  std::vector<const ir::BasicBlock*> postorder;
+  CFA<ir::BasicBlock>::DepthFirstTraversal(
+      root, [&next](const ir::BasicBlock* b) { return &next[b]; },
+      [](const ir::BasicBlock*) {},
+      [&postorder](const ir::BasicBlock* b) { postorder.push_back(b); },
+      [](const ir::BasicBlock*, const ir::BasicBlock*) {});
+  const auto edges = CFA<ir::BasicBlock>::CalculateDominators(
+      postorder, [this](const ir::BasicBlock* b) { return &preds_[b]; });
+  std::unordered_map<const ir::BasicBlock*, ir::BasicBlock*> idom;
+  for (const auto& edge : edges) idom[edge.first] = edge.second;
+
+  // Number the nodes in reverse postorder of the CFG, so the root is node 0.
+  nodes_.reserve(postorder.size());
+  for (auto it = postorder.rbegin(); it != postorder.rend(); ++it) {
+    auto block = const_cast<ir::BasicBlock*>(*it);
+    block2node_[block] = static_cast<uint32_t>(nodes_.size());
+    if (!IsPseudoBlock(block)) id2node_[block->id()] = block2node_[block];
+    nodes_.push_back({block, kNoNode, 0, 0, {}, {}});
+  }
+
+  // Link each node to its parent. Children are listed in the order the
+  // blocks appear in the function, followed by the pseudo blocks.
+  ordered_blocks.push_back(&pseudo_entry_block_);
+  ordered_blocks.push_back(&pseudo_exit_block_);
+  std::vector<std::vector<uint32_t>> child_nodes(nodes_.size());
+  for (auto blk : ordered_blocks) {
+    const uint32_t n = NodeIndex(blk);
+    if (n == kNoNode || n == 0) continue;
+    const uint32_t parent = block2node_[idom[blk]];
+    nodes_[n].parent = parent;
+    child_nodes[parent].push_back(n);
+    if (!IsPseudoBlock(blk)) nodes_[parent].children.push_back(blk);
+  }
+
+  // Walk the tree to assign the preorder and postorder numbers.
+  uint32_t pre = 0;
+  uint32_t post = 0;
+  std::vector<std::pair<uint32_t, size_t>> stack;
+  stack.push_back({0, 0});
+  nodes_[0].pre = pre++;
+  if (!IsPseudoBlock(nodes_[0].block)) preorder_.push_back(nodes_[0].block);
+  while (!stack.empty()) {
+    auto& top = stack.back();
+    if (top.second == child_nodes[top.first].size()) {
+      nodes_[top.first].post = post++;
+      stack.pop_back();
+      continue;
+    }
+    const uint32_t child = child_nodes[top.first][top.second++];
+    nodes_[child].pre = pre++;
+    if (!IsPseudoBlock(nodes_[child].block))
+      preorder_.push_back(nodes_[child].block);
+    stack.push_back({child, 0});
+  }
+}
+
+uint32_t DominatorAnalysis::NodeIndex(const ir::BasicBlock* b) const {
+  const auto it = block2node_.find(b);
+  return it == block2node_.end() ? kNoNode : it->second;
+}
+
+uint32_t DominatorAnalysis::NodeIndex(uint32_t id) const {
+  const auto it = id2node_.find(id);
+  return it == id2node_.end() ? kNoNode : it->second;
+}
+
+bool DominatorAnalysis::Dominates(uint32_t a, uint32_t b, bool strict) const {
+  if (a == kNoNode || b == kNoNode) return false;
+  if (a == b) return !strict;
+  return nodes_[a].pre < nodes_[b].pre && nodes_[b].post < nodes_[a].post;
+}
+
+bool DominatorAnalysis::Dominates(const ir::BasicBlock* a,
+                                  const ir::BasicBlock* b) const {
+  return Dominates(NodeIndex(a), NodeIndex(b), false);
+}
+
+bool DominatorAnalysis::Dominates(uint32_t a_id, uint32_t b_id) const {
+  return Dominates(NodeIndex(a_id), NodeIndex(b_id), false);
+}
+
+bool DominatorAnalysis::StrictlyDominates(const ir::BasicBlock* a,
+                                          const ir::BasicBlock* b) const {
+  return Dominates(NodeIndex(a), NodeIndex(b), true);
+}
+
+bool DominatorAnalysis::StrictlyDominates(uint32_t a_id,
+                                          uint32_t b_id) const {
+  return Dominates(NodeIndex(a_id), NodeIndex(b_id), true);
+}
+
+ir::BasicBlock* DominatorAnalysis::ImmediateDominator(
+    const ir::BasicBlock* b) const {
+  const uint32_t n = NodeIndex(b);
+  if (n == kNoNode || nodes_[n].parent == kNoNode) return nullptr;
+  ir::BasicBlock* parent = nodes_[nodes_[n].parent].block;
+  return IsPseudoBlock(parent) ? nullptr : parent;
+}
+
+ir::BasicBlock* DominatorAnalysis::ImmediateDominator(uint32_t b_id) const {
+  const uint32_t n = NodeIndex(b_id);
+  return n == kNoNode ? nullptr : ImmediateDominator(nodes_[n].block);
+}
+
+const std::vector<ir::BasicBlock*>& DominatorAnalysis::Children(
+    const ir::BasicBlock* b) const {
+  const uint32_t n = NodeIndex(b);
+  return n == kNoNode ? no_blocks_ : nodes_[n].children;
+}
+
+const std::vector<ir::BasicBlock*>& DominatorAnalysis::DominanceFrontier(
+    const ir::BasicBlock* b) {
+  if (!frontiers_computed_) ComputeDominanceFrontiers();
+  const uint32_t n = NodeIndex(b);
+  return n == kNoNode ? no_blocks_ : nodes_[n].frontier;
+}
+
+void DominatorAnalysis::ComputeDominanceFrontiers() {
+  // Cooper, Harvey and Kennedy: walk up from each predecessor of a join
+  // point until reaching the join point's immediate dominator.
+  for (uint32_t i = 0; i < nodes_.size(); ++i) {
+    ir::BasicBlock* block = nodes_[i].block;
+    if (IsPseudoBlock(block)) continue;
+    const auto& block_preds = preds_[block];
+    if (block_preds.size() < 2) continue;
+    for (auto pred : block_preds) {
+      uint32_t runner = NodeIndex(pred);
+      while (runner != kNoNode && runner != nodes_[i].parent) {
+        auto& frontier = nodes_[runner].frontier;
+        if (frontier.empty() || frontier.back() != block)
+          frontier.push_back(block);
+        runner = nodes_[runner].parent;
+      }
+    }
+  }
+  frontiers_computed_ = true;
+}
+
+void DominatorAnalysis::IteratedDominanceFrontier(
+    const std::vector<ir::BasicBlock*>& blocks,
+    std::vector<ir::BasicBlock*>* idf) {
+  if (!frontiers_computed_) ComputeDominanceFrontiers();
+  std::vector<bool> in_idf(nodes_.size(), false);
+  std::vector<uint32_t> worklist;
+  std::vector<uint32_t> result;
+  for (auto b : blocks) {
+    const uint32_t n = NodeIndex(b);
+    if (n != kNoNode) worklist.push_back(n);
+  }
+  while (!worklist.empty()) {
+    const uint32_t n = worklist.back();
+    worklist.pop_back();
+    for (auto f : nodes_[n].frontier) {
+      const uint32_t fn = NodeIndex(f);
+      if (in_idf[fn]) continue;
+      in_idf[fn] = true;
+      result.push_back(fn);
+      worklist.push_back(fn);
+    }
+  }
+  std::sort(result.begin(), result.end(), [this](uint32_t a, uint32_t b) {
+    return nodes_[a].pre < nodes_[b].pre;
+  });
+  idf->clear();
+  idf->reserve(result.size());
+  for (auto n : result) idf->push_back(nodes_[n].block);
+}
+
+}  // namespace opt
+}  // namespace spvtools
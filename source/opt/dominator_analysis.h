@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_DOMINATOR_ANALYSIS_H_
+#define LIBSPIRV_OPT_DOMINATOR_ANALYSIS_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "basic_block.h"
+#include "function.h"
+
+namespace spvtools {
+namespace opt {
+
+// The dominator tree, or the post-dominator tree, of a single function.
+//
+// The dominator tree is rooted at the function's entry block; blocks that are
+// unreachable from it have no node, and are neither dominated by nor dominate
+// any block. The post-dominator tree is computed over the CFG augmented with a
+// pseudo exit block (see CFA::ComputeAugmentedCFG), so every block has a node
+// even if the function has several returns or none. The pseudo blocks are
+// never returned by any of the queries below.
+//
+// Nodes are numbered by a depth first walk of the tree, which makes Dominates()
+// a constant time test. Dominance frontiers are computed on first request.
+//
+// The analysis holds pointers to the function's blocks: it must be discarded
+// (see ir::IRContext::InvalidateDominatorAnalyses) whenever the function's
+// blocks or branches change.
+class DominatorAnalysis {
+ public:
+  // Builds the dominator tree of |func|, or its post-dominator tree if
+  // |post_dominator| is true.
+  DominatorAnalysis(ir::Function* func, bool post_dominator);
+
+  // Returns the function this analysis describes.
+  ir::Function* function() const { return function_; }
+
+  // Returns true if this is a post-dominator tree.
+  bool IsPostDominator() const { return post_dominator_; }
+
+  // Returns true if |a| dominates |b|. Every block with a node dominates
+  // itself. Returns false if either block has no node. For a post-dominator tree
+  // this answers whether |a| post-dominates |b|.
+  bool Dominates(const ir::BasicBlock* a, const ir::BasicBlock* b) const;
+  bool Dominates(uint32_t a_id, uint32_t b_id) const;
+
+  // Returns true if |a| dominates |b| and |a| is not |b|.
+  bool StrictlyDominates(const ir::BasicBlock* a,
+                         const ir::BasicBlock* b) const;
+  bool StrictlyDominates(uint32_t a_id, uint32_t b_id) const;
+
+  // Returns the immediate dominator of |b|, or nullptr if |b| is the entry
+  // block, is immediately post-dominated only by the pseudo exit, or has no
+  // node.
+  ir::BasicBlock* ImmediateDominator(const ir::BasicBlock* b) const;
+  ir::BasicBlock* ImmediateDominator(uint32_t b_id) const;
+
+  // Returns the blocks immediately dominated by |b|, in function order.
+  const std::vector<ir::BasicBlock*>& Children(const ir::BasicBlock* b) const;
+
+  // Returns the blocks of the tree in preorder: every block appears after all
+  // of its dominators.
+  const std::vector<ir::BasicBlock*>& Preorder() const { return preorder_; }
+
+  // Returns the dominance frontier of |b|: the blocks where the dominance of
+  // |b| ends. For a post-dominator tree this is the set of blocks |b| is
+  // control dependent on.
+  const std::vector<ir::BasicBlock*>& DominanceFrontier(
+      const ir::BasicBlock* b);
+
+  // Replaces the contents of |idf| with the iterated dominance frontier of
+  // |blocks|, ordered by Preorder(). This is where phi functions are needed
+  // for a variable stored in |blocks|.
+  void IteratedDominanceFrontier(const std::vector<ir::BasicBlock*>& blocks,
+                                 std::vector<ir::BasicBlock*>* idf);
+
+ private:
+  static const uint32_t kNoNode = ~0u;
+
+  struct Node {
+    ir::BasicBlock* block;
+    // Index of the immediate dominator, or kNoNode for the root.
+    uint32_t parent;
+    // Numbering of the depth first walk of the tree.
+    uint32_t pre;
+    uint32_t post;
+    // Children of the node, excluding pseudo blocks.
+    std::vector<ir::BasicBlock*> children;
+    // Dominance frontier, valid once frontiers_computed_ is set.
+    std::vector<ir::BasicBlock*> frontier;
+  };
+
+  // Returns the node index of |b|, or kNoNode if |b| has no node.
+  uint32_t NodeIndex(const ir::BasicBlock* b) const;
+  uint32_t NodeIndex(uint32_t id) const;
+
+  bool Dominates(uint32_t a, uint32_t b, bool strict) const;
+
+  // Returns true if |b| is one of the pseudo blocks.
+  bool IsPseudoBlock(const ir::BasicBlock* b) const {
+    return b == &pseudo_entry_block_ || b == &pseudo_exit_block_;
+  }
+
+  // Computes the dominance frontier of every node.
+  void ComputeDominanceFrontiers();
+
+  ir::Function* function_;
+  bool post_dominator_;
+  bool frontiers_computed_;
+
+  // Pseudo blocks of the augmented CFG.
+  ir::BasicBlock pseudo_entry_block_;
+  ir::BasicBlock pseudo_exit_block_;
+
+  // Edges of the augmented CFG. For a post-dominator tree these are the
+  // edges of the reverse CFG, so "predecessors" are the CFG successors.
+  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
+      preds_;
+
+  std::vector<Node> nodes_;
+  std::unordered_map<const ir::BasicBlock*, uint32_t> block2node_;
+  std::unordered_map<uint32_t, uint32_t> id2node_;
+  std::vector<ir::BasicBlock*> preorder_;
+
+  // Returned for blocks that have no node.
+  const std::vector<ir::BasicBlock*> no_blocks_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_DOMINATOR_ANALYSIS_H_
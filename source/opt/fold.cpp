@@ -16,6 +16,8 @@
 #include "def_use_manager.h"
 
 #include <cassert>
+#include <cmath>
+#include <cstring>
 #include <vector>
 
 namespace spvtools {
@@ -29,7 +31,8 @@ uint32_t UnaryOperate(SpvOp opcode, uint32_t operand) {
   switch (opcode) {
     // Arthimetics
     case SpvOp::SpvOpSNegate:
-      return -static_cast<int32_t>(operand);
+      // Negate in unsigned arithmetic so that the most negative value wraps.
+      return 0u - operand;
     case SpvOp::SpvOpNot:
       return ~operand;
     case SpvOp::SpvOpLogicalNot:
@@ -71,7 +74,9 @@ uint32_t BinaryOperate(SpvOp opcode, uint32_t a, uint32_t b) {
       assert(b != 0u);
       int32_t rem = BinaryOperate(SpvOp::SpvOpSRem, a, b);
       int32_t b_prim = static_cast<int32_t>(b);
-      return (rem + b_prim) % b_prim;
+      // Adding operands of opposite signs cannot overflow.
+      if (rem != 0 && ((rem < 0) != (b_prim < 0))) rem += b_prim;
+      return rem;
     }
     case SpvOp::SpvOpUMod:
       assert(b != 0u);
@@ -240,5 +245,210 @@ std::vector<uint32_t> FoldVectors(
   return result;
 }
 
+bool IsFoldableScalarOp(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOp::SpvOpSNegate:
+    case SpvOp::SpvOpNot:
+    case SpvOp::SpvOpLogicalNot:
+    case SpvOp::SpvOpIAdd:
+    case SpvOp::SpvOpISub:
+    case SpvOp::SpvOpIMul:
+    case SpvOp::SpvOpUDiv:
+    case SpvOp::SpvOpSDiv:
+    case SpvOp::SpvOpSRem:
+    case SpvOp::SpvOpSMod:
+    case SpvOp::SpvOpUMod:
+    case SpvOp::SpvOpShiftRightLogical:
+    case SpvOp::SpvOpShiftRightArithmetic:
+    case SpvOp::SpvOpShiftLeftLogical:
+    case SpvOp::SpvOpBitwiseOr:
+    case SpvOp::SpvOpBitwiseAnd:
+    case SpvOp::SpvOpBitwiseXor:
+    case SpvOp::SpvOpLogicalEqual:
+    case SpvOp::SpvOpLogicalNotEqual:
+    case SpvOp::SpvOpLogicalOr:
+    case SpvOp::SpvOpLogicalAnd:
+    case SpvOp::SpvOpIEqual:
+    case SpvOp::SpvOpINotEqual:
+    case SpvOp::SpvOpULessThan:
+    case SpvOp::SpvOpSLessThan:
+    case SpvOp::SpvOpUGreaterThan:
+    case SpvOp::SpvOpSGreaterThan:
+    case SpvOp::SpvOpULessThanEqual:
+    case SpvOp::SpvOpSLessThanEqual:
+    case SpvOp::SpvOpUGreaterThanEqual:
+    case SpvOp::SpvOpSGreaterThanEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool FoldScalarWords(SpvOp opcode, const std::vector<uint32_t>& operand_words,
+                     uint32_t* result) {
+  const uint32_t kMinInt = 0x80000000u;
+  switch (opcode) {
+    case SpvOp::SpvOpSNegate:
+    case SpvOp::SpvOpNot:
+    case SpvOp::SpvOpLogicalNot:
+      if (operand_words.size() != 1) return false;
+      break;
+    case SpvOp::SpvOpUDiv:
+    case SpvOp::SpvOpUMod:
+      if (operand_words.size() != 2 || operand_words[1] == 0u) return false;
+      break;
+    case SpvOp::SpvOpSDiv:
+    case SpvOp::SpvOpSRem:
+    case SpvOp::SpvOpSMod:
+      // Avoid the signed overflows of the host's division as well as the
+      // division by zero.
+      if (operand_words.size() != 2 || operand_words[1] == 0u ||
+          operand_words[0] == kMinInt || operand_words[1] == kMinInt)
+        return false;
+      break;
+    case SpvOp::SpvOpShiftRightLogical:
+    case SpvOp::SpvOpShiftRightArithmetic:
+    case SpvOp::SpvOpShiftLeftLogical:
+      if (operand_words.size() != 2 || operand_words[1] >= 32u) return false;
+      break;
+    default:
+      if (!IsFoldableScalarOp(opcode) || operand_words.size() != 2)
+        return false;
+      break;
+  }
+  *result = OperateWords(opcode, operand_words);
+  return true;
+}
+
+bool IsFoldableFloatOp(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOp::SpvOpFNegate:
+    case SpvOp::SpvOpFAdd:
+    case SpvOp::SpvOpFSub:
+    case SpvOp::SpvOpFMul:
+    case SpvOp::SpvOpFDiv:
+    case SpvOp::SpvOpFOrdEqual:
+    case SpvOp::SpvOpFUnordEqual:
+    case SpvOp::SpvOpFOrdNotEqual:
+    case SpvOp::SpvOpFUnordNotEqual:
+    case SpvOp::SpvOpFOrdLessThan:
+    case SpvOp::SpvOpFUnordLessThan:
+    case SpvOp::SpvOpFOrdGreaterThan:
+    case SpvOp::SpvOpFUnordGreaterThan:
+    case SpvOp::SpvOpFOrdLessThanEqual:
+    case SpvOp::SpvOpFUnordLessThanEqual:
+    case SpvOp::SpvOpFOrdGreaterThanEqual:
+    case SpvOp::SpvOpFUnordGreaterThanEqual:
+    case SpvOp::SpvOpConvertFToS:
+    case SpvOp::SpvOpConvertFToU:
+    case SpvOp::SpvOpConvertSToF:
+    case SpvOp::SpvOpConvertUToF:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool FoldFloatWords(SpvOp opcode, const std::vector<uint32_t>& operand_words,
+                    uint32_t* result) {
+  const bool unary = opcode == SpvOp::SpvOpFNegate ||
+                     opcode == SpvOp::SpvOpConvertFToS ||
+                     opcode == SpvOp::SpvOpConvertFToU ||
+                     opcode == SpvOp::SpvOpConvertSToF ||
+                     opcode == SpvOp::SpvOpConvertUToF;
+  if (!IsFoldableFloatOp(opcode) ||
+      operand_words.size() != (unary ? 1u : 2u))
+    return false;
+  float a = 0.0f;
+  float b = 0.0f;
+  memcpy(&a, &operand_words[0], sizeof(a));
+  if (!unary) memcpy(&b, &operand_words[1], sizeof(b));
+  const bool unordered = std::isnan(a) || std::isnan(b);
+  float value = 0.0f;
+  bool isFloat = true;
+  switch (opcode) {
+    case SpvOp::SpvOpFNegate:
+      value = -a;
+      break;
+    case SpvOp::SpvOpFAdd:
+      value = a + b;
+      break;
+    case SpvOp::SpvOpFSub:
+      value = a - b;
+      break;
+    case SpvOp::SpvOpFMul:
+      value = a * b;
+      break;
+    case SpvOp::SpvOpFDiv:
+      if (b == 0.0f) return false;
+      value = a / b;
+      break;
+    case SpvOp::SpvOpConvertSToF:
+      value = static_cast<float>(static_cast<int32_t>(operand_words[0]));
+      break;
+    case SpvOp::SpvOpConvertUToF:
+      value = static_cast<float>(operand_words[0]);
+      break;
+    case SpvOp::SpvOpConvertFToS:
+      if (!(a > -2147483904.0f && a < 2147483648.0f)) return false;
+      *result = static_cast<uint32_t>(static_cast<int32_t>(a));
+      return true;
+    case SpvOp::SpvOpConvertFToU:
+      if (!(a > -1.0f && a < 4294967296.0f)) return false;
+      *result = static_cast<uint32_t>(a);
+      return true;
+    default:
+      isFloat = false;
+      break;
+  }
+  if (isFloat) {
+    memcpy(result, &value, sizeof(value));
+    return true;
+  }
+  bool cmp = false;
+  switch (opcode) {
+    case SpvOp::SpvOpFOrdEqual:
+      cmp = a == b;
+      break;
+    case SpvOp::SpvOpFUnordEqual:
+      cmp = unordered || a == b;
+      break;
+    case SpvOp::SpvOpFOrdNotEqual:
+      cmp = !unordered && a != b;
+      break;
+    case SpvOp::SpvOpFUnordNotEqual:
+      cmp = a != b;
+      break;
+    case SpvOp::SpvOpFOrdLessThan:
+      cmp = a < b;
+      break;
+    case SpvOp::SpvOpFUnordLessThan:
+      cmp = unordered || a < b;
+      break;
+    case SpvOp::SpvOpFOrdGreaterThan:
+      cmp = a > b;
+      break;
+    case SpvOp::SpvOpFUnordGreaterThan:
+      cmp = unordered || a > b;
+      break;
+    case SpvOp::SpvOpFOrdLessThanEqual:
+      cmp = a <= b;
+      break;
+    case SpvOp::SpvOpFUnordLessThanEqual:
+      cmp = unordered || a <= b;
+      break;
+    case SpvOp::SpvOpFOrdGreaterThanEqual:
+      cmp = a >= b;
+      break;
+    case SpvOp::SpvOpFUnordGreaterThanEqual:
+      cmp = unordered || a >= b;
+      break;
+    default:
+      return false;
+  }
+  *result = cmp ? 1u : 0u;
+  return true;
+}
+
 }  // namespace opt
 }  // namespace spvtools
@@ -31,6 +31,29 @@ std::vector<uint32_t> FoldVectors(
     SpvOp opcode, uint32_t num_dims,
     const std::vector<analysis::Constant*>& operands);
 
+// Returns true if |opcode| is a unary or binary operation on 32-bit integer or
+// boolean scalars that FoldScalarWords() can evaluate.
+bool IsFoldableScalarOp(SpvOp opcode);
+
+// Evaluates |opcode| on the 32-bit scalar values |operand_words|, using the
+// convention that 0u is false and anything else is true, and returns the
+// result in |result|. Returns false if the result is undefined, e.g. for a
+// division by zero or a shift by 32 or more bits.
+bool FoldScalarWords(SpvOp opcode, const std::vector<uint32_t>& operand_words,
+                     uint32_t* result);
+
+// Returns true if |opcode| is a floating point arithmetic, comparison or
+// conversion operation that FoldFloatWords() can evaluate.
+bool IsFoldableFloatOp(SpvOp opcode);
+
+// Evaluates |opcode| on the 32-bit scalar values |operand_words|, floats
+// being given by their bit patterns, and returns the result in |result|.
+// Booleans are 0u or 1u. Returns false if the result is undefined, e.g. for
+// the conversion of a float out of the range of the integer type, or if the
+// device may compute it differently, as for a division by zero.
+bool FoldFloatWords(SpvOp opcode, const std::vector<uint32_t>& operand_words,
+                    uint32_t* result);
+
 }  // namespace opt
 }  // namespace spvtools
 
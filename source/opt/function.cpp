@@ -42,6 +42,18 @@ Function::Function(const Function& f)
   SetFunctionEnd(MakeUnique<Instruction>(f.function_end()));
 }
 
+std::unique_ptr<Function> Function::CloneDeclaration() const {
+  std::unique_ptr<Function> decl(
+      new Function(MakeUnique<Instruction>(DefInst())));
+  ForEachParam(
+      [&decl](const Instruction* param) {
+        decl->AddParameter(MakeUnique<Instruction>(*param));
+      },
+      true);
+  decl->SetFunctionEnd(MakeUnique<Instruction>(function_end()));
+  return decl;
+}
+
 void Function::ForEachInst(const std::function<void(Instruction*)>& f,
                            bool run_on_debug_line_insts) {
   if (def_inst_) def_inst_->ForEachInst(f, run_on_debug_line_insts);
@@ -43,6 +43,9 @@ class Function {
   // The parent module will default to null and needs to be explicitly set by
   // the user.
   explicit Function(const Function& f);
+  // Returns a copy of this function without its basic blocks, which declares
+  // it. The parent module of the copy is null.
+  std::unique_ptr<Function> CloneDeclaration() const;
   // The OpFunction instruction that begins the definition of this function.
   Instruction& DefInst() { return *def_inst_; }
   const Instruction& DefInst() const { return *def_inst_; }
@@ -0,0 +1,137 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "function_cache.h"
+
+#include <algorithm>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+
+#include "build_module.h"
+#include "function_task.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// First word of the keys of the results for functions in the cache.
+const uint32_t kFunctionKeyTag = 0x464e4331;  // "FNC1"
+
+// The image of a function, and the ids of the module its ids stand for.
+struct FunctionImage {
+  std::unique_ptr<ir::Module> module;
+  std::vector<uint32_t> original_ids;
+  uint32_t func_id;
+};
+
+// Builds the image of |func|, a function of |module|, with ids renumbered in
+// order of appearance so that identical functions have identical images.
+FunctionImage BuildImage(const ir::Module& module, const ModuleIndex& index,
+                         const ir::Function& func) {
+  FunctionImage image;
+  image.module = BuildFunctionImage(module, index, func);
+  ir::Module* copy = image.module.get();
+
+  // Renumber the ids in order of appearance.
+  std::unordered_map<uint32_t, uint32_t> canonical;
+  image.original_ids.push_back(0);
+  copy->ForEachInst(
+      [&canonical, &image](ir::Instruction* inst) {
+        inst->ForEachId([&canonical, &image](uint32_t* id) {
+          const auto inserted = canonical.insert(
+              {*id, static_cast<uint32_t>(image.original_ids.size())});
+          if (inserted.second) image.original_ids.push_back(*id);
+          *id = inserted.first->second;
+        });
+      },
+      true);
+  copy->SetHeader({SpvMagicNumber, module.version(), 0,
+                   static_cast<uint32_t>(image.original_ids.size()), 0});
+  image.func_id = canonical.at(func.result_id());
+  return image;
+}
+
+// Runs |passes| on the image of the function of |task|, or finds their result
+// in |cache|, and records it in |task| if it differs from the image.
+void RunFunctionTask(const std::vector<Pass*>& passes,
+                     const std::vector<uint32_t>& key_prefix,
+                     const ResultCache& cache, spv_target_env env,
+                     const ir::Module& module, const ModuleIndex& index,
+                     FunctionTask* task) {
+  FunctionImage image = BuildImage(module, index, *task->func);
+  task->original_ids = std::move(image.original_ids);
+  task->image_bound = static_cast<uint32_t>(task->original_ids.size());
+  std::vector<uint32_t> key = key_prefix;
+  key.push_back(task->called_from_entry_points ? 1 : 0);
+  const size_t image_start = key.size();
+  image.module->ToBinary(&key, /* skip_nop = */ false);
+
+  std::vector<uint32_t> result;
+  if (!cache.Lookup(key, &result)) {
+    ir::IRContext context(std::move(image.module));
+    const Pass::Status status =
+        RunFunctionLocalPasses(passes, image.func_id,
+                               task->called_from_entry_points, &context);
+    if (status == Pass::Status::Failure) {
+      task->status = status;
+      return;
+    }
+    context.module()->ToBinary(&result, /* skip_nop = */ true);
+    cache.Store(key, result);
+  }
+
+  if (result.size() == key.size() - image_start &&
+      std::equal(result.begin(), result.end(), key.begin() + image_start))
+    return;
+  std::unique_ptr<ir::Module> result_module =
+      BuildModule(env, passes[0]->consumer(), result.data(), result.size());
+  if (result_module == nullptr) {
+    task->status = Pass::Status::Failure;
+    return;
+  }
+  SetFunctionTaskResult(*result_module, task);
+}
+
+}  // namespace
+
+bool CanProcessFunctionsIncrementally(const ir::Module& module) {
+  for (auto& inst : module.annotations())
+    if (inst.opcode() == SpvOpDecorationGroup) return false;
+  return true;
+}
+
+Pass::Status ProcessFunctionsIncrementally(const std::vector<Pass*>& passes,
+                                           const std::string& passes_key,
+                                           const ResultCache& cache,
+                                           spv_target_env env,
+                                           uint32_t num_threads,
+                                           ir::IRContext* context) {
+  assert(CanProcessFunctionsIncrementally(*context->module()));
+
+  ir::Module* module = context->module();
+  std::vector<FunctionTask> tasks =
+      CollectFunctionTasks(passes[0], context, nullptr);
+  const ModuleIndex index = IndexModule(module);
+  std::vector<uint32_t> key_prefix = {kFunctionKeyTag};
+  ResultCache::AppendString(passes_key, &key_prefix);
+  RunFunctionTasks(&tasks, num_threads, [&](FunctionTask* task) {
+    RunFunctionTask(passes, key_prefix, cache, env, *module, index, task);
+  });
+  return MergeFunctionTasks(&tasks, index, context);
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,60 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_FUNCTION_CACHE_H_
+#define LIBSPIRV_OPT_FUNCTION_CACHE_H_
+
+#include <string>
+#include <vector>
+
+#include "ir_context.h"
+#include "module.h"
+#include "pass.h"
+#include "result_cache.h"
+
+namespace spvtools {
+namespace opt {
+
+// Returns true if ProcessFunctionsIncrementally() can process |module|,
+// which is the case unless it has decoration groups.
+bool CanProcessFunctionsIncrementally(const ir::Module& module);
+
+// Runs the function-local |passes| in order on each function of the module
+// of |context| that they process, using up to |num_threads| threads.
+//
+// Each function is optimized in an image: a module holding the function,
+// declarations of the functions it calls, and only the types, constants,
+// global variables, decorations and entry point it refers to, with ids
+// renumbered in order of appearance. The image of a function is thus the
+// same whenever the function and what it refers to are the same, wherever
+// it is in the module. The result of the passes on an image is stored in
+// |cache|, under a key made of |passes_key|, which identifies the passes and
+// anything else their result depends on, and the image. When the result for
+// an image is already there, the passes do not run on the function.
+//
+// The results are merged into the module in the order of its functions. A
+// type or constant added by the passes reuses the id of an identical
+// undecorated one of the module, or of one added before. |env| is the target
+// environment of the module.
+Pass::Status ProcessFunctionsIncrementally(const std::vector<Pass*>& passes,
+                                           const std::string& passes_key,
+                                           const ResultCache& cache,
+                                           spv_target_env env,
+                                           uint32_t num_threads,
+                                           ir::IRContext* context);
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_FUNCTION_CACHE_H_
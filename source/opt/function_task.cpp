@@ -0,0 +1,455 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "function_task.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <map>
+#include <thread>
+
+#include "make_unique.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// Returns the words identifying the global |inst| among identical ones.
+std::vector<uint32_t> GlobalKey(const ir::Instruction& inst) {
+  std::vector<uint32_t> key = {static_cast<uint32_t>(inst.opcode()),
+                               inst.type_id()};
+  for (uint32_t i = 0; i < inst.NumInOperands(); ++i) {
+    const auto& words = inst.GetInOperand(i).words;
+    key.insert(key.end(), words.begin(), words.end());
+  }
+  return key;
+}
+
+// Returns true if |a| and |b| have the same opcode and operands.
+bool SameInstruction(const ir::Instruction& a, const ir::Instruction& b) {
+  if (a.opcode() != b.opcode() || a.NumInOperands() != b.NumInOperands())
+    return false;
+  for (uint32_t i = 0; i < a.NumInOperands(); ++i)
+    if (a.GetInOperand(i).words != b.GetInOperand(i).words) return false;
+  return true;
+}
+
+// Makes |originals|, the names or decorations of the ids of a function,
+// those of |results| once renumbered by |remap|. Those that did not change
+// stay in place, in order. The others are turned into OpNop, and their new
+// version is added to the module with |add|.
+template <typename Range, typename AddFunction>
+void MergeNames(const std::vector<ir::Instruction*>& originals,
+                const Range& results,
+                const std::function<void(uint32_t*)>& remap,
+                AddFunction add) {
+  std::vector<std::unique_ptr<ir::Instruction>> copies;
+  for (auto& inst : results) {
+    copies.emplace_back(new ir::Instruction(inst));
+    copies.back()->ForEachId(remap);
+  }
+  size_t next = 0;
+  for (auto* inst : originals) {
+    if (next < copies.size() && SameInstruction(*inst, *copies[next]))
+      ++next;
+    else
+      inst->ToNop();
+  }
+  for (; next < copies.size(); ++next) add(std::move(copies[next]));
+}
+
+// Merges the result of |task| into |module|, indexed by |index|. The ids
+// allocated by the passes are renumbered from |*next_id|, except for new
+// types and constants that |global_ids| maps to an id, from their key.
+void MergeFunctionTask(
+    ir::Module* module, const ModuleIndex& index, FunctionTask* task,
+    uint32_t* next_id,
+    std::map<std::vector<uint32_t>, uint32_t>* global_ids) {
+  ir::Module* result = task->result.get();
+  const uint32_t image_bound = task->image_bound;
+  std::vector<uint32_t> new_ids(
+      std::max(result->ComputeIdBound(), image_bound) - image_bound, 0);
+  std::function<void(uint32_t*)> remap = [task, image_bound,
+                                          &new_ids](uint32_t* id) {
+    if (*id < image_bound) {
+      if (!task->original_ids.empty()) *id = task->original_ids[*id];
+      return;
+    }
+    assert(new_ids[*id - image_bound] != 0 && "use of an unknown id");
+    *id = new_ids[*id - image_bound];
+  };
+
+  for (auto& inst : result->capabilities())
+    if (!module->HasCapability(inst.GetSingleWordInOperand(0)))
+      module->AddCapability(MakeUnique<ir::Instruction>(inst));
+  for (auto& inst : result->extensions()) {
+    const auto& name = inst.GetInOperand(0).words;
+    bool found = false;
+    for (auto& ext : module->extensions())
+      found = found || ext.GetInOperand(0).words == name;
+    if (!found) module->AddExtension(MakeUnique<ir::Instruction>(inst));
+  }
+  for (auto& inst : result->ext_inst_imports()) {
+    const char* name =
+        reinterpret_cast<const char*>(inst.GetInOperand(0).words.data());
+    uint32_t id = module->GetExtInstImportId(name);
+    if (id == 0) {
+      id = (*next_id)++;
+      std::unique_ptr<ir::Instruction> copy(new ir::Instruction(inst));
+      copy->SetResultId(id);
+      module->AddExtInstImport(std::move(copy));
+    }
+    new_ids[inst.result_id() - image_bound] = id;
+  }
+  for (auto& inst : result->types_values()) {
+    std::unique_ptr<ir::Instruction> copy(new ir::Instruction(inst));
+    copy->ForEachInId(remap);
+    if (copy->type_id() != 0) {
+      uint32_t type_id = copy->type_id();
+      remap(&type_id);
+      copy->SetResultType(type_id);
+    }
+    const std::vector<uint32_t> key = GlobalKey(*copy);
+    const auto it = global_ids->find(key);
+    uint32_t& new_id = new_ids[inst.result_id() - image_bound];
+    if (it != global_ids->end() && copy->opcode() != SpvOpVariable) {
+      new_id = it->second;
+      continue;
+    }
+    new_id = (*next_id)++;
+    copy->SetResultId(new_id);
+    if (copy->opcode() != SpvOpVariable) global_ids->insert({key, new_id});
+    module->AddGlobalValue(std::move(copy));
+  }
+
+  std::unique_ptr<ir::Function> new_func(new ir::Function(*result->begin()));
+  new_func->ForEachInst(
+      [image_bound, &new_ids, next_id](ir::Instruction* inst) {
+        const uint32_t id = inst->result_id();
+        if (id >= image_bound && new_ids[id - image_bound] == 0)
+          new_ids[id - image_bound] = (*next_id)++;
+      },
+      true);
+  new_func->ForEachInst(
+      [&remap](ir::Instruction* inst) { inst->ForEachId(remap); }, true);
+  new_func->SetParent(module);
+  for (auto fi = module->begin(); fi != module->end(); ++fi) {
+    if (&*fi != task->func) continue;
+    fi = fi.Erase();
+    fi.InsertBefore(std::move(new_func));
+    break;
+  }
+
+  const std::vector<ir::Instruction*> none;
+  const auto local_names = index.local_names.find(task->func);
+  MergeNames(local_names != index.local_names.end() ? local_names->second
+                                                    : none,
+             result->debugs2(), remap,
+             [module](std::unique_ptr<ir::Instruction> inst) {
+               module->AddDebug2Inst(std::move(inst));
+             });
+  const auto local_annotations = index.local_annotations.find(task->func);
+  MergeNames(local_annotations != index.local_annotations.end()
+                 ? local_annotations->second
+                 : none,
+             result->annotations(), remap,
+             [module](std::unique_ptr<ir::Instruction> inst) {
+               module->AddAnnotationInst(std::move(inst));
+             });
+}
+
+}  // namespace
+
+uint32_t TargetId(const ir::Instruction& inst) {
+  return inst.NumInOperands() == 0 ? 0 : inst.GetSingleWordInOperand(0);
+}
+
+ModuleIndex IndexModule(ir::Module* module) {
+  ModuleIndex index;
+  auto add_global = [&index](const ir::Instruction& inst) {
+    index.positions[inst.result_id()] = index.globals.size();
+    index.globals[inst.result_id()] = &inst;
+  };
+  for (auto& inst : module->ext_inst_imports()) add_global(inst);
+  for (auto& inst : module->debugs1())
+    if (inst.opcode() == SpvOpString) add_global(inst);
+  for (auto& inst : module->types_values())
+    if (inst.result_id() != 0) add_global(inst);
+
+  for (auto& func : *module) {
+    ir::Function* owner = &func;
+    func.ForEachInst([owner, &index](ir::Instruction* inst) {
+      if (inst->result_id() != 0) index.owners[inst->result_id()] = owner;
+    });
+  }
+  for (auto& inst : module->debugs2()) {
+    const auto owner = index.owners.find(TargetId(inst));
+    if (owner != index.owners.end())
+      index.local_names[owner->second].push_back(&inst);
+    else
+      index.global_names.push_back(&inst);
+  }
+  for (auto& inst : module->annotations()) {
+    const auto owner = index.owners.find(TargetId(inst));
+    if (owner != index.owners.end()) {
+      index.local_annotations[owner->second].push_back(&inst);
+      continue;
+    }
+    index.global_annotations.push_back(&inst);
+    if (TargetId(inst) != 0)
+      index.annotations_of[TargetId(inst)].push_back(&inst);
+  }
+  return index;
+}
+
+std::unique_ptr<ir::Module> BuildFunctionImage(const ir::Module& module,
+                                               const ModuleIndex& index,
+                                               const ir::Function& func) {
+  // Find the globals and the callees |func| refers to, directly or through
+  // other globals and decorations.
+  std::unordered_set<uint32_t> needed;
+  std::vector<uint32_t> worklist;
+  std::vector<const ir::Function*> callees;
+  std::unordered_set<uint32_t> callee_ids;
+  auto add_global = [&index, &needed, &worklist](uint32_t id) {
+    if (index.globals.count(id) != 0 && needed.insert(id).second)
+      worklist.push_back(id);
+  };
+  auto use = [&](const uint32_t* id) {
+    const auto owner = index.owners.find(*id);
+    if (owner == index.owners.end()) {
+      add_global(*id);
+      return;
+    }
+    const ir::Function* callee = owner->second;
+    if (callee == &func || callee->result_id() != *id ||
+        !callee_ids.insert(*id).second)
+      return;
+    callees.push_back(callee);
+    add_global(callee->type_id());
+    add_global(callee->DefInst().GetSingleWordInOperand(1));
+    callee->ForEachParam([&add_global](const ir::Instruction* param) {
+      add_global(param->type_id());
+    });
+  };
+  func.ForEachInst(
+      [&use](const ir::Instruction* inst) { inst->ForEachId(use); }, true);
+  std::vector<const ir::Instruction*> entry_points;
+  std::vector<const ir::Instruction*> execution_modes;
+  for (auto& inst : module.entry_points()) {
+    if (inst.GetSingleWordInOperand(1) != func.result_id()) continue;
+    entry_points.push_back(&inst);
+    inst.ForEachId(use);
+  }
+  for (auto& inst : module.execution_modes())
+    if (TargetId(inst) == func.result_id()) execution_modes.push_back(&inst);
+  const auto local_annotations = index.local_annotations.find(&func);
+  if (local_annotations != index.local_annotations.end())
+    for (auto* inst : local_annotations->second) inst->ForEachId(use);
+  while (!worklist.empty()) {
+    const uint32_t id = worklist.back();
+    worklist.pop_back();
+    index.globals.at(id)->ForEachId(use);
+    const auto annotations = index.annotations_of.find(id);
+    if (annotations != index.annotations_of.end())
+      for (auto* inst : annotations->second) inst->ForEachId(use);
+  }
+  std::vector<uint32_t> globals(needed.begin(), needed.end());
+  std::sort(globals.begin(), globals.end(),
+            [&index](uint32_t a, uint32_t b) {
+              return index.positions.at(a) < index.positions.at(b);
+            });
+
+  std::unique_ptr<ir::Module> copy(new ir::Module());
+  copy->SetHeader({SpvMagicNumber, module.version(), 0, module.id_bound(), 0});
+  for (auto& inst : module.capabilities())
+    copy->AddCapability(MakeUnique<ir::Instruction>(inst));
+  for (auto& inst : module.extensions())
+    copy->AddExtension(MakeUnique<ir::Instruction>(inst));
+  if (module.GetMemoryModel() != nullptr)
+    copy->SetMemoryModel(MakeUnique<ir::Instruction>(*module.GetMemoryModel()));
+  for (auto* inst : entry_points)
+    copy->AddEntryPoint(MakeUnique<ir::Instruction>(*inst));
+  for (auto* inst : execution_modes)
+    copy->AddExecutionMode(MakeUnique<ir::Instruction>(*inst));
+  const auto local_names = index.local_names.find(&func);
+  if (local_names != index.local_names.end())
+    for (auto* inst : local_names->second)
+      copy->AddDebug2Inst(MakeUnique<ir::Instruction>(*inst));
+  if (local_annotations != index.local_annotations.end())
+    for (auto* inst : local_annotations->second)
+      copy->AddAnnotationInst(MakeUnique<ir::Instruction>(*inst));
+  for (uint32_t id : globals) {
+    const ir::Instruction& inst = *index.globals.at(id);
+    if (inst.opcode() == SpvOpExtInstImport)
+      copy->AddExtInstImport(MakeUnique<ir::Instruction>(inst));
+    else if (inst.opcode() == SpvOpString)
+      copy->AddDebug1Inst(MakeUnique<ir::Instruction>(inst));
+    else
+      copy->AddGlobalValue(MakeUnique<ir::Instruction>(inst));
+    const auto annotations = index.annotations_of.find(id);
+    if (annotations != index.annotations_of.end())
+      for (auto* annotation : annotations->second)
+        copy->AddAnnotationInst(MakeUnique<ir::Instruction>(*annotation));
+  }
+  std::unique_ptr<ir::Function> func_copy(new ir::Function(func));
+  func_copy->SetParent(copy.get());
+  copy->AddFunction(std::move(func_copy));
+  for (auto* callee : callees) {
+    std::unique_ptr<ir::Function> decl = callee->CloneDeclaration();
+    decl->SetParent(copy.get());
+    copy->AddFunction(std::move(decl));
+  }
+  return copy;
+}
+
+std::vector<FunctionTask> CollectFunctionTasks(
+    Pass* pass, ir::IRContext* context,
+    const std::unordered_set<uint32_t>* skipped) {
+  std::unordered_set<const ir::Function*> reachable;
+  std::unordered_set<const ir::Function*> from_entry_points;
+  Pass::ProcessFunction mark_reachable = [&reachable](ir::Function* fp) {
+    reachable.insert(fp);
+    return false;
+  };
+  Pass::ProcessFunction mark_from_entry_points =
+      [&from_entry_points](ir::Function* fp) {
+        from_entry_points.insert(fp);
+        return false;
+      };
+  pass->ProcessReachableCallTree(mark_reachable, context);
+  pass->ProcessEntryPointCallTree(mark_from_entry_points, context->module());
+
+  std::vector<FunctionTask> tasks;
+  for (auto& fn : *context->module()) {
+    if (reachable.count(&fn) == 0 ||
+        (skipped != nullptr && skipped->count(fn.result_id()) != 0))
+      continue;
+    tasks.emplace_back();
+    FunctionTask& task = tasks.back();
+    task.func = &fn;
+    task.called_from_entry_points = from_entry_points.count(&fn) != 0;
+    task.size = 0;
+    fn.ForEachInst([&task](ir::Instruction*) { ++task.size; });
+    task.image_bound = 0;
+    task.status = Pass::Status::SuccessWithoutChange;
+  }
+  return tasks;
+}
+
+void RunFunctionTasks(std::vector<FunctionTask>* tasks, uint32_t num_threads,
+                      const std::function<void(FunctionTask*)>& run) {
+  std::vector<FunctionTask*> order;
+  for (auto& task : *tasks) order.push_back(&task);
+  std::stable_sort(order.begin(), order.end(),
+                   [](const FunctionTask* a, const FunctionTask* b) {
+                     return a->size > b->size;
+                   });
+  std::atomic<size_t> next_task(0);
+  auto worker = [&]() {
+    for (size_t i = next_task++; i < order.size(); i = next_task++)
+      run(order[i]);
+  };
+  const size_t num_workers = std::min<size_t>(num_threads, order.size());
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; ++i) workers.emplace_back(worker);
+  worker();
+  for (auto& t : workers) t.join();
+}
+
+Pass::Status RunFunctionLocalPasses(const std::vector<Pass*>& passes,
+                                    uint32_t func_id,
+                                    bool called_from_entry_points,
+                                    ir::IRContext* context) {
+  auto status = Pass::Status::SuccessWithoutChange;
+  for (auto* pass : passes) {
+    std::unique_ptr<Pass> clone = pass->CloneFunctionLocal();
+    clone->SetMessageConsumer(pass->consumer());
+    clone->RestrictToFunction(func_id, called_from_entry_points);
+    const auto one_status = clone->Process(context);
+    if (one_status == Pass::Status::Failure) return one_status;
+    if (one_status == Pass::Status::SuccessWithChange) {
+      status = one_status;
+      context->InvalidateDominatorAnalyses();
+    }
+  }
+  return status;
+}
+
+void SetFunctionTaskResult(const ir::Module& image, FunctionTask* task) {
+  const uint32_t image_bound = task->image_bound;
+  std::unique_ptr<ir::Module> result(new ir::Module());
+  for (auto& inst : image.capabilities())
+    result->AddCapability(MakeUnique<ir::Instruction>(inst));
+  for (auto& inst : image.extensions())
+    result->AddExtension(MakeUnique<ir::Instruction>(inst));
+  for (auto& inst : image.ext_inst_imports())
+    if (inst.result_id() >= image_bound)
+      result->AddExtInstImport(MakeUnique<ir::Instruction>(inst));
+  // Passes may leave OpNop in place of the globals they removed.
+  for (auto& inst : image.types_values())
+    if (inst.opcode() != SpvOpNop && inst.result_id() >= image_bound)
+      result->AddGlobalValue(MakeUnique<ir::Instruction>(inst));
+
+  const ir::Function& func = *image.cbegin();
+  std::unordered_set<uint32_t> local_ids;
+  func.ForEachInst(
+      [&local_ids](const ir::Instruction* inst) {
+        if (inst->result_id() != 0) local_ids.insert(inst->result_id());
+      },
+      true);
+  for (auto& inst : image.debugs2())
+    if (local_ids.count(TargetId(inst)) != 0)
+      result->AddDebug2Inst(MakeUnique<ir::Instruction>(inst));
+  for (auto& inst : image.annotations())
+    if (local_ids.count(TargetId(inst)) != 0)
+      result->AddAnnotationInst(MakeUnique<ir::Instruction>(inst));
+  std::unique_ptr<ir::Function> func_copy(new ir::Function(func));
+  func_copy->SetParent(result.get());
+  result->AddFunction(std::move(func_copy));
+
+  task->result = std::move(result);
+  task->status = Pass::Status::SuccessWithChange;
+}
+
+Pass::Status MergeFunctionTasks(std::vector<FunctionTask>* tasks,
+                                const ModuleIndex& index,
+                                ir::IRContext* context) {
+  auto status = Pass::Status::SuccessWithoutChange;
+  for (auto& task : *tasks) {
+    if (task.status == Pass::Status::Failure) return task.status;
+    if (task.status == Pass::Status::SuccessWithChange) status = task.status;
+  }
+  if (status == Pass::Status::SuccessWithoutChange) return status;
+
+  ir::Module* module = context->module();
+  std::map<std::vector<uint32_t>, uint32_t> global_ids;
+  for (auto& inst : module->types_values()) {
+    if (inst.result_id() == 0 || inst.opcode() == SpvOpVariable ||
+        index.annotations_of.count(inst.result_id()) != 0)
+      continue;
+    global_ids.insert({GlobalKey(inst), inst.result_id()});
+  }
+  uint32_t next_id = std::max(module->id_bound(), module->ComputeIdBound());
+  for (auto& task : *tasks)
+    if (task.status == Pass::Status::SuccessWithChange)
+      MergeFunctionTask(module, index, &task, &next_id, &global_ids);
+  context->SetIdBound(next_id);
+  return status;
+}
+
+}  // namespace opt
+}  // namespace spvtools
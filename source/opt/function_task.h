@@ -0,0 +1,137 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_FUNCTION_TASK_H_
+#define LIBSPIRV_OPT_FUNCTION_TASK_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ir_context.h"
+#include "module.h"
+#include "pass.h"
+
+// Running function-local passes on each function of a module separately, in
+// a module of its own called the image of the function, and merging the
+// results back into the module. How the image is built is left to the
+// caller.
+
+namespace spvtools {
+namespace opt {
+
+// The instructions of a module that relate to its functions.
+struct ModuleIndex {
+  // The instructions defining the ids of extended instruction sets, strings,
+  // types, constants and global variables, and their position in the module.
+  std::unordered_map<uint32_t, const ir::Instruction*> globals;
+  std::unordered_map<uint32_t, size_t> positions;
+  // The function defining each id defined in a function, including the ids
+  // of the functions themselves.
+  std::unordered_map<uint32_t, ir::Function*> owners;
+  // The names and decorations of the ids defined in each function.
+  std::unordered_map<const ir::Function*, std::vector<ir::Instruction*>>
+      local_names;
+  std::unordered_map<const ir::Function*, std::vector<ir::Instruction*>>
+      local_annotations;
+  // The names and decorations of the other ids, and the decorations of each
+  // of these ids.
+  std::vector<const ir::Instruction*> global_names;
+  std::vector<const ir::Instruction*> global_annotations;
+  std::unordered_map<uint32_t, std::vector<const ir::Instruction*>>
+      annotations_of;
+};
+
+// The work of function-local passes on one function of a module.
+struct FunctionTask {
+  // The function in the module, and whether the entry points call it.
+  ir::Function* func;
+  bool called_from_entry_points;
+  // Number of instructions of |func|.
+  size_t size;
+
+  // The ids of the image below |image_bound| stand for the ids of the module
+  // in |original_ids|, or for themselves if it is empty. The ids from
+  // |image_bound| on were allocated by the passes.
+  std::vector<uint32_t> original_ids;
+  uint32_t image_bound;
+
+  // The status returned by the passes and, if they changed the image, what
+  // of it goes back to the module: the function, capabilities, extensions,
+  // and the new extended instruction sets, types, constants and global
+  // variables, and the names and decorations of the ids of the function.
+  Pass::Status status;
+  std::unique_ptr<ir::Module> result;
+};
+
+// Returns the target of the name or decoration |inst|, or 0.
+uint32_t TargetId(const ir::Instruction& inst);
+
+// Returns the index of |module|.
+ModuleIndex IndexModule(ir::Module* module);
+
+// Returns the image of |func|, a function of |module| indexed by |index|,
+// with the ids of |module| and its id bound. The image holds |func|, the
+// declarations of its callees, and only the parts of |module| that these
+// refer to, directly or through other globals and decorations, so that its
+// size does not grow with the globals used by other functions. These parts
+// are the capabilities, extensions and memory model, the entry points and
+// execution modes of |func|, the names and decorations of its ids, and the
+// extended instruction sets, strings, types, constants and global variables
+// it uses, with their decorations.
+std::unique_ptr<ir::Module> BuildFunctionImage(const ir::Module& module,
+                                               const ModuleIndex& index,
+                                               const ir::Function& func);
+
+// Returns the tasks for the functions of the module of |context| that the
+// function-local |pass| processes, in the order of the module, except for
+// those whose ids are in |skipped| if it is not null.
+std::vector<FunctionTask> CollectFunctionTasks(
+    Pass* pass, ir::IRContext* context,
+    const std::unordered_set<uint32_t>* skipped);
+
+// Calls |run| on each of |tasks| using up to |num_threads| threads. Each
+// thread takes the largest task not yet taken, so that a large function
+// started late does not leave the other threads idle.
+void RunFunctionTasks(std::vector<FunctionTask>* tasks, uint32_t num_threads,
+                      const std::function<void(FunctionTask*)>& run);
+
+// Runs clones of the function-local |passes| in order on the function
+// |func_id| of the module of |context|, which the entry points call if
+// |called_from_entry_points|. Stops at the first failure.
+Pass::Status RunFunctionLocalPasses(const std::vector<Pass*>& passes,
+                                    uint32_t func_id,
+                                    bool called_from_entry_points,
+                                    ir::IRContext* context);
+
+// Sets the result of |task| from |image|, the image of its function after
+// the passes changed it. The function must be the first one of |image|.
+void SetFunctionTaskResult(const ir::Module& image, FunctionTask* task);
+
+// Merges the results of the changed |tasks| into the module of |context|,
+// indexed by |index|, in the order of the tasks. The ids the passes
+// allocated are renumbered from the id bound of the module, except that a
+// new type or constant reuses the id of an identical undecorated one of the
+// module or of one added before. Returns the status of the tasks together.
+Pass::Status MergeFunctionTasks(std::vector<FunctionTask>* tasks,
+                                const ModuleIndex& index,
+                                ir::IRContext* context);
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_FUNCTION_TASK_H_
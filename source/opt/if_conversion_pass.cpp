@@ -0,0 +1,338 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "if_conversion_pass.h"
+
+#include <algorithm>
+
+#include "ir_context.h"
+#include "opcode.h"
+#include "spirv/1.0/GLSL.std.450.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kBranchTargetLabIdInIdx = 0;
+const uint32_t kBranchCondConditionalIdInIdx = 0;
+const uint32_t kBranchCondTrueLabIdInIdx = 1;
+const uint32_t kBranchCondFalseLabIdInIdx = 2;
+const uint32_t kSelectionMergeMergeBlockIdInIdx = 0;
+const uint32_t kTypeVectorComponentTypeInIdx = 0;
+const uint32_t kTypeVectorCountInIdx = 1;
+const uint32_t kExtInstSetIdInIdx = 0;
+const uint32_t kExtInstInstructionInIdx = 1;
+
+// Returns the value of |phi| coming from the block labeled |label|, or 0.
+uint32_t PhiValue(const ir::Instruction* phi, uint32_t label) {
+  for (uint32_t i = 1; i < phi->NumInOperands(); i += 2)
+    if (phi->GetSingleWordInOperand(i) == label)
+      return phi->GetSingleWordInOperand(i - 1);
+  return 0;
+}
+
+}  // anonymous namespace
+
+bool IfConversionPass::IsSpeculatable(const ir::Instruction* inst) const {
+  if (inst->opcode() == SpvOpExtInst) {
+    if (glsl_std_450_id_ == 0 ||
+        inst->GetSingleWordInOperand(kExtInstSetIdInIdx) != glsl_std_450_id_)
+      return false;
+    // These write through a pointer or depend on the active invocations.
+    switch (inst->GetSingleWordInOperand(kExtInstInstructionInIdx)) {
+      case GLSLstd450Modf:
+      case GLSLstd450Frexp:
+      case GLSLstd450InterpolateAtCentroid:
+      case GLSLstd450InterpolateAtSample:
+      case GLSLstd450InterpolateAtOffset:
+        return false;
+      default:
+        return true;
+    }
+  }
+  // Integer division may be guarded by a test of its divisor.
+  switch (inst->opcode()) {
+    case SpvOpNop:
+    case SpvOpUndef:
+    case SpvOpCopyObject:
+      return true;
+    default:
+      return spvOpcodeIsPure(inst->opcode()) &&
+             !spvOpcodeMayBeUndefined(inst->opcode());
+  }
+}
+
+bool IfConversionPass::IsSelectableType(uint32_t typeId) const {
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  switch (typeInst->opcode()) {
+    case SpvOpTypeBool:
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+    case SpvOpTypeVector:
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool IfConversionPass::GetArm(ir::BasicBlock* header, uint32_t target,
+                              uint32_t mergeId, ir::BasicBlock** arm,
+                              uint32_t* size) {
+  if (target == mergeId) {
+    *arm = nullptr;
+    return true;
+  }
+  ir::BasicBlock* bp = blocks_[target];
+  const auto& preds = preds_[target];
+  if (preds.size() != 1 || preds[0] != header->id()) return false;
+  const ir::Instruction* br = &*bp->tail();
+  if (br->opcode() != SpvOpBranch ||
+      br->GetSingleWordInOperand(kBranchTargetLabIdInIdx) != mergeId)
+    return false;
+  // The block must not be the merge block or continue target of another
+  // construct.
+  const ir::Instruction* headerBr = &*header->tail();
+  for (const auto& u : *get_def_use_mgr()->GetUses(target)) {
+    const SpvOp op = u.inst->opcode();
+    if (op != SpvOpName && op != SpvOpPhi && u.inst != headerBr) return false;
+  }
+  for (auto ii = bp->begin(); &*ii != br; ++ii) {
+    if (!IsSpeculatable(&*ii)) return false;
+    ++*size;
+  }
+  *arm = bp;
+  return true;
+}
+
+uint32_t IfConversionPass::GetBoolVectorType(uint32_t boolTypeId,
+                                             uint32_t count) {
+  for (auto& inst : get_module()->types_values())
+    if (inst.opcode() == SpvOpTypeVector &&
+        inst.GetSingleWordInOperand(kTypeVectorComponentTypeInIdx) ==
+            boolTypeId &&
+        inst.GetSingleWordInOperand(kTypeVectorCountInIdx) == count)
+      return inst.result_id();
+  const uint32_t resultId = TakeNextId();
+  std::unique_ptr<ir::Instruction> typeInst(new ir::Instruction(
+      SpvOpTypeVector, 0, resultId,
+      {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {boolTypeId}},
+       {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER, {count}}}));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*typeInst);
+  context()->AddType(std::move(typeInst));
+  return resultId;
+}
+
+void IfConversionPass::InsertInstBefore(
+    ir::Instruction* pos, std::unique_ptr<ir::Instruction> newInst) {
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newInst);
+  (void)ir::BasicBlock::iterator(pos).InsertBefore(std::move(newInst));
+}
+
+bool IfConversionPass::ConvertSelection(ir::Function* func,
+                                        ir::BasicBlock* header) {
+  ir::Instruction* mergeInst = header->GetMergeInst();
+  ir::Instruction* br = &*header->tail();
+  if (mergeInst == nullptr || mergeInst->opcode() != SpvOpSelectionMerge ||
+      br->opcode() != SpvOpBranchConditional)
+    return false;
+  const uint32_t mergeId =
+      mergeInst->GetSingleWordInOperand(kSelectionMergeMergeBlockIdInIdx);
+  const uint32_t trueId = br->GetSingleWordInOperand(kBranchCondTrueLabIdInIdx);
+  const uint32_t falseId =
+      br->GetSingleWordInOperand(kBranchCondFalseLabIdInIdx);
+  if (trueId == falseId) return false;
+  ir::BasicBlock* trueArm = nullptr;
+  ir::BasicBlock* falseArm = nullptr;
+  uint32_t size = 0;
+  if (!GetArm(header, trueId, mergeId, &trueArm, &size) ||
+      !GetArm(header, falseId, mergeId, &falseArm, &size) ||
+      size > size_limit_)
+    return false;
+
+  // The merge block must only be reached through the arms, so that its phis
+  // choose between the values of the two arms.
+  const uint32_t truePred = trueArm != nullptr ? trueId : header->id();
+  const uint32_t falsePred = falseArm != nullptr ? falseId : header->id();
+  const auto& mergePreds = preds_[mergeId];
+  if (mergePreds.size() != 2 ||
+      std::find(mergePreds.begin(), mergePreds.end(), truePred) ==
+          mergePreds.end() ||
+      std::find(mergePreds.begin(), mergePreds.end(), falsePred) ==
+          mergePreds.end())
+    return false;
+  ir::BasicBlock* merge = blocks_[mergeId];
+  bool selectable = true;
+  merge->ForEachPhiInst([&selectable, this](ir::Instruction* phi) {
+    selectable = selectable && IsSelectableType(phi->type_id());
+  });
+  if (!selectable) return false;
+
+  // The instructions of the arms are moved before the selection, followed
+  // by the phis turned into OpSelects.
+  for (auto arm : {trueArm, falseArm}) {
+    if (arm == nullptr) continue;
+    for (auto ii = arm->begin(); &*ii != &*arm->tail();) {
+      ir::Instruction* inst = &*ii;
+      ++ii;
+      inst->InsertBefore(mergeInst);
+    }
+  }
+  const uint32_t condId =
+      br->GetSingleWordInOperand(kBranchCondConditionalIdInIdx);
+  const uint32_t boolTypeId = get_def_use_mgr()->GetDef(condId)->type_id();
+  // Vectors are selected by a vector of booleans of the same size.
+  std::unordered_map<uint32_t, uint32_t> condVectors;
+  for (auto ii = merge->begin(); ii->opcode() == SpvOpPhi;) {
+    ir::Instruction* phi = &*ii;
+    ++ii;
+    uint32_t selectCondId = condId;
+    const ir::Instruction* typeInst =
+        get_def_use_mgr()->GetDef(phi->type_id());
+    if (typeInst->opcode() == SpvOpTypeVector) {
+      const uint32_t count =
+          typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx);
+      uint32_t& vectorId = condVectors[count];
+      if (vectorId == 0) {
+        vectorId = TakeNextId();
+        std::vector<ir::Operand> operands(
+            count,
+            ir::Operand(spv_operand_type_t::SPV_OPERAND_TYPE_ID, {condId}));
+        InsertInstBefore(mergeInst,
+                         std::unique_ptr<ir::Instruction>(new ir::Instruction(
+                             SpvOpCompositeConstruct,
+                             GetBoolVectorType(boolTypeId, count), vectorId,
+                             operands)));
+      }
+      selectCondId = vectorId;
+    }
+    // The names and decorations of the phi are moved to the OpSelect.
+    const uint32_t selectId = TakeNextId();
+    InsertInstBefore(
+        mergeInst,
+        std::unique_ptr<ir::Instruction>(new ir::Instruction(
+            SpvOpSelect, phi->type_id(), selectId,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {selectCondId}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+              {PhiValue(phi, truePred)}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+              {PhiValue(phi, falsePred)}}})));
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(phi->result_id(), selectId);
+    get_def_use_mgr()->KillInst(phi);
+    (void)ir::BasicBlock::iterator(phi).Erase();
+  }
+
+  // The header now branches to the merge block, and the arms are removed.
+  get_def_use_mgr()->KillInst(mergeInst);
+  (void)ir::BasicBlock::iterator(mergeInst).Erase();
+  get_def_use_mgr()->KillInst(br);
+  (void)ir::BasicBlock::iterator(br).Erase();
+  std::unique_ptr<ir::Instruction> newBr(new ir::Instruction(
+      SpvOpBranch, 0, 0, {{spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                           {mergeId}}}));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newBr);
+  header->AddInstruction(std::move(newBr));
+  std::unordered_set<uint32_t> deadBlocks;
+  for (auto arm : {trueArm, falseArm}) {
+    if (arm == nullptr) continue;
+    get_def_use_mgr()->KillInst(&*arm->tail());
+    KillNamesAndDecorates(arm->GetLabelInst());
+    get_def_use_mgr()->KillInst(arm->GetLabelInst());
+    deadBlocks.insert(arm->id());
+  }
+
+  // The merge block is merged into the header when it is not a merge block
+  // or continue target of another construct. The phis of its successors
+  // then refer to the header.
+  bool mergeable = true;
+  for (const auto& u : *get_def_use_mgr()->GetUses(mergeId)) {
+    const SpvOp op = u.inst->opcode();
+    if (op != SpvOpName && op != SpvOpPhi && op != SpvOpBranch)
+      mergeable = false;
+  }
+  if (mergeable) {
+    KillNamesAndDecorates(mergeId);
+    get_def_use_mgr()->KillInst(&*header->tail());
+    (void)header->tail().Erase();
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(mergeId, header->id());
+    header->AddInstructions(merge);
+    get_def_use_mgr()->KillInst(merge->GetLabelInst());
+    deadBlocks.insert(mergeId);
+  }
+  for (auto bi = func->begin(); bi != func->end();) {
+    if (deadBlocks.count(bi->id()) != 0)
+      bi = bi.Erase();
+    else
+      ++bi;
+  }
+  return true;
+}
+
+bool IfConversionPass::ConvertSelections(ir::Function* func) {
+  bool modified = false;
+  // The selections are looked for again after each conversion, so that a
+  // selection whose arm contained a converted selection can be converted in
+  // turn.
+  for (bool changed = true; changed;) {
+    changed = false;
+    blocks_.clear();
+    preds_.clear();
+    for (auto& blk : *func) {
+      blocks_[blk.id()] = &blk;
+      const uint32_t blkId = blk.id();
+      blk.ForEachSuccessorLabel(
+          [blkId, this](uint32_t succ) { preds_[succ].push_back(blkId); });
+    }
+    for (auto& blk : *func) {
+      if (ConvertSelection(func, &blk)) {
+        changed = true;
+        break;
+      }
+    }
+    modified = modified || changed;
+  }
+  if (modified) context()->InvalidateDominatorAnalyses();
+  return modified;
+}
+
+void IfConversionPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+
+  glsl_std_450_id_ = get_module()->GetExtInstImportId("GLSL.std.450");
+}
+
+Pass::Status IfConversionPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return ConvertSelections(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+IfConversionPass::IfConversionPass(uint32_t size_limit)
+    : size_limit_(size_limit), glsl_std_450_id_(0) {}
+
+Pass::Status IfConversionPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,92 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_IF_CONVERSION_PASS_H_
+#define LIBSPIRV_OPT_IF_CONVERSION_PASS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class IfConversionPass : public MemPass {
+ public:
+  explicit IfConversionPass(uint32_t size_limit);
+  const char* name() const override { return "if-conversion"; }
+  Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new IfConversionPass(size_limit_));
+  }
+
+ private:
+  // Returns true if |inst| has no side effect and can be executed whatever
+  // the value of the condition of the selection it is moved out of.
+  bool IsSpeculatable(const ir::Instruction* inst) const;
+
+  // Returns true if values of type |typeId| can be chosen by an OpSelect.
+  bool IsSelectableType(uint32_t typeId) const;
+
+  // Returns true if the branch of |header| to |target| leads to the merge
+  // block |mergeId|, either directly or through a block whose only
+  // predecessor is |header| and whose instructions are speculatable. Sets
+  // |arm| to that block, or to null for a direct branch, and adds the number
+  // of its instructions to |size|.
+  bool GetArm(ir::BasicBlock* header, uint32_t target, uint32_t mergeId,
+              ir::BasicBlock** arm, uint32_t* size);
+
+  // Returns the id of the type of vectors of |count| booleans of type
+  // |boolTypeId|, adding it to the module if needed.
+  uint32_t GetBoolVectorType(uint32_t boolTypeId, uint32_t count);
+
+  // Inserts |newInst| before |pos| and records its definitions and uses.
+  void InsertInstBefore(ir::Instruction* pos,
+                        std::unique_ptr<ir::Instruction> newInst);
+
+  // Converts the selection headed by |header| into OpSelects when its arms
+  // are small and speculatable and its merge block is only reached from
+  // them, then merges the merge block into |header| if possible. Returns
+  // true if |func| is modified.
+  bool ConvertSelection(ir::Function* func, ir::BasicBlock* header);
+
+  // Converts the selections of |func|, inner selections first. Returns true
+  // if |func| is modified.
+  bool ConvertSelections(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Maximum number of instructions moved out of the arms of a selection.
+  uint32_t size_limit_;
+
+  // Blocks of the current function, and their predecessors.
+  std::unordered_map<uint32_t, ir::BasicBlock*> blocks_;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> preds_;
+
+  // Id of the GLSL.std.450 extended instruction set, or 0.
+  uint32_t glsl_std_450_id_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_IF_CONVERSION_PASS_H_
@@ -19,54 +19,6 @@
 namespace spvtools {
 namespace opt {
 
-namespace {
-
-  const uint32_t kTypePointerTypeIdInIdx = 1;
-
-} // anonymous namespace
-
-bool InlineOpaquePass::IsOpaqueType(uint32_t typeId) {
-  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
-  switch (typeInst->opcode()) {
-    case SpvOpTypeSampler:
-    case SpvOpTypeImage:
-    case SpvOpTypeSampledImage:
-      return true;
-    case SpvOpTypePointer:
-      return IsOpaqueType(typeInst->GetSingleWordInOperand(
-          kTypePointerTypeIdInIdx));
-    default:
-      break;
-  }
-  // TODO(greg-lunarg): Handle arrays containing opaque type
-  if (typeInst->opcode() != SpvOpTypeStruct)
-    return false;
-  // Return true if any member is opaque
-  int ocnt = 0;
-  typeInst->ForEachInId([&ocnt,this](const uint32_t* tid) {
-    if (ocnt == 0 && IsOpaqueType(*tid)) ++ocnt;
-  });
-  return ocnt > 0;
-}
-
-bool InlineOpaquePass::HasOpaqueArgsOrReturn(const ir::Instruction* callInst) {
-  // Check return type
-  if (IsOpaqueType(callInst->type_id()))
-    return true;
-  // Check args
-  int icnt = 0;
-  int ocnt = 0;
-  callInst->ForEachInId([&icnt,&ocnt,this](const uint32_t *iid) {
-    if (icnt > 0) {
-      const ir::Instruction* argInst = get_def_use_mgr()->GetDef(*iid);
-      if (IsOpaqueType(argInst->type_id()))
-        ++ocnt;
-    }
-    ++icnt;
-  });
-  return ocnt > 0;
-}
-
 bool InlineOpaquePass::InlineOpaque(ir::Function* func) {
   bool modified = false;
   // Using block iterators here because of block erasures and insertions.
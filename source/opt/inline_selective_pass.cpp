@@ -0,0 +1,177 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "inline_selective_pass.h"
+
+#include "opcode.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+
+// Number of instructions of the callee assumed to fold away for each
+// constant argument of a call.
+const int32_t kConstantArgBonus = 4;
+
+}  // anonymous namespace
+
+uint32_t InlineSelectivePass::FunctionSize(ir::Function* func) const {
+  uint32_t size = 0;
+  for (auto& blk : *func)
+    for (auto& inst : blk)
+      if (inst.opcode() != SpvOpNop) ++size;
+  return size;
+}
+
+void InlineSelectivePass::PostOrderCallees(
+    uint32_t funcId, std::unordered_set<uint32_t>* visited,
+    std::vector<ir::Function*>* order) {
+  if (!visited->insert(funcId).second) return;
+  ir::Function* func = id2function_[funcId];
+  for (auto& blk : *func) {
+    for (auto& inst : blk) {
+      if (inst.opcode() != SpvOpFunctionCall) continue;
+      const uint32_t calleeId =
+          inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+      ++call_count_[calleeId];
+      PostOrderCallees(calleeId, visited, order);
+    }
+  }
+  order->push_back(func);
+}
+
+void InlineSelectivePass::BuildCallGraph() {
+  std::unordered_set<uint32_t> visited;
+  for (auto& e : get_module()->entry_points()) {
+    const uint32_t funcId =
+        e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx);
+    entry_points_.insert(funcId);
+    PostOrderCallees(funcId, &visited, &bottom_up_order_);
+  }
+  uint64_t moduleSize = 0;
+  for (auto func : bottom_up_order_) {
+    const uint32_t size = FunctionSize(func);
+    function_size_[func->result_id()] = size;
+    moduleSize += size;
+  }
+  budget_ = static_cast<uint32_t>(moduleSize * growth_percent_ / 100);
+}
+
+bool InlineSelectivePass::ShouldInline(const ir::Instruction* callInst) {
+  // Opaque values cannot be stored, so these calls must go away.
+  if (HasOpaqueArgsOrReturn(callInst)) return true;
+  const uint32_t calleeId =
+      callInst->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+  const int32_t calleeSize = static_cast<int32_t>(function_size_[calleeId]);
+  // The call and its arguments are replaced by the body of the callee.
+  int32_t growth = calleeSize - static_cast<int32_t>(callInst->NumInOperands());
+  // The callee is dead once its only call is inlined.
+  if (call_count_[calleeId] == 1 && entry_points_.count(calleeId) == 0)
+    growth -= calleeSize;
+  // Constant arguments let some of the inlined code fold away.
+  for (uint32_t i = 1; i < callInst->NumInOperands(); ++i) {
+    const ir::Instruction* argInst =
+        get_def_use_mgr()->GetDef(callInst->GetSingleWordInOperand(i));
+    if (spvOpcodeIsConstant(argInst->opcode())) growth -= kConstantArgBonus;
+  }
+  if (growth <= 0) return true;
+  if (static_cast<uint32_t>(growth) > budget_) return false;
+  budget_ -= static_cast<uint32_t>(growth);
+  return true;
+}
+
+bool InlineSelectivePass::InlineSelective(ir::Function* func) {
+  bool modified = false;
+  // Using block iterators here because of block erasures and insertions.
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    for (auto ii = bi->begin(); ii != bi->end();) {
+      if (IsInlinableFunctionCall(&*ii) && ShouldInline(&*ii)) {
+        // The calls of the callee are copied into the caller.
+        const uint32_t calleeId =
+            ii->GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+        --call_count_[calleeId];
+        for (auto& blk : *id2function_[calleeId])
+          for (auto& inst : blk)
+            if (inst.opcode() == SpvOpFunctionCall)
+              ++call_count_[inst.GetSingleWordInOperand(
+                  kFunctionCallFunctionIdInIdx)];
+        // Inline call.
+        std::vector<std::unique_ptr<ir::BasicBlock>> newBlocks;
+        std::vector<std::unique_ptr<ir::Instruction>> newVars;
+        GenInlineCode(&newBlocks, &newVars, ii, bi);
+        // If call block is replaced with more than one block, point
+        // succeeding phis at new last block.
+        if (newBlocks.size() > 1)
+          UpdateSucceedingPhis(newBlocks);
+        // Replace old calling block with new block(s). The def-use manager
+        // is used to look at the arguments of later calls, so it forgets
+        // the instructions of the old block and learns the new ones.
+        bi->ForEachInst([this](ir::Instruction* inst) {
+          get_def_use_mgr()->KillInst(inst);
+        });
+        const size_t newBlockCount = newBlocks.size();
+        bi = bi.Erase();
+        bi = bi.InsertBefore(&newBlocks);
+        auto nbi = bi;
+        for (size_t i = 0; i < newBlockCount; ++i, ++nbi)
+          nbi->ForEachInst([this](ir::Instruction* inst) {
+            get_def_use_mgr()->AnalyzeInstDefUse(inst);
+          });
+        for (auto& var : newVars) get_def_use_mgr()->AnalyzeInstDefUse(&*var);
+        // Insert new function variables.
+        if (newVars.size() > 0)
+          func->begin()->begin().InsertBefore(std::move(newVars));
+        // Restart inlining at beginning of calling block.
+        ii = bi->begin();
+        modified = true;
+      } else {
+        ++ii;
+      }
+    }
+  }
+  if (modified) function_size_[func->result_id()] = FunctionSize(func);
+  return modified;
+}
+
+void InlineSelectivePass::Initialize(ir::IRContext* c) {
+  InitializeInline(c);
+  function_size_.clear();
+  call_count_.clear();
+  entry_points_.clear();
+  bottom_up_order_.clear();
+  BuildCallGraph();
+}
+
+Pass::Status InlineSelectivePass::ProcessImpl() {
+  // Inline into callees before their callers, so that the size of a callee
+  // includes the code inlined into it.
+  bool modified = false;
+  for (auto func : bottom_up_order_) modified |= InlineSelective(func);
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+InlineSelectivePass::InlineSelectivePass(uint32_t growth_percent)
+    : growth_percent_(growth_percent), budget_(0) {}
+
+Pass::Status InlineSelectivePass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
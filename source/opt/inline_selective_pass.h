@@ -0,0 +1,91 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_INLINE_SELECTIVE_PASS_H_
+#define LIBSPIRV_OPT_INLINE_SELECTIVE_PASS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "def_use_manager.h"
+#include "inline_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class InlineSelectivePass : public InlinePass {
+ public:
+  explicit InlineSelectivePass(uint32_t growth_percent);
+  Status Process(ir::IRContext* c) override;
+
+  const char* name() const override { return "inline-entry-points-selective"; }
+
+ private:
+  // Return the number of instructions in the blocks of |func|.
+  uint32_t FunctionSize(ir::Function* func) const;
+
+  // Add to |order| the functions called from |funcId|, callees first,
+  // followed by |funcId| itself. Functions in |visited| are skipped.
+  void PostOrderCallees(uint32_t funcId, std::unordered_set<uint32_t>* visited,
+                        std::vector<ir::Function*>* order);
+
+  // Build the call graph of the entry point call trees: the number of
+  // call sites of each function and the order in which functions are
+  // processed. Compute the size of each function and the growth budget.
+  void BuildCallGraph();
+
+  // Return true if the inlinable call |callInst| is worth inlining. Calls
+  // with opaque arguments or return type are always inlined. Other calls
+  // are inlined if they do not grow the module, taking into account the
+  // removal of a callee with a single call site and the folding of constant
+  // arguments, or if their growth fits in the remaining budget, which is
+  // then reduced.
+  bool ShouldInline(const ir::Instruction* callInst);
+
+  // Inline the calls of |func| selected by ShouldInline, including the
+  // calls in the inlined code. Return true if |func| is modified.
+  bool InlineSelective(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Maximum growth of the module, in percent of its initial size.
+  uint32_t growth_percent_;
+
+  // Number of instructions the module may still grow by.
+  uint32_t budget_;
+
+  // Number of instructions of each function. Callees are processed before
+  // their callers, so this is the size after inlining into the callee.
+  std::unordered_map<uint32_t, uint32_t> function_size_;
+
+  // Number of call sites of each function.
+  std::unordered_map<uint32_t, uint32_t> call_count_;
+
+  // Ids of entry point functions, which are kept even if all their calls
+  // are inlined.
+  std::unordered_set<uint32_t> entry_points_;
+
+  // Functions of the entry point call trees, callees first.
+  std::vector<ir::Function*> bottom_up_order_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_INLINE_SELECTIVE_PASS_H_
@@ -39,6 +39,9 @@ class InsertExtractElimPass : public Pass {
   InsertExtractElimPass();
   const char* name() const override { return "eliminate-insert-extract"; }
   Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new InsertExtractElimPass());
+  }
 
  private:
   // Return true if indices of extract |extInst| and insert |insInst| match
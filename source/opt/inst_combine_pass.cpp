@@ -0,0 +1,438 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "inst_combine_pass.h"
+
+#include <queue>
+
+#include "fold.h"
+#include "ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kTypeWidthInIdx = 0;
+const uint32_t kTypeVectorComponentTypeInIdx = 0;
+const uint32_t kTypeVectorCountInIdx = 1;
+const uint32_t kConstantValueInIdx = 0;
+const uint32_t kSelectConditionInIdx = 0;
+const uint32_t kSelectTrueInIdx = 1;
+const uint32_t kSelectFalseInIdx = 2;
+const uint32_t kCompositeExtractCompositeInIdx = 0;
+const uint32_t kCompositeInsertObjectInIdx = 0;
+const uint32_t kCompositeInsertCompositeInIdx = 1;
+
+// Bit patterns of float constants used by the identities.
+const uint32_t kFloatPositiveZero = 0x00000000u;
+const uint32_t kFloatNegativeZero = 0x80000000u;
+const uint32_t kFloatOne = 0x3f800000u;
+
+}  // anonymous namespace
+
+uint32_t InstCombinePass::FoldableWidth(uint32_t typeId) const {
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  if (typeInst == nullptr) return 0;
+  switch (typeInst->opcode()) {
+    case SpvOpTypeBool:
+      return 1;
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+      // Values of other widths are not folded.
+      return typeInst->GetSingleWordInOperand(kTypeWidthInIdx) == 32 ? 1 : 0;
+    case SpvOpTypeVector:
+      return FoldableWidth(typeInst->GetSingleWordInOperand(
+                 kTypeVectorComponentTypeInIdx)) == 1
+                 ? typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx)
+                 : 0;
+    default:
+      return 0;
+  }
+}
+
+bool InstCombinePass::GetConstWords(uint32_t id,
+                                    std::vector<uint32_t>* words) const {
+  const ir::Instruction* inst = get_def_use_mgr()->GetDef(id);
+  if (inst == nullptr) return false;
+  const uint32_t width = FoldableWidth(inst->type_id());
+  if (width == 0) return false;
+  switch (inst->opcode()) {
+    case SpvOpConstantTrue:
+      *words = {1u};
+      return true;
+    case SpvOpConstantFalse:
+      *words = {0u};
+      return true;
+    case SpvOpConstant:
+      *words = {inst->GetSingleWordInOperand(kConstantValueInIdx)};
+      return true;
+    case SpvOpConstantNull:
+      words->assign(width, 0u);
+      return true;
+    case SpvOpConstantComposite: {
+      std::vector<uint32_t> result;
+      for (uint32_t i = 0; i < inst->NumInOperands(); ++i) {
+        std::vector<uint32_t> component;
+        if (!GetConstWords(inst->GetSingleWordInOperand(i), &component))
+          return false;
+        result.push_back(component[0]);
+      }
+      *words = std::move(result);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+bool InstCombinePass::IsConstWithValue(uint32_t id, uint32_t word) const {
+  std::vector<uint32_t> words;
+  if (!GetConstWords(id, &words)) return false;
+  for (auto w : words)
+    if (w != word) return false;
+  return true;
+}
+
+uint32_t InstCombinePass::GetConstId(uint32_t typeId,
+                                     const std::vector<uint32_t>& words) {
+  const auto key = std::make_pair(typeId, words);
+  const auto ci = const_ids_.find(key);
+  if (ci != const_ids_.end()) return ci->second;
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  SpvOp op;
+  std::vector<ir::Operand> operands;
+  switch (typeInst->opcode()) {
+    case SpvOpTypeBool:
+      op = words[0] != 0 ? SpvOpConstantTrue : SpvOpConstantFalse;
+      break;
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+      op = SpvOpConstant;
+      operands.push_back(
+          {spv_operand_type_t::SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER, words});
+      break;
+    default: {
+      op = SpvOpConstantComposite;
+      const uint32_t compTypeId =
+          typeInst->GetSingleWordInOperand(kTypeVectorComponentTypeInIdx);
+      for (auto w : words)
+        operands.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                            {GetConstId(compTypeId, {w})}});
+    } break;
+  }
+  const uint32_t constId = TakeNextId();
+  std::unique_ptr<ir::Instruction> newConst(
+      new ir::Instruction(op, typeId, constId, operands));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newConst);
+  get_module()->AddGlobalValue(std::move(newConst));
+  const_ids_[key] = constId;
+  new_const_ids_.push_back(constId);
+  return constId;
+}
+
+uint32_t InstCombinePass::GetSplatConstId(uint32_t typeId, uint32_t word) {
+  const uint32_t width = FoldableWidth(typeId);
+  if (width == 0) return 0;
+  return GetConstId(typeId, std::vector<uint32_t>(width, word));
+}
+
+uint32_t InstCombinePass::IfTypeIs(uint32_t id, uint32_t typeId) const {
+  const ir::Instruction* inst = get_def_use_mgr()->GetDef(id);
+  return inst != nullptr && inst->type_id() == typeId ? id : 0;
+}
+
+uint32_t InstCombinePass::FoldInst(ir::Instruction* inst) {
+  const SpvOp op = inst->opcode();
+  const bool scalarOp = IsFoldableScalarOp(op);
+  const bool floatOp = IsFoldableFloatOp(op);
+  if (!scalarOp && !floatOp && op != SpvOpBitcast) return 0;
+  const uint32_t width = FoldableWidth(inst->type_id());
+  if (width == 0 || inst->NumInOperands() == 0) return 0;
+  std::vector<std::vector<uint32_t>> operandWords;
+  for (uint32_t i = 0; i < inst->NumInOperands(); ++i) {
+    std::vector<uint32_t> words;
+    if (!GetConstWords(inst->GetSingleWordInOperand(i), &words) ||
+        words.size() != width)
+      return 0;
+    operandWords.push_back(std::move(words));
+  }
+  if (op == SpvOpBitcast) return GetConstId(inst->type_id(), operandWords[0]);
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(inst->type_id());
+  const uint32_t compTypeId =
+      typeInst->opcode() == SpvOpTypeVector
+          ? typeInst->GetSingleWordInOperand(kTypeVectorComponentTypeInIdx)
+          : inst->type_id();
+  const bool isBool =
+      get_def_use_mgr()->GetDef(compTypeId)->opcode() == SpvOpTypeBool;
+  std::vector<uint32_t> results;
+  for (uint32_t d = 0; d < width; ++d) {
+    std::vector<uint32_t> words;
+    for (const auto& w : operandWords) words.push_back(w[d]);
+    uint32_t result = 0;
+    if (scalarOp ? !FoldScalarWords(op, words, &result)
+                 : !FoldFloatWords(op, words, &result))
+      return 0;
+    if (isBool) result = result != 0 ? 1 : 0;
+    results.push_back(result);
+  }
+  return GetConstId(inst->type_id(), results);
+}
+
+uint32_t InstCombinePass::SimplifyExtract(ir::Instruction* inst) const {
+  uint32_t id = inst->GetSingleWordInOperand(kCompositeExtractCompositeInIdx);
+  std::vector<uint32_t> indices;
+  for (uint32_t i = kCompositeExtractCompositeInIdx + 1;
+       i < inst->NumInOperands(); ++i)
+    indices.push_back(inst->GetSingleWordInOperand(i));
+  // Follow the composites the element comes from, consuming the indices.
+  size_t next = 0;
+  while (next < indices.size()) {
+    const ir::Instruction* def = get_def_use_mgr()->GetDef(id);
+    if (def == nullptr) return 0;
+    switch (def->opcode()) {
+      case SpvOpCompositeConstruct:
+      case SpvOpConstantComposite: {
+        // A vector may be constructed from smaller vectors, in which case
+        // the operands are not the elements.
+        const ir::Instruction* typeInst =
+            get_def_use_mgr()->GetDef(def->type_id());
+        if (typeInst->opcode() == SpvOpTypeVector &&
+            def->NumInOperands() !=
+                typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx))
+          return 0;
+        if (indices[next] >= def->NumInOperands()) return 0;
+        id = def->GetSingleWordInOperand(indices[next]);
+        ++next;
+      } break;
+      case SpvOpCompositeInsert: {
+        // The inserted object is extracted if the indices are the same. If
+        // they differ, the element comes from the original composite.
+        const uint32_t numInsertIndices =
+            def->NumInOperands() - kCompositeInsertCompositeInIdx - 1;
+        bool differ = false;
+        uint32_t k = 0;
+        for (; k < numInsertIndices && next + k < indices.size(); ++k) {
+          if (def->GetSingleWordInOperand(kCompositeInsertCompositeInIdx + 1 +
+                                          k) != indices[next + k]) {
+            differ = true;
+            break;
+          }
+        }
+        if (differ) {
+          id = def->GetSingleWordInOperand(kCompositeInsertCompositeInIdx);
+        } else if (k == numInsertIndices) {
+          // The inserted object contains the element.
+          id = def->GetSingleWordInOperand(kCompositeInsertObjectInIdx);
+          next += k;
+        } else {
+          // The element contains the inserted object.
+          return 0;
+        }
+      } break;
+      default:
+        return 0;
+    }
+  }
+  return IfTypeIs(id, inst->type_id());
+}
+
+uint32_t InstCombinePass::SimplifyInst(ir::Instruction* inst) {
+  const uint32_t typeId = inst->type_id();
+  const auto in = [inst](uint32_t i) {
+    return inst->GetSingleWordInOperand(i);
+  };
+  switch (inst->opcode()) {
+    case SpvOpIAdd:
+      if (IsConstWithValue(in(1), 0)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(0), 0)) return IfTypeIs(in(1), typeId);
+      break;
+    case SpvOpISub:
+      if (IsConstWithValue(in(1), 0)) return IfTypeIs(in(0), typeId);
+      if (in(0) == in(1)) return GetSplatConstId(typeId, 0);
+      break;
+    case SpvOpIMul:
+      if (IsConstWithValue(in(1), 1)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(0), 1)) return IfTypeIs(in(1), typeId);
+      if (IsConstWithValue(in(0), 0) || IsConstWithValue(in(1), 0))
+        return GetSplatConstId(typeId, 0);
+      break;
+    case SpvOpUDiv:
+    case SpvOpSDiv:
+      if (IsConstWithValue(in(1), 1)) return IfTypeIs(in(0), typeId);
+      break;
+    // Only the identities which hold for all floats, including negative
+    // zero and NaN, are applied: x + 0.0 is -0.0 + 0.0 = 0.0 for x = -0.0.
+    case SpvOpFAdd:
+      if (IsConstWithValue(in(1), kFloatNegativeZero)) return in(0);
+      if (IsConstWithValue(in(0), kFloatNegativeZero)) return in(1);
+      break;
+    case SpvOpFSub:
+      if (IsConstWithValue(in(1), kFloatPositiveZero)) return in(0);
+      break;
+    case SpvOpFMul:
+      if (IsConstWithValue(in(1), kFloatOne)) return in(0);
+      if (IsConstWithValue(in(0), kFloatOne)) return in(1);
+      break;
+    case SpvOpFDiv:
+      if (IsConstWithValue(in(1), kFloatOne)) return in(0);
+      break;
+    case SpvOpShiftRightLogical:
+    case SpvOpShiftRightArithmetic:
+    case SpvOpShiftLeftLogical:
+      if (IsConstWithValue(in(1), 0)) return IfTypeIs(in(0), typeId);
+      break;
+    case SpvOpBitwiseAnd:
+      if (in(0) == in(1)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(1), ~0u)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(0), ~0u)) return IfTypeIs(in(1), typeId);
+      if (IsConstWithValue(in(0), 0) || IsConstWithValue(in(1), 0))
+        return GetSplatConstId(typeId, 0);
+      break;
+    case SpvOpBitwiseOr:
+      if (in(0) == in(1)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(1), 0)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(0), 0)) return IfTypeIs(in(1), typeId);
+      if (IsConstWithValue(in(0), ~0u) || IsConstWithValue(in(1), ~0u))
+        return GetSplatConstId(typeId, ~0u);
+      break;
+    case SpvOpBitwiseXor:
+      if (in(0) == in(1)) return GetSplatConstId(typeId, 0);
+      if (IsConstWithValue(in(1), 0)) return IfTypeIs(in(0), typeId);
+      if (IsConstWithValue(in(0), 0)) return IfTypeIs(in(1), typeId);
+      break;
+    case SpvOpLogicalAnd:
+      if (in(0) == in(1)) return in(0);
+      if (IsConstWithValue(in(1), 1)) return in(0);
+      if (IsConstWithValue(in(0), 1)) return in(1);
+      if (IsConstWithValue(in(0), 0) || IsConstWithValue(in(1), 0))
+        return GetSplatConstId(typeId, 0);
+      break;
+    case SpvOpLogicalOr:
+      if (in(0) == in(1)) return in(0);
+      if (IsConstWithValue(in(1), 0)) return in(0);
+      if (IsConstWithValue(in(0), 0)) return in(1);
+      if (IsConstWithValue(in(0), 1) || IsConstWithValue(in(1), 1))
+        return GetSplatConstId(typeId, 1);
+      break;
+    case SpvOpIEqual:
+    case SpvOpULessThanEqual:
+    case SpvOpSLessThanEqual:
+    case SpvOpUGreaterThanEqual:
+    case SpvOpSGreaterThanEqual:
+      if (in(0) == in(1)) return GetSplatConstId(typeId, 1);
+      break;
+    case SpvOpINotEqual:
+    case SpvOpULessThan:
+    case SpvOpSLessThan:
+    case SpvOpUGreaterThan:
+    case SpvOpSGreaterThan:
+      if (in(0) == in(1)) return GetSplatConstId(typeId, 0);
+      break;
+    case SpvOpSNegate:
+    case SpvOpFNegate:
+    case SpvOpNot:
+    case SpvOpLogicalNot: {
+      const ir::Instruction* operand = get_def_use_mgr()->GetDef(in(0));
+      if (operand != nullptr && operand->opcode() == inst->opcode())
+        return IfTypeIs(operand->GetSingleWordInOperand(0), typeId);
+    } break;
+    case SpvOpSelect:
+      if (in(kSelectTrueInIdx) == in(kSelectFalseInIdx))
+        return in(kSelectTrueInIdx);
+      if (IsConstWithValue(in(kSelectConditionInIdx), 1))
+        return in(kSelectTrueInIdx);
+      if (IsConstWithValue(in(kSelectConditionInIdx), 0))
+        return in(kSelectFalseInIdx);
+      break;
+    case SpvOpCompositeExtract:
+      return SimplifyExtract(inst);
+    default:
+      break;
+  }
+  return 0;
+}
+
+bool InstCombinePass::CombineInsts(ir::Function* func) {
+  std::queue<ir::Instruction*> worklist;
+  for (auto& blk : *func)
+    for (auto& inst : blk)
+      if (inst.result_id() != 0 && inst.type_id() != 0) worklist.push(&inst);
+  bool modified = false;
+  while (!worklist.empty()) {
+    ir::Instruction* inst = worklist.front();
+    worklist.pop();
+    // Already replaced.
+    if (inst->opcode() == SpvOpNop) continue;
+    uint32_t value = FoldInst(inst);
+    if (value == 0) value = SimplifyInst(inst);
+    if (value == 0) continue;
+    // The users of |inst| may be combined in turn once they use |value|.
+    const uint32_t id = inst->result_id();
+    const analysis::UseList* uses = get_def_use_mgr()->GetUses(id);
+    if (uses != nullptr)
+      for (const auto& u : *uses)
+        if (u.inst->result_id() != 0 && u.inst->type_id() != 0)
+          worklist.push(u.inst);
+    KillNamesAndDecorates(inst);
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(id, value);
+    get_def_use_mgr()->KillInst(inst);
+    modified = true;
+  }
+  return modified;
+}
+
+void InstCombinePass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+
+  const_ids_.clear();
+  new_const_ids_.clear();
+  for (auto& inst : get_module()->types_values()) {
+    if (inst.opcode() != SpvOpConstantTrue &&
+        inst.opcode() != SpvOpConstantFalse &&
+        inst.opcode() != SpvOpConstant &&
+        inst.opcode() != SpvOpConstantComposite)
+      continue;
+    std::vector<uint32_t> words;
+    if (GetConstWords(inst.result_id(), &words))
+      const_ids_.emplace(std::make_pair(inst.type_id(), words),
+                         inst.result_id());
+  }
+}
+
+Pass::Status InstCombinePass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) { return CombineInsts(fp); };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  // Composites come after their components.
+  for (auto ci = new_const_ids_.rbegin(); ci != new_const_ids_.rend(); ++ci)
+    if (get_def_use_mgr()->GetUses(*ci) == nullptr)
+      get_def_use_mgr()->KillInst(get_def_use_mgr()->GetDef(*ci));
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+InstCombinePass::InstCombinePass() {}
+
+Pass::Status InstCombinePass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
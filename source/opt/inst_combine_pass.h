@@ -0,0 +1,98 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_INST_COMBINE_PASS_H_
+#define LIBSPIRV_OPT_INST_COMBINE_PASS_H_
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class InstCombinePass : public MemPass {
+ public:
+  InstCombinePass();
+  const char* name() const override { return "combine-instructions"; }
+  Status Process(ir::IRContext*) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new InstCombinePass());
+  }
+
+ private:
+  // Returns the number of components of type |typeId| if it is a vector of
+  // 32-bit integers, 32-bit floats or booleans, 1 if it is such a scalar, and
+  // 0 otherwise.
+  uint32_t FoldableWidth(uint32_t typeId) const;
+
+  // Returns true and sets |words| to the value of each component of |id| if
+  // it is a constant, not a specialization constant, of a foldable type.
+  // Booleans are 0 or 1.
+  bool GetConstWords(uint32_t id, std::vector<uint32_t>* words) const;
+
+  // Returns true if |id| is a constant whose components all are |word|.
+  bool IsConstWithValue(uint32_t id, uint32_t word) const;
+
+  // Returns the id of the constant of foldable type |typeId| with component
+  // values |words|, adding it to the module if needed.
+  uint32_t GetConstId(uint32_t typeId, const std::vector<uint32_t>& words);
+
+  // Returns the id of the constant of foldable type |typeId| whose
+  // components all are |word|, or 0 if |typeId| is not foldable.
+  uint32_t GetSplatConstId(uint32_t typeId, uint32_t word);
+
+  // Returns |id| if its type is |typeId|, and 0 otherwise.
+  uint32_t IfTypeIs(uint32_t id, uint32_t typeId) const;
+
+  // Returns the id of the constant |inst| evaluates to if all its operands
+  // are constants, or 0.
+  uint32_t FoldInst(ir::Instruction* inst);
+
+  // Returns the id of the element extracted by OpCompositeExtract |inst|
+  // when it comes from an OpCompositeConstruct, an OpConstantComposite, or
+  // an OpCompositeInsert of the same element, or 0.
+  uint32_t SimplifyExtract(ir::Instruction* inst) const;
+
+  // Returns the id of a value equal to |inst| by an algebraic identity, such
+  // as x + 0 = x, or 0 if there is none. May add a constant to the module.
+  uint32_t SimplifyInst(ir::Instruction* inst);
+
+  // Replaces the instructions of |func| that fold to a constant or simplify
+  // to another value, until no more can be. Returns true if |func| is
+  // modified.
+  bool CombineInsts(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Ids of the constants of foldable type, keyed by type and component
+  // values.
+  std::map<std::pair<uint32_t, std::vector<uint32_t>>, uint32_t> const_ids_;
+
+  // Constants added by the pass, in order. Those which end up unused, such
+  // as the intermediate results of folded expressions, are removed.
+  std::vector<uint32_t> new_const_ids_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_INST_COMBINE_PASS_H_
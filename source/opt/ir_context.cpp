@@ -13,3 +13,33 @@
 // limitations under the License.
 
 #include "ir_context.h"
+
+namespace spvtools {
+namespace ir {
+
+opt::DominatorAnalysis* IRContext::GetDominatorAnalysis(Function* f) {
+  auto& tree = dominator_trees_[f];
+  if (!tree) tree.reset(new opt::DominatorAnalysis(f, false));
+  return tree.get();
+}
+
+opt::DominatorAnalysis* IRContext::GetPostDominatorAnalysis(Function* f) {
+  auto& tree = post_dominator_trees_[f];
+  if (!tree) tree.reset(new opt::DominatorAnalysis(f, true));
+  return tree.get();
+}
+
+opt::LoopDescriptor* IRContext::GetLoopDescriptor(Function* f) {
+  auto& loops = loop_descriptors_[f];
+  if (!loops) loops.reset(new opt::LoopDescriptor(f, GetDominatorAnalysis(f)));
+  return loops.get();
+}
+
+void IRContext::InvalidateDominatorAnalyses() {
+  loop_descriptors_.clear();
+  dominator_trees_.clear();
+  post_dominator_trees_.clear();
+}
+
+}  // namespace ir
+}  // namespace spvtools
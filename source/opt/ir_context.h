@@ -15,9 +15,13 @@
 #ifndef SPIRV_TOOLS_IR_CONTEXT_H
 #define SPIRV_TOOLS_IR_CONTEXT_H
 
+#include "dominator_analysis.h"
+#include "loop_descriptor.h"
 #include "module.h"
 
 #include <iostream>
+#include <memory>
+#include <unordered_map>
 
 namespace spvtools {
 namespace ir {
@@ -121,8 +125,30 @@ class IRContext {
   // Appends a function to this module.
   inline void AddFunction(std::unique_ptr<Function>&& f);
 
+  // Returns the dominator tree of |f|, building it on first use.
+  opt::DominatorAnalysis* GetDominatorAnalysis(Function* f);
+  // Returns the post-dominator tree of |f|, building it on first use.
+  opt::DominatorAnalysis* GetPostDominatorAnalysis(Function* f);
+  // Returns the loops of |f|, finding them on first use.
+  opt::LoopDescriptor* GetLoopDescriptor(Function* f);
+  // Discards every dominator and post-dominator tree, and the loop
+  // descriptors built from them. This must be called whenever blocks or
+  // branches are added, removed or retargeted. PassManager does so after each
+  // pass that reports a change.
+  void InvalidateDominatorAnalyses();
+
  private:
   std::unique_ptr<Module> module_;
+
+  // Dominator and post-dominator trees, by function.
+  std::unordered_map<const Function*, std::unique_ptr<opt::DominatorAnalysis>>
+      dominator_trees_;
+  std::unordered_map<const Function*, std::unique_ptr<opt::DominatorAnalysis>>
+      post_dominator_trees_;
+
+  // Loop descriptors, by function.
+  std::unordered_map<const Function*, std::unique_ptr<opt::LoopDescriptor>>
+      loop_descriptors_;
 };
 
 void IRContext::SetIdBound(uint32_t i) { module_->SetIdBound(i); }
@@ -0,0 +1,101 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "licm_pass.h"
+
+#include "ir_context.h"
+#include "opcode.h"
+
+namespace spvtools {
+namespace opt {
+
+bool LICMPass::IsHoistable(const ir::Instruction* inst,
+                           const ir::BasicBlock* bp, const Loop* loop) const {
+  if (inst->result_id() == 0 || !spvOpcodeIsPure(inst->opcode()))
+    return false;
+  // The header is the only block known to execute whenever the loop is
+  // entered. Elsewhere, a division might be guarded by a test of its divisor.
+  if (bp != loop->header() && spvOpcodeMayBeUndefined(inst->opcode()))
+    return false;
+  bool invariant = true;
+  inst->ForEachInId([&invariant, loop, this](const uint32_t* iid) {
+    // Ids not defined in the function, such as constants, are invariant.
+    const auto di = def_block_.find(*iid);
+    if (di != def_block_.end() && loop->Contains(di->second))
+      invariant = false;
+  });
+  return invariant;
+}
+
+bool LICMPass::HoistLoop(const Loop* loop) {
+  ir::BasicBlock* preheader = loop->preheader();
+  if (preheader == nullptr) return false;
+  // Code is placed before the preheader's branch, or before its OpLoopMerge
+  // if it is itself the header of an enclosing loop.
+  ir::Instruction* insertPoint = preheader->GetMergeInst();
+  if (insertPoint == nullptr) insertPoint = &*preheader->tail();
+  bool modified = false;
+  // Blocks appear after their dominators in a function, so the operands of
+  // an instruction are hoisted before it.
+  for (auto bp : loop->blocks()) {
+    for (auto ii = bp->begin(); ii != bp->end();) {
+      ir::Instruction* inst = &*ii;
+      ++ii;
+      if (!IsHoistable(inst, bp, loop)) continue;
+      inst->InsertBefore(insertPoint);
+      def_block_[inst->result_id()] = preheader->id();
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+bool LICMPass::HoistInvariants(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  def_block_.clear();
+  for (auto& blk : *func) {
+    const uint32_t blkId = blk.id();
+    blk.ForEachInst([blkId, this](ir::Instruction* inst) {
+      if (inst->result_id() != 0) def_block_[inst->result_id()] = blkId;
+    });
+  }
+  // Inner loops come first, so that what they hoist into their preheader
+  // can then be hoisted out of the enclosing loops.
+  bool modified = false;
+  LoopDescriptor* loops = context()->GetLoopDescriptor(func);
+  for (auto loop : loops->PostOrder()) modified |= HoistLoop(loop);
+  return modified;
+}
+
+void LICMPass::Initialize(ir::IRContext* c) { InitializeProcessing(c); }
+
+Pass::Status LICMPass::ProcessImpl() {
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return HoistInvariants(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+LICMPass::LICMPass() {}
+
+Pass::Status LICMPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
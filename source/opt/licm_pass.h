@@ -0,0 +1,60 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LICM_PASS_H_
+#define LIBSPIRV_OPT_LICM_PASS_H_
+
+#include <unordered_map>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "loop_descriptor.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class LICMPass : public Pass {
+ public:
+  LICMPass();
+  const char* name() const override { return "loop-invariant-code-motion"; }
+  Status Process(ir::IRContext*) override;
+
+ private:
+  // Returns true if |inst| of block |bp| of |loop| computes the same value
+  // on every iteration and can be executed each time the loop is entered.
+  bool IsHoistable(const ir::Instruction* inst, const ir::BasicBlock* bp,
+                   const Loop* loop) const;
+
+  // Moves the invariant instructions of |loop| to the end of its preheader.
+  // Returns true if an instruction was moved.
+  bool HoistLoop(const Loop* loop);
+
+  // Hoists the invariant instructions of each loop of |func|, innermost
+  // loops first. Returns true if |func| is modified.
+  bool HoistInvariants(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Label of the block defining each result id of the current function.
+  std::unordered_map<uint32_t, uint32_t> def_block_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LICM_PASS_H_
@@ -39,6 +39,9 @@ class LocalSingleBlockLoadStoreElimPass : public MemPass {
   LocalSingleBlockLoadStoreElimPass();
   const char* name() const override { return "eliminate-local-single-block"; }
   Status Process(ir::IRContext* c) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new LocalSingleBlockLoadStoreElimPass());
+  }
 
  private:
   // Return true if all uses of |varId| are only through supported reference
@@ -16,7 +16,6 @@
 
 #include "local_single_store_elim_pass.h"
 
-#include "cfa.h"
 #include "iterator.h"
 #include "spirv/1.0/GLSL.std.450.h"
 
@@ -94,89 +93,8 @@ void LocalSingleStoreElimPass::SingleStoreAnalyze(ir::Function* func) {
   }
 }
 
-LocalSingleStoreElimPass::GetBlocksFunction
-LocalSingleStoreElimPass::AugmentedCFGSuccessorsFunction() const {
-  return [this](const ir::BasicBlock* block) {
-    auto asmi = augmented_successors_map_.find(block);
-    if (asmi != augmented_successors_map_.end())
-      return &(*asmi).second;
-    auto smi = successors_map_.find(block);
-    return &(*smi).second;
-  };
-}
-
-LocalSingleStoreElimPass::GetBlocksFunction
-LocalSingleStoreElimPass::AugmentedCFGPredecessorsFunction() const {
-  return [this](const ir::BasicBlock* block) {
-    auto apmi = augmented_predecessors_map_.find(block);
-    if (apmi != augmented_predecessors_map_.end())
-      return &(*apmi).second;
-    auto pmi = predecessors_map_.find(block);
-    return &(*pmi).second;
-  };
-}
-
-void LocalSingleStoreElimPass::CalculateImmediateDominators(
-    ir::Function* func) {
-  // Compute CFG
-  vector<ir::BasicBlock*> ordered_blocks;
-  predecessors_map_.clear();
-  successors_map_.clear();
-  for (auto& blk : *func) {
-    ordered_blocks.push_back(&blk);
-    blk.ForEachSuccessorLabel([&blk, &ordered_blocks, this](uint32_t sbid) {
-      successors_map_[&blk].push_back(label2block_[sbid]);
-      predecessors_map_[label2block_[sbid]].push_back(&blk);
-    });
-  }
-  // Compute Augmented CFG
-  augmented_successors_map_.clear();
-  augmented_predecessors_map_.clear();
-  successors_map_[cfg()->pseudo_exit_block()] = {};
-  predecessors_map_[cfg()->pseudo_entry_block()] = {};
-  auto succ_func = [this](const ir::BasicBlock* b)
-    { return &successors_map_[b]; };
-  auto pred_func = [this](const ir::BasicBlock* b)
-    { return &predecessors_map_[b]; };
-  CFA<ir::BasicBlock>::ComputeAugmentedCFG(
-    ordered_blocks,
-    cfg()->pseudo_entry_block(),
-    cfg()->pseudo_exit_block(),
-    &augmented_successors_map_,
-    &augmented_predecessors_map_,
-    succ_func,
-    pred_func);
-  // Compute Dominators
-  vector<const ir::BasicBlock*> postorder;
-  auto ignore_block = [](cbb_ptr) {};
-  auto ignore_edge = [](cbb_ptr, cbb_ptr) {};
-  spvtools::CFA<ir::BasicBlock>::DepthFirstTraversal(
-    ordered_blocks[0], AugmentedCFGSuccessorsFunction(),
-    ignore_block, [&](cbb_ptr b) { postorder.push_back(b); },
-    ignore_edge);
-  auto edges = spvtools::CFA<ir::BasicBlock>::CalculateDominators(
-    postorder, AugmentedCFGPredecessorsFunction());
-  idom_.clear();
-  for (auto edge : edges)
-    idom_[edge.first] = edge.second;
-}
-
-bool LocalSingleStoreElimPass::Dominates(
-    ir::BasicBlock* blk0, uint32_t idx0,
-    ir::BasicBlock* blk1, uint32_t idx1) {
-  if (blk0 == blk1)
-    return idx0 <= idx1;
-  ir::BasicBlock* b = blk1;
-  while (idom_[b] != b) {
-    b = idom_[b];
-    if (b == blk0)
-      return true;
-  }
-  return false;
-}
-
 bool LocalSingleStoreElimPass::SingleStoreProcess(ir::Function* func) {
-  CalculateImmediateDominators(func);
+  const DominatorAnalysis* dom_tree = context()->GetDominatorAnalysis(func);
   bool modified = false;
   for (auto bi = func->begin(); bi != func->end(); ++bi) {
     uint32_t instIdx = 0;
@@ -194,7 +112,9 @@ bool LocalSingleStoreElimPass::SingleStoreProcess(ir::Function* func) {
       if (non_ssa_vars_.find(varId) != non_ssa_vars_.end())
         continue;
       // store must dominate load
-      if (!Dominates(store2blk_[vsi->second], store2idx_[vsi->second], &*bi, instIdx))
+      ir::BasicBlock* storeBlk = store2blk_[vsi->second];
+      if (storeBlk == &*bi ? store2idx_[vsi->second] > instIdx
+                           : !dom_tree->StrictlyDominates(storeBlk, &*bi))
         continue;
       // Use store value as replacement id
       uint32_t replId = vsi->second->GetSingleWordInOperand(kStoreValIdInIdx);
@@ -235,15 +155,6 @@ bool LocalSingleStoreElimPass::LocalSingleStoreElim(ir::Function* func) {
 void LocalSingleStoreElimPass::Initialize(ir::IRContext* irContext) {
   InitializeProcessing(irContext);
 
-  // Initialize function and block maps
-  label2block_.clear();
-  for (auto& fn : *get_module()) {
-    for (auto& blk : fn) {
-      uint32_t bid = blk.id();
-      label2block_[bid] = &blk;
-    }
-  }
-
   // Initialize Target Type Caches
   seen_target_vars_.clear();
   seen_non_target_vars_.clear();
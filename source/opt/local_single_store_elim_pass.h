@@ -41,6 +41,9 @@ class LocalSingleStoreElimPass : public MemPass {
   LocalSingleStoreElimPass();
   const char* name() const override { return "eliminate-local-single-store"; }
   Status Process(ir::IRContext* irContext) override;
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return std::unique_ptr<Pass>(new LocalSingleStoreElimPass());
+  }
 
  private:
   // Return true if all refs through |ptrId| are only loads or stores and
@@ -57,25 +60,6 @@ class LocalSingleStoreElimPass : public MemPass {
   // analysis in the presence of function calls.
   void SingleStoreAnalyze(ir::Function* func);
 
-  using GetBlocksFunction =
-    std::function<const std::vector<ir::BasicBlock*>*(const ir::BasicBlock*)>;
-
-  /// Returns the block successors function for the augmented CFG.
-  GetBlocksFunction AugmentedCFGSuccessorsFunction() const;
-
-  /// Returns the block predecessors function for the augmented CFG.
-  GetBlocksFunction AugmentedCFGPredecessorsFunction() const;
-
-  // Calculate immediate dominators for |func|'s CFG. Leaves result
-  // in idom_. Entries for augmented CFG (pseudo blocks) are not created.
-  // TODO(dnovillo): Move to new CFG class.
-  void CalculateImmediateDominators(ir::Function* func);
-  
-  // Return true if instruction in |blk0| at ordinal position |idx0|
-  // dominates instruction in |blk1| at position |idx1|.
-  bool Dominates(ir::BasicBlock* blk0, uint32_t idx0,
-    ir::BasicBlock* blk1, uint32_t idx1);
-
   // For each load of an SSA variable in |func|, replace all uses of
   // the load with the value stored if the store dominates the load.
   // Assumes that SingleStoreAnalyze() has just been run. Return true
@@ -102,9 +86,6 @@ class LocalSingleStoreElimPass : public MemPass {
   void Initialize(ir::IRContext* irContext);
   Pass::Status ProcessImpl();
 
-  // Map from block's label id to block
-  std::unordered_map<uint32_t, ir::BasicBlock*> label2block_;
-
   // Map from SSA Variable to its single store
   std::unordered_map<uint32_t, ir::Instruction*> ssa_var2store_;
 
@@ -121,26 +102,6 @@ class LocalSingleStoreElimPass : public MemPass {
   // variable directly or through non-ptr access chains.
   std::unordered_set<uint32_t> supported_ref_ptrs_;
 
-  // CFG Predecessors
-  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
-    predecessors_map_;
-
-  // CFG Successors
-  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
-    successors_map_;
-
-  // CFG Augmented Predecessors
-  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
-    augmented_predecessors_map_;
-
-  // CFG Augmented Successors
-  std::unordered_map<const ir::BasicBlock*, std::vector<ir::BasicBlock*>>
-    augmented_successors_map_;
-
-  // Immediate Dominator Map
-  // If block has no idom it points to itself.
-  std::unordered_map<ir::BasicBlock*, ir::BasicBlock*> idom_;
-
   // Extensions supported by this pass.
   std::unordered_set<std::string> extensions_whitelist_;
 };
@@ -0,0 +1,151 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "loop_descriptor.h"
+
+#include <algorithm>
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kLoopMergeMergeBlockIdInIdx = 0;
+const uint32_t kLoopMergeContinueBlockIdInIdx = 1;
+
+}  // namespace
+
+LoopDescriptor::LoopDescriptor(ir::Function* func,
+                               const DominatorAnalysis* dom_tree)
+    : function_(func) {
+  // Position of each block in the function, and predecessors of each block,
+  // ignoring duplicate edges out of an OpSwitch.
+  std::unordered_map<uint32_t, uint32_t> position;
+  std::unordered_map<uint32_t, std::vector<ir::BasicBlock*>> preds;
+  uint32_t next_position = 0;
+  for (auto& blk : *func) {
+    position[blk.id()] = next_position++;
+    ir::BasicBlock* bp = &blk;
+    std::vector<uint32_t> succ_ids;
+    blk.ForEachSuccessorLabel([&succ_ids](const uint32_t label) {
+      if (std::find(succ_ids.begin(), succ_ids.end(), label) == succ_ids.end())
+        succ_ids.push_back(label);
+    });
+    for (auto succ_id : succ_ids) preds[succ_id].push_back(bp);
+  }
+  const auto by_position = [&position](const ir::BasicBlock* a,
+                                       const ir::BasicBlock* b) {
+    return position[a->id()] < position[b->id()];
+  };
+  const auto loop_by_position = [&by_position](const Loop* a, const Loop* b) {
+    return by_position(a->header(), b->header());
+  };
+
+  // Headers are visited in dominator tree preorder, so a loop is found
+  // before the loops nested in it.
+  for (auto header : dom_tree->Preorder()) {
+    std::vector<ir::BasicBlock*> latches;
+    for (auto pred : preds[header->id()])
+      if (dom_tree->Dominates(header, pred)) latches.push_back(pred);
+    if (latches.empty()) continue;
+
+    std::unique_ptr<Loop> loop(new Loop);
+    loop->header_ = header;
+    loop->latches_ = latches;
+    const ir::Instruction* merge_inst = header->GetLoopMergeInst();
+    if (merge_inst != nullptr) {
+      loop->merge_id_ =
+          merge_inst->GetSingleWordInOperand(kLoopMergeMergeBlockIdInIdx);
+      loop->continue_id_ =
+          merge_inst->GetSingleWordInOperand(kLoopMergeContinueBlockIdInIdx);
+    }
+
+    // The loop is made of the blocks reaching a latch without going through
+    // the header.
+    loop->block_ids_.insert(header->id());
+    loop->blocks_.push_back(header);
+    std::vector<ir::BasicBlock*> worklist = latches;
+    while (!worklist.empty()) {
+      ir::BasicBlock* bp = worklist.back();
+      worklist.pop_back();
+      if (!loop->block_ids_.insert(bp->id()).second) continue;
+      loop->blocks_.push_back(bp);
+      for (auto pred : preds[bp->id()])
+        if (dom_tree->Dominates(header, pred)) worklist.push_back(pred);
+    }
+    std::sort(loop->blocks_.begin(), loop->blocks_.end(), by_position);
+
+    // The preheader is the only block entering the loop, if it enters it
+    // unconditionally.
+    ir::BasicBlock* entering = nullptr;
+    uint32_t num_entering = 0;
+    for (auto pred : preds[header->id()]) {
+      if (loop->Contains(pred) || !dom_tree->Dominates(pred, pred)) continue;
+      entering = pred;
+      ++num_entering;
+    }
+    if (num_entering == 1 && entering->tail()->opcode() == SpvOpBranch)
+      loop->preheader_ = entering;
+
+    // Loops enclosing this one have already claimed its header.
+    const auto enclosing = innermost_.find(header->id());
+    if (enclosing != innermost_.end()) {
+      loop->parent_ = enclosing->second;
+      loop->depth_ = enclosing->second->depth_ + 1;
+      enclosing->second->children_.push_back(loop.get());
+    } else {
+      loop->depth_ = 1;
+      top_level_.push_back(loop.get());
+    }
+    for (auto bp : loop->blocks_) innermost_[bp->id()] = loop.get();
+    loops_.push_back(std::move(loop));
+  }
+
+  std::sort(top_level_.begin(), top_level_.end(), loop_by_position);
+  for (auto& loop : loops_)
+    std::sort(loop->children_.begin(), loop->children_.end(),
+              loop_by_position);
+
+  // Nested loops come before the loop containing them.
+  struct Frame {
+    Loop* loop;
+    size_t next_child;
+  };
+  std::vector<Frame> stack;
+  for (auto top : top_level_) {
+    stack.push_back({top, 0});
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      if (frame.next_child < frame.loop->children_.size()) {
+        Loop* child = frame.loop->children_[frame.next_child++];
+        stack.push_back({child, 0});
+        continue;
+      }
+      post_order_.push_back(frame.loop);
+      stack.pop_back();
+    }
+  }
+}
+
+Loop* LoopDescriptor::InnermostLoop(const ir::BasicBlock* b) const {
+  return b == nullptr ? nullptr : InnermostLoop(b->id());
+}
+
+Loop* LoopDescriptor::InnermostLoop(uint32_t block_id) const {
+  const auto it = innermost_.find(block_id);
+  return it == innermost_.end() ? nullptr : it->second;
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,132 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LOOP_DESCRIPTOR_H_
+#define LIBSPIRV_OPT_LOOP_DESCRIPTOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "basic_block.h"
+#include "dominator_analysis.h"
+#include "function.h"
+
+namespace spvtools {
+namespace opt {
+
+// A natural loop: a header block, and the blocks that can reach one of the
+// header's back edges without going through the header.
+class Loop {
+ public:
+  // Returns the header of the loop. It dominates every block of the loop.
+  ir::BasicBlock* header() const { return header_; }
+
+  // Returns the single block outside the loop that branches to the header,
+  // if it ends with an unconditional branch. Code placed at the end of the
+  // preheader executes exactly once each time the loop is entered. Returns
+  // nullptr if the loop has no such block.
+  ir::BasicBlock* preheader() const { return preheader_; }
+
+  // Returns the merge block and continue target declared by the header's
+  // OpLoopMerge, or 0 if the header has none.
+  uint32_t merge_id() const { return merge_id_; }
+  uint32_t continue_id() const { return continue_id_; }
+
+  // Returns the blocks branching back to the header, in function order.
+  const std::vector<ir::BasicBlock*>& latches() const { return latches_; }
+
+  // Returns the blocks of the loop, including those of nested loops, in
+  // function order. The header comes first.
+  const std::vector<ir::BasicBlock*>& blocks() const { return blocks_; }
+
+  // Returns true if block |b| is part of the loop or of a nested loop.
+  bool Contains(const ir::BasicBlock* b) const {
+    return b != nullptr && Contains(b->id());
+  }
+  bool Contains(uint32_t block_id) const {
+    return block_ids_.count(block_id) != 0;
+  }
+
+  // Returns the innermost loop enclosing this one, or nullptr for an
+  // outermost loop.
+  Loop* parent() const { return parent_; }
+
+  // Returns the loops immediately nested in this one, in function order.
+  const std::vector<Loop*>& children() const { return children_; }
+
+  // Returns the nesting depth of the loop: 1 for an outermost loop.
+  uint32_t depth() const { return depth_; }
+
+ private:
+  friend class LoopDescriptor;
+
+  ir::BasicBlock* header_ = nullptr;
+  ir::BasicBlock* preheader_ = nullptr;
+  uint32_t merge_id_ = 0;
+  uint32_t continue_id_ = 0;
+  std::vector<ir::BasicBlock*> latches_;
+  std::vector<ir::BasicBlock*> blocks_;
+  std::unordered_set<uint32_t> block_ids_;
+  Loop* parent_ = nullptr;
+  std::vector<Loop*> children_;
+  uint32_t depth_ = 0;
+};
+
+// The loops of a single function and their nesting tree.
+//
+// A loop is found for each block that is the target of a back edge: an edge
+// from a block it dominates. In a shader these are the headers declared by
+// OpLoopMerge. Blocks unreachable from the entry block belong to no loop.
+//
+// The descriptor holds pointers to the function's blocks: it must be
+// discarded (see ir::IRContext::InvalidateDominatorAnalyses) whenever the
+// function's blocks or branches change.
+class LoopDescriptor {
+ public:
+  // Finds the loops of |func|, whose dominator tree is |dom_tree|.
+  LoopDescriptor(ir::Function* func, const DominatorAnalysis* dom_tree);
+
+  // Returns the function this descriptor describes.
+  ir::Function* function() const { return function_; }
+
+  // Returns the number of loops of the function.
+  size_t NumLoops() const { return loops_.size(); }
+
+  // Returns the outermost loops, in function order.
+  const std::vector<Loop*>& TopLevelLoops() const { return top_level_; }
+
+  // Returns every loop, nested loops before the loops containing them.
+  const std::vector<Loop*>& PostOrder() const { return post_order_; }
+
+  // Returns the innermost loop containing |b|, or nullptr if |b| is in no
+  // loop.
+  Loop* InnermostLoop(const ir::BasicBlock* b) const;
+  Loop* InnermostLoop(uint32_t block_id) const;
+
+ private:
+  ir::Function* function_;
+
+  std::vector<std::unique_ptr<Loop>> loops_;
+  std::vector<Loop*> top_level_;
+  std::vector<Loop*> post_order_;
+  std::unordered_map<uint32_t, Loop*> innermost_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LOOP_DESCRIPTOR_H_
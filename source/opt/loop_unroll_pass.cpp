@@ -0,0 +1,549 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "loop_unroll_pass.h"
+
+#include <algorithm>
+
+#include "fold.h"
+#include "ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kBranchTargetLabIdInIdx = 0;
+const uint32_t kBranchCondConditionalIdInIdx = 0;
+const uint32_t kBranchCondTrueLabIdInIdx = 1;
+const uint32_t kBranchCondFalseLabIdInIdx = 2;
+const uint32_t kLoopMergeContinueBlockIdInIdx = 1;
+const uint32_t kTypeIntWidthInIdx = 0;
+const uint32_t kConstantValueInIdx = 0;
+
+// Largest number of copies of a loop body made by partial unrolling.
+const uint32_t kMaxPartialUnrollFactor = 4;
+
+// Returns the entry of |id| in |id_map|, or |id| if there is none.
+uint32_t MapId(const std::unordered_map<uint32_t, uint32_t>& id_map,
+               uint32_t id) {
+  const auto mi = id_map.find(id);
+  return mi == id_map.end() ? id : mi->second;
+}
+
+// Returns the value of |phi| coming from the block labeled |label|, or 0.
+uint32_t PhiValue(const ir::Instruction* phi, uint32_t label) {
+  for (uint32_t i = 1; i < phi->NumInOperands(); i += 2)
+    if (phi->GetSingleWordInOperand(i) == label)
+      return phi->GetSingleWordInOperand(i - 1);
+  return 0;
+}
+
+// Returns the block of |blocks| labeled |label|.
+ir::BasicBlock* FindBlock(
+    const std::vector<std::unique_ptr<ir::BasicBlock>>& blocks,
+    uint32_t label) {
+  for (auto& bp : blocks)
+    if (bp->id() == label) return bp.get();
+  return nullptr;
+}
+
+// Removes the phis and the OpLoopMerge of |bp|, a copy of a loop header.
+void RemoveHeaderInsts(ir::BasicBlock* bp) {
+  for (auto ii = bp->begin(); ii != bp->end();) {
+    if (ii->opcode() == SpvOpPhi || ii->opcode() == SpvOpLoopMerge)
+      ii = ii.Erase();
+    else
+      ++ii;
+  }
+}
+
+// Replaces the terminator of |bp| by a branch to |label|.
+void ReplaceWithBranch(ir::BasicBlock* bp, uint32_t label) {
+  (void)bp->tail().Erase();
+  bp->AddInstruction(std::unique_ptr<ir::Instruction>(
+      new ir::Instruction(SpvOpBranch, 0, 0,
+          {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {label}}})));
+}
+
+}  // namespace
+
+bool LoopUnrollPass::GetShape(ir::Function* func, const Loop* loop,
+                              LoopShape* shape) {
+  ir::BasicBlock* header = loop->header();
+  ir::BasicBlock* preheader = loop->preheader();
+  if (header->GetLoopMergeInst() == nullptr || preheader == nullptr ||
+      loop->latches().size() != 1)
+    return false;
+  ir::BasicBlock* latch = loop->latches()[0];
+  if (latch == header || latch->id() != loop->continue_id() ||
+      latch->tail()->opcode() != SpvOpBranch)
+    return false;
+
+  // The exit test is in the header, or in a block only entered from it.
+  ir::BasicBlock* test = header;
+  if (header->tail()->opcode() == SpvOpBranch) {
+    test = cfg()->block(
+        header->tail()->GetSingleWordInOperand(kBranchTargetLabIdInIdx));
+    if (!loop->Contains(test) || test == latch ||
+        test->GetMergeInst() != nullptr ||
+        cfg()->preds(test->id()).size() != 1)
+      return false;
+  }
+  const ir::Instruction* branch = &*test->tail();
+  if (branch->opcode() != SpvOpBranchConditional) return false;
+  const uint32_t mergeId = loop->merge_id();
+  const uint32_t trueId =
+      branch->GetSingleWordInOperand(kBranchCondTrueLabIdInIdx);
+  const uint32_t falseId =
+      branch->GetSingleWordInOperand(kBranchCondFalseLabIdInIdx);
+  if (trueId == falseId || (trueId != mergeId && falseId != mergeId))
+    return false;
+  const uint32_t bodyId = trueId == mergeId ? falseId : trueId;
+  if (!loop->Contains(bodyId) || bodyId == header->id()) return false;
+
+  // The header phis merge the values of the preheader and of the latch.
+  bool ok = true;
+  header->ForEachPhiInst([&ok](ir::Instruction* phi) {
+    if (phi->NumInOperands() != 4) ok = false;
+  });
+
+  // The test block branching to the merge block is the only way out. The
+  // copies of decorated ids would need their own decorations.
+  std::unordered_set<uint32_t> loopIds;
+  uint32_t size = 0;
+  for (auto bp : loop->blocks()) {
+    bp->ForEachInst([&ok, &loopIds, &size, this](const ir::Instruction* inst) {
+      const uint32_t resultId = inst->result_id();
+      if (resultId != 0) {
+        if (decorated_ids_.count(resultId) != 0) ok = false;
+        loopIds.insert(resultId);
+      }
+      if (inst->opcode() != SpvOpLabel) ++size;
+    });
+    bp->ForEachSuccessorLabel([&ok, bp, test, mergeId,
+                               loop](const uint32_t label) {
+      if (!loop->Contains(label) && !(bp == test && label == mergeId))
+        ok = false;
+    });
+  }
+  if (!ok) return false;
+
+  // Only the values computed before the exit test are available after the
+  // loop. Other blocks may only refer to the loop by entering it or as the
+  // predecessor of the merge block.
+  std::unordered_set<uint32_t> exitIds;
+  for (auto bp : {header, test})
+    for (auto& inst : *bp)
+      if (inst.result_id() != 0) exitIds.insert(inst.result_id());
+  for (auto& blk : *func) {
+    if (loop->Contains(&blk)) continue;
+    const bool isMerge = blk.id() == mergeId;
+    const ir::Instruction* preheaderBranch = &*preheader->tail();
+    blk.ForEachInst([&](const ir::Instruction* inst) {
+      const bool isMergePhi = isMerge && inst->opcode() == SpvOpPhi;
+      inst->ForEachInId([&](const uint32_t* iid) {
+        if (loopIds.count(*iid) == 0) return;
+        if (loop->Contains(*iid)) {
+          if (!(inst == preheaderBranch && *iid == header->id()) &&
+              !(isMergePhi && *iid == test->id()))
+            ok = false;
+        } else if (exitIds.count(*iid) == 0) {
+          ok = false;
+        }
+      });
+    });
+  }
+  if (!ok) return false;
+
+  shape->header = header;
+  shape->preheader = preheader;
+  shape->test = test;
+  shape->latch = latch;
+  shape->merge_id = mergeId;
+  shape->body_id = bodyId;
+  shape->blocks = loop->blocks();
+  shape->size = size;
+  return true;
+}
+
+bool LoopUnrollPass::GetIntConstant(uint32_t id, uint32_t* value) const {
+  const ir::Instruction* cInst = get_def_use_mgr()->GetDef(id);
+  if (cInst == nullptr || cInst->opcode() != SpvOpConstant) return false;
+  const ir::Instruction* typeInst =
+      get_def_use_mgr()->GetDef(cInst->type_id());
+  if (typeInst->opcode() != SpvOpTypeInt ||
+      typeInst->GetSingleWordInOperand(kTypeIntWidthInIdx) != 32)
+    return false;
+  *value = cInst->GetSingleWordInOperand(kConstantValueInIdx);
+  return true;
+}
+
+bool LoopUnrollPass::GetTripCount(const LoopShape& shape, uint32_t max_trips,
+                                  uint32_t* trip_count) {
+  const ir::Instruction* branch = &*shape.test->tail();
+  const bool continueIfTrue =
+      branch->GetSingleWordInOperand(kBranchCondTrueLabIdInIdx) ==
+      shape.body_id;
+  const ir::Instruction* cond = get_def_use_mgr()->GetDef(
+      branch->GetSingleWordInOperand(kBranchCondConditionalIdInIdx));
+  if (cond == nullptr || !IsFoldableScalarOp(cond->opcode()) ||
+      cond->NumInOperands() != 2)
+    return false;
+
+  // The condition compares a header phi with a constant.
+  const ir::Instruction* iv = nullptr;
+  uint32_t ivIdx = 0;
+  uint32_t bound = 0;
+  for (uint32_t i = 0; i < 2; ++i) {
+    const ir::Instruction* opInst =
+        get_def_use_mgr()->GetDef(cond->GetSingleWordInOperand(i));
+    if (opInst != nullptr && opInst->opcode() == SpvOpPhi &&
+        GetIntConstant(cond->GetSingleWordInOperand(1 - i), &bound)) {
+      iv = opInst;
+      ivIdx = i;
+      break;
+    }
+  }
+  if (iv == nullptr) return false;
+  bool inHeader = false;
+  shape.header->ForEachPhiInst(
+      [iv, &inHeader](ir::Instruction* phi) { inHeader |= phi == iv; });
+  if (!inHeader) return false;
+
+  // The phi starts at a constant and is stepped by a constant.
+  uint32_t value = 0;
+  if (!GetIntConstant(PhiValue(iv, shape.preheader->id()), &value))
+    return false;
+  const ir::Instruction* next =
+      get_def_use_mgr()->GetDef(PhiValue(iv, shape.latch->id()));
+  if (next == nullptr ||
+      (next->opcode() != SpvOpIAdd && next->opcode() != SpvOpISub))
+    return false;
+  uint32_t stepIdx = 1;
+  if (next->GetSingleWordInOperand(0) != iv->result_id()) {
+    if (next->opcode() == SpvOpISub ||
+        next->GetSingleWordInOperand(1) != iv->result_id())
+      return false;
+    stepIdx = 0;
+  }
+  uint32_t step = 0;
+  if (!GetIntConstant(next->GetSingleWordInOperand(stepIdx), &step))
+    return false;
+
+  // Run the loop control with the constant values.
+  uint32_t count = 0;
+  for (;;) {
+    std::vector<uint32_t> condWords = {value, value};
+    condWords[1 - ivIdx] = bound;
+    uint32_t taken = 0;
+    if (!FoldScalarWords(cond->opcode(), condWords, &taken)) return false;
+    if ((taken != 0) != continueIfTrue) break;
+    if (++count > max_trips) return false;
+    std::vector<uint32_t> nextWords = {value, value};
+    nextWords[stepIdx] = step;
+    if (!FoldScalarWords(next->opcode(), nextWords, &value)) return false;
+  }
+  *trip_count = count;
+  return true;
+}
+
+std::vector<std::unique_ptr<ir::BasicBlock>> LoopUnrollPass::CloneBlocks(
+    const std::vector<ir::BasicBlock*>& blocks,
+    std::unordered_map<uint32_t, uint32_t>* id_map) {
+  // All ids are taken first, as a phi can refer to a later block.
+  for (auto bp : blocks) {
+    bp->ForEachInst([id_map, this](const ir::Instruction* inst) {
+      const uint32_t resultId = inst->result_id();
+      if (resultId != 0 && id_map->count(resultId) == 0)
+        (*id_map)[resultId] = TakeNextId();
+    });
+  }
+  std::vector<std::unique_ptr<ir::BasicBlock>> copies;
+  for (auto bp : blocks) {
+    std::unique_ptr<ir::BasicBlock> copy(new ir::BasicBlock(*bp));
+    copy->ForEachInst([id_map](ir::Instruction* inst) {
+      if (inst->result_id() != 0)
+        inst->SetResultId(MapId(*id_map, inst->result_id()));
+      inst->ForEachInId(
+          [id_map](uint32_t* iid) { *iid = MapId(*id_map, *iid); });
+    });
+    // Loops nested in this one have already been considered.
+    if (processed_headers_.count(bp->id()) != 0)
+      processed_headers_.insert(copy->id());
+    copies.push_back(std::move(copy));
+  }
+  return copies;
+}
+
+void LoopUnrollPass::FullyUnroll(ir::Function* func, const LoopShape& shape,
+                                 uint32_t trip_count) {
+  for (auto bp : shape.blocks)
+    bp->ForEachInst(
+        [this](ir::Instruction* inst) { KillNamesAndDecorates(inst); });
+
+  // Each copy of the loop blocks is an iteration, where the header phis are
+  // replaced by the values of the preheader or of the previous latch. The
+  // last copy only computes the exit test.
+  std::vector<ir::BasicBlock*> exitBlocks(1, shape.header);
+  if (shape.test != shape.header) exitBlocks.push_back(shape.test);
+  std::vector<std::unique_ptr<ir::BasicBlock>> newBlocks;
+  std::unordered_map<uint32_t, uint32_t> prevMap;
+  ir::Instruction* prevBranch = &*shape.preheader->tail();
+  for (uint32_t k = 0; k <= trip_count; ++k) {
+    std::unordered_map<uint32_t, uint32_t> idMap;
+    shape.header->ForEachPhiInst([k, &shape, &idMap,
+                                  &prevMap](ir::Instruction* phi) {
+      idMap[phi->result_id()] =
+          k == 0 ? PhiValue(phi, shape.preheader->id())
+                 : MapId(prevMap, PhiValue(phi, shape.latch->id()));
+    });
+    const bool last = k == trip_count;
+    auto copies = CloneBlocks(last ? exitBlocks : shape.blocks, &idMap);
+    // Dominators come first, so the header is the first block.
+    ir::BasicBlock* header = copies.front().get();
+    RemoveHeaderInsts(header);
+    ReplaceWithBranch(FindBlock(copies, idMap[shape.test->id()]),
+                      last ? shape.merge_id : idMap[shape.body_id]);
+    prevBranch->SetInOperand(kBranchTargetLabIdInIdx, {header->id()});
+    if (!last)
+      prevBranch = &*FindBlock(copies, idMap[shape.latch->id()])->tail();
+    for (auto& bp : copies) {
+      bp->SetParent(func);
+      newBlocks.push_back(std::move(bp));
+    }
+    prevMap = std::move(idMap);
+  }
+
+  // The code after the loop uses the values of the last exit test.
+  std::unordered_set<uint32_t> loopLabels;
+  for (auto bp : shape.blocks) loopLabels.insert(bp->id());
+  for (auto& blk : *func) {
+    if (loopLabels.count(blk.id()) != 0) continue;
+    blk.ForEachInst([&prevMap](ir::Instruction* inst) {
+      inst->ForEachInId(
+          [&prevMap](uint32_t* iid) { *iid = MapId(prevMap, *iid); });
+    });
+  }
+
+  // The copies take the place of the loop.
+  const uint32_t headerId = shape.header->id();
+  for (auto bi = func->begin(); bi != func->end();) {
+    if (bi->id() != headerId && loopLabels.count(bi->id()) != 0)
+      bi = bi.Erase();
+    else
+      ++bi;
+  }
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    if (bi->id() != headerId) continue;
+    bi = bi.Erase();
+    (void)bi.InsertBefore(&newBlocks);
+    break;
+  }
+}
+
+void LoopUnrollPass::PartiallyUnroll(ir::Function* func,
+                                     const LoopShape& shape,
+                                     uint32_t factor) {
+  // Each copy starts with the values of the previous latch and goes on to
+  // the next copy, the last one going back to the header.
+  std::vector<std::unique_ptr<ir::BasicBlock>> newBlocks;
+  std::vector<std::unordered_map<uint32_t, uint32_t>> copyMaps;
+  std::unordered_map<uint32_t, uint32_t> prevMap;
+  ir::BasicBlock* prevLatch = shape.latch;
+  for (uint32_t k = 1; k < factor; ++k) {
+    std::unordered_map<uint32_t, uint32_t> idMap;
+    shape.header->ForEachPhiInst([&shape, &idMap,
+                                  &prevMap](ir::Instruction* phi) {
+      idMap[phi->result_id()] =
+          MapId(prevMap, PhiValue(phi, shape.latch->id()));
+    });
+    auto copies = CloneBlocks(shape.blocks, &idMap);
+    ir::BasicBlock* header = copies.front().get();
+    RemoveHeaderInsts(header);
+    prevLatch->tail()->SetInOperand(kBranchTargetLabIdInIdx, {header->id()});
+    prevLatch = FindBlock(copies, idMap[shape.latch->id()]);
+    for (auto& bp : copies) {
+      bp->SetParent(func);
+      newBlocks.push_back(std::move(bp));
+    }
+    prevMap = idMap;
+    copyMaps.push_back(std::move(idMap));
+  }
+  prevLatch->tail()->SetInOperand(kBranchTargetLabIdInIdx,
+                                  {shape.header->id()});
+  const uint32_t latchId = shape.latch->id();
+  shape.header->ForEachPhiInst([latchId, prevLatch,
+                                &prevMap](ir::Instruction* phi) {
+    for (uint32_t i = 1; i < phi->NumInOperands(); i += 2) {
+      if (phi->GetSingleWordInOperand(i) != latchId) continue;
+      phi->SetInOperand(i - 1,
+                        {MapId(prevMap, phi->GetSingleWordInOperand(i - 1))});
+      phi->SetInOperand(i, {prevLatch->id()});
+    }
+  });
+  shape.header->GetLoopMergeInst()->SetInOperand(
+      kLoopMergeContinueBlockIdInIdx, {prevLatch->id()});
+
+  // Every copy of the test block now branches to the merge block.
+  const uint32_t testId = shape.test->id();
+  ir::BasicBlock* merge = cfg()->block(shape.merge_id);
+  auto mergePhiEnd = merge->begin();
+  while (mergePhiEnd != merge->end() && mergePhiEnd->opcode() == SpvOpPhi) {
+    std::vector<ir::Operand> operands;
+    for (uint32_t i = 0; i < mergePhiEnd->NumInOperands(); ++i)
+      operands.push_back(mergePhiEnd->GetInOperand(i));
+    const uint32_t value = PhiValue(&*mergePhiEnd, testId);
+    for (auto& idMap : copyMaps) {
+      operands.push_back(
+          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {MapId(idMap, value)}});
+      operands.push_back(
+          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {idMap[testId]}});
+    }
+    (void)mergePhiEnd.InsertBefore(std::unique_ptr<ir::Instruction>(
+        new ir::Instruction(SpvOpPhi, mergePhiEnd->type_id(),
+                            mergePhiEnd->result_id(), operands)));
+    mergePhiEnd = mergePhiEnd.Erase();
+  }
+
+  // Values of the header and test block used after the loop now come from
+  // any of the copies, so they are merged by new phis.
+  std::unordered_set<uint32_t> loopLabels;
+  for (auto bp : shape.blocks) loopLabels.insert(bp->id());
+  std::vector<ir::BasicBlock*> exitBlocks(1, shape.header);
+  if (shape.test != shape.header) exitBlocks.push_back(shape.test);
+  std::unordered_set<uint32_t> exitIds;
+  for (auto bp : exitBlocks)
+    for (auto& inst : *bp)
+      if (inst.result_id() != 0) exitIds.insert(inst.result_id());
+  std::unordered_set<uint32_t> usedAfter;
+  for (auto& blk : *func) {
+    if (loopLabels.count(blk.id()) != 0) continue;
+    const bool isMerge = &blk == merge;
+    blk.ForEachInst([isMerge, &exitIds, &usedAfter](ir::Instruction* inst) {
+      if (isMerge && inst->opcode() == SpvOpPhi) return;
+      inst->ForEachInId([&exitIds, &usedAfter](const uint32_t* iid) {
+        if (exitIds.count(*iid) != 0) usedAfter.insert(*iid);
+      });
+    });
+  }
+  std::unordered_map<uint32_t, uint32_t> exitPhis;
+  for (auto bp : exitBlocks) {
+    for (auto& inst : *bp) {
+      if (usedAfter.count(inst.result_id()) == 0) continue;
+      std::vector<ir::Operand> operands = {
+          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {inst.result_id()}},
+          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {testId}}};
+      for (auto& idMap : copyMaps) {
+        operands.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                            {MapId(idMap, inst.result_id())}});
+        operands.push_back(
+            {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {idMap[testId]}});
+      }
+      const uint32_t phiId = TakeNextId();
+      (void)mergePhiEnd.InsertBefore(std::unique_ptr<ir::Instruction>(
+          new ir::Instruction(SpvOpPhi, inst.type_id(), phiId, operands)));
+      exitPhis[inst.result_id()] = phiId;
+    }
+  }
+  for (auto& blk : *func) {
+    if (loopLabels.count(blk.id()) != 0) continue;
+    const bool isMerge = &blk == merge;
+    blk.ForEachInst([isMerge, &exitPhis](ir::Instruction* inst) {
+      // The new phis are not changed either: they come after the old ones.
+      if (isMerge && inst->opcode() == SpvOpPhi) return;
+      inst->ForEachInId(
+          [&exitPhis](uint32_t* iid) { *iid = MapId(exitPhis, *iid); });
+    });
+  }
+
+  // The copies follow the loop blocks.
+  const uint32_t lastId = shape.blocks.back()->id();
+  for (auto bi = func->begin(); bi != func->end(); ++bi) {
+    if (bi->id() != lastId) continue;
+    ++bi;
+    (void)bi.InsertBefore(&newBlocks);
+    break;
+  }
+}
+
+bool LoopUnrollPass::UnrollLoops(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  bool modified = false;
+  // The loops are found again after each change, so that a loop whose inner
+  // loops were fully unrolled can be unrolled in turn.
+  for (bool changed = true; changed;) {
+    changed = false;
+    LoopDescriptor* loops = context()->GetLoopDescriptor(func);
+    for (auto loop : loops->PostOrder()) {
+      if (!processed_headers_.insert(loop->header()->id()).second) continue;
+      LoopShape shape;
+      if (!GetShape(func, loop, &shape)) continue;
+      uint32_t tripCount = 0;
+      if (GetTripCount(shape, size_budget_ / shape.size, &tripCount)) {
+        FullyUnroll(func, shape, tripCount);
+        changed = true;
+        break;
+      }
+      // Copying a loop also copies the loops nested in it, so only
+      // innermost loops are partially unrolled.
+      const uint32_t factor =
+          std::min(kMaxPartialUnrollFactor, size_budget_ / shape.size);
+      if (loop->children().empty() && factor > 1) {
+        PartiallyUnroll(func, shape, factor);
+        changed = true;
+        break;
+      }
+    }
+    if (changed) {
+      modified = true;
+      InitializeProcessing(context());
+      context()->InvalidateDominatorAnalyses();
+    }
+  }
+  return modified;
+}
+
+void LoopUnrollPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+  decorated_ids_.clear();
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() != SpvOpDecorationGroup && ai.NumInOperands() > 0)
+      decorated_ids_.insert(ai.GetSingleWordInOperand(0));
+  processed_headers_.clear();
+}
+
+Pass::Status LoopUnrollPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) { return UnrollLoops(fp); };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+LoopUnrollPass::LoopUnrollPass(uint32_t size_budget)
+    : size_budget_(size_budget) {}
+
+Pass::Status LoopUnrollPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,116 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_LOOP_UNROLL_PASS_H_
+#define LIBSPIRV_OPT_LOOP_UNROLL_PASS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "loop_descriptor.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class LoopUnrollPass : public MemPass {
+ public:
+  explicit LoopUnrollPass(uint32_t size_budget);
+  const char* name() const override { return "loop-unroll"; }
+  Status Process(ir::IRContext*) override;
+
+ private:
+  // The blocks of a loop that can be unrolled.
+  struct LoopShape {
+    ir::BasicBlock* header;
+    ir::BasicBlock* preheader;
+    // The block ending with the conditional branch leaving the loop. Either
+    // the header or its only successor.
+    ir::BasicBlock* test;
+    // The continue target, which is the only block branching to the header.
+    ir::BasicBlock* latch;
+    uint32_t merge_id;
+    // The target of the test that stays in the loop.
+    uint32_t body_id;
+    // All blocks of the loop, in function order.
+    std::vector<ir::BasicBlock*> blocks;
+    // Number of instructions in the loop.
+    uint32_t size;
+  };
+
+  // Returns true and fills |shape| if |loop| of |func| is a structured loop
+  // entered from a preheader, continued from its continue target alone and
+  // left only through a conditional branch of its header or of the header's
+  // successor. Also checks that the only references to the loop from outside
+  // are the preheader branch, the phis of the merge block and uses of values
+  // computed before the exit test.
+  bool GetShape(ir::Function* func, const Loop* loop, LoopShape* shape);
+
+  // Returns true and sets |value| if |id| is a 32-bit integer constant.
+  bool GetIntConstant(uint32_t id, uint32_t* value) const;
+
+  // Returns true and sets |trip_count| if the exit test of |shape| compares
+  // an induction variable of the header with a constant, the induction
+  // variable starts at a constant and is incremented or decremented by a
+  // constant, and the body is executed at most |max_trips| times.
+  bool GetTripCount(const LoopShape& shape, uint32_t max_trips,
+                    uint32_t* trip_count);
+
+  // Returns a copy of |blocks| where the result ids are replaced by new ids
+  // and the references to them are updated. Ids already in |id_map|, such
+  // as those of the header phis, are replaced by their entry. The new ids
+  // are added to |id_map|.
+  std::vector<std::unique_ptr<ir::BasicBlock>> CloneBlocks(
+      const std::vector<ir::BasicBlock*>& blocks,
+      std::unordered_map<uint32_t, uint32_t>* id_map);
+
+  // Replaces the loop of |shape| in |func| by |trip_count| copies of its
+  // blocks, followed by a copy of its header and test block branching to
+  // the merge block.
+  void FullyUnroll(ir::Function* func, const LoopShape& shape,
+                   uint32_t trip_count);
+
+  // Adds |factor| - 1 copies of the blocks of the loop of |shape| after its
+  // latch, each keeping its exit test, and makes the last copy of the latch
+  // the continue target.
+  void PartiallyUnroll(ir::Function* func, const LoopShape& shape,
+                       uint32_t factor);
+
+  // Unrolls the loops of |func| fitting in the size budget, innermost loops
+  // first. Returns true if |func| is modified.
+  bool UnrollLoops(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Maximum number of instructions in an unrolled loop.
+  uint32_t size_budget_;
+
+  // Ids with decorations, which are not duplicated.
+  std::unordered_set<uint32_t> decorated_ids_;
+
+  // Headers of the loops already considered for unrolling.
+  std::unordered_set<uint32_t> processed_headers_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_LOOP_UNROLL_PASS_H_
@@ -18,6 +18,7 @@
 
 #include "basic_block.h"
 #include "cfa.h"
+#include "dominator_analysis.h"
 #include "iterator.h"
 
 namespace spvtools {
@@ -28,7 +29,6 @@ namespace {
 const uint32_t kAccessChainPtrIdInIdx = 0;
 const uint32_t kCopyObjectOperandInIdx = 0;
 const uint32_t kLoadPtrIdInIdx = 0;
-const uint32_t kLoopMergeMergeBlockIdInIdx = 0;
 const uint32_t kStorePtrIdInIdx = 0;
 const uint32_t kStoreValIdInIdx = 1;
 const uint32_t kTypePointerStorageClassInIdx = 0;
@@ -274,6 +274,7 @@ void MemPass::InitSSARewrite(ir::Function* func) {
   type2undefs_.clear();
   supported_ref_vars_.clear();
   label2ssa_map_.clear();
+  label2phi_vars_.clear();
   phis_to_patch_.clear();
 
   // Collect target (and non-) variable sets. Remove variables with
@@ -297,24 +298,6 @@ void MemPass::InitSSARewrite(ir::Function* func) {
   }
 }
 
-bool MemPass::IsLiveAfter(uint32_t var_id, uint32_t label) const {
-  // For now, return very conservative result: true. This will result in
-  // correct, but possibly usused, phi code to be generated. A subsequent
-  // DCE pass should eliminate this code.
-  // TODO(greg-lunarg): Return more accurate information
-  (void)var_id;
-  (void)label;
-  return true;
-}
-
-void MemPass::SSABlockInitSinglePred(ir::BasicBlock* block_ptr) {
-  // Copy map entry from single predecessor
-  const uint32_t label = block_ptr->id();
-  const uint32_t predLabel = cfg()->preds(label).front();
-  assert(visitedBlocks_.find(predLabel) != visitedBlocks_.end());
-  label2ssa_map_[label] = label2ssa_map_[predLabel];
-}
-
 uint32_t MemPass::Type2Undef(uint32_t type_id) {
   const auto uitr = type2undefs_.find(type_id);
   if (uitr != type2undefs_.end()) return uitr->second;
@@ -327,175 +310,109 @@ uint32_t MemPass::Type2Undef(uint32_t type_id) {
   return undefId;
 }
 
-void MemPass::SSABlockInitLoopHeader(
-    std::list<ir::BasicBlock*>::iterator block_itr) {
-  const uint32_t label = (*block_itr)->id();
+bool MemPass::IsTargetVar(uint32_t varId) {
+  if (seen_non_target_vars_.find(varId) != seen_non_target_vars_.end())
+    return false;
+  if (seen_target_vars_.find(varId) != seen_target_vars_.end()) return true;
+  const ir::Instruction* varInst = get_def_use_mgr()->GetDef(varId);
+  if (varInst->opcode() != SpvOpVariable) return false;
+  ;
+  const uint32_t varTypeId = varInst->type_id();
+  const ir::Instruction* varTypeInst = get_def_use_mgr()->GetDef(varTypeId);
+  if (varTypeInst->GetSingleWordInOperand(kTypePointerStorageClassInIdx) !=
+      SpvStorageClassFunction) {
+    seen_non_target_vars_.insert(varId);
+    return false;
+  }
+  const uint32_t varPteTypeId =
+      varTypeInst->GetSingleWordInOperand(kTypePointerTypeIdInIdx);
+  ir::Instruction* varPteTypeInst = get_def_use_mgr()->GetDef(varPteTypeId);
+  if (!IsTargetType(varPteTypeInst)) {
+    seen_non_target_vars_.insert(varId);
+    return false;
+  }
+  seen_target_vars_.insert(varId);
+  return true;
+}
 
-  // Determine the back-edge label.
-  uint32_t backLabel = 0;
-  for (uint32_t predLabel : cfg()->preds(label))
-    if (visitedBlocks_.find(predLabel) == visitedBlocks_.end()) {
-      assert(backLabel == 0);
-      backLabel = predLabel;
-      break;
-    }
-  assert(backLabel != 0);
-
-  // Determine merge block.
-  auto mergeInst = (*block_itr)->end();
-  --mergeInst;
-  --mergeInst;
-  uint32_t mergeLabel =
-      mergeInst->GetSingleWordInOperand(kLoopMergeMergeBlockIdInIdx);
-
-  // Collect all live variables and a default value for each across all
-  // non-backedge predecesors. Must be ordered map because phis are
-  // generated based on order and test results will otherwise vary across
+void MemPass::PlacePhis(ir::Function* func) {
+  // Find the blocks that store each target variable, and the blocks that
+  // load it before any store in the block. Must be ordered map because phis
+  // are generated based on order and test results will otherwise vary across
   // platforms.
-  std::map<uint32_t, uint32_t> liveVars;
-  for (uint32_t predLabel : cfg()->preds(label)) {
-    for (auto var_val : label2ssa_map_[predLabel]) {
-      uint32_t varId = var_val.first;
-      liveVars[varId] = var_val.second;
-    }
-  }
-  // Add all stored variables in loop. Set their default value id to zero.
-  for (auto bi = block_itr; (*bi)->id() != mergeLabel; ++bi) {
-    ir::BasicBlock* bp = *bi;
-    for (auto ii = bp->begin(); ii != bp->end(); ++ii) {
-      if (ii->opcode() != SpvOpStore) {
-        continue;
-      }
+  std::map<uint32_t, std::vector<ir::BasicBlock*>> var2def_blocks;
+  std::unordered_map<uint32_t, std::vector<uint32_t>> var2use_labels;
+  for (auto& blk : *func) {
+    std::unordered_set<uint32_t> stored;
+    std::unordered_set<uint32_t> loaded;
+    for (auto& inst : blk) {
+      if (inst.opcode() != SpvOpStore && inst.opcode() != SpvOpLoad) continue;
       uint32_t varId;
-      (void)GetPtr(&*ii, &varId);
-      if (!IsTargetVar(varId)) {
-        continue;
+      (void)GetPtr(&inst, &varId);
+      if (!IsTargetVar(varId)) continue;
+      if (inst.opcode() == SpvOpStore) {
+        if (stored.insert(varId).second)
+          var2def_blocks[varId].push_back(&blk);
+      } else if (stored.count(varId) == 0 && loaded.insert(varId).second) {
+        var2use_labels[varId].push_back(blk.id());
       }
-      liveVars[varId] = 0;
     }
   }
-  // Insert phi for all live variables that require them. All variables
-  // defined in loop require a phi. Otherwise all variables
-  // with differing predecessor values require a phi.
-  auto insertItr = (*block_itr)->begin();
-  for (auto var_val : liveVars) {
-    const uint32_t varId = var_val.first;
-    if (!IsLiveAfter(varId, label)) {
-      continue;
-    }
-    const uint32_t val0Id = var_val.second;
-    bool needsPhi = false;
-    if (val0Id != 0) {
-      for (uint32_t predLabel : cfg()->preds(label)) {
-        // Skip back edge predecessor.
-        if (predLabel == backLabel) continue;
-        const auto var_val_itr = label2ssa_map_[predLabel].find(varId);
-        // Missing (undef) values always cause difference with (defined) value
-        if (var_val_itr == label2ssa_map_[predLabel].end()) {
-          needsPhi = true;
-          break;
-        }
-        if (var_val_itr->second != val0Id) {
-          needsPhi = true;
-          break;
-        }
-      }
-    } else {
-      needsPhi = true;
-    }
-
-    // If val is the same for all predecessors, enter it in map
-    if (!needsPhi) {
-      label2ssa_map_[label].insert(var_val);
-      continue;
-    }
 
-    // Val differs across predecessors. Add phi op to block and
-    // add its result id to the map. For back edge predecessor,
-    // use the variable id. We will patch this after visiting back
-    // edge predecessor. For predecessors that do not define a value,
-    // use undef.
-    std::vector<ir::Operand> phi_in_operands;
-    uint32_t typeId = GetPointeeTypeId(get_def_use_mgr()->GetDef(varId));
-    for (uint32_t predLabel : cfg()->preds(label)) {
-      uint32_t valId;
-      if (predLabel == backLabel) {
-        valId = varId;
-      } else {
-        const auto var_val_itr = label2ssa_map_[predLabel].find(varId);
-        if (var_val_itr == label2ssa_map_[predLabel].end())
-          valId = Type2Undef(typeId);
-        else
-          valId = var_val_itr->second;
+  opt::DominatorAnalysis* dom_tree = context()->GetDominatorAnalysis(func);
+  std::vector<ir::BasicBlock*> idf;
+  for (const auto& var_defs : var2def_blocks) {
+    const uint32_t varId = var_defs.first;
+    const auto uses_itr = var2use_labels.find(varId);
+    if (uses_itr == var2use_labels.end()) continue;
+    // The variable is live on entry to the blocks that load it before
+    // storing it, and to every block from which one of those is reachable
+    // without passing a store.
+    std::unordered_set<uint32_t> def_labels;
+    for (auto bp : var_defs.second) def_labels.insert(bp->id());
+    std::unordered_set<uint32_t> live_in(uses_itr->second.begin(),
+                                         uses_itr->second.end());
+    std::vector<uint32_t> worklist(uses_itr->second);
+    while (!worklist.empty()) {
+      const uint32_t label = worklist.back();
+      worklist.pop_back();
+      for (uint32_t predLabel : cfg()->preds(label)) {
+        if (def_labels.count(predLabel) != 0) continue;
+        if (live_in.insert(predLabel).second) worklist.push_back(predLabel);
       }
-      phi_in_operands.push_back(
-          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {valId}});
-      phi_in_operands.push_back(
-          {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {predLabel}});
     }
-    const uint32_t phiId = TakeNextId();
-    std::unique_ptr<ir::Instruction> newPhi(
-        new ir::Instruction(SpvOpPhi, typeId, phiId, phi_in_operands));
-    // The only phis requiring patching are the ones we create.
-    phis_to_patch_.insert(phiId);
-    // Only analyze the phi define now; analyze the phi uses after the
-    // phi backedge predecessor value is patched.
-    get_def_use_mgr()->AnalyzeInstDef(&*newPhi);
-    insertItr = insertItr.InsertBefore(std::move(newPhi));
-    ++insertItr;
-    label2ssa_map_[label].insert({varId, phiId});
+    dom_tree->IteratedDominanceFrontier(var_defs.second, &idf);
+    for (auto bp : idf)
+      if (live_in.count(bp->id()) != 0)
+        label2phi_vars_[bp->id()].push_back(varId);
   }
 }
 
-void MemPass::SSABlockInitMultiPred(ir::BasicBlock* block_ptr) {
+void MemPass::SSABlockInit(ir::BasicBlock* block_ptr, ir::BasicBlock* idom) {
   const uint32_t label = block_ptr->id();
-  // Collect all live variables and a default value for each across all
-  // predecesors. Must be ordered map because phis are generated based on
-  // order and test results will otherwise vary across platforms.
-  std::map<uint32_t, uint32_t> liveVars;
-  for (uint32_t predLabel : cfg()->preds(label)) {
-    assert(visitedBlocks_.find(predLabel) != visitedBlocks_.end());
-    for (auto var_val : label2ssa_map_[predLabel]) {
-      const uint32_t varId = var_val.first;
-      liveVars[varId] = var_val.second;
-    }
-  }
-  // For each live variable, look for a difference in values across
-  // predecessors that would require a phi and insert one.
+  // Values that reach the block without passing a phi come from the
+  // immediate dominator.
+  if (idom != nullptr) label2ssa_map_[label] = label2ssa_map_[idom->id()];
+  const auto phi_vars_itr = label2phi_vars_.find(label);
+  if (phi_vars_itr == label2phi_vars_.end()) return;
   auto insertItr = block_ptr->begin();
-  for (auto var_val : liveVars) {
-    const uint32_t varId = var_val.first;
-    if (!IsLiveAfter(varId, label)) continue;
-    const uint32_t val0Id = var_val.second;
-    bool differs = false;
-    for (uint32_t predLabel : cfg()->preds(label)) {
-      const auto var_val_itr = label2ssa_map_[predLabel].find(varId);
-      // Missing values cause a difference because we'll need to create an
-      // undef for that predecessor.
-      if (var_val_itr == label2ssa_map_[predLabel].end()) {
-        differs = true;
-        break;
-      }
-      if (var_val_itr->second != val0Id) {
-        differs = true;
-        break;
-      }
-    }
-    // If val is the same for all predecessors, enter it in map
-    if (!differs) {
-      label2ssa_map_[label].insert(var_val);
-      continue;
-    }
-    // Val differs across predecessors. Add phi op to block and add its result
-    // id to the map.
+  for (uint32_t varId : phi_vars_itr->second) {
+    // Use the value at the end of each visited predecessor, or undef if the
+    // variable is not defined on that path. Use the variable id for the
+    // other predecessors until PatchPhis.
     std::vector<ir::Operand> phi_in_operands;
     const uint32_t typeId = GetPointeeTypeId(get_def_use_mgr()->GetDef(varId));
+    bool complete = true;
     for (uint32_t predLabel : cfg()->preds(label)) {
-      const auto var_val_itr = label2ssa_map_[predLabel].find(varId);
-      // If variable not defined on this path, use undef
-      const uint32_t valId = (var_val_itr != label2ssa_map_[predLabel].end())
-                                 ? var_val_itr->second
-                                 : Type2Undef(typeId);
+      uint32_t valId = varId;
+      if (visitedBlocks_.find(predLabel) != visitedBlocks_.end()) {
+        const auto var_val_itr = label2ssa_map_[predLabel].find(varId);
+        valId = (var_val_itr != label2ssa_map_[predLabel].end())
+                    ? var_val_itr->second
+                    : Type2Undef(typeId);
+      } else {
+        complete = false;
+      }
       phi_in_operands.push_back(
           {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {valId}});
       phi_in_operands.push_back(
@@ -504,151 +421,100 @@ void MemPass::SSABlockInitMultiPred(ir::BasicBlock* block_ptr) {
     const uint32_t phiId = TakeNextId();
     std::unique_ptr<ir::Instruction> newPhi(
         new ir::Instruction(SpvOpPhi, typeId, phiId, phi_in_operands));
-    get_def_use_mgr()->AnalyzeInstDefUse(&*newPhi);
+    if (complete) {
+      get_def_use_mgr()->AnalyzeInstDefUse(&*newPhi);
+    } else {
+      // Only analyze the phi define now; analyze the phi uses after the
+      // missing values are patched.
+      get_def_use_mgr()->AnalyzeInstDef(&*newPhi);
+      phis_to_patch_.push_back({&*newPhi, varId});
+    }
     insertItr = insertItr.InsertBefore(std::move(newPhi));
     ++insertItr;
-    label2ssa_map_[label].insert({varId, phiId});
+    label2ssa_map_[label][varId] = phiId;
   }
 }
 
-void MemPass::SSABlockInit(std::list<ir::BasicBlock*>::iterator block_itr) {
-  const size_t numPreds = cfg()->preds((*block_itr)->id()).size();
-  if (numPreds == 0) return;
-  if (numPreds == 1)
-    SSABlockInitSinglePred(*block_itr);
-  else if ((*block_itr)->IsLoopHeader())
-    SSABlockInitLoopHeader(block_itr);
-  else
-    SSABlockInitMultiPred(*block_itr);
-}
-
-bool MemPass::IsTargetVar(uint32_t varId) {
-  if (seen_non_target_vars_.find(varId) != seen_non_target_vars_.end())
-    return false;
-  if (seen_target_vars_.find(varId) != seen_target_vars_.end()) return true;
-  const ir::Instruction* varInst = get_def_use_mgr()->GetDef(varId);
-  if (varInst->opcode() != SpvOpVariable) return false;
-  ;
-  const uint32_t varTypeId = varInst->type_id();
-  const ir::Instruction* varTypeInst = get_def_use_mgr()->GetDef(varTypeId);
-  if (varTypeInst->GetSingleWordInOperand(kTypePointerStorageClassInIdx) !=
-      SpvStorageClassFunction) {
-    seen_non_target_vars_.insert(varId);
-    return false;
-  }
-  const uint32_t varPteTypeId =
-      varTypeInst->GetSingleWordInOperand(kTypePointerTypeIdInIdx);
-  ir::Instruction* varPteTypeInst = get_def_use_mgr()->GetDef(varPteTypeId);
-  if (!IsTargetType(varPteTypeInst)) {
-    seen_non_target_vars_.insert(varId);
-    return false;
+void MemPass::SSABlockRewrite(ir::BasicBlock* block_ptr) {
+  const uint32_t label = block_ptr->id();
+  for (auto ii = block_ptr->begin(); ii != block_ptr->end(); ++ii) {
+    switch (ii->opcode()) {
+      case SpvOpStore: {
+        uint32_t varId;
+        (void)GetPtr(&*ii, &varId);
+        if (!IsTargetVar(varId)) break;
+        // Register new stored value for the variable
+        label2ssa_map_[label][varId] =
+            ii->GetSingleWordInOperand(kStoreValIdInIdx);
+      } break;
+      case SpvOpLoad: {
+        uint32_t varId;
+        (void)GetPtr(&*ii, &varId);
+        if (!IsTargetVar(varId)) break;
+        uint32_t replId = 0;
+        const auto ssaItr = label2ssa_map_.find(label);
+        if (ssaItr != label2ssa_map_.end()) {
+          const auto valItr = ssaItr->second.find(varId);
+          if (valItr != ssaItr->second.end()) replId = valItr->second;
+        }
+        // If variable is not defined, use undef
+        if (replId == 0) {
+          replId =
+              Type2Undef(GetPointeeTypeId(get_def_use_mgr()->GetDef(varId)));
+        }
+        // Replace load's id with the last stored value id for variable
+        // and delete load. Kill any names or decorates using id before
+        // replacing to prevent incorrect replacement in those instructions.
+        const uint32_t loadId = ii->result_id();
+        KillNamesAndDecorates(loadId);
+        (void)get_def_use_mgr()->ReplaceAllUsesWith(loadId, replId);
+        get_def_use_mgr()->KillInst(&*ii);
+      } break;
+      default: { } break; }
   }
-  seen_target_vars_.insert(varId);
-  return true;
-}
-
-void MemPass::PatchPhis(uint32_t header_id, uint32_t back_id) {
-  ir::BasicBlock* header = cfg()->block(header_id);
-  auto phiItr = header->begin();
-  for (; phiItr->opcode() == SpvOpPhi; ++phiItr) {
-    // Only patch phis that we created in a loop header.
-    // There might be other phis unrelated to our optimizations.
-    if (0 == phis_to_patch_.count(phiItr->result_id())) continue;
-
-    // Find phi operand index for back edge
-    uint32_t cnt = 0;
-    uint32_t idx = phiItr->NumInOperands();
-    phiItr->ForEachInId([&cnt, &back_id, &idx](uint32_t* iid) {
-      if (cnt % 2 == 1 && *iid == back_id) idx = cnt - 1;
-      ++cnt;
-    });
-    assert(idx != phiItr->NumInOperands());
-    // Replace temporary phi operand with variable's value in backedge block
-    // map. Use undef if variable not in map.
-    const uint32_t varId = phiItr->GetSingleWordInOperand(idx);
-    const auto valItr = label2ssa_map_[back_id].find(varId);
-    uint32_t valId =
-        (valItr != label2ssa_map_[back_id].end())
-            ? valItr->second
-            : Type2Undef(GetPointeeTypeId(get_def_use_mgr()->GetDef(varId)));
-    phiItr->SetInOperand(idx, {valId});
+  visitedBlocks_.insert(label);
+}
+
+void MemPass::PatchPhis() {
+  for (const auto& phi_var : phis_to_patch_) {
+    ir::Instruction* phi = phi_var.first;
+    const uint32_t varId = phi_var.second;
+    // Replace each temporary phi operand with the variable's value in the
+    // predecessor's map. Use undef if variable not in map.
+    for (uint32_t idx = 0; idx < phi->NumInOperands(); idx += 2) {
+      if (phi->GetSingleWordInOperand(idx) != varId) continue;
+      const uint32_t predLabel = phi->GetSingleWordInOperand(idx + 1);
+      const auto valItr = label2ssa_map_[predLabel].find(varId);
+      const uint32_t valId =
+          (valItr != label2ssa_map_[predLabel].end())
+              ? valItr->second
+              : Type2Undef(GetPointeeTypeId(get_def_use_mgr()->GetDef(varId)));
+      phi->SetInOperand(idx, {valId});
+    }
     // Analyze uses now that they are complete
-    get_def_use_mgr()->AnalyzeInstUse(&*phiItr);
+    get_def_use_mgr()->AnalyzeInstUse(phi);
   }
+  phis_to_patch_.clear();
 }
 
 Pass::Status MemPass::InsertPhiInstructions(ir::Function* func) {
-  // TODO(dnovillo) the current Phi placement mechanism assumes structured
-  // control-flow. This should be generalized
-  // (https://github.com/KhronosGroup/SPIRV-Tools/issues/893).
-  assert(get_module()->HasCapability(SpvCapabilityShader) &&
-         "This only works on structured control flow");
-
   // Initialize the data structures used to insert Phi instructions.
   InitSSARewrite(func);
-
-  // Process all blocks in structured order. This is just one way (the
-  // simplest?) to make sure all predecessors blocks are processed before
-  // a block itself.
-  std::list<ir::BasicBlock*> structuredOrder;
-  cfg()->ComputeStructuredOrder(func, cfg()->pseudo_entry_block(),
-                                &structuredOrder);
-  for (auto bi = structuredOrder.begin(); bi != structuredOrder.end(); ++bi) {
-    // Skip pseudo entry block
-    if (cfg()->IsPseudoEntryBlock(*bi)) {
-      continue;
-    }
-
-    // Initialize this block's label2ssa_map_ entry using predecessor maps.
-    // Then process all stores and loads of targeted variables.
-    SSABlockInit(bi);
-    ir::BasicBlock* bp = *bi;
-    const uint32_t label = bp->id();
-    for (auto ii = bp->begin(); ii != bp->end(); ++ii) {
-      switch (ii->opcode()) {
-        case SpvOpStore: {
-          uint32_t varId;
-          (void)GetPtr(&*ii, &varId);
-          if (!IsTargetVar(varId)) break;
-          // Register new stored value for the variable
-          label2ssa_map_[label][varId] =
-              ii->GetSingleWordInOperand(kStoreValIdInIdx);
-        } break;
-        case SpvOpLoad: {
-          uint32_t varId;
-          (void)GetPtr(&*ii, &varId);
-          if (!IsTargetVar(varId)) break;
-          uint32_t replId = 0;
-          const auto ssaItr = label2ssa_map_.find(label);
-          if (ssaItr != label2ssa_map_.end()) {
-            const auto valItr = ssaItr->second.find(varId);
-            if (valItr != ssaItr->second.end()) replId = valItr->second;
-          }
-          // If variable is not defined, use undef
-          if (replId == 0) {
-            replId = Type2Undef(GetPointeeTypeId(get_def_use_mgr()->GetDef(varId)));
-          }
-          // Replace load's id with the last stored value id for variable
-          // and delete load. Kill any names or decorates using id before
-          // replacing to prevent incorrect replacement in those instructions.
-          const uint32_t loadId = ii->result_id();
-          KillNamesAndDecorates(loadId);
-          (void)get_def_use_mgr()->ReplaceAllUsesWith(loadId, replId);
-          get_def_use_mgr()->KillInst(&*ii);
-        } break;
-        default: { } break; }
-    }
-    visitedBlocks_.insert(label);
-    // Look for successor backedge and patch phis in loop header
-    // if found.
-    uint32_t header = 0;
-    bp->ForEachSuccessorLabel([&header, this](uint32_t succ) {
-      if (visitedBlocks_.find(succ) == visitedBlocks_.end()) return;
-      assert(header == 0);
-      header = succ;
-    });
-    if (header != 0) PatchPhis(header, label);
+  PlacePhis(func);
+
+  // Process the blocks in dominator tree order, so each block starts from
+  // the values at the end of its immediate dominator.
+  opt::DominatorAnalysis* dom_tree = context()->GetDominatorAnalysis(func);
+  for (auto bp : dom_tree->Preorder()) {
+    SSABlockInit(bp, dom_tree->ImmediateDominator(bp));
+    SSABlockRewrite(bp);
+  }
+  // Blocks unreachable from the entry have no dominator and load undef.
+  for (auto& blk : *func) {
+    if (visitedBlocks_.find(blk.id()) != visitedBlocks_.end()) continue;
+    SSABlockRewrite(&blk);
   }
+  PatchPhis();
 
   return Status::SuccessWithChange;
 }
@@ -24,6 +24,7 @@
 #include <unordered_map>
 #include <unordered_set>
 #include <utility>
+#include <vector>
 
 #include "basic_block.h"
 #include "def_use_manager.h"
@@ -139,7 +140,9 @@ class MemPass : public Pass {
 
   // Insert Phi instructions in the CFG of |func|.  This removes extra
   // load/store operations to local storage while preserving the SSA form of the
-  // code.
+  // code. Phis are only inserted where a target variable is live and more
+  // than one of its stores reaches, so the control flow need not be
+  // structured.
   Pass::Status InsertPhiInstructions(ir::Function* func);
 
   // Cache of verified target vars
@@ -156,48 +159,31 @@ class MemPass : public Pass {
   // implementation?
   bool HasOnlySupportedRefs(uint32_t varId);
 
-  // Patch phis in loop header block |header_id| now that the map is complete
-  // for the backedge predecessor |back_id|. Specifically, for each phi, find
-  // the value corresponding to the backedge predecessor. That was temporarily
-  // set with the variable id that this phi corresponds to. Change this phi
-  // operand to the the value which corresponds to that variable in the
-  // predecessor map.
-  void PatchPhis(uint32_t header_id, uint32_t back_id);
-
   // Initialize data structures used by EliminateLocalMultiStore for
   // function |func|, specifically block predecessors and target variables.
   void InitSSARewrite(ir::Function* func);
 
-  // Initialize label2ssa_map_ entry for block |block_ptr| with single
-  // predecessor.
-  void SSABlockInitSinglePred(ir::BasicBlock* block_ptr);
-
-  // Initialize label2ssa_map_ entry for loop header block pointed to
-  // |block_itr| by merging entries from all predecessors. If any value
-  // ids differ for any variable across predecessors, create a phi function
-  // in the block and use that value id for the variable in the new map.
-  // Assumes all predecessors have been visited by EliminateLocalMultiStore
-  // except the back edge. Use a dummy value in the phi for the back edge
-  // until the back edge block is visited and patch the phi value then.
-  void SSABlockInitLoopHeader(std::list<ir::BasicBlock*>::iterator block_itr);
-
-  // Initialize label2ssa_map_ entry for multiple predecessor block
-  // |block_ptr| by merging label2ssa_map_ entries for all predecessors.
-  // If any value ids differ for any variable across predecessors, create
-  // a phi function in the block and use that value id for the variable in
-  // the new map. Assumes all predecessors have been visited by
-  // EliminateLocalMultiStore.
-  void SSABlockInitMultiPred(ir::BasicBlock* block_ptr);
-
-  // Initialize the label2ssa_map entry for a block pointed to by |block_itr|.
-  // Insert phi instructions into block when necessary. All predecessor
-  // blocks must have been visited by EliminateLocalMultiStore except for
-  // backedges.
-  void SSABlockInit(std::list<ir::BasicBlock*>::iterator block_itr);
-
-  // Return true if variable is loaded in block with |label| or in any
-  // succeeding block in structured order.
-  bool IsLiveAfter(uint32_t var_id, uint32_t label) const;
+  // Compute the blocks of |func| that need a phi for each target variable
+  // and record them in label2phi_vars_. A variable needs a phi in the
+  // iterated dominance frontier of the blocks that store it, but only where
+  // it is live on entry to the block (pruned SSA).
+  void PlacePhis(ir::Function* func);
+
+  // Initialize the label2ssa_map_ entry for block |block_ptr| from the entry
+  // of its immediate dominator |idom|, which may be null, and insert the
+  // phis placed in the block. Phi operands for predecessors that have not
+  // been visited yet are temporarily set to the variable id and patched by
+  // PatchPhis.
+  void SSABlockInit(ir::BasicBlock* block_ptr, ir::BasicBlock* idom);
+
+  // Replace the loads of target variables in |block_ptr| with the value
+  // last stored to the variable and update the block's label2ssa_map_ entry
+  // with its stores.
+  void SSABlockRewrite(ir::BasicBlock* block_ptr);
+
+  // Patch the phi operands left for unvisited predecessors by SSABlockInit
+  // now that the label2ssa_map_ entries of all blocks are complete.
+  void PatchPhis();
 
   // Remove all the unreachable basic blocks in |func|.
   bool RemoveUnreachableBlocks(ir::Function* func);
@@ -221,6 +207,10 @@ class MemPass : public Pass {
   // Set of label ids of visited blocks
   std::unordered_set<uint32_t> visitedBlocks_;
 
+  // Map from block's label id to the target variables that need a phi at
+  // the start of the block, in increasing id order.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> label2phi_vars_;
+
   // Variables that are only referenced by supported operations for this
   // pass ie. loads and stores.
   std::unordered_set<uint32_t> supported_ref_vars_;
@@ -228,9 +218,9 @@ class MemPass : public Pass {
   // Map from type to undef
   std::unordered_map<uint32_t, uint32_t> type2undefs_;
 
-  // The Ids of OpPhi instructions that are in a loop header and which require
-  // patching of the value for the loop back-edge.
-  std::unordered_set<uint32_t> phis_to_patch_;
+  // The phis that still have operands to patch, with the variable each
+  // phi stands for.
+  std::vector<std::pair<ir::Instruction*, uint32_t>> phis_to_patch_;
 
   // Map from an instruction result ID to the block that holds it.
   // TODO(dnovillo): This would be unnecessary if ir::Instruction instances
@@ -0,0 +1,180 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "merge_identical_functions_pass.h"
+
+#include "operand.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kEntryPointFunctionIdInIdx = 1;
+const uint32_t kFunctionCallFunctionIdInIdx = 0;
+
+// Tags distinguishing the ids defined in a function from the other ids in
+// a function key.
+const uint32_t kLocalIdTag = 0;
+const uint32_t kGlobalIdTag = 1;
+
+}  // anonymous namespace
+
+size_t MergeIdenticalFunctionsPass::FunctionKeyHash::operator()(
+    const FunctionKey& key) const {
+  size_t hash = key.size();
+  for (auto word : key)
+    hash ^= std::hash<uint32_t>()(word) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+  return hash;
+}
+
+bool MergeIdenticalFunctionsPass::IsCandidate(const ir::Function* func) const {
+  // Nothing to merge for a function declaration.
+  if (func->cbegin() == func->cend()) return false;
+  if (entry_points_.count(func->result_id()) != 0) return false;
+  bool decorated = false;
+  func->ForEachInst(
+      [&decorated, this](const ir::Instruction* inst) {
+        if (decorated_ids_.count(inst->result_id()) != 0) decorated = true;
+      },
+      false);
+  return !decorated;
+}
+
+MergeIdenticalFunctionsPass::FunctionKey MergeIdenticalFunctionsPass::MakeKey(
+    const ir::Function* func) const {
+  std::unordered_map<uint32_t, uint32_t> localIds;
+  func->ForEachInst(
+      [&localIds](const ir::Instruction* inst) {
+        const uint32_t resultId = inst->result_id();
+        if (resultId != 0)
+          localIds.emplace(resultId, static_cast<uint32_t>(localIds.size()));
+      },
+      false);
+
+  FunctionKey key;
+  func->ForEachInst(
+      [&key, &localIds](const ir::Instruction* inst) {
+        if (inst->opcode() == SpvOpNop) return;
+        key.push_back(inst->opcode());
+        key.push_back(inst->NumOperands());
+        for (uint32_t i = 0; i < inst->NumOperands(); ++i) {
+          const ir::Operand& operand = inst->GetOperand(i);
+          key.push_back(operand.type);
+          if (spvIsIdType(operand.type)) {
+            const auto local = localIds.find(operand.words[0]);
+            if (local != localIds.end()) {
+              key.push_back(kLocalIdTag);
+              key.push_back(local->second);
+            } else {
+              key.push_back(kGlobalIdTag);
+              key.push_back(operand.words[0]);
+            }
+          } else {
+            key.push_back(static_cast<uint32_t>(operand.words.size()));
+            key.insert(key.end(), operand.words.begin(), operand.words.end());
+          }
+        }
+      },
+      false);
+  return key;
+}
+
+bool MergeIdenticalFunctionsPass::RedirectCalls(ir::Function* func) {
+  bool modified = false;
+  for (auto& blk : *func) {
+    for (auto& inst : blk) {
+      if (inst.opcode() != SpvOpFunctionCall) continue;
+      uint32_t calleeId =
+          inst.GetSingleWordInOperand(kFunctionCallFunctionIdInIdx);
+      auto mi = merged_into_.find(calleeId);
+      if (mi == merged_into_.end()) continue;
+      // A function may have been merged into a function merged later on.
+      while (mi != merged_into_.end()) {
+        calleeId = mi->second;
+        mi = merged_into_.find(calleeId);
+      }
+      inst.SetInOperand(kFunctionCallFunctionIdInIdx, {calleeId});
+      modified = true;
+    }
+  }
+  return modified;
+}
+
+bool MergeIdenticalFunctionsPass::MergeFunctions() {
+  bool merged = false;
+  // Functions with the same key are identical, which the key comparisons of
+  // the map verify.
+  std::unordered_map<FunctionKey, uint32_t, FunctionKeyHash> keptFunctions;
+  for (auto& func : *get_module()) {
+    const uint32_t funcId = func.result_id();
+    if (merged_into_.count(funcId) != 0 || !IsCandidate(&func)) continue;
+    const auto kept = keptFunctions.emplace(MakeKey(&func), funcId);
+    if (kept.second) continue;
+    merged_into_[funcId] = kept.first->second;
+    merged = true;
+  }
+  if (!merged) return false;
+  for (auto& func : *get_module()) RedirectCalls(&func);
+  return true;
+}
+
+void MergeIdenticalFunctionsPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+
+  entry_points_.clear();
+  for (auto& e : get_module()->entry_points())
+    entry_points_.insert(e.GetSingleWordInOperand(kEntryPointFunctionIdInIdx));
+
+  decorated_ids_.clear();
+  for (auto& ai : get_module()->annotations()) {
+    switch (ai.opcode()) {
+      case SpvOpDecorationGroup:
+        break;
+      case SpvOpGroupDecorate:
+        for (uint32_t i = 1; i < ai.NumInOperands(); ++i)
+          decorated_ids_.insert(ai.GetSingleWordInOperand(i));
+        break;
+      case SpvOpGroupMemberDecorate:
+        for (uint32_t i = 1; i < ai.NumInOperands(); i += 2)
+          decorated_ids_.insert(ai.GetSingleWordInOperand(i));
+        break;
+      default:
+        if (ai.NumInOperands() > 0)
+          decorated_ids_.insert(ai.GetSingleWordInOperand(0));
+        break;
+    }
+  }
+
+  merged_into_.clear();
+}
+
+Pass::Status MergeIdenticalFunctionsPass::ProcessImpl() {
+  // Merging functions makes the functions calling them identical, so merge
+  // until nothing changes.
+  bool modified = false;
+  while (MergeFunctions()) modified = true;
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+MergeIdenticalFunctionsPass::MergeIdenticalFunctionsPass() {}
+
+Pass::Status MergeIdenticalFunctionsPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
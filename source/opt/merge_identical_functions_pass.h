@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_MERGE_IDENTICAL_FUNCTIONS_PASS_H_
+#define LIBSPIRV_OPT_MERGE_IDENTICAL_FUNCTIONS_PASS_H_
+
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "function.h"
+#include "module.h"
+#include "pass.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class MergeIdenticalFunctionsPass : public Pass {
+ public:
+  MergeIdenticalFunctionsPass();
+  const char* name() const override { return "merge-identical-functions"; }
+  Status Process(ir::IRContext*) override;
+
+ private:
+  // The canonical form of a function body.
+  using FunctionKey = std::vector<uint32_t>;
+
+  struct FunctionKeyHash {
+    size_t operator()(const FunctionKey& key) const;
+  };
+
+  // Returns true if |func| has a body, is not an entry point and none of its
+  // ids is decorated.
+  bool IsCandidate(const ir::Function* func) const;
+
+  // Returns the canonical form of |func|: the opcodes and operands of its
+  // instructions, where the ids defined in |func| are replaced by their
+  // index in the function. Debug line instructions are ignored, so two
+  // functions with the same key compute the same thing.
+  FunctionKey MakeKey(const ir::Function* func) const;
+
+  // Makes the calls of |func| to merged functions call the function they
+  // were merged into. Returns true if |func| is modified.
+  bool RedirectCalls(ir::Function* func);
+
+  // Merges each candidate function into the first earlier function with the
+  // same key, and redirects the calls. Returns true if a function is merged.
+  bool MergeFunctions();
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Ids of entry point functions.
+  std::unordered_set<uint32_t> entry_points_;
+
+  // Ids with decorations.
+  std::unordered_set<uint32_t> decorated_ids_;
+
+  // Map from the id of a merged function to the id of the function it was
+  // merged into.
+  std::unordered_map<uint32_t, uint32_t> merged_into_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_MERGE_IDENTICAL_FUNCTIONS_PASS_H_
@@ -14,17 +14,25 @@
 
 #include "spirv-tools/optimizer.hpp"
 
+#include <map>
+#include <sstream>
+
 #include "build_module.h"
 #include "make_unique.h"
 #include "pass_manager.h"
 #include "passes.h"
+#include "result_cache.h"
+#include "util/timer.h"
 
 namespace spvtools {
 
 struct Optimizer::PassToken::Impl {
-  Impl(std::unique_ptr<opt::Pass> p) : pass(std::move(p)) {}
+  Impl(std::unique_ptr<opt::Pass> p) : pass(std::move(p)), key(pass->name()) {}
+  Impl(std::unique_ptr<opt::Pass> p, const std::string& parameters)
+      : pass(std::move(p)), key(std::string(pass->name()) + "=" + parameters) {}
 
   std::unique_ptr<opt::Pass> pass;  // Internal implementation pass.
+  std::string key;  // Name and parameters of the pass, for the result cache.
 };
 
 Optimizer::PassToken::PassToken(
@@ -41,12 +49,41 @@ Optimizer::PassToken& Optimizer::PassToken::operator=(PassToken&& that) {
 Optimizer::PassToken::~PassToken() {}
 
 struct Optimizer::Impl {
-  explicit Impl(spv_target_env env) : target_env(env), pass_manager() {}
+  explicit Impl(spv_target_env env)
+      : target_env(env),
+        pass_manager(),
+        time_report_stream(nullptr),
+        num_threads(1),
+        incremental(false) {}
+
+  // Returns the key of the result of optimizing |binary|, of |size| words, in
+  // the result cache.
+  std::vector<uint32_t> CacheKey(const uint32_t* binary, size_t size) const;
 
   const spv_target_env target_env;  // Target environment.
   opt::PassManager pass_manager;    // Internal implementation pass manager.
+  std::ostream* time_report_stream;  // Stream for the time report, or null.
+  uint32_t num_threads;  // Number of threads processing functions.
+  bool incremental;  // Whether results for functions are cached.
+  std::vector<std::string> pass_keys;  // Keys of the registered passes.
+  std::string groups;  // Bounds of the fixed-point groups, for the cache.
+  std::unique_ptr<opt::ResultCache> result_cache;  // Result cache, or null.
 };
 
+std::vector<uint32_t> Optimizer::Impl::CacheKey(const uint32_t* binary,
+                                                size_t size) const {
+  std::string passes = spvSoftwareVersionDetailsString();
+  for (const auto& key : pass_keys) passes += "\n" + key;
+  passes += "\n" + groups;
+  std::vector<uint32_t> words = {static_cast<uint32_t>(target_env),
+                                 num_threads > 1 ? 1u : 0u,
+                                 incremental ? 1u : 0u};
+  opt::ResultCache::AppendString(passes, &words);
+  words.push_back(static_cast<uint32_t>(size));
+  words.insert(words.end(), binary, binary + size);
+  return words;
+}
+
 Optimizer::Optimizer(spv_target_env env) : impl_(new Impl(env)) {}
 
 Optimizer::~Optimizer() {}
@@ -63,6 +100,44 @@ Optimizer& Optimizer::RegisterPass(PassToken&& p) {
   // Change to use the pass manager's consumer.
   p.impl_->pass->SetMessageConsumer(impl_->pass_manager.consumer());
   impl_->pass_manager.AddPass(std::move(p.impl_->pass));
+  impl_->pass_keys.push_back(std::move(p.impl_->key));
+  return *this;
+}
+
+Optimizer& Optimizer::BeginFixedPointGroup(uint32_t max_iterations) {
+  impl_->pass_manager.BeginFixedPointGroup(max_iterations);
+  impl_->groups += " " + std::to_string(impl_->pass_keys.size()) + "-" +
+                   std::to_string(max_iterations);
+  return *this;
+}
+
+Optimizer& Optimizer::EndFixedPointGroup() {
+  impl_->pass_manager.EndFixedPointGroup();
+  impl_->groups += " " + std::to_string(impl_->pass_keys.size());
+  return *this;
+}
+
+Optimizer& Optimizer::SetTimeReport(std::ostream* out) {
+  impl_->time_report_stream = out;
+  impl_->pass_manager.SetTimeReport(out);
+  return *this;
+}
+
+Optimizer& Optimizer::SetNumThreads(uint32_t num_threads) {
+  impl_->num_threads = num_threads;
+  impl_->pass_manager.SetNumThreads(num_threads);
+  return *this;
+}
+
+Optimizer& Optimizer::SetResultCache(const std::string& directory,
+                                     uint64_t max_size) {
+  impl_->result_cache.reset(
+      directory.empty() ? nullptr : new opt::ResultCache(directory, max_size));
+  return *this;
+}
+
+Optimizer& Optimizer::SetIncremental(bool incremental) {
+  impl_->incremental = incremental;
   return *this;
 }
 
@@ -76,13 +151,18 @@ Optimizer& Optimizer::RegisterPerformancePasses() {
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateBlockMergePass())
       .RegisterPass(CreateLocalMultiStoreElimPass())
+      .RegisterPass(CreateCopyPropagationPass())
+      .RegisterPass(CreateInstCombinePass())
+      .RegisterPass(CreateIfConversionPass())
       .RegisterPass(CreateInsertExtractElimPass())
       .RegisterPass(CreateCommonUniformElimPass())
       .RegisterPass(CreateDeadVariableEliminationPass());
 }
 
 Optimizer& Optimizer::RegisterSizePasses() {
-  return RegisterPass(CreateInlineExhaustivePass())
+  return RegisterPass(CreateMergeIdenticalFunctionsPass())
+      .RegisterPass(CreateInlineSelectivePass())
+      .RegisterPass(CreateEliminateDeadFunctionsPass())
       .RegisterPass(CreateLocalAccessChainConvertPass())
       .RegisterPass(CreateLocalSingleBlockLoadStoreElimPass())
       .RegisterPass(CreateLocalSingleStoreElimPass())
@@ -91,6 +171,8 @@ Optimizer& Optimizer::RegisterSizePasses() {
       .RegisterPass(CreateDeadBranchElimPass())
       .RegisterPass(CreateBlockMergePass())
       .RegisterPass(CreateLocalMultiStoreElimPass())
+      .RegisterPass(CreateCopyPropagationPass())
+      .RegisterPass(CreateInstCombinePass())
       .RegisterPass(CreateInsertExtractElimPass())
       .RegisterPass(CreateCommonUniformElimPass())
       .RegisterPass(CreateDeadVariableEliminationPass());
@@ -99,9 +181,27 @@ Optimizer& Optimizer::RegisterSizePasses() {
 bool Optimizer::Run(const uint32_t* original_binary,
                     const size_t original_binary_size,
                     std::vector<uint32_t>* optimized_binary) const {
-  std::unique_ptr<ir::Module> module =
-      BuildModule(impl_->target_env, impl_->pass_manager.consumer(),
-                  original_binary, original_binary_size);
+  std::vector<uint32_t> cache_key;
+  if (impl_->result_cache) {
+    spvutils::ScopedTimer timer(impl_->time_report_stream, "CacheLookup");
+    cache_key = impl_->CacheKey(original_binary, original_binary_size);
+    std::vector<uint32_t> cached;
+    if (impl_->result_cache->Lookup(cache_key, &cached)) {
+      *optimized_binary = std::move(cached);
+      return true;
+    }
+  }
+
+  if (impl_->result_cache && impl_->incremental)
+    impl_->pass_manager.SetFunctionCache(impl_->result_cache.get(),
+                                         impl_->target_env, impl_->pass_keys);
+
+  std::unique_ptr<ir::Module> module;
+  {
+    spvutils::ScopedTimer timer(impl_->time_report_stream, "BuildModule");
+    module = BuildModule(impl_->target_env, impl_->pass_manager.consumer(),
+                         original_binary, original_binary_size);
+  }
   if (module == nullptr) return false;
   ir::IRContext context(std::move(module));
 
@@ -110,11 +210,17 @@ bool Optimizer::Run(const uint32_t* original_binary,
       (status == opt::Pass::Status::SuccessWithoutChange &&
        (optimized_binary->data() != original_binary ||
         optimized_binary->size() != original_binary_size))) {
+    spvutils::ScopedTimer timer(impl_->time_report_stream, "ToBinary");
     optimized_binary->clear();
     context.module()->ToBinary(optimized_binary, /* skip_nop = */ true);
   }
 
-  return status != opt::Pass::Status::Failure;
+  if (status == opt::Pass::Status::Failure) return false;
+  if (impl_->result_cache) {
+    spvutils::ScopedTimer timer(impl_->time_report_stream, "CacheStore");
+    impl_->result_cache->Store(cache_key, *optimized_binary);
+  }
+  return true;
 }
 
 Optimizer::PassToken CreateNullPass() {
@@ -133,14 +239,30 @@ Optimizer::PassToken CreateEliminateDeadFunctionsPass() {
 
 Optimizer::PassToken CreateSetSpecConstantDefaultValuePass(
     const std::unordered_map<uint32_t, std::string>& id_value_map) {
+  std::map<uint32_t, std::string> sorted(id_value_map.begin(),
+                                         id_value_map.end());
+  std::ostringstream parameters;
+  for (const auto& id_value : sorted)
+    parameters << id_value.first << ":" << id_value.second.size() << ":"
+               << id_value.second << ";";
   return MakeUnique<Optimizer::PassToken::Impl>(
-      MakeUnique<opt::SetSpecConstantDefaultValuePass>(id_value_map));
+      MakeUnique<opt::SetSpecConstantDefaultValuePass>(id_value_map),
+      parameters.str());
 }
 
 Optimizer::PassToken CreateSetSpecConstantDefaultValuePass(
     const std::unordered_map<uint32_t, std::vector<uint32_t>>& id_value_map) {
+  std::map<uint32_t, std::vector<uint32_t>> sorted(id_value_map.begin(),
+                                                   id_value_map.end());
+  std::ostringstream parameters;
+  for (const auto& id_value : sorted) {
+    parameters << id_value.first << ":";
+    for (uint32_t word : id_value.second) parameters << word << ",";
+    parameters << ";";
+  }
   return MakeUnique<Optimizer::PassToken::Impl>(
-      MakeUnique<opt::SetSpecConstantDefaultValuePass>(id_value_map));
+      MakeUnique<opt::SetSpecConstantDefaultValuePass>(id_value_map),
+      parameters.str());
 }
 
 Optimizer::PassToken CreateFlattenDecorationPass() {
@@ -251,4 +373,62 @@ Optimizer::PassToken CreateCFGCleanupPass() {
       MakeUnique<opt::CFGCleanupPass>());
 }
 
+Optimizer::PassToken CreateSCCPPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::SCCPPass>());
+}
+
+Optimizer::PassToken CreateValueNumberingPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::ValueNumberingPass>());
+}
+
+Optimizer::PassToken CreateLICMPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LICMPass>());
+}
+
+Optimizer::PassToken CreateLoopUnrollPass(uint32_t size_budget) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::LoopUnrollPass>(size_budget),
+      std::to_string(size_budget));
+}
+
+Optimizer::PassToken CreateScalarReplacementPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::ScalarReplacementPass>());
+}
+
+Optimizer::PassToken CreateInlineSelectivePass(uint32_t growth_percent) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InlineSelectivePass>(growth_percent),
+      std::to_string(growth_percent));
+}
+
+Optimizer::PassToken CreateMergeIdenticalFunctionsPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::MergeIdenticalFunctionsPass>());
+}
+
+Optimizer::PassToken CreateDeadStoreElimPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::DeadStoreElimPass>());
+}
+
+Optimizer::PassToken CreateIfConversionPass(uint32_t size_limit) {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::IfConversionPass>(size_limit),
+      std::to_string(size_limit));
+}
+
+Optimizer::PassToken CreateCopyPropagationPass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::CopyPropagationPass>());
+}
+
+Optimizer::PassToken CreateInstCombinePass() {
+  return MakeUnique<Optimizer::PassToken::Impl>(
+      MakeUnique<opt::InstCombinePass>());
+}
+
 }  // namespace spvtools
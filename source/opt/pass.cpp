@@ -32,7 +32,10 @@ Pass::Pass()
     : consumer_(nullptr),
       def_use_mgr_(nullptr),
       next_id_(0),
-      context_(nullptr) {}
+      context_(nullptr),
+      restrict_function_id_(0),
+      restrict_from_entry_points_(false),
+      tracker_(nullptr) {}
 
 void Pass::AddCalls(ir::Function* func, std::queue<uint32_t>* todo) {
   for (auto bi = func->begin(); bi != func->end(); ++bi)
@@ -42,6 +45,11 @@ void Pass::AddCalls(ir::Function* func, std::queue<uint32_t>* todo) {
 }
 
 bool Pass::ProcessEntryPointCallTree(ProcessFunction& pfn, ir::Module* module) {
+  if (restrict_function_id_ != 0) {
+    if (!restrict_from_entry_points_) return false;
+    return ProcessRestrictedFunction(pfn, module);
+  }
+
   // Map from function's result id to function
   std::unordered_map<uint32_t, ir::Function*> id2function;
   for (auto& fn : *module) id2function[fn.result_id()] = &fn;
@@ -55,6 +63,9 @@ bool Pass::ProcessEntryPointCallTree(ProcessFunction& pfn, ir::Module* module) {
 
 bool Pass::ProcessReachableCallTree(ProcessFunction& pfn,
                                     ir::IRContext* irContext) {
+  if (restrict_function_id_ != 0)
+    return ProcessRestrictedFunction(pfn, irContext->module());
+
   // Map from function's result id to function
   std::unordered_map<uint32_t, ir::Function*> id2function;
   for (auto& fn : *irContext->module()) id2function[fn.result_id()] = &fn;
@@ -99,13 +110,30 @@ bool Pass::ProcessCallTreeFromRoots(
     roots->pop();
     if (done.insert(fi).second) {
       ir::Function* fn = id2function.at(fi);
-      modified = pfn(fn) || modified;
+      modified = ApplyToFunction(pfn, fn) || modified;
       AddCalls(fn, roots);
     }
   }
   return modified;
 }
 
+bool Pass::ProcessRestrictedFunction(ProcessFunction& pfn,
+                                     ir::Module* module) {
+  for (auto& fn : *module)
+    if (fn.result_id() == restrict_function_id_)
+      return ApplyToFunction(pfn, &fn);
+  return false;
+}
+
+bool Pass::ApplyToFunction(ProcessFunction& pfn, ir::Function* func) {
+  if (tracker_ == nullptr) return pfn(func);
+  const uint32_t id = func->result_id();
+  if (tracker_->skipped.count(id) != 0) return false;
+  const bool modified = pfn(func);
+  if (modified) tracker_->modified.insert(id);
+  return modified;
+}
+
 uint32_t Pass::GetPointeeTypeId(const ir::Instruction* ptrInst) const {
   const uint32_t ptrTypeId = ptrInst->type_id();
   const ir::Instruction* ptrTypeInst = get_def_use_mgr()->GetDef(ptrTypeId);
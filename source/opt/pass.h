@@ -17,6 +17,7 @@
 
 #include <algorithm>
 #include <map>
+#include <memory>
 #include <queue>
 #include <unordered_map>
 #include <unordered_set>
@@ -116,6 +117,37 @@ class Pass {
   // succesful to indicate whether changes are made to the module.
   virtual Status Process(ir::IRContext* context) = 0;
 
+  // Returns a new instance of this pass with the same options if the pass is
+  // function-local, or null otherwise. A function-local pass changes nothing
+  // but the functions it processes and the names and decorations of their
+  // ids, except for adding types, constants and OpUndefs. What it does to a
+  // function does not depend on the other functions, so the pass manager can
+  // run clones of it on copies of the module holding one function each.
+  virtual std::unique_ptr<Pass> CloneFunctionLocal() const { return nullptr; }
+
+  // Limits the call tree walks above to the function |id| when it is not 0:
+  // they apply their function to it alone, and ProcessEntryPointCallTree only
+  // does so if |called_from_entry_points| is true. The pass manager uses this
+  // to process one function of a module with a function-local pass.
+  void RestrictToFunction(uint32_t id, bool called_from_entry_points) {
+    restrict_function_id_ = id;
+    restrict_from_entry_points_ = called_from_entry_points;
+  }
+
+  // The ids of the functions the call tree walks above do not apply their
+  // function to, and of those for which it returns true.
+  struct FunctionTracker {
+    std::unordered_set<uint32_t> skipped;
+    std::unordered_set<uint32_t> modified;
+  };
+
+  // Makes the call tree walks above skip the functions whose ids are in
+  // |tracker->skipped|, and add to |tracker->modified| the ids of the
+  // functions they modify, until this is called with null. The pass manager
+  // uses this to run a function-local pass again only on the functions that
+  // changed since it left them unchanged.
+  void SetFunctionTracker(FunctionTracker* tracker) { tracker_ = tracker; }
+
  protected:
   // Initialize basic data structures for the pass. This sets up the def-use
   // manager, module and other attributes. TODO(dnovillo): Some of this should
@@ -140,6 +172,15 @@ class Pass {
   }
 
  private:
+  // Applies |pfn| to the function of |module| the call tree walks are
+  // restricted to. Returns the value returned by |pfn|.
+  bool ProcessRestrictedFunction(ProcessFunction& pfn, ir::Module* module);
+
+  // Applies |pfn| to |func| unless the function tracker skips it, and records
+  // in the tracker whether |pfn| modified it. Returns the value returned by
+  // |pfn|, or false if |func| is skipped.
+  bool ApplyToFunction(ProcessFunction& pfn, ir::Function* func);
+
   MessageConsumer consumer_;  // Message consumer.
 
   // Def-Uses for the module we are processing
@@ -153,6 +194,14 @@ class Pass {
 
   // The CFG for all the functions in this module.
   std::unique_ptr<ir::CFG> cfg_;
+
+  // The only function processed by the call tree walks, or 0 for all of
+  // them, and whether the entry points call it.
+  uint32_t restrict_function_id_;
+  bool restrict_from_entry_points_;
+
+  // The function tracker, or null.
+  FunctionTracker* tracker_;
 };
 
 }  // namespace opt
@@ -13,24 +13,206 @@
 // limitations under the License.
 
 #include "pass_manager.h"
+
+#include <cstdint>
+#include <unordered_set>
+
+#include "function_cache.h"
+#include "function_task.h"
 #include "ir_context.h"
+#include "util/timer.h"
 
 namespace spvtools {
 namespace opt {
 
+namespace {
+
+// Runs a clone of the function-local |pass| on the image of the function of
+// |task|, and records the result in |task|. Only reads |module|. The ids the
+// pass allocates start from the id bound of |module|, independently of the
+// other functions.
+void RunFunctionTask(Pass* pass, ir::Module* module, const ModuleIndex& index,
+                     FunctionTask* task) {
+  ir::IRContext context(BuildFunctionImage(*module, index, *task->func));
+  task->image_bound = module->id_bound();
+  task->status = RunFunctionLocalPasses({pass}, task->func->result_id(),
+                                        task->called_from_entry_points,
+                                        &context);
+  if (task->status == Pass::Status::SuccessWithChange)
+    SetFunctionTaskResult(*context.module(), task);
+}
+
+// Runs |pass| on the module of |context|, with |tracker| as its function
+// tracker.
+Pass::Status ProcessTracked(Pass* pass, Pass::FunctionTracker* tracker,
+                            ir::IRContext* context) {
+  pass->SetFunctionTracker(tracker);
+  const auto status = pass->Process(context);
+  pass->SetFunctionTracker(nullptr);
+  return status;
+}
+
+// Runs |pass| on the functions of the module of |context| using up to
+// |num_threads| threads, if the pass is function-local. Each thread takes
+// the largest function not yet taken, so that a large function started late
+// does not leave the other threads idle. The changes are then merged in the
+// order of the functions in the module, which makes the result independent
+// of the number of threads. When |tracker| is not null, the functions it
+// skips are not processed, and those the pass changes are recorded in it.
+Pass::Status ProcessFunctions(Pass* pass, ir::IRContext* context,
+                              uint32_t num_threads,
+                              Pass::FunctionTracker* tracker) {
+  if (pass->CloneFunctionLocal() == nullptr)
+    return ProcessTracked(pass, tracker, context);
+
+  std::vector<FunctionTask> tasks = CollectFunctionTasks(
+      pass, context, tracker != nullptr ? &tracker->skipped : nullptr);
+  if (tasks.size() < 2) return ProcessTracked(pass, tracker, context);
+
+  ir::Module* module = context->module();
+  const ModuleIndex index = IndexModule(module);
+  RunFunctionTasks(&tasks, num_threads, [pass, module, &index](
+                                            FunctionTask* task) {
+    RunFunctionTask(pass, module, index, task);
+  });
+  // The functions of the tasks are replaced by the merge.
+  std::vector<uint32_t> modified;
+  for (auto& task : tasks)
+    if (task.status == Pass::Status::SuccessWithChange)
+      modified.push_back(task.func->result_id());
+  const auto status = MergeFunctionTasks(&tasks, index, context);
+  if (tracker != nullptr && status != Pass::Status::Failure)
+    tracker->modified.insert(modified.begin(), modified.end());
+  return status;
+}
+
+}  // namespace
+
+void PassManager::BeginFixedPointGroup(uint32_t max_iterations) {
+  EndFixedPointGroup();
+  groups_.push_back({passes_.size(), SIZE_MAX, max_iterations});
+}
+
+void PassManager::EndFixedPointGroup() {
+  if (!groups_.empty() && groups_.back().end == SIZE_MAX)
+    groups_.back().end = passes_.size();
+}
+
+Pass::Status PassManager::RunPass(Pass* pass, Pass::FunctionTracker* tracker,
+                                  ir::IRContext* context) {
+  spvutils::ScopedTimer timer(time_report_stream_, pass->name());
+  return num_threads_ > 1
+             ? ProcessFunctions(pass, context, num_threads_, tracker)
+             : ProcessTracked(pass, tracker, context);
+}
+
+Pass::Status PassManager::RunFixedPointGroup(const FixedPointGroup& group,
+                                             ir::IRContext* context) {
+  // For each pass, the ids of the functions it left unchanged and which did
+  // not change since.
+  std::vector<std::unordered_set<uint32_t>> unchanged(group.end -
+                                                      group.begin);
+  auto status = Pass::Status::SuccessWithoutChange;
+  for (uint32_t iteration = 0; iteration < group.max_iterations;
+       ++iteration) {
+    bool changed = false;
+    for (size_t i = group.begin; i < group.end; ++i) {
+      Pass* pass = passes_[i].get();
+      auto& pass_unchanged = unchanged[i - group.begin];
+      const bool local = pass->CloneFunctionLocal() != nullptr;
+      Pass::FunctionTracker tracker;
+      if (local) {
+        // A pass that would skip every function does not need to run.
+        bool all_unchanged = true;
+        for (auto& fn : *context->module())
+          all_unchanged =
+              all_unchanged && pass_unchanged.count(fn.result_id()) != 0;
+        if (all_unchanged) continue;
+        tracker.skipped.swap(pass_unchanged);
+      }
+      const auto one_status =
+          RunPass(pass, local ? &tracker : nullptr, context);
+      if (one_status == Pass::Status::Failure) return one_status;
+      if (local) {
+        // The functions the pass does not process are left unchanged too.
+        pass_unchanged.clear();
+        for (auto& fn : *context->module())
+          if (tracker.modified.count(fn.result_id()) == 0)
+            pass_unchanged.insert(fn.result_id());
+      }
+      if (one_status == Pass::Status::SuccessWithoutChange) continue;
+
+      changed = true;
+      // The pass may have changed control flow.
+      context->InvalidateDominatorAnalyses();
+      if (!local || tracker.modified.empty()) {
+        // Without knowing which functions the pass changed, assume it
+        // changed them all.
+        for (auto& functions : unchanged) functions.clear();
+      } else {
+        for (auto& functions : unchanged)
+          for (uint32_t id : tracker.modified) functions.erase(id);
+      }
+    }
+    if (!changed) break;
+    status = Pass::Status::SuccessWithChange;
+  }
+  return status;
+}
+
 Pass::Status PassManager::Run(ir::IRContext* context) {
+  EndFixedPointGroup();
   auto status = Pass::Status::SuccessWithoutChange;
-  for (const auto& pass : passes_) {
-    const auto one_status = pass->Process(context);
+  size_t next_group = 0;
+  for (size_t i = 0; i < passes_.size();) {
+    Pass* pass = passes_[i].get();
+    size_t end = i + 1;
+    // Skip the empty groups, and find the first pass of the next one.
+    while (next_group < groups_.size() &&
+           groups_[next_group].begin == groups_[next_group].end)
+      ++next_group;
+    const size_t group_begin = next_group < groups_.size()
+                                   ? groups_[next_group].begin
+                                   : passes_.size();
+    Pass::Status one_status;
+    if (group_begin == i) {
+      end = groups_[next_group].end;
+      one_status = RunFixedPointGroup(groups_[next_group++], context);
+    } else if (function_cache_ != nullptr &&
+               pass->CloneFunctionLocal() != nullptr &&
+               CanProcessFunctionsIncrementally(*context->module())) {
+      assert(pass_keys_.size() == passes_.size());
+      while (end < group_begin &&
+             passes_[end]->CloneFunctionLocal() != nullptr)
+        ++end;
+      std::vector<Pass*> group;
+      std::string key = std::string(spvSoftwareVersionDetailsString()) +
+                        "\n" + std::to_string(function_cache_env_);
+      for (size_t j = i; j < end; ++j) {
+        group.push_back(passes_[j].get());
+        key += "\n" + pass_keys_[j];
+      }
+      spvutils::ScopedTimer timer(time_report_stream_,
+                                  "function-local passes");
+      one_status = ProcessFunctionsIncrementally(
+          group, key, *function_cache_, function_cache_env_, num_threads_,
+          context);
+    } else {
+      one_status = RunPass(pass, nullptr, context);
+    }
+    i = end;
     if (one_status == Pass::Status::Failure) return one_status;
-    if (one_status == Pass::Status::SuccessWithChange) status = one_status;
+    if (one_status == Pass::Status::SuccessWithChange) {
+      status = one_status;
+      // The pass may have changed control flow.
+      context->InvalidateDominatorAnalyses();
+    }
   }
 
   // Set the Id bound in the header in case a pass forgot to do so.
   if (status == Pass::Status::SuccessWithChange) {
     context->SetIdBound(context->module()->ComputeIdBound());
   }
-  passes_.clear();
   return status;
 }
 
@@ -15,12 +15,16 @@
 #ifndef LIBSPIRV_OPT_PASS_MANAGER_H_
 #define LIBSPIRV_OPT_PASS_MANAGER_H_
 
+#include <cstddef>
 #include <memory>
+#include <ostream>
+#include <string>
 #include <vector>
 
 #include "log.h"
 #include "module.h"
 #include "pass.h"
+#include "result_cache.h"
 
 #include "spirv-tools/libspirv.hpp"
 #include "ir_context.h"
@@ -38,11 +42,51 @@ class PassManager {
   // The constructed instance will have an empty message consumer, which just
   // ignores all messages from the library. Use SetMessageConsumer() to supply
   // one if messages are of concern.
-  PassManager() : consumer_(nullptr) {}
+  PassManager()
+      : consumer_(nullptr),
+        time_report_stream_(nullptr),
+        num_threads_(1),
+        function_cache_(nullptr),
+        function_cache_env_(SPV_ENV_UNIVERSAL_1_2) {}
 
   // Sets the message consumer to the given |consumer|.
   void SetMessageConsumer(MessageConsumer c) { consumer_ = std::move(c); }
 
+  // Sets the stream to which Run() reports the time and heap allocations of
+  // each pass, or disables the report if |out| is null.
+  void SetTimeReport(std::ostream* out) { time_report_stream_ = out; }
+
+  // Sets the number of threads on which Run() processes the functions of the
+  // module with function-local passes. With 0 or 1, every pass runs on the
+  // calling thread. The message consumer may then be called from several
+  // threads at once.
+  void SetNumThreads(uint32_t num_threads) { num_threads_ = num_threads; }
+
+  // Makes Run() process the functions of the module with each sequence of
+  // consecutive function-local passes at once, reusing the results stored in
+  // |cache| for functions that did not change, as done by
+  // ProcessFunctionsIncrementally(). |env| is the target environment of the
+  // module. |pass_keys| identify the passes added so far, in order, with
+  // their parameters. A null |cache| disables this.
+  void SetFunctionCache(const ResultCache* cache, spv_target_env env,
+                        std::vector<std::string> pass_keys) {
+    function_cache_ = cache;
+    function_cache_env_ = env;
+    pass_keys_ = std::move(pass_keys);
+  }
+
+  // Makes Run() repeat the passes added from now on, up to the next call to
+  // EndFixedPointGroup() or BeginFixedPointGroup(), until they leave the
+  // module unchanged or they ran |max_iterations| times. A function-local
+  // pass of the group is not applied again to the functions it left
+  // unchanged, until a pass changes them, and does not run when that leaves
+  // no function. A pass that is not function-local and changes the module
+  // makes every pass process every function again. Function-local passes in
+  // a group run one at a time, without the function cache.
+  void BeginFixedPointGroup(uint32_t max_iterations);
+  // Ends the group of passes started by BeginFixedPointGroup(), if any.
+  void EndFixedPointGroup();
+
   // Adds an externally constructed pass.
   void AddPass(std::unique_ptr<Pass> pass);
   // Uses the argument |args| to construct a pass instance of type |T|, and adds
@@ -65,14 +109,44 @@ class PassManager {
   // corresponding Status::Success if processing is succesful to indicate
   // whether changes are made to the module.
   //
-  // After running all the passes, they are removed from the list.
+  // The passes stay registered, so that Run() may be called again on another
+  // module.
   Pass::Status Run(ir::IRContext* context);
 
  private:
+  // A group of passes run until a fixed point: the passes from |begin| to
+  // |end| excluded, or to the last one while the group is open, run at most
+  // |max_iterations| times.
+  struct FixedPointGroup {
+    size_t begin;
+    size_t end;
+    uint32_t max_iterations;
+  };
+
+  // Runs |pass| on the module of |context|, on several threads if it is
+  // function-local, restricted to the functions |tracker| does not skip and
+  // recording in it those the pass processes, if |tracker| is not null.
+  Pass::Status RunPass(Pass* pass, Pass::FunctionTracker* tracker,
+                       ir::IRContext* context);
+  // Runs the passes of |group| until a fixed point.
+  Pass::Status RunFixedPointGroup(const FixedPointGroup& group,
+                                  ir::IRContext* context);
+
   // Consumer for messages.
   MessageConsumer consumer_;
+  // The stream for the time report, or null.
+  std::ostream* time_report_stream_;
+  // The number of threads running function-local passes.
+  uint32_t num_threads_;
+  // The cache of results for functions, or null, the target environment and
+  // the keys of the passes.
+  const ResultCache* function_cache_;
+  spv_target_env function_cache_env_;
+  std::vector<std::string> pass_keys_;
   // A vector of passes. Order matters.
   std::vector<std::unique_ptr<Pass>> passes_;
+  // The groups of passes run until a fixed point, in order.
+  std::vector<FixedPointGroup> groups_;
 };
 
 inline void PassManager::AddPass(std::unique_ptr<Pass> pass) {
@@ -21,25 +21,37 @@
 #include "cfg_cleanup_pass.h"
 #include "common_uniform_elim_pass.h"
 #include "compact_ids_pass.h"
+#include "copy_propagation_pass.h"
 #include "dead_branch_elim_pass.h"
+#include "dead_store_elim_pass.h"
 #include "dead_variable_elimination.h"
 #include "eliminate_dead_constant_pass.h"
 #include "flatten_decoration_pass.h"
+#include "if_conversion_pass.h"
 #include "fold_spec_constant_op_and_composite_pass.h"
 #include "inline_exhaustive_pass.h"
 #include "inline_opaque_pass.h"
+#include "inline_selective_pass.h"
+#include "inst_combine_pass.h"
 #include "insert_extract_elim.h"
+#include "licm_pass.h"
 #include "local_single_block_elim_pass.h"
 #include "local_single_store_elim_pass.h"
 #include "local_ssa_elim_pass.h"
+#include "loop_unroll_pass.h"
+#include "merge_identical_functions_pass.h"
 #include "freeze_spec_constant_value_pass.h"
 #include "local_access_chain_convert_pass.h"
 #include "aggressive_dead_code_elim_pass.h"
 #include "null_pass.h"
+#include "remove_duplicates_pass.h"
+#include "scalar_replacement_pass.h"
+#include "sccp_pass.h"
 #include "set_spec_constant_default_value_pass.h"
 #include "strength_reduction_pass.h"
 #include "strip_debug_info_pass.h"
 #include "unify_const_pass.h"
+#include "value_numbering_pass.h"
 #include "eliminate_dead_functions_pass.h"
 
 #endif  // LIBSPIRV_OPT_PASSES_H_
@@ -35,6 +35,40 @@ using ir::Operand;
 using opt::analysis::DefUseManager;
 using opt::analysis::DecorationManager;
 
+namespace {
+
+// Mixes |value| into |hash|.
+void HashCombine(size_t* hash, size_t value) {
+  *hash ^= value + 0x9e3779b9 + (*hash << 6) + (*hash >> 2);
+}
+
+// The words of the in-operands that DecorationManager::AreDecorationsTheSame
+// compares, along with the opcode and the number of in-operands, so that two
+// decorations are the same if and only if they have the same key.
+std::vector<uint32_t> DecorationKey(const Instruction& inst) {
+  std::vector<uint32_t> key;
+  key.push_back(inst.opcode());
+  key.push_back(inst.NumInOperands());
+  for (uint32_t i = (inst.opcode() == SpvOpDecorate) ? 1u : 2u;
+       i < inst.NumInOperands(); ++i) {
+    const Operand& operand = inst.GetInOperand(i);
+    key.push_back(operand.type);
+    key.push_back(static_cast<uint32_t>(operand.words.size()));
+    key.insert(key.end(), operand.words.begin(), operand.words.end());
+  }
+  return key;
+}
+
+struct DecorationKeyHash {
+  size_t operator()(const std::vector<uint32_t>& key) const {
+    size_t hash = key.size();
+    for (auto word : key) HashCombine(&hash, std::hash<uint32_t>()(word));
+    return hash;
+  }
+};
+
+}  // anonymous namespace
+
 Pass::Status RemoveDuplicatesPass::Process(ir::IRContext* irContext) {
   DefUseManager defUseManager(consumer(), irContext->module());
   DecorationManager decManager(irContext->module());
@@ -96,7 +130,10 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes(
     DecorationManager& decManager) const {
   bool modified = false;
 
-  std::vector<Instruction> visitedTypes;
+  // Types which may be equal have the same hash, so a type is only compared
+  // with the previously visited types of its bucket, in visiting order.
+  std::unordered_map<size_t, std::vector<Instruction>> visitedTypes;
+  std::unordered_map<uint32_t, size_t> typeHashes;
 
   for (auto i = irContext->types_values_begin();
        i != irContext->types_values_end();) {
@@ -109,7 +146,9 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes(
 
     // Is the current type equal to one of the types we have aready visited?
     SpvId idToKeep = 0u;
-    for (auto j : visitedTypes) {
+    auto& bucket = visitedTypes[HashType(*i, defUseManager, decManager,
+                                         &typeHashes)];
+    for (const auto& j : bucket) {
       if (AreTypesEqual(*i, j, defUseManager, decManager)) {
         idToKeep = j.result_id();
         break;
@@ -118,7 +157,7 @@ bool RemoveDuplicatesPass::RemoveDuplicateTypes(
 
     if (idToKeep == 0u) {
       // This is a never seen before type, keep it around.
-      visitedTypes.emplace_back(*i);
+      bucket.emplace_back(*i);
       ++i;
     } else {
       // The same type has already been seen before, remove this one.
@@ -135,29 +174,16 @@ bool RemoveDuplicatesPass::RemoveDuplicateDecorations(
     ir::IRContext* irContext) const {
   bool modified = false;
 
-  std::unordered_map<SpvId, const Instruction*> constants;
-  for (const auto& i : irContext->types_values())
-    if (i.opcode() == SpvOpConstant) constants[i.result_id()] = &i;
-  for (const auto& i : irContext->types_values())
-    if (i.opcode() == SpvOpConstant) constants[i.result_id()] = &i;
+  std::unordered_set<std::vector<uint32_t>, DecorationKeyHash>
+      visitedDecorations;
 
-  std::vector<const Instruction*> visitedDecorations;
-
-  opt::analysis::DecorationManager decorationManager(irContext->module());
   for (auto i = irContext->annotation_begin(); i != irContext->annotation_end();) {
     // Is the current decoration equal to one of the decorations we have aready
-    // visited?
-    bool alreadyVisited = false;
-    for (const Instruction* j : visitedDecorations) {
-      if (decorationManager.AreDecorationsTheSame(&*i, j)) {
-        alreadyVisited = true;
-        break;
-      }
-    }
-
-    if (!alreadyVisited) {
+    // visited? SpvOpDecorateId and SpvOpNop are never the same as another
+    // decoration.
+    if (i->opcode() == SpvOpDecorateId || i->opcode() == SpvOpNop ||
+        visitedDecorations.insert(DecorationKey(*i)).second) {
       // This is a never seen before decoration, keep it around.
-      visitedDecorations.emplace_back(&*i);
       ++i;
     } else {
       // The same decoration has already been seen before, remove this one.
@@ -269,5 +295,88 @@ bool RemoveDuplicatesPass::AreTypesEqual(const Instruction& inst1,
   }
 }
 
+size_t RemoveDuplicatesPass::HashTypeId(
+    uint32_t id, const DefUseManager& defUseManager,
+    const DecorationManager& decManager,
+    std::unordered_map<uint32_t, size_t>* typeHashes) const {
+  const auto cached = typeHashes->find(id);
+  if (cached != typeHashes->end()) return cached->second;
+  const Instruction* inst = defUseManager.GetDef(id);
+  size_t hash = id;
+  if (inst != nullptr && spvOpcodeGeneratesType(inst->opcode()))
+    hash = HashType(*inst, defUseManager, decManager, typeHashes);
+  (*typeHashes)[id] = hash;
+  return hash;
+}
+
+size_t RemoveDuplicatesPass::HashType(
+    const Instruction& inst, const DefUseManager& defUseManager,
+    const DecorationManager& decManager,
+    std::unordered_map<uint32_t, size_t>* typeHashes) const {
+  // Types with the same decorations have the same number of them.
+  size_t hash = inst.opcode();
+  HashCombine(&hash,
+              decManager.GetDecorationsFor(inst.result_id(), false).size());
+
+  const auto hashWord = [&inst, &hash](uint32_t i) {
+    HashCombine(&hash, inst.GetSingleWordInOperand(i));
+  };
+  const auto hashTypeOperand = [&inst, &hash, &defUseManager, &decManager,
+                                typeHashes, this](uint32_t i) {
+    HashCombine(&hash, HashTypeId(inst.GetSingleWordInOperand(i),
+                                  defUseManager, decManager, typeHashes));
+  };
+
+  switch (inst.opcode()) {
+    case SpvOpTypeInt:
+      hashWord(0u);
+      hashWord(1u);
+      break;
+    case SpvOpTypeFloat:
+    case SpvOpTypePipe:
+    case SpvOpTypeForwardPointer:
+      hashWord(0u);
+      break;
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+      hashTypeOperand(0u);
+      hashWord(1u);
+      break;
+    case SpvOpTypeImage:
+      hashTypeOperand(0u);
+      for (uint32_t i = 1u; i < inst.NumInOperands(); ++i) hashWord(i);
+      break;
+    case SpvOpTypeSampledImage:
+    case SpvOpTypeRuntimeArray:
+      hashTypeOperand(0u);
+      break;
+    case SpvOpTypeArray:
+      hashTypeOperand(0u);
+      hashTypeOperand(1u);
+      break;
+    case SpvOpTypeStruct:
+    case SpvOpTypeFunction:
+      HashCombine(&hash, inst.NumInOperands());
+      for (uint32_t i = 0u; i < inst.NumInOperands(); ++i) hashTypeOperand(i);
+      break;
+    case SpvOpTypeOpaque:
+      HashCombine(&hash, std::hash<std::string>()(reinterpret_cast<const char*>(
+                             inst.GetInOperand(0u).words.data())));
+      break;
+    case SpvOpTypePointer: {
+      // Only the opcode of the pointee is used, as pointers are how types
+      // refer to themselves.
+      hashWord(0u);
+      const Instruction* pointee =
+          defUseManager.GetDef(inst.GetSingleWordInOperand(1u));
+      if (pointee != nullptr) HashCombine(&hash, pointee->opcode());
+      break;
+    }
+    default:
+      break;
+  }
+  return hash;
+}
+
 }  // namespace opt
 }  // namespace spvtools
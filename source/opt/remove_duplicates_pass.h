@@ -48,6 +48,20 @@ class RemoveDuplicatesPass : public Pass {
                             analysis::DefUseManager& defUseManager,
                             analysis::DecorationManager& decManager) const;
   bool RemoveDuplicateDecorations(ir::IRContext* irContext) const;
+
+  // Returns a hash of the type |inst| such that types for which
+  // |AreTypesEqual| returns true have the same hash. The hashes of the types
+  // referenced by |inst| are cached in |typeHashes|.
+  size_t HashType(const ir::Instruction& inst,
+                  const analysis::DefUseManager& defUseManager,
+                  const analysis::DecorationManager& decManager,
+                  std::unordered_map<uint32_t, size_t>* typeHashes) const;
+
+  // Returns the hash of the type with id |id|, computing it if it is not in
+  // |typeHashes| yet. Ids which are not types hash to themselves.
+  size_t HashTypeId(uint32_t id, const analysis::DefUseManager& defUseManager,
+                    const analysis::DecorationManager& decManager,
+                    std::unordered_map<uint32_t, size_t>* typeHashes) const;
 };
 
 }  // namespace opt
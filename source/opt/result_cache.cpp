@@ -0,0 +1,232 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "result_cache.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <thread>
+
+#if defined(SPIRV_WINDOWS)
+#include <direct.h>
+#include <sys/utime.h>
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#include <utime.h>
+#endif
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+// First word of the file of an entry, which changes with its layout:
+//   <magic> <key word count> <key words> <value word count> <value words>
+const uint32_t kEntryMagic = 0x53504331;  // "SPC1"
+
+// Extension of the files of the entries.
+const char kEntryExtension[] = ".spvcache";
+
+// An entry file found in the cache directory.
+struct EntryInfo {
+  std::string file;
+  uint64_t size;
+  uint64_t last_use;
+};
+
+// Returns the 64-bit FNV-1a hash of the bytes of |words|.
+uint64_t HashWords(const std::vector<uint32_t>& words) {
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (uint32_t word : words) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      hash ^= (word >> shift) & 0xff;
+      hash *= 0x100000001b3ull;
+    }
+  }
+  return hash;
+}
+
+// Returns true if |name| ends with the extension of entry files.
+bool IsEntryFile(const std::string& name) {
+  const size_t length = sizeof(kEntryExtension) - 1;
+  return name.size() > length &&
+         name.compare(name.size() - length, length, kEntryExtension) == 0;
+}
+
+// Appends the entry files of |dir| to |entries|.
+void ListEntries(const std::string& dir, std::vector<EntryInfo>* entries) {
+#if defined(SPIRV_WINDOWS)
+  WIN32_FIND_DATAA entry;
+  HANDLE handle = FindFirstFileA(
+      (dir + "\\*" + kEntryExtension).c_str(), &entry);
+  if (handle == INVALID_HANDLE_VALUE) return;
+  do {
+    if ((entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) ||
+        !IsEntryFile(entry.cFileName))
+      continue;
+    entries->push_back(
+        {dir + "/" + entry.cFileName,
+         (uint64_t(entry.nFileSizeHigh) << 32) | entry.nFileSizeLow,
+         (uint64_t(entry.ftLastWriteTime.dwHighDateTime) << 32) |
+             entry.ftLastWriteTime.dwLowDateTime});
+  } while (FindNextFileA(handle, &entry));
+  FindClose(handle);
+#else
+  DIR* handle = opendir(dir.c_str());
+  if (!handle) return;
+  while (const struct dirent* entry = readdir(handle)) {
+    const std::string name = entry->d_name;
+    struct stat info;
+    if (!IsEntryFile(name) || stat((dir + "/" + name).c_str(), &info) != 0 ||
+        !S_ISREG(info.st_mode))
+      continue;
+    entries->push_back({dir + "/" + name, static_cast<uint64_t>(info.st_size),
+                        static_cast<uint64_t>(info.st_mtime)});
+  }
+  closedir(handle);
+#endif
+}
+
+// Returns a file name in |dir| that no other thread or process uses.
+std::string TemporaryFile(const std::string& dir) {
+  static std::atomic<uint32_t> counter(0);
+  const uint64_t unique =
+      std::hash<std::thread::id>()(std::this_thread::get_id()) ^
+      static_cast<uint64_t>(
+          std::chrono::steady_clock::now().time_since_epoch().count());
+  return dir + "/" + std::to_string(unique) + "-" +
+         std::to_string(counter++) + ".tmp";
+}
+
+}  // namespace
+
+ResultCache::ResultCache(const std::string& directory, uint64_t max_size)
+    : directory_(directory), max_size_(max_size) {
+#if defined(SPIRV_WINDOWS)
+  _mkdir(directory_.c_str());
+#else
+  mkdir(directory_.c_str(), 0777);
+#endif
+}
+
+std::string ResultCache::EntryFile(const std::vector<uint32_t>& key) const {
+  char name[17];
+  snprintf(name, sizeof(name), "%016llx",
+           static_cast<unsigned long long>(HashWords(key)));
+  return directory_ + "/" + name + kEntryExtension;
+}
+
+bool ResultCache::Lookup(const std::vector<uint32_t>& key,
+                         std::vector<uint32_t>* value) const {
+  const std::string file = EntryFile(key);
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  if (!in) return false;
+  const std::streamoff size = in.tellg();
+  if (size < 0 || size % sizeof(uint32_t) != 0) return false;
+  std::vector<uint32_t> words(static_cast<size_t>(size) / sizeof(uint32_t));
+  in.seekg(0);
+  if (!in.read(reinterpret_cast<char*>(words.data()), size)) return false;
+
+  // Check the layout and compare the key word by word, since several keys
+  // may share a hash.
+  if (words.size() < key.size() + 3 || words[0] != kEntryMagic ||
+      words[1] != key.size() ||
+      !std::equal(key.begin(), key.end(), words.begin() + 2))
+    return false;
+  const size_t value_start = key.size() + 3;
+  if (words[value_start - 1] != words.size() - value_start) return false;
+  value->assign(words.begin() + value_start, words.end());
+
+#if defined(SPIRV_WINDOWS)
+  _utime(file.c_str(), nullptr);
+#else
+  utime(file.c_str(), nullptr);
+#endif
+  return true;
+}
+
+void ResultCache::Store(const std::vector<uint32_t>& key,
+                        const std::vector<uint32_t>& value) const {
+  // Write to a temporary file first, so that a concurrent lookup never
+  // reads a partial entry.
+  const std::string temporary = TemporaryFile(directory_);
+  {
+    std::ofstream out(temporary, std::ios::binary);
+    if (!out) return;
+    const uint32_t header[] = {kEntryMagic, static_cast<uint32_t>(key.size())};
+    const uint32_t value_size = static_cast<uint32_t>(value.size());
+    out.write(reinterpret_cast<const char*>(header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(key.data()),
+              key.size() * sizeof(uint32_t));
+    out.write(reinterpret_cast<const char*>(&value_size), sizeof(value_size));
+    out.write(reinterpret_cast<const char*>(value.data()),
+              value.size() * sizeof(uint32_t));
+    if (!out) {
+      out.close();
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  const std::string file = EntryFile(key);
+  if (std::rename(temporary.c_str(), file.c_str()) != 0) {
+    // Renaming onto an existing file fails on some systems.
+    std::remove(file.c_str());
+    if (std::rename(temporary.c_str(), file.c_str()) != 0)
+      std::remove(temporary.c_str());
+  }
+  Evict(file);
+}
+
+void ResultCache::AppendString(const std::string& str,
+                               std::vector<uint32_t>* key) {
+  key->push_back(static_cast<uint32_t>(str.size()));
+  for (size_t i = 0; i < str.size(); i += 4) {
+    uint32_t word = 0;
+    for (size_t j = i; j < std::min(i + 4, str.size()); ++j)
+      word |= uint32_t(static_cast<unsigned char>(str[j])) << (8 * (j - i));
+    key->push_back(word);
+  }
+}
+
+void ResultCache::Evict(const std::string& newest) const {
+  std::vector<EntryInfo> entries;
+  ListEntries(directory_, &entries);
+  uint64_t total = 0;
+  for (const auto& entry : entries) total += entry.size;
+  if (total <= max_size_) return;
+
+  // The most recently used entry comes first, and is removed last. File
+  // times may be too coarse to tell it from the others.
+  std::sort(entries.begin(), entries.end(),
+            [&newest](const EntryInfo& a, const EntryInfo& b) {
+              if ((a.file == newest) != (b.file == newest))
+                return a.file == newest;
+              return a.last_use != b.last_use ? a.last_use > b.last_use
+                                              : a.file < b.file;
+            });
+  while (total > max_size_ && entries.size() > 1) {
+    std::remove(entries.back().file.c_str());
+    total -= entries.back().size;
+    entries.pop_back();
+  }
+}
+
+}  // namespace opt
+}  // namespace spvtools
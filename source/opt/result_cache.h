@@ -0,0 +1,71 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_RESULT_CACHE_H_
+#define LIBSPIRV_OPT_RESULT_CACHE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace spvtools {
+namespace opt {
+
+// A cache of optimization results stored in a directory, one file per entry.
+// An entry maps a key, a sequence of words describing the input and the
+// optimizations applied to it, to the resulting words. The file of an entry
+// is named after a hash of its key and also holds the key itself, so that a
+// lookup only succeeds for an identical key.
+//
+// When storing an entry makes the files of the cache larger than the size
+// limit, the least recently used entries are removed, but never the one just
+// stored, even if it alone exceeds the limit. Several processes may
+// use the same directory at once. Errors reading or writing the directory
+// only make lookups fail.
+class ResultCache {
+ public:
+  // Uses the directory |directory|, created if it does not exist, holding up
+  // to |max_size| bytes of entries.
+  ResultCache(const std::string& directory, uint64_t max_size);
+
+  // Returns true and sets |value| to the value stored for |key| if there is
+  // one. Marks the entry as used.
+  bool Lookup(const std::vector<uint32_t>& key,
+              std::vector<uint32_t>* value) const;
+
+  // Stores |value| for |key|, then removes entries to respect the size
+  // limit.
+  void Store(const std::vector<uint32_t>& key,
+             const std::vector<uint32_t>& value) const;
+
+  // Appends to |key| the length of |str| and its characters, four per word.
+  static void AppendString(const std::string& str, std::vector<uint32_t>* key);
+
+ private:
+  // Returns the name of the file of the entry for |key|.
+  std::string EntryFile(const std::vector<uint32_t>& key) const;
+
+  // Removes the least recently used entries until the remaining ones take
+  // at most |max_size_| bytes, or only |newest| remains. The entry file
+  // |newest| is the most recently used one.
+  void Evict(const std::string& newest) const;
+
+  const std::string directory_;
+  const uint64_t max_size_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_RESULT_CACHE_H_
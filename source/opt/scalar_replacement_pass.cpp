@@ -0,0 +1,330 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "scalar_replacement_pass.h"
+
+#include "ir_context.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kAccessChainIndexInIdx = 1;
+const uint32_t kAccessChainBaseOperandIdx = 2;
+const uint32_t kStorePtrOperandIdx = 0;
+const uint32_t kStoreValIdInIdx = 1;
+const uint32_t kVariableInitIdInIdx = 1;
+const uint32_t kTypePointerStorageClassInIdx = 0;
+const uint32_t kTypePointerTypeIdInIdx = 1;
+const uint32_t kTypeArrayLengthIdInIdx = 1;
+const uint32_t kTypeVectorCountInIdx = 1;
+const uint32_t kTypeIntWidthInIdx = 0;
+const uint32_t kConstantValueInIdx = 0;
+
+// Arrays with more elements are not split.
+const uint32_t kMaxArrayLength = 64;
+
+}  // namespace
+
+bool ScalarReplacementPass::GetConstIndex(uint32_t id, uint32_t* value) const {
+  const ir::Instruction* cInst = get_def_use_mgr()->GetDef(id);
+  if (cInst == nullptr || cInst->opcode() != SpvOpConstant) return false;
+  const ir::Instruction* typeInst =
+      get_def_use_mgr()->GetDef(cInst->type_id());
+  if (typeInst->opcode() != SpvOpTypeInt ||
+      typeInst->GetSingleWordInOperand(kTypeIntWidthInIdx) != 32)
+    return false;
+  *value = cInst->GetSingleWordInOperand(kConstantValueInIdx);
+  return true;
+}
+
+bool ScalarReplacementPass::GetElementTypes(
+    uint32_t typeId, std::vector<uint32_t>* elementTypes) {
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  elementTypes->clear();
+  switch (typeInst->opcode()) {
+    case SpvOpTypeStruct:
+      for (uint32_t i = 0; i < typeInst->NumInOperands(); ++i)
+        elementTypes->push_back(typeInst->GetSingleWordInOperand(i));
+      break;
+    case SpvOpTypeArray: {
+      uint32_t length = 0;
+      if (!GetConstIndex(
+              typeInst->GetSingleWordInOperand(kTypeArrayLengthIdInIdx),
+              &length) ||
+          length > kMaxArrayLength)
+        return false;
+      elementTypes->assign(length, typeInst->GetSingleWordInOperand(0));
+    } break;
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+      elementTypes->assign(
+          typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx),
+          typeInst->GetSingleWordInOperand(0));
+      break;
+    default:
+      return false;
+  }
+  return !elementTypes->empty();
+}
+
+bool ScalarReplacementPass::IsCandidate(const ir::Instruction* varInst,
+                                        std::vector<uint32_t>* elementTypes) {
+  const uint32_t varId = varInst->result_id();
+  if (decorated_ids_.count(varId) != 0) return false;
+  const ir::Instruction* ptrTypeInst =
+      get_def_use_mgr()->GetDef(varInst->type_id());
+  if (!GetElementTypes(
+          ptrTypeInst->GetSingleWordInOperand(kTypePointerTypeIdInIdx),
+          elementTypes))
+    return false;
+  // Only a constant composite initializer can be split.
+  if (varInst->NumInOperands() > kVariableInitIdInIdx &&
+      get_def_use_mgr()
+              ->GetDef(varInst->GetSingleWordInOperand(kVariableInitIdInIdx))
+              ->opcode() != SpvOpConstantComposite)
+    return false;
+  analysis::UseList* uses = get_def_use_mgr()->GetUses(varId);
+  if (uses == nullptr) return false;
+  bool hasAccessChain = false;
+  for (auto u : *uses) {
+    switch (u.inst->opcode()) {
+      case SpvOpName:
+        break;
+      case SpvOpAccessChain:
+      case SpvOpInBoundsAccessChain: {
+        uint32_t index = 0;
+        if (u.operand_index != kAccessChainBaseOperandIdx ||
+            u.inst->NumInOperands() <= kAccessChainIndexInIdx ||
+            !GetConstIndex(
+                u.inst->GetSingleWordInOperand(kAccessChainIndexInIdx),
+                &index) ||
+            index >= elementTypes->size())
+          return false;
+        hasAccessChain = true;
+      } break;
+      case SpvOpLoad:
+        // Memory accesses such as Volatile are not split.
+        if (u.inst->NumInOperands() != 1) return false;
+        break;
+      case SpvOpStore:
+        if (u.operand_index != kStorePtrOperandIdx ||
+            u.inst->NumInOperands() != 2)
+          return false;
+        break;
+      default:
+        return false;
+    }
+  }
+  return hasAccessChain;
+}
+
+uint32_t ScalarReplacementPass::GetFunctionPointerType(uint32_t typeId) {
+  for (auto& inst : get_module()->types_values())
+    if (inst.opcode() == SpvOpTypePointer &&
+        inst.GetSingleWordInOperand(kTypePointerStorageClassInIdx) ==
+            SpvStorageClassFunction &&
+        inst.GetSingleWordInOperand(kTypePointerTypeIdInIdx) == typeId)
+      return inst.result_id();
+  const uint32_t resultId = TakeNextId();
+  std::unique_ptr<ir::Instruction> typeInst(new ir::Instruction(
+      SpvOpTypePointer, 0, resultId,
+      {{spv_operand_type_t::SPV_OPERAND_TYPE_STORAGE_CLASS,
+        {uint32_t(SpvStorageClassFunction)}},
+       {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {typeId}}}));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*typeInst);
+  context()->AddType(std::move(typeInst));
+  return resultId;
+}
+
+void ScalarReplacementPass::InsertInstBefore(
+    ir::Instruction* pos, std::unique_ptr<ir::Instruction> newInst) {
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newInst);
+  (void)ir::BasicBlock::iterator(pos).InsertBefore(std::move(newInst));
+}
+
+void ScalarReplacementPass::ReplaceAccessChain(
+    ir::Instruction* acInst, const std::vector<uint32_t>& elementVars) {
+  uint32_t index = 0;
+  (void)GetConstIndex(acInst->GetSingleWordInOperand(kAccessChainIndexInIdx),
+                      &index);
+  const uint32_t acId = acInst->result_id();
+  if (acInst->NumInOperands() == kAccessChainIndexInIdx + 1) {
+    // The access chain points to the element variable itself.
+    KillNamesAndDecorates(acId);
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(acId, elementVars[index]);
+  } else {
+    std::vector<ir::Operand> operands = {
+        {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {elementVars[index]}}};
+    for (uint32_t i = kAccessChainIndexInIdx + 1; i < acInst->NumInOperands();
+         ++i)
+      operands.push_back(acInst->GetInOperand(i));
+    const uint32_t newId = TakeNextId();
+    InsertInstBefore(acInst,
+                     std::unique_ptr<ir::Instruction>(new ir::Instruction(
+                         acInst->opcode(), acInst->type_id(), newId,
+                         operands)));
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(acId, newId);
+  }
+  get_def_use_mgr()->KillInst(acInst);
+}
+
+void ScalarReplacementPass::ReplaceLoad(
+    ir::Instruction* loadInst, const std::vector<uint32_t>& elementVars,
+    const std::vector<uint32_t>& elementTypes) {
+  std::vector<ir::Operand> elements;
+  for (size_t i = 0; i < elementVars.size(); ++i) {
+    const uint32_t ldId = TakeNextId();
+    InsertInstBefore(loadInst,
+                     std::unique_ptr<ir::Instruction>(new ir::Instruction(
+                         SpvOpLoad, elementTypes[i], ldId,
+                         {{spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                           {elementVars[i]}}})));
+    elements.push_back({spv_operand_type_t::SPV_OPERAND_TYPE_ID, {ldId}});
+  }
+  const uint32_t constructId = TakeNextId();
+  InsertInstBefore(loadInst,
+                   std::unique_ptr<ir::Instruction>(new ir::Instruction(
+                       SpvOpCompositeConstruct, loadInst->type_id(),
+                       constructId, elements)));
+  (void)get_def_use_mgr()->ReplaceAllUsesWith(loadInst->result_id(),
+                                              constructId);
+  get_def_use_mgr()->KillInst(loadInst);
+}
+
+void ScalarReplacementPass::ReplaceStore(
+    ir::Instruction* storeInst, const std::vector<uint32_t>& elementVars,
+    const std::vector<uint32_t>& elementTypes) {
+  const uint32_t valId = storeInst->GetSingleWordInOperand(kStoreValIdInIdx);
+  for (size_t i = 0; i < elementVars.size(); ++i) {
+    const uint32_t extId = TakeNextId();
+    InsertInstBefore(
+        storeInst,
+        std::unique_ptr<ir::Instruction>(new ir::Instruction(
+            SpvOpCompositeExtract, elementTypes[i], extId,
+            {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {valId}},
+             {spv_operand_type_t::SPV_OPERAND_TYPE_LITERAL_INTEGER,
+              {static_cast<uint32_t>(i)}}})));
+    InsertInstBefore(storeInst,
+                     std::unique_ptr<ir::Instruction>(new ir::Instruction(
+                         SpvOpStore, 0, 0,
+                         {{spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                           {elementVars[i]}},
+                          {spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+                           {extId}}})));
+  }
+  get_def_use_mgr()->KillInst(storeInst);
+}
+
+void ScalarReplacementPass::ReplaceVariable(
+    ir::Instruction* varInst, const std::vector<uint32_t>& elementTypes,
+    std::vector<ir::Instruction*>* worklist) {
+  const ir::Instruction* initInst =
+      varInst->NumInOperands() > kVariableInitIdInIdx
+          ? get_def_use_mgr()->GetDef(
+                varInst->GetSingleWordInOperand(kVariableInitIdInIdx))
+          : nullptr;
+  std::vector<uint32_t> elementVars;
+  for (size_t i = 0; i < elementTypes.size(); ++i) {
+    std::vector<ir::Operand> operands = {
+        {spv_operand_type_t::SPV_OPERAND_TYPE_STORAGE_CLASS,
+         {uint32_t(SpvStorageClassFunction)}}};
+    if (initInst != nullptr)
+      operands.push_back(
+          {spv_operand_type_t::SPV_OPERAND_TYPE_ID,
+           {initInst->GetSingleWordInOperand(static_cast<uint32_t>(i))}});
+    const uint32_t elementVarId = TakeNextId();
+    std::unique_ptr<ir::Instruction> elementVar(new ir::Instruction(
+        SpvOpVariable, GetFunctionPointerType(elementTypes[i]), elementVarId,
+        operands));
+    // Element variables of aggregate type may be split in turn.
+    worklist->push_back(&*elementVar);
+    InsertInstBefore(varInst, std::move(elementVar));
+    elementVars.push_back(elementVarId);
+  }
+
+  // The use list changes as the uses are replaced.
+  std::vector<ir::Instruction*> users;
+  for (auto u : *get_def_use_mgr()->GetUses(varInst->result_id()))
+    users.push_back(u.inst);
+  for (auto user : users) {
+    switch (user->opcode()) {
+      case SpvOpAccessChain:
+      case SpvOpInBoundsAccessChain:
+        ReplaceAccessChain(user, elementVars);
+        break;
+      case SpvOpLoad:
+        ReplaceLoad(user, elementVars, elementTypes);
+        break;
+      case SpvOpStore:
+        ReplaceStore(user, elementVars, elementTypes);
+        break;
+      default:
+        break;
+    }
+  }
+  KillNamesAndDecorates(varInst);
+  get_def_use_mgr()->KillInst(varInst);
+}
+
+bool ScalarReplacementPass::ReplaceVariables(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  std::vector<ir::Instruction*> worklist;
+  for (auto& inst : *func->begin())
+    if (inst.opcode() == SpvOpVariable) worklist.push_back(&inst);
+  bool modified = false;
+  std::vector<uint32_t> elementTypes;
+  while (!worklist.empty()) {
+    ir::Instruction* varInst = worklist.back();
+    worklist.pop_back();
+    if (!IsCandidate(varInst, &elementTypes)) continue;
+    ReplaceVariable(varInst, elementTypes, &worklist);
+    modified = true;
+  }
+  return modified;
+}
+
+void ScalarReplacementPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+  decorated_ids_.clear();
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() != SpvOpDecorationGroup && ai.NumInOperands() > 0)
+      decorated_ids_.insert(ai.GetSingleWordInOperand(0));
+}
+
+Pass::Status ScalarReplacementPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate) return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return ReplaceVariables(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+ScalarReplacementPass::ScalarReplacementPass() {}
+
+Pass::Status ScalarReplacementPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,97 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_SCALAR_REPLACEMENT_PASS_H_
+#define LIBSPIRV_OPT_SCALAR_REPLACEMENT_PASS_H_
+
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class ScalarReplacementPass : public MemPass {
+ public:
+  ScalarReplacementPass();
+  const char* name() const override { return "scalar-replacement"; }
+  Status Process(ir::IRContext*) override;
+
+ private:
+  // Returns true and sets |value| if |id| is a 32-bit integer constant.
+  bool GetConstIndex(uint32_t id, uint32_t* value) const;
+
+  // Returns true if |typeId| is a struct, array, vector or matrix type that
+  // can be split, and sets |elementTypes| to the types of its elements.
+  bool GetElementTypes(uint32_t typeId, std::vector<uint32_t>* elementTypes);
+
+  // Returns true if the function scope variable |varInst| is only named,
+  // loaded, stored, and used as the base of access chains whose first index
+  // is a constant, at least one of them. Sets |elementTypes| to the types of
+  // the elements of the variable.
+  bool IsCandidate(const ir::Instruction* varInst,
+                   std::vector<uint32_t>* elementTypes);
+
+  // Returns the id of the type of function scope pointers to |typeId|,
+  // adding it to the module if needed.
+  uint32_t GetFunctionPointerType(uint32_t typeId);
+
+  // Inserts |newInst| before |pos| and records its definitions and uses.
+  void InsertInstBefore(ir::Instruction* pos,
+                        std::unique_ptr<ir::Instruction> newInst);
+
+  // Makes access chain |acInst| start from the element variable selected by
+  // its first index, out of |elementVars|.
+  void ReplaceAccessChain(ir::Instruction* acInst,
+                          const std::vector<uint32_t>& elementVars);
+
+  // Replaces |loadInst| by loads of |elementVars| combined with an
+  // OpCompositeConstruct.
+  void ReplaceLoad(ir::Instruction* loadInst,
+                   const std::vector<uint32_t>& elementVars,
+                   const std::vector<uint32_t>& elementTypes);
+
+  // Replaces |storeInst| by stores of each element of the stored value to
+  // |elementVars|.
+  void ReplaceStore(ir::Instruction* storeInst,
+                    const std::vector<uint32_t>& elementVars,
+                    const std::vector<uint32_t>& elementTypes);
+
+  // Replaces |varInst| by one variable per element, of types
+  // |elementTypes|. The new variables are added to |worklist|.
+  void ReplaceVariable(ir::Instruction* varInst,
+                       const std::vector<uint32_t>& elementTypes,
+                       std::vector<ir::Instruction*>* worklist);
+
+  // Splits the candidate variables of |func|, and the variables resulting
+  // from them. Returns true if |func| is modified.
+  bool ReplaceVariables(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Ids with decorations.
+  std::unordered_set<uint32_t> decorated_ids_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_SCALAR_REPLACEMENT_PASS_H_
@@ -0,0 +1,581 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// This file implements sparse conditional constant propagation, after Wegman
+// and Zadeck, "Constant propagation with conditional branches". Values are
+// propagated over the SSA def-use chains of a function while only the edges
+// of the CFG that can be taken are followed, so that constants flowing into
+// phis from blocks that are never executed are not lost.
+
+#include "sccp_pass.h"
+
+#include <algorithm>
+
+#include "fold.h"
+
+namespace spvtools {
+namespace opt {
+
+namespace {
+
+const uint32_t kBranchCondTrueLabIdInIdx = 1;
+const uint32_t kBranchCondFalseLabIdInIdx = 2;
+const uint32_t kSwitchDefaultLabIdInIdx = 1;
+const uint32_t kSwitchFirstCaseInIdx = 2;
+const uint32_t kTypeWidthInIdx = 0;
+const uint32_t kTypeVectorComponentTypeInIdx = 0;
+const uint32_t kTypeVectorCountInIdx = 1;
+const uint32_t kVectorShuffleFirstComponentInIdx = 2;
+const uint32_t kUndefinedComponent = 0xFFFFFFFF;
+
+}  // anonymous namespace
+
+const uint32_t SCCPPass::kUnknown;
+const uint32_t SCCPPass::kVarying;
+
+uint32_t SCCPPass::FindOrAddConst(uint32_t typeId,
+                                  const std::vector<uint32_t>& words) {
+  const auto key = std::make_pair(typeId, words);
+  const auto it = const_index_.find(key);
+  if (it != const_index_.end()) return it->second;
+  const uint32_t index = static_cast<uint32_t>(consts_.size());
+  consts_.push_back({typeId, words, 0});
+  const_index_[key] = index;
+  return index;
+}
+
+uint32_t SCCPPass::GetConstId(uint32_t index) {
+  if (consts_[index].id != 0) return consts_[index].id;
+  const uint32_t typeId = consts_[index].type_id;
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  SpvOp op;
+  std::vector<ir::Operand> operands;
+  switch (typeInst->opcode()) {
+    case SpvOpTypeBool:
+      op = consts_[index].words[0] != 0 ? SpvOpConstantTrue
+                                        : SpvOpConstantFalse;
+      break;
+    case SpvOpTypeInt:
+    case SpvOpTypeFloat:
+      op = SpvOpConstant;
+      operands.push_back(
+          {spv_operand_type_t::SPV_OPERAND_TYPE_TYPED_LITERAL_NUMBER,
+           consts_[index].words});
+      break;
+    default: {
+      op = SpvOpConstantComposite;
+      // Copy the component indices: GetConstId() does not add constants but
+      // keep this independent of |consts_| anyway.
+      const std::vector<uint32_t> components = consts_[index].words;
+      for (auto c : components)
+        operands.push_back(
+            {spv_operand_type_t::SPV_OPERAND_TYPE_ID, {GetConstId(c)}});
+    } break;
+  }
+  const uint32_t constId = TakeNextId();
+  std::unique_ptr<ir::Instruction> newConst(
+      new ir::Instruction(op, typeId, constId, operands));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newConst);
+  get_module()->AddGlobalValue(std::move(newConst));
+  consts_[index].id = constId;
+  return constId;
+}
+
+uint32_t SCCPPass::FoldableWidth(uint32_t typeId) {
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  switch (typeInst->opcode()) {
+    case SpvOpTypeBool:
+      return 1;
+    case SpvOpTypeInt:
+      // Arithmetic is only folded on 32-bit integers.
+      return typeInst->GetSingleWordInOperand(kTypeWidthInIdx) == 32 ? 1 : 0;
+    case SpvOpTypeVector:
+      return FoldableWidth(typeInst->GetSingleWordInOperand(
+                 kTypeVectorComponentTypeInIdx)) == 1
+                 ? typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx)
+                 : 0;
+    default:
+      return 0;
+  }
+}
+
+uint32_t SCCPPass::ComponentType(uint32_t typeId) {
+  const ir::Instruction* typeInst = get_def_use_mgr()->GetDef(typeId);
+  if (typeInst->opcode() != SpvOpTypeVector) return typeId;
+  return typeInst->GetSingleWordInOperand(kTypeVectorComponentTypeInIdx);
+}
+
+void SCCPPass::InitializeValues() {
+  for (auto& inst : get_module()->types_values()) {
+    const uint32_t resultId = inst.result_id();
+    if (resultId == 0) continue;
+    uint32_t value = kVarying;
+    switch (inst.opcode()) {
+      case SpvOpConstantTrue:
+      case SpvOpConstantFalse:
+        value = FindOrAddConst(inst.type_id(),
+                               {inst.opcode() == SpvOpConstantTrue ? 1u : 0u});
+        break;
+      case SpvOpConstant:
+        value = FindOrAddConst(inst.type_id(), inst.GetInOperand(0).words);
+        break;
+      case SpvOpConstantComposite: {
+        std::vector<uint32_t> components;
+        inst.ForEachInId([&components, this](const uint32_t* iid) {
+          components.push_back(Value(*iid));
+        });
+        if (std::all_of(components.begin(), components.end(), IsConst))
+          value = FindOrAddConst(inst.type_id(), components);
+      } break;
+      case SpvOpConstantNull: {
+        // Only null scalars and vectors are tracked.
+        const uint32_t compTypeId = ComponentType(inst.type_id());
+        const ir::Instruction* compTypeInst =
+            get_def_use_mgr()->GetDef(compTypeId);
+        if (compTypeInst->opcode() != SpvOpTypeBool &&
+            compTypeInst->opcode() != SpvOpTypeInt &&
+            compTypeInst->opcode() != SpvOpTypeFloat)
+          break;
+        const uint32_t width =
+            compTypeInst->opcode() == SpvOpTypeBool
+                ? 32
+                : compTypeInst->GetSingleWordInOperand(kTypeWidthInIdx);
+        value = FindOrAddConst(compTypeId,
+                               std::vector<uint32_t>((width + 31) / 32, 0));
+        if (compTypeId != inst.type_id()) {
+          const ir::Instruction* typeInst =
+              get_def_use_mgr()->GetDef(inst.type_id());
+          value = FindOrAddConst(
+              inst.type_id(),
+              std::vector<uint32_t>(
+                  typeInst->GetSingleWordInOperand(kTypeVectorCountInIdx),
+                  value));
+        }
+      } break;
+      default:
+        // Spec constants, global variables and undefs are not constant.
+        break;
+    }
+    if (IsConst(value) && consts_[value].id == 0)
+      consts_[value].id = resultId;
+    values_[resultId] = value;
+  }
+}
+
+void SCCPPass::SetValue(ir::Instruction* inst, uint32_t value) {
+  const uint32_t resultId = inst->result_id();
+  uint32_t& old = values_[resultId];
+  if (value == kUnknown || value == old || old == kVarying) return;
+  // A second, different, constant makes the value varying.
+  old = old == kUnknown ? value : kVarying;
+  analysis::UseList* uses = get_def_use_mgr()->GetUses(resultId);
+  if (uses == nullptr) return;
+  for (const auto& u : *uses) {
+    const auto bi = inst2block_.find(u.inst);
+    if (bi != inst2block_.end() && executable_blocks_.count(bi->second) != 0)
+      ssa_worklist_.push(u.inst);
+  }
+}
+
+void SCCPPass::AddEdge(uint32_t predId, uint32_t succId) {
+  if (!IsEdgeExecutable(predId, succId))
+    flow_worklist_.push(std::make_pair(predId, succId));
+}
+
+uint32_t SCCPPass::WalkComposite(ir::Instruction* inst, uint32_t firstIdx,
+                                 uint32_t index, uint32_t object) {
+  if (firstIdx == inst->NumInOperands())
+    return object == kUnknown ? index : object;
+  const ir::Instruction* typeInst =
+      get_def_use_mgr()->GetDef(consts_[index].type_id);
+  switch (typeInst->opcode()) {
+    case SpvOpTypeVector:
+    case SpvOpTypeMatrix:
+    case SpvOpTypeArray:
+    case SpvOpTypeStruct:
+      break;
+    default:
+      return kVarying;
+  }
+  const uint32_t member = inst->GetSingleWordInOperand(firstIdx);
+  if (member >= consts_[index].words.size()) return kVarying;
+  const uint32_t result = WalkComposite(
+      inst, firstIdx + 1, consts_[index].words[member], object);
+  if (object == kUnknown || !IsConst(result)) return result;
+  std::vector<uint32_t> components = consts_[index].words;
+  components[member] = result;
+  return FindOrAddConst(consts_[index].type_id, components);
+}
+
+uint32_t SCCPPass::EvaluateFoldable(ir::Instruction* inst) {
+  const uint32_t width = FoldableWidth(inst->type_id());
+  if (width == 0) return kVarying;
+  const bool isVector = ComponentType(inst->type_id()) != inst->type_id();
+  std::vector<uint32_t> operands;
+  bool unknown = false;
+  bool varying = false;
+  inst->ForEachInId([&operands, &unknown, &varying, width, this](
+      const uint32_t* iid) {
+    const uint32_t value = Value(*iid);
+    if (value == kUnknown)
+      unknown = true;
+    else if (value == kVarying || FoldableWidth(consts_[value].type_id) != width)
+      varying = true;
+    operands.push_back(value);
+  });
+  if (varying) return kVarying;
+  if (unknown) return kUnknown;
+  const uint32_t compTypeId = ComponentType(inst->type_id());
+  const bool isBool =
+      get_def_use_mgr()->GetDef(compTypeId)->opcode() == SpvOpTypeBool;
+  std::vector<uint32_t> results;
+  for (uint32_t d = 0; d < width; ++d) {
+    std::vector<uint32_t> words;
+    for (auto value : operands) {
+      const uint32_t comp = isVector ? consts_[value].words[d] : value;
+      words.push_back(consts_[comp].words[0]);
+    }
+    uint32_t result;
+    if (!FoldScalarWords(inst->opcode(), words, &result)) return kVarying;
+    if (isBool) result = result != 0 ? 1 : 0;
+    results.push_back(FindOrAddConst(compTypeId, {result}));
+  }
+  if (!isVector) return results[0];
+  return FindOrAddConst(inst->type_id(), results);
+}
+
+uint32_t SCCPPass::Evaluate(ir::Instruction* inst) {
+  switch (inst->opcode()) {
+    case SpvOpCopyObject:
+      return Value(inst->GetSingleWordInOperand(0));
+    case SpvOpSelect: {
+      const uint32_t cond = Value(inst->GetSingleWordInOperand(0));
+      const uint32_t trueVal = Value(inst->GetSingleWordInOperand(1));
+      const uint32_t falseVal = Value(inst->GetSingleWordInOperand(2));
+      if (cond == kUnknown) return kUnknown;
+      const bool vectorCond =
+          IsConst(cond) &&
+          ComponentType(consts_[cond].type_id) != consts_[cond].type_id;
+      if (IsConst(cond) && !vectorCond)
+        return consts_[cond].words[0] != 0 ? trueVal : falseVal;
+      if (trueVal == kVarying || falseVal == kVarying) return kVarying;
+      if (trueVal == kUnknown || falseVal == kUnknown) return kUnknown;
+      if (!vectorCond) return trueVal == falseVal ? trueVal : kVarying;
+      // Select each component.
+      std::vector<uint32_t> components;
+      for (uint32_t d = 0; d < consts_[cond].words.size(); ++d) {
+        const uint32_t c = consts_[cond].words[d];
+        components.push_back(consts_[c].words[0] != 0
+                                 ? consts_[trueVal].words[d]
+                                 : consts_[falseVal].words[d]);
+      }
+      return FindOrAddConst(inst->type_id(), components);
+    }
+    case SpvOpCompositeConstruct: {
+      const bool vectorResult =
+          ComponentType(inst->type_id()) != inst->type_id();
+      std::vector<uint32_t> components;
+      bool unknown = false;
+      bool varying = false;
+      inst->ForEachInId([&components, &unknown, &varying, vectorResult,
+                         this](const uint32_t* iid) {
+        const uint32_t value = Value(*iid);
+        if (value == kUnknown) {
+          unknown = true;
+        } else if (value == kVarying) {
+          varying = true;
+        } else if (vectorResult && ComponentType(consts_[value].type_id) !=
+                                       consts_[value].type_id) {
+          // A vector operand contributes all of its components.
+          const std::vector<uint32_t>& words = consts_[value].words;
+          components.insert(components.end(), words.begin(), words.end());
+        } else {
+          components.push_back(value);
+        }
+      });
+      if (varying) return kVarying;
+      if (unknown) return kUnknown;
+      return FindOrAddConst(inst->type_id(), components);
+    }
+    case SpvOpCompositeExtract: {
+      const uint32_t composite = Value(inst->GetSingleWordInOperand(0));
+      if (!IsConst(composite)) return composite;
+      return WalkComposite(inst, 1, composite, kUnknown);
+    }
+    case SpvOpCompositeInsert: {
+      const uint32_t object = Value(inst->GetSingleWordInOperand(0));
+      const uint32_t composite = Value(inst->GetSingleWordInOperand(1));
+      if (object == kVarying || composite == kVarying) return kVarying;
+      if (object == kUnknown || composite == kUnknown) return kUnknown;
+      return WalkComposite(inst, 2, composite, object);
+    }
+    case SpvOpVectorShuffle: {
+      const uint32_t vec1 = Value(inst->GetSingleWordInOperand(0));
+      const uint32_t vec2 = Value(inst->GetSingleWordInOperand(1));
+      if (vec1 == kVarying || vec2 == kVarying) return kVarying;
+      if (vec1 == kUnknown || vec2 == kUnknown) return kUnknown;
+      std::vector<uint32_t> sources = consts_[vec1].words;
+      sources.insert(sources.end(), consts_[vec2].words.begin(),
+                     consts_[vec2].words.end());
+      std::vector<uint32_t> components;
+      for (uint32_t i = kVectorShuffleFirstComponentInIdx;
+           i < inst->NumInOperands(); ++i) {
+        const uint32_t c = inst->GetSingleWordInOperand(i);
+        if (c == kUndefinedComponent || c >= sources.size()) return kVarying;
+        components.push_back(sources[c]);
+      }
+      return FindOrAddConst(inst->type_id(), components);
+    }
+    default:
+      if (IsFoldableScalarOp(inst->opcode())) return EvaluateFoldable(inst);
+      // Loads, calls, image operations, floating point arithmetic, etc.
+      return kVarying;
+  }
+}
+
+void SCCPPass::VisitPhi(ir::BasicBlock* bp, ir::Instruction* inst) {
+  const uint32_t blkId = bp->id();
+  uint32_t value = kUnknown;
+  for (uint32_t i = 0; i < inst->NumInOperands(); i += 2) {
+    if (!IsEdgeExecutable(inst->GetSingleWordInOperand(i + 1), blkId))
+      continue;
+    const uint32_t opValue = Value(inst->GetSingleWordInOperand(i));
+    if (opValue == kUnknown) continue;
+    if (value == kUnknown) {
+      value = opValue;
+    } else if (opValue != value) {
+      value = kVarying;
+      break;
+    }
+  }
+  SetValue(inst, value);
+}
+
+bool SCCPPass::GetConstBranchTarget(ir::Instruction* br, uint32_t* liveLabId) {
+  if (br->opcode() != SpvOpBranchConditional && br->opcode() != SpvOpSwitch)
+    return false;
+  // Both BranchConditional and Switch have their conditional value at 0.
+  const uint32_t cond = Value(br->GetSingleWordInOperand(0));
+  if (!IsConst(cond)) return false;
+  if (br->opcode() == SpvOpBranchConditional) {
+    *liveLabId = br->GetSingleWordInOperand(consts_[cond].words[0] != 0
+                                                ? kBranchCondTrueLabIdInIdx
+                                                : kBranchCondFalseLabIdInIdx);
+    return true;
+  }
+  // Switches on constants of other widths than 32 bits are left alone: their
+  // case literals take more than one word each.
+  if (consts_[cond].words.size() != 1) return false;
+  const uint32_t selVal = consts_[cond].words[0];
+  *liveLabId = br->GetSingleWordInOperand(kSwitchDefaultLabIdInIdx);
+  for (uint32_t i = kSwitchFirstCaseInIdx; i + 1 < br->NumInOperands();
+       i += 2) {
+    if (br->GetSingleWordInOperand(i) == selVal) {
+      *liveLabId = br->GetSingleWordInOperand(i + 1);
+      break;
+    }
+  }
+  return true;
+}
+
+void SCCPPass::VisitBranch(ir::BasicBlock* bp, ir::Instruction* inst) {
+  const uint32_t blkId = bp->id();
+  if ((inst->opcode() == SpvOpBranchConditional ||
+       inst->opcode() == SpvOpSwitch) &&
+      Value(inst->GetSingleWordInOperand(0)) == kUnknown)
+    return;
+  uint32_t liveLabId;
+  if (GetConstBranchTarget(inst, &liveLabId)) {
+    AddEdge(blkId, liveLabId);
+    return;
+  }
+  bp->ForEachSuccessorLabel(
+      [blkId, this](const uint32_t labId) { AddEdge(blkId, labId); });
+}
+
+void SCCPPass::VisitInstruction(ir::BasicBlock* bp, ir::Instruction* inst) {
+  switch (inst->opcode()) {
+    case SpvOpLabel:
+      return;
+    case SpvOpPhi:
+      VisitPhi(bp, inst);
+      return;
+    default:
+      break;
+  }
+  if (inst == &*bp->tail())
+    VisitBranch(bp, inst);
+  else if (inst->result_id() != 0 && inst->type_id() != 0)
+    SetValue(inst, Evaluate(inst));
+}
+
+void SCCPPass::Propagate(ir::Function* func) {
+  inst2block_.clear();
+  executable_blocks_.clear();
+  executable_edges_.clear();
+  func->ForEachParam([this](const ir::Instruction* param) {
+    values_[param->result_id()] = kVarying;
+  });
+  for (auto& blk : *func)
+    blk.ForEachInst(
+        [&blk, this](ir::Instruction* inst) { inst2block_[inst] = &blk; });
+  AddEdge(0, func->begin()->id());
+  while (!flow_worklist_.empty() || !ssa_worklist_.empty()) {
+    while (!flow_worklist_.empty()) {
+      const auto edge = flow_worklist_.front();
+      flow_worklist_.pop();
+      if (!executable_edges_.insert(edge).second) continue;
+      ir::BasicBlock* succ = cfg()->block(edge.second);
+      // The first time a block is reached all of its instructions are
+      // evaluated. After that only its phis see the new edge.
+      if (executable_blocks_.insert(succ).second)
+        succ->ForEachInst(
+            [succ, this](ir::Instruction* inst) { VisitInstruction(succ, inst); });
+      else
+        succ->ForEachPhiInst(
+            [succ, this](ir::Instruction* phi) { VisitPhi(succ, phi); });
+    }
+    if (!ssa_worklist_.empty()) {
+      ir::Instruction* inst = ssa_worklist_.front();
+      ssa_worklist_.pop();
+      ir::BasicBlock* bp = inst2block_[inst];
+      if (executable_blocks_.count(bp) != 0) VisitInstruction(bp, inst);
+    }
+  }
+}
+
+void SCCPPass::RemovePhiEdge(ir::BasicBlock* bp, uint32_t succId) {
+  const uint32_t predId = bp->id();
+  cfg()->block(succId)->ForEachPhiInst([predId](ir::Instruction* phi) {
+    // Operands 0 and 1 are the type and result ids; the rest come in pairs
+    // of value and parent block.
+    std::vector<ir::Operand> keepOperands;
+    for (uint32_t i = 0; i < phi->NumOperands(); ++i) {
+      if (i >= 2 && i % 2 == 1 && phi->GetSingleWordOperand(i) == predId) {
+        keepOperands.pop_back();
+        continue;
+      }
+      keepOperands.push_back(phi->GetOperand(i));
+    }
+    phi->ReplaceOperands(keepOperands);
+  });
+}
+
+void SCCPPass::AddBranch(uint32_t labelId, ir::BasicBlock* bp) {
+  std::unique_ptr<ir::Instruction> newBranch(
+    new ir::Instruction(SpvOpBranch, 0, 0,
+        {{spv_operand_type_t::SPV_OPERAND_TYPE_ID, {labelId}}}));
+  get_def_use_mgr()->AnalyzeInstDefUse(&*newBranch);
+  bp->AddInstruction(std::move(newBranch));
+}
+
+bool SCCPPass::ReplaceConstants(ir::Function* func) {
+  bool branchesModified = false;
+  // Replace branches on constants before the constants themselves, so that
+  // the lattice values of the conditions can still be found by id. The phis
+  // of the targets no longer taken are updated last, as their operands are
+  // rewritten without updating the def-use manager.
+  std::vector<std::pair<ir::BasicBlock*, uint32_t>> deadEdges;
+  for (auto& blk : *func) {
+    if (executable_blocks_.count(&blk) == 0) continue;
+    ir::Instruction* br = &*blk.tail();
+    uint32_t liveLabId;
+    if (!GetConstBranchTarget(br, &liveLabId)) continue;
+    std::vector<uint32_t> deadLabIds;
+    blk.ForEachSuccessorLabel([&deadLabIds, liveLabId](const uint32_t labId) {
+      if (labId != liveLabId &&
+          std::find(deadLabIds.begin(), deadLabIds.end(), labId) ==
+              deadLabIds.end())
+        deadLabIds.push_back(labId);
+    });
+    for (auto labId : deadLabIds) deadEdges.push_back({&blk, labId});
+    // The selection construct disappears with the conditional branch. A
+    // loop header keeps its OpLoopMerge, which may precede an OpBranch. The
+    // instructions are erased rather than left as OpNop so that the merge
+    // instruction stays right before the terminator.
+    ir::Instruction* mergeInst = blk.GetMergeInst();
+    get_def_use_mgr()->KillInst(br);
+    (void)blk.tail().Erase();
+    if (mergeInst != nullptr && mergeInst->opcode() == SpvOpSelectionMerge) {
+      get_def_use_mgr()->KillInst(mergeInst);
+      (void)blk.tail().Erase();
+    }
+    AddBranch(liveLabId, &blk);
+    branchesModified = true;
+  }
+  // Replace constant results, users first, so that no constant is added to
+  // the module for a result whose uses are all being replaced as well.
+  std::vector<ir::Instruction*> constInsts;
+  for (auto& blk : *func) {
+    if (executable_blocks_.count(&blk) == 0) continue;
+    for (auto& inst : blk)
+      if (inst.result_id() != 0 && IsConst(Value(inst.result_id())))
+        constInsts.push_back(&inst);
+  }
+  for (auto ii = constInsts.rbegin(); ii != constInsts.rend(); ++ii) {
+    const uint32_t resultId = (*ii)->result_id();
+    KillNamesAndDecorates(resultId);
+    const analysis::UseList* uses = get_def_use_mgr()->GetUses(resultId);
+    if (uses != nullptr && !uses->empty())
+      (void)get_def_use_mgr()->ReplaceAllUsesWith(
+          resultId, GetConstId(Value(resultId)));
+    get_def_use_mgr()->KillInst(*ii);
+  }
+  for (auto& edge : deadEdges) RemovePhiEdge(edge.first, edge.second);
+  // Blocks only reached through the removed edges are now unreachable.
+  if (branchesModified) (void)CFGCleanup(func);
+  return branchesModified || !constInsts.empty();
+}
+
+bool SCCPPass::PropagateConstants(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  Propagate(func);
+  return ReplaceConstants(func);
+}
+
+void SCCPPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+  InitializeCFGCleanup(c);
+
+  consts_.clear();
+  const_index_.clear();
+  values_.assign(get_module()->IdBound(), kUnknown);
+  InitializeValues();
+}
+
+Pass::Status SCCPPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate)
+      return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return PropagateConstants(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+SCCPPass::SCCPPass() {}
+
+Pass::Status SCCPPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,183 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_SCCP_PASS_H_
+#define LIBSPIRV_OPT_SCCP_PASS_H_
+
+#include <map>
+#include <queue>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include "basic_block.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class SCCPPass : public MemPass {
+ public:
+  SCCPPass();
+  const char* name() const override { return "sccp"; }
+  Status Process(ir::IRContext* c) override;
+
+ private:
+  // Lattice values of an id that are not indices into |consts_|. An id whose
+  // value is kUnknown has not been shown to be executed yet; one whose value
+  // is kVarying is not a constant.
+  static const uint32_t kUnknown = ~0u;
+  static const uint32_t kVarying = ~0u - 1;
+
+  // A constant value that an id may hold.
+  struct ConstValue {
+    // Type of the constant.
+    uint32_t type_id;
+    // The literal words of a scalar, or the indices into |consts_| of the
+    // components of a composite. A boolean is a single word, 0 or 1.
+    std::vector<uint32_t> words;
+    // Result id of the instruction defining the constant, or 0 if it has not
+    // been added to the module yet.
+    uint32_t id;
+  };
+
+  // Returns the index into |consts_| of the constant of type |typeId| with
+  // |words|, recording a new constant if there is none yet.
+  uint32_t FindOrAddConst(uint32_t typeId, const std::vector<uint32_t>& words);
+
+  // Returns the id of the instruction defining constant |index|, adding the
+  // instruction, and those of its components, to the module if needed.
+  uint32_t GetConstId(uint32_t index);
+
+  // Returns the lattice value of |id|.
+  uint32_t Value(uint32_t id) const {
+    return id < values_.size() ? values_[id] : kVarying;
+  }
+
+  // Returns true if |value| is a constant, not kUnknown or kVarying.
+  static bool IsConst(uint32_t value) { return value < kVarying; }
+
+  // Returns the number of components of type |typeId| if it is a vector of
+  // 32-bit integers or booleans, 1 if it is a 32-bit integer or boolean
+  // scalar, and 0 otherwise.
+  uint32_t FoldableWidth(uint32_t typeId);
+
+  // Returns the type of the components of vector type |typeId|, or |typeId|
+  // itself if it is not a vector.
+  uint32_t ComponentType(uint32_t typeId);
+
+  // Records the lattice value of each constant and global value of the
+  // module.
+  void InitializeValues();
+
+  // Lowers the lattice value of |inst|'s result to |value| and queues the
+  // executable users of the result if it changed. The value of an id only
+  // goes down from kUnknown to a constant to kVarying.
+  void SetValue(ir::Instruction* inst, uint32_t value);
+
+  // Marks the edge from block |predId| to block |succId| executable. The
+  // entry block is reached through the edge from id 0.
+  void AddEdge(uint32_t predId, uint32_t succId);
+
+  // Returns true if the edge from block |predId| to block |succId| has been
+  // found executable.
+  bool IsEdgeExecutable(uint32_t predId, uint32_t succId) const {
+    return executable_edges_.count(std::make_pair(predId, succId)) != 0;
+  }
+
+  // Returns the lattice value of |inst|'s result given the values of its
+  // operands. Handles the foldable integer and boolean operations, OpSelect,
+  // OpCopyObject and the composite instructions.
+  uint32_t Evaluate(ir::Instruction* inst);
+
+  // Returns the lattice value of composite constant |index| after applying
+  // the indices of OpCompositeExtract or OpCompositeInsert |inst| starting at
+  // in-operand |firstIdx|. If |object| is not kUnknown, the indexed element is
+  // replaced with |object| and the new composite is returned instead.
+  uint32_t WalkComposite(ir::Instruction* inst, uint32_t firstIdx,
+                         uint32_t index, uint32_t object);
+
+  // Evaluates foldable operation |inst| component by component.
+  uint32_t EvaluateFoldable(ir::Instruction* inst);
+
+  // Meets the values of phi |inst| of block |bp| over its executable incoming
+  // edges.
+  void VisitPhi(ir::BasicBlock* bp, ir::Instruction* inst);
+
+  // Marks executable the outgoing edges of block |bp| that its terminator
+  // |inst| may take.
+  void VisitBranch(ir::BasicBlock* bp, ir::Instruction* inst);
+
+  // Visits |inst| in block |bp|.
+  void VisitInstruction(ir::BasicBlock* bp, ir::Instruction* inst);
+
+  // Propagates constants through |func| and finds its executable edges.
+  void Propagate(ir::Function* func);
+
+  // If |br| is a conditional branch or switch on a constant, returns true and
+  // the label of the only target it can take in |liveLabId|.
+  bool GetConstBranchTarget(ir::Instruction* br, uint32_t* liveLabId);
+
+  // Removes from the phis of block |succId| the operands for the edge from
+  // |bp|.
+  void RemovePhiEdge(ir::BasicBlock* bp, uint32_t succId);
+
+  // Add branch to |labelId| to end of block |bp|.
+  void AddBranch(uint32_t labelId, ir::BasicBlock* bp);
+
+  // Replaces the results of |func| found to be constant with the constants,
+  // turns branches on constants into unconditional branches, and removes the
+  // blocks that are no longer reachable. Return true if |func| is modified.
+  bool ReplaceConstants(ir::Function* func);
+
+  // Runs sparse conditional constant propagation on |func|. Return true if
+  // |func| is modified.
+  bool PropagateConstants(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // All constants known to the pass, existing or folded.
+  std::vector<ConstValue> consts_;
+
+  // Map from the type and words of a constant to its index in |consts_|.
+  std::map<std::pair<uint32_t, std::vector<uint32_t>>, uint32_t> const_index_;
+
+  // Lattice value of each id.
+  std::vector<uint32_t> values_;
+
+  // Block containing each instruction of the current function.
+  std::unordered_map<const ir::Instruction*, ir::BasicBlock*> inst2block_;
+
+  // Blocks of the current function found to be executable.
+  std::unordered_set<const ir::BasicBlock*> executable_blocks_;
+
+  // Edges of the current function found to be executable, as pairs of
+  // predecessor and successor labels.
+  std::set<std::pair<uint32_t, uint32_t>> executable_edges_;
+
+  // Edges newly found executable, and instructions whose operands changed.
+  std::queue<std::pair<uint32_t, uint32_t>> flow_worklist_;
+  std::queue<ir::Instruction*> ssa_worklist_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_SCCP_PASS_H_
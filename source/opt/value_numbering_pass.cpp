@@ -0,0 +1,185 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "value_numbering_pass.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "dominator_analysis.h"
+#include "ir_context.h"
+#include "opcode.h"
+#include "operand.h"
+
+namespace spvtools {
+namespace opt {
+
+size_t ValueNumberingPass::ValueKeyHash::operator()(
+    const ValueKey& key) const {
+  size_t hash = key.size();
+  for (auto word : key)
+    hash ^= std::hash<uint32_t>()(word) + 0x9e3779b9 + (hash << 6) +
+            (hash >> 2);
+  return hash;
+}
+
+bool ValueNumberingPass::IsCommutativeOp(SpvOp opcode) {
+  switch (opcode) {
+    case SpvOpIAdd:
+    case SpvOpIMul:
+    case SpvOpBitwiseOr:
+    case SpvOpBitwiseXor:
+    case SpvOpBitwiseAnd:
+    case SpvOpLogicalEqual:
+    case SpvOpLogicalNotEqual:
+    case SpvOpLogicalOr:
+    case SpvOpLogicalAnd:
+    case SpvOpIEqual:
+    case SpvOpINotEqual:
+      return true;
+    default:
+      return false;
+  }
+}
+
+ValueNumberingPass::ValueKey ValueNumberingPass::MakeKey(
+    const ir::Instruction* inst, const ir::BasicBlock* bp) const {
+  ValueKey key;
+  key.push_back(inst->opcode());
+  key.push_back(inst->type_id());
+  // A phi's value depends on the edge its block is entered through, so phis
+  // can only be equal within a block.
+  if (inst->opcode() == SpvOpPhi) key.push_back(bp->id());
+  const size_t firstOperand = key.size();
+  for (uint32_t i = 0; i < inst->NumInOperands(); ++i) {
+    const ir::Operand& operand = inst->GetInOperand(i);
+    if (spvIsIdType(operand.type)) {
+      key.push_back(ValueNumber(operand.words[0]));
+    } else {
+      key.insert(key.end(), operand.words.begin(), operand.words.end());
+    }
+  }
+  if (IsCommutativeOp(inst->opcode()) && key.size() == firstOperand + 2 &&
+      key[firstOperand] > key[firstOperand + 1])
+    std::swap(key[firstOperand], key[firstOperand + 1]);
+  return key;
+}
+
+void ValueNumberingPass::NumberBlock(ir::BasicBlock* bp) {
+  for (auto& inst : *bp) {
+    const uint32_t resultId = inst.result_id();
+    if (resultId == 0 || inst.type_id() == 0) continue;
+    // Phis are pure within a block.
+    if (!spvOpcodeIsPure(inst.opcode()) && inst.opcode() != SpvOpPhi)
+      continue;
+    ValueKey key = MakeKey(&inst, bp);
+    const auto ti = table_.find(key);
+    if (ti == table_.end()) {
+      scope_.push_back(key);
+      table_.emplace(std::move(key), resultId);
+      continue;
+    }
+    // Decorations such as NoContraction or RelaxedPrecision change the
+    // meaning of the result, so both ids must have the same ones.
+    const uint32_t leaderId = ti->second;
+    if ((decorated_ids_.count(resultId) != 0 ||
+         decorated_ids_.count(leaderId) != 0) &&
+        !dec_mgr_->HaveTheSameDecorations(resultId, leaderId))
+      continue;
+    value_numbers_[resultId] = leaderId;
+    redundant_insts_.push_back(&inst);
+  }
+}
+
+bool ValueNumberingPass::EliminateRedundancies(ir::Function* func) {
+  // Nothing to do for a function declaration.
+  if (func->begin() == func->end()) return false;
+  value_numbers_.clear();
+  table_.clear();
+  scope_.clear();
+  redundant_insts_.clear();
+  DominatorAnalysis* domTree = context()->GetDominatorAnalysis(func);
+  // Walk the dominator tree depth first, so that the table holds exactly the
+  // values computed in the dominators of the current block. Each entry of
+  // the stack is a block, the next of its children to visit, and the size
+  // of |scope_| before the block was numbered.
+  struct Frame {
+    ir::BasicBlock* block;
+    size_t next_child;
+    size_t scope_size;
+  };
+  std::vector<Frame> stack;
+  ir::BasicBlock* entry = &*func->begin();
+  stack.push_back({entry, 0, 0});
+  NumberBlock(entry);
+  while (!stack.empty()) {
+    Frame& frame = stack.back();
+    const std::vector<ir::BasicBlock*>& children =
+        domTree->Children(frame.block);
+    if (frame.next_child < children.size()) {
+      ir::BasicBlock* child = children[frame.next_child++];
+      stack.push_back({child, 0, scope_.size()});
+      NumberBlock(child);
+      continue;
+    }
+    for (size_t i = frame.scope_size; i < scope_.size(); ++i)
+      table_.erase(scope_[i]);
+    scope_.resize(frame.scope_size);
+    stack.pop_back();
+  }
+  // Value numbers always refer to instructions that are kept, so the
+  // replacements can be done in any order.
+  for (auto inst : redundant_insts_) {
+    const uint32_t resultId = inst->result_id();
+    KillNamesAndDecorates(resultId);
+    (void)get_def_use_mgr()->ReplaceAllUsesWith(resultId,
+                                                ValueNumber(resultId));
+    get_def_use_mgr()->KillInst(inst);
+  }
+  return !redundant_insts_.empty();
+}
+
+void ValueNumberingPass::Initialize(ir::IRContext* c) {
+  InitializeProcessing(c);
+  dec_mgr_.reset(new analysis::DecorationManager(get_module()));
+  decorated_ids_.clear();
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() != SpvOpDecorationGroup && ai.NumInOperands() > 0)
+      decorated_ids_.insert(ai.GetSingleWordInOperand(0));
+}
+
+Pass::Status ValueNumberingPass::ProcessImpl() {
+  // Do not process if module contains OpGroupDecorate. Additional
+  // support required in KillNamesAndDecorates().
+  // TODO(greg-lunarg): Add support for OpGroupDecorate
+  for (auto& ai : get_module()->annotations())
+    if (ai.opcode() == SpvOpGroupDecorate)
+      return Status::SuccessWithoutChange;
+  // Process all functions reachable from entry points and exported functions
+  ProcessFunction pfn = [this](ir::Function* fp) {
+    return EliminateRedundancies(fp);
+  };
+  bool modified = ProcessReachableCallTree(pfn, context());
+  return modified ? Status::SuccessWithChange : Status::SuccessWithoutChange;
+}
+
+ValueNumberingPass::ValueNumberingPass() {}
+
+Pass::Status ValueNumberingPass::Process(ir::IRContext* c) {
+  Initialize(c);
+  return ProcessImpl();
+}
+
+}  // namespace opt
+}  // namespace spvtools
@@ -0,0 +1,99 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_OPT_VALUE_NUMBERING_PASS_H_
+#define LIBSPIRV_OPT_VALUE_NUMBERING_PASS_H_
+
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "basic_block.h"
+#include "decoration_manager.h"
+#include "def_use_manager.h"
+#include "mem_pass.h"
+#include "module.h"
+
+namespace spvtools {
+namespace opt {
+
+// See optimizer.hpp for documentation.
+class ValueNumberingPass : public MemPass {
+ public:
+  ValueNumberingPass();
+  const char* name() const override { return "value-numbering"; }
+  Status Process(ir::IRContext* c) override;
+
+ private:
+  // The words identifying the value computed by an instruction: its opcode,
+  // result type and in-operands, with the ids replaced by their value numbers.
+  using ValueKey = std::vector<uint32_t>;
+
+  struct ValueKeyHash {
+    size_t operator()(const ValueKey& key) const;
+  };
+
+  // Returns true if the result of |opcode| does not depend on the order of
+  // its two operands.
+  static bool IsCommutativeOp(SpvOp opcode);
+
+  // Returns the value number of |id|: the id of the earliest dominating
+  // instruction known to compute the same value, or |id| itself.
+  uint32_t ValueNumber(uint32_t id) const {
+    const auto vi = value_numbers_.find(id);
+    return vi == value_numbers_.end() ? id : vi->second;
+  }
+
+  // Returns the key of pure instruction |inst| of block |bp|.
+  ValueKey MakeKey(const ir::Instruction* inst, const ir::BasicBlock* bp) const;
+
+  // Numbers the instructions of block |bp|, whose dominators have already
+  // been numbered. The keys added to |table_| are appended to |scope_|, and
+  // the redundant instructions to |redundant_insts_|.
+  void NumberBlock(ir::BasicBlock* bp);
+
+  // Walks the dominator tree of |func|, numbering values and replacing
+  // every instruction that computes the same value as a dominating one.
+  // Return true if |func| is modified.
+  bool EliminateRedundancies(ir::Function* func);
+
+  void Initialize(ir::IRContext* c);
+  Pass::Status ProcessImpl();
+
+  // Value number of each id found equal to an earlier one.
+  std::unordered_map<uint32_t, uint32_t> value_numbers_;
+
+  // Map from the key of each value computed in the blocks dominating the
+  // current block to the id computing it.
+  std::unordered_map<ValueKey, uint32_t, ValueKeyHash> table_;
+
+  // Keys added to |table_|, in the order they were added. The entries of a
+  // block are removed once its dominator subtree has been walked.
+  std::vector<ValueKey> scope_;
+
+  // Redundant instructions of the current function, replaced once the walk
+  // is done.
+  std::vector<ir::Instruction*> redundant_insts_;
+
+  // Ids that are the target of a decoration.
+  std::unordered_set<uint32_t> decorated_ids_;
+
+  std::unique_ptr<analysis::DecorationManager> dec_mgr_;
+};
+
+}  // namespace opt
+}  // namespace spvtools
+
+#endif  // LIBSPIRV_OPT_VALUE_NUMBERING_PASS_H_
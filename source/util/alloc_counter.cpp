@@ -0,0 +1,45 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/alloc_counter.h"
+
+#include <atomic>
+
+namespace spvutils {
+
+namespace {
+
+// These are constant-initialized and trivially destructible, so they work
+// for allocations made during static initialization and destruction.
+std::atomic<uint64_t> allocation_count(0);
+std::atomic<uint64_t> allocated_bytes(0);
+
+}  // anonymous namespace
+
+bool AllocationCountingEnabled() {
+  // The hooks see allocations well before main() runs.
+  return allocation_count.load(std::memory_order_relaxed) != 0;
+}
+
+AllocationStats GetAllocationStats() {
+  return {allocation_count.load(std::memory_order_relaxed),
+          allocated_bytes.load(std::memory_order_relaxed)};
+}
+
+void RecordAllocation(size_t size) {
+  allocation_count.fetch_add(1, std::memory_order_relaxed);
+  allocated_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+}  // namespace spvutils
@@ -0,0 +1,49 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_UTIL_ALLOC_COUNTER_H_
+#define LIBSPIRV_UTIL_ALLOC_COUNTER_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace spvutils {
+
+// The heap allocations made by the process.
+struct AllocationStats {
+  uint64_t count;  // Number of allocations.
+  uint64_t bytes;  // Number of bytes requested.
+};
+
+// Returns true if the executable counts its heap allocations. Executables do
+// so when they are linked with the allocation hooks, as done for the tools
+// and tests of a build configured with SPIRV_COUNT_ALLOCATIONS=ON.
+bool AllocationCountingEnabled();
+
+// Returns the heap allocations made so far by all threads. This is all zeros
+// unless AllocationCountingEnabled().
+AllocationStats GetAllocationStats();
+
+// Returns the allocations in |after| that are not in |before|.
+inline AllocationStats operator-(const AllocationStats& after,
+                                 const AllocationStats& before) {
+  return {after.count - before.count, after.bytes - before.bytes};
+}
+
+// Called by the allocation hooks for each allocation of |size| bytes.
+void RecordAllocation(size_t size);
+
+}  // namespace spvutils
+
+#endif  // LIBSPIRV_UTIL_ALLOC_COUNTER_H_
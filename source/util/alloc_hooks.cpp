@@ -0,0 +1,81 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Allocation hooks for executables. Linking this file into an executable
+// makes it count its heap allocations through spvutils::RecordAllocation().
+//
+// With glibc, malloc and friends are interposed, which also covers the
+// global operator new since it allocates with malloc. Elsewhere, the global
+// operator new and delete are replaced.
+
+#include <cstdlib>
+#include <new>
+
+#include "util/alloc_counter.h"
+
+#if defined(__GLIBC__)
+
+extern "C" {
+
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* p, size_t size);
+
+void* malloc(size_t size) {
+  spvutils::RecordAllocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+  spvutils::RecordAllocation(count * size);
+  return __libc_calloc(count, size);
+}
+
+void* realloc(void* p, size_t size) {
+  spvutils::RecordAllocation(size);
+  return __libc_realloc(p, size);
+}
+
+}  // extern "C"
+
+#else  // !defined(__GLIBC__)
+
+namespace {
+
+void* CountedAllocate(std::size_t size) {
+  spvutils::RecordAllocation(size);
+  if (void* p = std::malloc(size ? size : 1)) return p;
+  // The library is built without exceptions: fail the way the default
+  // allocator of such a build does.
+  std::abort();
+}
+
+}  // anonymous namespace
+
+void* operator new(std::size_t size) { return CountedAllocate(size); }
+void* operator new[](std::size_t size) { return CountedAllocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return CountedAllocate(size);
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+  std::free(p);
+}
+
+#endif  // defined(__GLIBC__)
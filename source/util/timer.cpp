@@ -0,0 +1,39 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "util/timer.h"
+
+#include <iomanip>
+
+namespace spvutils {
+
+ScopedTimer::~ScopedTimer() {
+  if (!out_) return;
+  const AllocationStats allocations = GetAllocationStats() - start_allocations_;
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - start_time_;
+  const auto flags = out_->flags();
+  const auto precision = out_->precision();
+  *out_ << name_ << ": " << std::fixed << std::setprecision(3)
+        << elapsed.count() << " ms";
+  if (AllocationCountingEnabled()) {
+    *out_ << ", " << allocations.count << " allocations, " << allocations.bytes
+          << " bytes";
+  }
+  *out_ << std::endl;
+  out_->flags(flags);
+  out_->precision(precision);
+}
+
+}  // namespace spvutils
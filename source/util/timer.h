@@ -0,0 +1,55 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_UTIL_TIMER_H_
+#define LIBSPIRV_UTIL_TIMER_H_
+
+#include <chrono>
+#include <ostream>
+
+#include "util/alloc_counter.h"
+
+namespace spvutils {
+
+// Measures the wall time and the heap allocations of a phase of processing,
+// from its construction to its destruction, and then reports them to |out|
+// on one line:
+//
+//   <name>: <milliseconds> ms, <count> allocations, <bytes> bytes
+//
+// The allocations are only reported when AllocationCountingEnabled(). Since
+// the counts are process-wide, they include the allocations of other threads.
+class ScopedTimer {
+ public:
+  // Reports the phase named |name| to |out|. Does nothing if |out| is null.
+  // |name| must outlive the timer.
+  ScopedTimer(std::ostream* out, const char* name)
+      : out_(out),
+        name_(name),
+        start_time_(std::chrono::steady_clock::now()),
+        start_allocations_(GetAllocationStats()) {}
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+  ~ScopedTimer();
+
+ private:
+  std::ostream* out_;
+  const char* name_;
+  const std::chrono::steady_clock::time_point start_time_;
+  const AllocationStats start_allocations_;
+};
+
+}  // namespace spvutils
+
+#endif  // LIBSPIRV_UTIL_TIMER_H_
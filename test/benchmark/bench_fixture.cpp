@@ -0,0 +1,110 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "bench_fixture.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "module_generator.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvbench {
+
+namespace {
+
+// The checked-in modules of the corpus directory.
+const char* const kCheckedInModules[] = {
+    "call.frag.spvasm", "for_loop.frag.spvasm",
+};
+
+// The number of functions in each of the synthetic modules of the corpus.
+const uint32_t kSyntheticSizes[] = {1, 16, 256};
+
+// Returns the number of instructions in |binary|.
+size_t CountInstructions(const std::vector<uint32_t>& binary) {
+  size_t count = 0;
+  spv_context context = spvContextCreate(kBenchEnv);
+  spvBinaryParse(context, &count, binary.data(), binary.size(), nullptr,
+                 [](void* user_data, const spv_parsed_instruction_t*) {
+                   ++*static_cast<size_t*>(user_data);
+                   return SPV_SUCCESS;
+                 },
+                 nullptr);
+  spvContextDestroy(context);
+  return count;
+}
+
+}  // anonymous namespace
+
+bool MakeCorpusModule(const std::string& name, const std::string& text,
+                      CorpusModule* module) {
+  spvtools::SpirvTools tools(kBenchEnv);
+  tools.SetMessageConsumer([&name](spv_message_level_t, const char*,
+                                   const spv_position_t& position,
+                                   const char* message) {
+    std::cerr << name << ":" << position.line + 1 << ":"
+              << position.column + 1 << ": " << message << std::endl;
+  });
+  module->name = name;
+  module->text = text;
+  module->binary.clear();
+  if (!tools.Assemble(text, &module->binary)) return false;
+  module->num_instructions = CountInstructions(module->binary);
+  return true;
+}
+
+std::vector<CorpusModule> LoadCorpus(const std::string& corpus_dir) {
+  std::vector<CorpusModule> corpus;
+  for (const char* file : kCheckedInModules) {
+    const std::string path = corpus_dir + "/" + file;
+    std::ifstream input(path);
+    if (input.fail()) {
+      std::cerr << "error: cannot open corpus file " << path << std::endl;
+      continue;
+    }
+    std::ostringstream text;
+    text << input.rdbuf();
+    CorpusModule module;
+    if (MakeCorpusModule(file, text.str(), &module))
+      corpus.push_back(std::move(module));
+  }
+  for (uint32_t size : kSyntheticSizes) {
+    ModuleGeneratorOptions options;
+    options.num_functions = size;
+    CorpusModule module;
+    if (MakeCorpusModule("synthetic_" + std::to_string(size),
+                         GenerateModuleText(options), &module))
+      corpus.push_back(std::move(module));
+  }
+  return corpus;
+}
+
+void ReportCounters(benchmark::State& state, const CorpusModule& module,
+                    uint64_t allocations) {
+  const double iterations = static_cast<double>(state.iterations());
+  const double words = static_cast<double>(module.binary.size());
+  state.SetItemsProcessed(state.iterations() *
+                          static_cast<int64_t>(module.binary.size()));
+  state.counters["words/s"] =
+      benchmark::Counter(words * iterations, benchmark::Counter::kIsRate);
+  if (module.num_instructions && state.iterations()) {
+    state.counters["allocs/inst"] =
+        static_cast<double>(allocations) /
+        (static_cast<double>(module.num_instructions) * iterations);
+  }
+}
+
+}  // namespace spvbench
@@ -0,0 +1,57 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_TEST_BENCHMARK_BENCH_FIXTURE_H_
+#define LIBSPIRV_TEST_BENCHMARK_BENCH_FIXTURE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "spirv-tools/libspirv.h"
+
+namespace spvbench {
+
+// The target environment all benchmarks run in.
+const spv_target_env kBenchEnv = SPV_ENV_UNIVERSAL_1_2;
+
+// A module of the benchmark corpus, in both of its forms.
+struct CorpusModule {
+  std::string name;
+  std::string text;
+  std::vector<uint32_t> binary;
+  size_t num_instructions;
+};
+
+// Assembles |text| into a corpus module named |name|. Returns false and
+// prints the diagnostic if |text| does not assemble.
+bool MakeCorpusModule(const std::string& name, const std::string& text,
+                      CorpusModule* module);
+
+// Returns the benchmark corpus: the checked-in modules of |corpus_dir|,
+// followed by synthetic modules of increasing size. Checked-in modules that
+// cannot be read or assembled are reported and skipped.
+std::vector<CorpusModule> LoadCorpus(const std::string& corpus_dir);
+
+// Reports the throughput of a benchmark that processed |module| once per
+// iteration as words per second, and |allocations|, the number of
+// allocations made by all the iterations, per instruction of |module|.
+void ReportCounters(benchmark::State& state, const CorpusModule& module,
+                    uint64_t allocations);
+
+}  // namespace spvbench
+
+#endif  // LIBSPIRV_TEST_BENCHMARK_BENCH_FIXTURE_H_
@@ -0,0 +1,443 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Microbenchmarks for the main entry points of the library, run over the
+// benchmark corpus. Each benchmark reports its throughput in words of input
+// per second and the heap allocations it makes per instruction of input.
+
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixture.h"
+#include "cfa.h"
+#include "module_generator.h"
+#include "opt/build_module.h"
+#include "opt/ir_context.h"
+#include "opt/make_unique.h"
+#include "opt/passes.h"
+#include "opt/remove_duplicates_pass.h"
+#include "spirv-tools/linker.hpp"
+#include "spirv-tools/optimizer.hpp"
+#include "util/alloc_counter.h"
+
+namespace {
+
+using spvbench::CorpusModule;
+using spvbench::kBenchEnv;
+using spvbench::ModuleGeneratorOptions;
+using spvtools::MakeUnique;
+using spvtools::opt::Pass;
+
+// Returns the number of heap allocations made so far.
+uint64_t AllocationCount() { return spvutils::GetAllocationStats().count; }
+
+// A pass to benchmark, named after its spirv-opt flag.
+struct PassEntry {
+  const char* name;
+  std::function<std::unique_ptr<Pass>()> create;
+};
+
+template <typename PassT>
+PassEntry Entry(const char* name) {
+  return {name, []() -> std::unique_ptr<Pass> { return MakeUnique<PassT>(); }};
+}
+
+// The passes run by the Pass benchmarks. Passes that need arguments are not
+// listed.
+std::vector<PassEntry> BenchmarkedPasses() {
+  using namespace spvtools::opt;
+  return {
+      Entry<StripDebugInfoPass>("strip-debug"),
+      Entry<FreezeSpecConstantValuePass>("freeze-spec-const"),
+      Entry<InlineExhaustivePass>("inline-entry-points-exhaustive"),
+      Entry<InlineOpaquePass>("inline-entry-points-opaque"),
+      Entry<LocalAccessChainConvertPass>("convert-local-access-chains"),
+      Entry<AggressiveDCEPass>("eliminate-dead-code-aggressive"),
+      Entry<InsertExtractElimPass>("eliminate-insert-extract"),
+      Entry<LocalSingleBlockLoadStoreElimPass>("eliminate-local-single-block"),
+      Entry<LocalSingleStoreElimPass>("eliminate-local-single-store"),
+      Entry<BlockMergePass>("merge-blocks"),
+      Entry<DeadBranchElimPass>("eliminate-dead-branches"),
+      Entry<EliminateDeadFunctionsPass>("eliminate-dead-functions"),
+      Entry<LocalMultiStoreElimPass>("eliminate-local-multi-store"),
+      Entry<CommonUniformElimPass>("eliminate-common-uniform"),
+      Entry<EliminateDeadConstantPass>("eliminate-dead-const"),
+      Entry<DeadVariableElimination>("eliminate-dead-variables"),
+      Entry<FoldSpecConstantOpAndCompositePass>("fold-spec-const-op-composite"),
+      Entry<StrengthReductionPass>("strength-reduction"),
+      Entry<SCCPPass>("sccp"),
+      Entry<ValueNumberingPass>("value-numbering"),
+      Entry<LICMPass>("loop-invariant-code-motion"),
+      Entry<ScalarReplacementPass>("scalar-replacement"),
+      Entry<MergeIdenticalFunctionsPass>("merge-identical-functions"),
+      Entry<DeadStoreElimPass>("eliminate-dead-stores"),
+      Entry<CopyPropagationPass>("copy-propagation"),
+      Entry<InstCombinePass>("combine-instructions"),
+      Entry<UnifyConstantPass>("unify-const"),
+      Entry<FlattenDecorationPass>("flatten-decorations"),
+      Entry<CompactIdsPass>("compact-ids"),
+      Entry<CFGCleanupPass>("cfg-cleanup"),
+      Entry<RemoveDuplicatesPass>("remove-duplicates"),
+  };
+}
+
+// A message consumer for modules that are known to be valid.
+void IgnoreMessage(spv_message_level_t, const char*, const spv_position_t&,
+                   const char*) {}
+
+// The number of modules, and of functions in each of them, linked by the
+// Link benchmarks.
+const uint32_t kLinkSizes[][2] = {{2, 16}, {16, 16}, {16, 256}};
+
+void BM_BinaryParse(benchmark::State& state, const CorpusModule* module) {
+  spv_context context = spvContextCreate(kBenchEnv);
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    spvBinaryParse(context, nullptr, module->binary.data(),
+                   module->binary.size(), nullptr, nullptr, nullptr);
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+  spvContextDestroy(context);
+}
+
+void BM_TextToBinary(benchmark::State& state, const CorpusModule* module) {
+  spv_context context = spvContextCreate(kBenchEnv);
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    spv_binary binary = nullptr;
+    spvTextToBinary(context, module->text.data(), module->text.size(), &binary,
+                    nullptr);
+    spvBinaryDestroy(binary);
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+  spvContextDestroy(context);
+}
+
+void BM_BinaryToText(benchmark::State& state, const CorpusModule* module) {
+  spv_context context = spvContextCreate(kBenchEnv);
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    spv_text text = nullptr;
+    spvBinaryToText(context, module->binary.data(), module->binary.size(),
+                    SPV_BINARY_TO_TEXT_OPTION_NONE, &text, nullptr);
+    spvTextDestroy(text);
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+  spvContextDestroy(context);
+}
+
+void BM_Validate(benchmark::State& state, const CorpusModule* module) {
+  spv_context context = spvContextCreate(kBenchEnv);
+  spv_const_binary_t binary = {module->binary.data(),
+                               module->binary.size()};
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    if (spvValidate(context, &binary, nullptr) != SPV_SUCCESS) {
+      state.SkipWithError("module is invalid");
+      break;
+    }
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+  spvContextDestroy(context);
+}
+
+void BM_BuildModule(benchmark::State& state, const CorpusModule* module) {
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    auto ir = spvtools::BuildModule(kBenchEnv, IgnoreMessage,
+                                    module->binary.data(),
+                                    module->binary.size());
+    benchmark::DoNotOptimize(ir.get());
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+}
+
+// Measures one run of a pass on a freshly built module. Building the module
+// and constructing the pass are not measured.
+void BM_Pass(benchmark::State& state, const CorpusModule* module,
+             const PassEntry* entry) {
+  uint64_t allocations = 0;
+  while (state.KeepRunning()) {
+    state.PauseTiming();
+    spvtools::ir::IRContext context(spvtools::BuildModule(
+        kBenchEnv, IgnoreMessage, module->binary.data(),
+        module->binary.size()));
+    std::unique_ptr<Pass> pass = entry->create();
+    const uint64_t before = AllocationCount();
+    state.ResumeTiming();
+
+    const auto status = pass->Process(&context);
+
+    state.PauseTiming();
+    allocations += AllocationCount() - before;
+    pass.reset();
+    state.ResumeTiming();
+    if (status == Pass::Status::Failure) {
+      state.SkipWithError("pass failed");
+      break;
+    }
+  }
+  spvbench::ReportCounters(state, *module, allocations);
+}
+
+void BM_Link(benchmark::State& state, const CorpusModule* module,
+             const std::vector<std::vector<uint32_t>>* inputs) {
+  spvtools::Linker linker(kBenchEnv);
+  const uint64_t allocations = AllocationCount();
+  while (state.KeepRunning()) {
+    std::vector<uint32_t> linked;
+    if (linker.Link(*inputs, linked) != SPV_SUCCESS) {
+      state.SkipWithError("link failed");
+      break;
+    }
+  }
+  spvbench::ReportCounters(state, *module,
+                           AllocationCount() - allocations);
+}
+
+// The sizes swept by the scaling benchmarks, which fit the complexity of
+// their operation to its running times.
+const int64_t kMinScalingSize = 16;
+const int64_t kMaxScalingSize = 16 << 10;
+
+// Returns the first function after the entry point of the generated
+// |module|.
+spvtools::ir::Function* GeneratedFunction(spvtools::ir::Module* module) {
+  return &*++module->begin();
+}
+
+// Measures the computation of the dominator tree of a function with
+// state.range(0) blocks.
+void BM_DominatorsScaling(benchmark::State& state) {
+  using spvtools::ir::BasicBlock;
+  using cbb_ptr = const BasicBlock*;
+
+  ModuleGeneratorOptions options;
+  options.blocks_per_function = static_cast<uint32_t>(state.range(0));
+  options.nesting_depth = 4;
+  options.instructions_per_block = 1;
+  options.call_depth = 0;
+  auto module = spvbench::GenerateIRModule(options, IgnoreMessage);
+  spvtools::ir::Function* function = GeneratedFunction(module.get());
+
+  std::unordered_map<uint32_t, BasicBlock*> blocks;
+  for (auto& block : *function) blocks[block.id()] = &block;
+  std::unordered_map<cbb_ptr, std::vector<BasicBlock*>> successors;
+  std::unordered_map<cbb_ptr, std::vector<BasicBlock*>> predecessors;
+  for (auto& block : *function) {
+    BasicBlock* b = &block;
+    b->ForEachSuccessorLabel([&](const uint32_t label) {
+      successors[b].push_back(blocks[label]);
+      predecessors[blocks[label]].push_back(b);
+    });
+  }
+  auto succ_func = [&successors](cbb_ptr b) { return &successors[b]; };
+  auto pred_func = [&predecessors](cbb_ptr b) { return &predecessors[b]; };
+  auto ignore_block = [](cbb_ptr) {};
+  auto ignore_edge = [](cbb_ptr, cbb_ptr) {};
+  const cbb_ptr entry = &*function->begin();
+
+  while (state.KeepRunning()) {
+    std::vector<cbb_ptr> postorder;
+    spvtools::CFA<BasicBlock>::DepthFirstTraversal(
+        entry, succ_func, ignore_block,
+        [&postorder](cbb_ptr b) { postorder.push_back(b); }, ignore_edge);
+    auto edges =
+        spvtools::CFA<BasicBlock>::CalculateDominators(postorder, pred_func);
+    benchmark::DoNotOptimize(edges.data());
+  }
+  state.SetComplexityN(static_cast<int64_t>(blocks.size()));
+}
+
+// Measures the validation of a module with one function of state.range(0)
+// blocks.
+void BM_ValidateBlocksScaling(benchmark::State& state) {
+  ModuleGeneratorOptions options;
+  options.blocks_per_function = static_cast<uint32_t>(state.range(0));
+  options.nesting_depth = 4;
+  options.call_depth = 0;
+  std::vector<uint32_t> binary;
+  spvbench::GenerateModule(options, &binary, IgnoreMessage);
+  spv_context context = spvContextCreate(kBenchEnv);
+  spv_const_binary_t input = {binary.data(), binary.size()};
+  while (state.KeepRunning()) {
+    spvValidate(context, &input, nullptr);
+  }
+  spvContextDestroy(context);
+  state.SetComplexityN(state.range(0));
+}
+
+// Measures the validation of a module with state.range(0) functions.
+void BM_ValidateFunctionsScaling(benchmark::State& state) {
+  ModuleGeneratorOptions options;
+  options.num_functions = static_cast<uint32_t>(state.range(0));
+  std::vector<uint32_t> binary;
+  spvbench::GenerateModule(options, &binary, IgnoreMessage);
+  spv_context context = spvContextCreate(kBenchEnv);
+  spv_const_binary_t input = {binary.data(), binary.size()};
+  while (state.KeepRunning()) {
+    spvValidate(context, &input, nullptr);
+  }
+  spvContextDestroy(context);
+  state.SetComplexityN(state.range(0));
+}
+
+// Measures the building of the in-memory representation of a module with
+// state.range(0) decorations.
+void BM_BuildModuleDecorationsScaling(benchmark::State& state) {
+  ModuleGeneratorOptions options;
+  options.num_functions = 16;
+  options.num_decorations = static_cast<uint32_t>(state.range(0));
+  std::vector<uint32_t> binary;
+  spvbench::GenerateModule(options, &binary, IgnoreMessage);
+  while (state.KeepRunning()) {
+    auto ir = spvtools::BuildModule(kBenchEnv, IgnoreMessage, binary.data(),
+                                    binary.size());
+    benchmark::DoNotOptimize(ir.get());
+  }
+  state.SetComplexityN(state.range(0));
+}
+
+// Measures function-local passes on a module with many functions sharing a
+// large global section, run on state.range(0) threads. The run on one thread
+// is the serial reference for the parallel ones.
+void BM_FunctionLocalPassesThreads(benchmark::State& state) {
+  ModuleGeneratorOptions options;
+  options.num_functions = 256;
+  options.num_types = 2048;
+  options.call_depth = 0;
+  std::vector<uint32_t> binary;
+  spvbench::GenerateModule(options, &binary, IgnoreMessage);
+
+  spvtools::Optimizer optimizer(kBenchEnv);
+  optimizer.RegisterPass(spvtools::CreateLocalSingleBlockLoadStoreElimPass())
+      .RegisterPass(spvtools::CreateLocalSingleStoreElimPass())
+      .RegisterPass(spvtools::CreateInsertExtractElimPass())
+      .RegisterPass(spvtools::CreateAggressiveDCEPass())
+      .RegisterPass(spvtools::CreateDeadBranchElimPass())
+      .RegisterPass(spvtools::CreateBlockMergePass())
+      .RegisterPass(spvtools::CreateCopyPropagationPass())
+      .RegisterPass(spvtools::CreateInstCombinePass())
+      .SetNumThreads(static_cast<uint32_t>(state.range(0)));
+  while (state.KeepRunning()) {
+    std::vector<uint32_t> optimized;
+    if (!optimizer.Run(binary.data(), binary.size(), &optimized)) {
+      state.SkipWithError("optimization failed");
+      break;
+    }
+  }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_FunctionLocalPassesThreads)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->UseRealTime()
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_DominatorsScaling)
+    ->RangeMultiplier(4)
+    ->Range(kMinScalingSize, kMaxScalingSize)
+    ->Complexity();
+BENCHMARK(BM_ValidateBlocksScaling)
+    ->RangeMultiplier(4)
+    ->Range(kMinScalingSize, kMaxScalingSize)
+    ->Complexity();
+BENCHMARK(BM_ValidateFunctionsScaling)
+    ->RangeMultiplier(4)
+    ->Range(kMinScalingSize, kMaxScalingSize)
+    ->Complexity();
+BENCHMARK(BM_BuildModuleDecorationsScaling)
+    ->RangeMultiplier(4)
+    ->Range(kMinScalingSize, kMaxScalingSize)
+    ->Complexity();
+
+int main(int argc, char** argv) {
+  // Everything registered below must outlive the run of the benchmarks.
+  static const std::vector<CorpusModule> corpus =
+      spvbench::LoadCorpus(SPIRV_BENCH_CORPUS_DIR);
+  static const std::vector<PassEntry> passes = BenchmarkedPasses();
+  if (corpus.empty()) {
+    std::cerr << "error: the benchmark corpus is empty" << std::endl;
+    return 1;
+  }
+
+  for (const CorpusModule& module : corpus) {
+    const CorpusModule* m = &module;
+    benchmark::RegisterBenchmark(("BinaryParse/" + m->name).c_str(),
+                                 BM_BinaryParse, m);
+    benchmark::RegisterBenchmark(("TextToBinary/" + m->name).c_str(),
+                                 BM_TextToBinary, m);
+    benchmark::RegisterBenchmark(("BinaryToText/" + m->name).c_str(),
+                                 BM_BinaryToText, m);
+    benchmark::RegisterBenchmark(("Validate/" + m->name).c_str(), BM_Validate,
+                                 m);
+    benchmark::RegisterBenchmark(("BuildModule/" + m->name).c_str(),
+                                 BM_BuildModule, m);
+    for (const PassEntry& entry : passes) {
+      benchmark::RegisterBenchmark(
+          ("Pass/" + std::string(entry.name) + "/" + m->name).c_str(), BM_Pass,
+          m, &entry);
+    }
+  }
+
+  // The Link benchmarks measure against the concatenation of their inputs.
+  static std::vector<CorpusModule> link_totals;
+  static std::vector<std::vector<std::vector<uint32_t>>> link_inputs;
+  link_totals.reserve(sizeof(kLinkSizes) / sizeof(kLinkSizes[0]));
+  link_inputs.reserve(sizeof(kLinkSizes) / sizeof(kLinkSizes[0]));
+  for (const auto& size : kLinkSizes) {
+    const std::string name = "library_" + std::to_string(size[0]) + "x" +
+                             std::to_string(size[1]);
+    CorpusModule total;
+    total.name = name;
+    total.num_instructions = 0;
+    std::vector<std::vector<uint32_t>> inputs;
+    for (uint32_t i = 0; i < size[0]; ++i) {
+      ModuleGeneratorOptions options;
+      options.num_functions = size[1];
+      options.library = true;
+      options.export_prefix = "m" + std::to_string(i) + "_";
+      CorpusModule library;
+      if (!spvbench::MakeCorpusModule(
+              name, spvbench::GenerateModuleText(options), &library))
+        return 1;
+      total.binary.insert(total.binary.end(), library.binary.begin(),
+                          library.binary.end());
+      total.num_instructions += library.num_instructions;
+      inputs.push_back(std::move(library.binary));
+    }
+    link_totals.push_back(std::move(total));
+    link_inputs.push_back(std::move(inputs));
+    benchmark::RegisterBenchmark(("Link/" + name).c_str(), BM_Link,
+                                 &link_totals.back(), &link_inputs.back());
+  }
+
+  benchmark::Initialize(&argc, argv);
+  benchmark::RunSpecifiedBenchmarks();
+  return 0;
+}
@@ -0,0 +1,146 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// spirv-gen writes a synthetic module of the requested size, for measuring
+// how the tools scale with their input.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "module_generator.h"
+#include "tools/io.h"
+
+namespace {
+
+void print_usage(char* argv0) {
+  printf(
+      R"(%s - Generate a synthetic SPIR-V module
+
+Usage: %s [options]
+
+The module is valid for the SPIR-V 1.2 universal environment. It is written
+to file "out.spv", unless the -o option is used.
+
+Options:
+
+  -h, --help            Print this help.
+  -o <filename>         Set the output filename. Use '-' to mean stdout.
+  --text                Write SPIR-V assembly instead of a binary.
+  --functions <N>       Number of functions besides the entry point.
+                        Defaults to 1.
+  --blocks <N>          Number of blocks in each function. Defaults to 8.
+  --depth <N>           Deepest nesting of loops and selections. Defaults to 2.
+  --insts <N>           Number of arithmetic instructions in each block.
+                        Defaults to 4.
+  --types <N>           Number of additional array and struct types.
+                        Defaults to 0.
+  --decorations <N>     Number of RelaxedPrecision decorations. Defaults to 0.
+  --call-depth <N>      Longest chain of calls between functions. Defaults
+                        to 4.
+  --library             Export the functions instead of calling them from an
+                        entry point.
+  --export-prefix <str> Prefix of the exported function names.
+  --seed <N>            Seed choosing between loops and selections.
+                        Defaults to 1.
+)",
+      argv0, argv0);
+}
+
+// Parses the numeric argument of option |argv[*argi]| into |value|,
+// advancing |*argi| over it. Returns false if it is missing or malformed.
+bool ParseCount(int argc, char** argv, int* argi, uint32_t* value) {
+  if (*argi + 1 >= argc) {
+    fprintf(stderr, "error: Missing argument to %s\n", argv[*argi]);
+    return false;
+  }
+  const char* arg = argv[++*argi];
+  char* end = nullptr;
+  const unsigned long parsed = strtoul(arg, &end, 10);
+  if (*arg == 0 || *end != 0 || parsed > UINT32_MAX) {
+    fprintf(stderr, "error: Invalid argument to %s: %s\n", argv[*argi - 1],
+            arg);
+    return false;
+  }
+  *value = static_cast<uint32_t>(parsed);
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char** argv) {
+  const char* out_file = "out.spv";
+  bool text = false;
+  spvbench::ModuleGeneratorOptions options;
+
+  for (int argi = 1; argi < argc; ++argi) {
+    const char* cur_arg = argv[argi];
+    bool ok = true;
+    if (0 == strcmp(cur_arg, "-h") || 0 == strcmp(cur_arg, "--help")) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (0 == strcmp(cur_arg, "-o") && argi + 1 < argc) {
+      out_file = argv[++argi];
+    } else if (0 == strcmp(cur_arg, "--text")) {
+      text = true;
+    } else if (0 == strcmp(cur_arg, "--functions")) {
+      ok = ParseCount(argc, argv, &argi, &options.num_functions);
+    } else if (0 == strcmp(cur_arg, "--blocks")) {
+      ok = ParseCount(argc, argv, &argi, &options.blocks_per_function);
+    } else if (0 == strcmp(cur_arg, "--depth")) {
+      ok = ParseCount(argc, argv, &argi, &options.nesting_depth);
+    } else if (0 == strcmp(cur_arg, "--insts")) {
+      ok = ParseCount(argc, argv, &argi, &options.instructions_per_block);
+    } else if (0 == strcmp(cur_arg, "--types")) {
+      ok = ParseCount(argc, argv, &argi, &options.num_types);
+    } else if (0 == strcmp(cur_arg, "--decorations")) {
+      ok = ParseCount(argc, argv, &argi, &options.num_decorations);
+    } else if (0 == strcmp(cur_arg, "--call-depth")) {
+      ok = ParseCount(argc, argv, &argi, &options.call_depth);
+    } else if (0 == strcmp(cur_arg, "--library")) {
+      options.library = true;
+    } else if (0 == strcmp(cur_arg, "--export-prefix") && argi + 1 < argc) {
+      options.export_prefix = argv[++argi];
+    } else if (0 == strcmp(cur_arg, "--seed")) {
+      ok = ParseCount(argc, argv, &argi, &options.seed);
+    } else {
+      print_usage(argv[0]);
+      return 1;
+    }
+    if (!ok) return 1;
+  }
+
+  if (text) {
+    const std::string assembly = spvbench::GenerateModuleText(options);
+    return WriteFile<char>(out_file, "w", assembly.data(), assembly.size())
+               ? 0
+               : 1;
+  }
+
+  std::vector<uint32_t> binary;
+  if (!spvbench::GenerateModule(
+          options, &binary,
+          [](spv_message_level_t, const char*, const spv_position_t& position,
+             const char* message) {
+            fprintf(stderr, "error: %zu:%zu: %s\n", position.line + 1,
+                    position.column + 1, message);
+          })) {
+    return 1;
+  }
+  return WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())
+             ? 0
+             : 1;
+}
@@ -0,0 +1,275 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "module_generator.h"
+
+#include <random>
+#include <sstream>
+
+#include "opt/build_module.h"
+
+namespace spvbench {
+
+namespace {
+
+// The target environment of the generated modules.
+const spv_target_env kGeneratorEnv = SPV_ENV_UNIVERSAL_1_2;
+
+// Writes the definition of one function of a synthetic module. The function
+// keeps a float accumulator in Function storage, which the arithmetic of
+// every block loads, updates and stores back, and which selections test.
+class FunctionBuilder {
+ public:
+  FunctionBuilder(const ModuleGeneratorOptions& options, uint32_t index,
+                  std::vector<std::string>* decoratable)
+      : options_(options),
+        index_(index),
+        prefix_("%f" + std::to_string(index) + "_"),
+        rng_(options.seed + index),
+        decoratable_(decoratable),
+        num_blocks_(0),
+        next_id_(0) {}
+
+  // Returns the text of the function.
+  std::string Build();
+
+ private:
+  // Returns a new id of the function, named after |hint|.
+  std::string NewId(const char* hint) {
+    return prefix_ + hint + std::to_string(next_id_++);
+  }
+
+  // Starts the block labelled |label|.
+  void StartBlock(const std::string& label) {
+    body_ << label << " = OpLabel\n";
+    ++num_blocks_;
+  }
+
+  bool HasBlocksLeft() const {
+    return num_blocks_ < options_.blocks_per_function;
+  }
+
+  // Writes the arithmetic of a block.
+  void EmitWork();
+
+  // Writes the body of a construct at nesting |depth|, ending in an open
+  // block.
+  void EmitRegion(uint32_t depth);
+
+  // Writes a loop or a selection at nesting |depth|, ending in its merge
+  // block.
+  void EmitConstruct(uint32_t depth);
+  void EmitSelection(uint32_t depth);
+  void EmitLoop(uint32_t depth);
+
+  const ModuleGeneratorOptions& options_;
+  const uint32_t index_;
+  const std::string prefix_;
+  std::mt19937 rng_;
+  std::vector<std::string>* decoratable_;
+  uint32_t num_blocks_;
+  uint32_t next_id_;
+  // The variables, which must all be at the start of the entry block.
+  std::ostringstream vars_;
+  // The blocks, after the variables.
+  std::ostringstream body_;
+};
+
+std::string FunctionBuilder::Build() {
+  const std::string acc = prefix_ + "acc";
+  vars_ << acc << " = OpVariable %ptr_Function_float Function\n";
+  decoratable_->push_back(acc);
+  body_ << "OpStore " << acc << " " << prefix_ << "x\n";
+  ++num_blocks_;  // The entry block.
+  EmitWork();
+  while (options_.nesting_depth > 0 && HasBlocksLeft()) EmitConstruct(0);
+
+  std::string result = NewId("r");
+  body_ << result << " = OpLoad %float " << acc << "\n";
+  if (options_.call_depth > 1 && index_ % options_.call_depth != 0) {
+    const std::string call = NewId("call");
+    body_ << call << " = OpFunctionCall %float %f" << index_ - 1 << " "
+          << result << "\n";
+    result = call;
+  }
+  body_ << "OpReturnValue " << result << "\n";
+
+  std::ostringstream out;
+  out << "%f" << index_ << " = OpFunction %float None %float_fn\n"
+      << prefix_ << "x = OpFunctionParameter %float\n"
+      << prefix_ << "entry = OpLabel\n"
+      << vars_.str() << body_.str() << "OpFunctionEnd\n";
+  return out.str();
+}
+
+void FunctionBuilder::EmitWork() {
+  if (options_.instructions_per_block == 0) return;
+  std::string value = NewId("a");
+  body_ << value << " = OpLoad %float " << prefix_ << "acc\n";
+  for (uint32_t i = 0; i < options_.instructions_per_block; ++i) {
+    const std::string next = NewId("t");
+    body_ << next << (i % 2 ? " = OpFMul %float " : " = OpFAdd %float ")
+          << value << (i % 2 ? " %float_2\n" : " %float_1\n");
+    decoratable_->push_back(next);
+    value = next;
+  }
+  body_ << "OpStore " << prefix_ << "acc " << value << "\n";
+}
+
+void FunctionBuilder::EmitRegion(uint32_t depth) {
+  EmitWork();
+  if (depth < options_.nesting_depth && HasBlocksLeft()) EmitConstruct(depth);
+}
+
+void FunctionBuilder::EmitConstruct(uint32_t depth) {
+  if (rng_() % 2)
+    EmitLoop(depth);
+  else
+    EmitSelection(depth);
+}
+
+void FunctionBuilder::EmitSelection(uint32_t depth) {
+  const std::string value = NewId("sv");
+  const std::string cond = NewId("sc");
+  const std::string then_label = NewId("then");
+  const std::string else_label = NewId("else");
+  const std::string merge = NewId("smerge");
+  body_ << value << " = OpLoad %float " << prefix_ << "acc\n"
+        << cond << " = OpFOrdGreaterThan %bool " << value << " %float_1\n"
+        << "OpSelectionMerge " << merge << " None\n"
+        << "OpBranchConditional " << cond << " " << then_label << " "
+        << else_label << "\n";
+  StartBlock(then_label);
+  EmitRegion(depth + 1);
+  body_ << "OpBranch " << merge << "\n";
+  StartBlock(else_label);
+  EmitRegion(depth + 1);
+  body_ << "OpBranch " << merge << "\n";
+  StartBlock(merge);
+}
+
+void FunctionBuilder::EmitLoop(uint32_t depth) {
+  const std::string counter = NewId("i");
+  const std::string header = NewId("header");
+  const std::string body = NewId("body");
+  const std::string cont = NewId("continue");
+  const std::string merge = NewId("lmerge");
+  const std::string iv = NewId("iv");
+  const std::string cond = NewId("lc");
+  const std::string iv2 = NewId("iv");
+  const std::string next = NewId("inext");
+  vars_ << counter << " = OpVariable %ptr_Function_int Function\n";
+  body_ << "OpStore " << counter << " %int_0\n"
+        << "OpBranch " << header << "\n";
+  StartBlock(header);
+  body_ << iv << " = OpLoad %int " << counter << "\n"
+        << cond << " = OpSLessThan %bool " << iv << " %int_4\n"
+        << "OpLoopMerge " << merge << " " << cont << " None\n"
+        << "OpBranchConditional " << cond << " " << body << " " << merge
+        << "\n";
+  StartBlock(body);
+  EmitRegion(depth + 1);
+  body_ << "OpBranch " << cont << "\n";
+  StartBlock(cont);
+  body_ << iv2 << " = OpLoad %int " << counter << "\n"
+        << next << " = OpIAdd %int " << iv2 << " %int_1\n"
+        << "OpStore " << counter << " " << next << "\n"
+        << "OpBranch " << header << "\n";
+  StartBlock(merge);
+}
+
+}  // anonymous namespace
+
+std::string GenerateModuleText(const ModuleGeneratorOptions& options) {
+  // The functions come first, as they determine what can be decorated.
+  std::vector<std::string> decoratable;
+  std::ostringstream functions;
+  for (uint32_t i = 0; i < options.num_functions; ++i) {
+    functions << FunctionBuilder(options, i, &decoratable).Build();
+  }
+
+  std::ostringstream out;
+  out << "OpCapability Shader\n";
+  if (options.library) out << "OpCapability Linkage\n";
+  out << "OpMemoryModel Logical GLSL450\n";
+  if (!options.library) {
+    out << "OpEntryPoint GLCompute %main \"main\"\n"
+        << "OpExecutionMode %main LocalSize 1 1 1\n";
+  }
+
+  if (options.library) {
+    for (uint32_t i = 0; i < options.num_functions; ++i) {
+      out << "OpDecorate %f" << i << " LinkageAttributes \""
+          << options.export_prefix << "f" << i << "\" Export\n";
+    }
+  }
+  for (uint32_t i = 0; i < options.num_decorations && !decoratable.empty();
+       ++i) {
+    out << "OpDecorate " << decoratable[i % decoratable.size()]
+        << " RelaxedPrecision\n";
+  }
+
+  out << "%void = OpTypeVoid\n"
+      << "%void_fn = OpTypeFunction %void\n"
+      << "%float = OpTypeFloat 32\n"
+      << "%int = OpTypeInt 32 1\n"
+      << "%uint = OpTypeInt 32 0\n"
+      << "%bool = OpTypeBool\n"
+      << "%float_fn = OpTypeFunction %float %float\n"
+      << "%ptr_Function_float = OpTypePointer Function %float\n"
+      << "%ptr_Function_int = OpTypePointer Function %int\n"
+      << "%ptr_Private_float = OpTypePointer Private %float\n"
+      << "%float_1 = OpConstant %float 1\n"
+      << "%float_2 = OpConstant %float 2\n"
+      << "%int_0 = OpConstant %int 0\n"
+      << "%int_1 = OpConstant %int 1\n"
+      << "%int_4 = OpConstant %int 4\n";
+  for (uint32_t i = 0; i < options.num_types; ++i) {
+    out << "%len_" << i << " = OpConstant %uint " << i + 1 << "\n"
+        << "%array_" << i << " = OpTypeArray %float %len_" << i << "\n"
+        << "%struct_" << i << " = OpTypeStruct %array_" << i << " %int\n";
+  }
+  out << "%result = OpVariable %ptr_Private_float Private\n";
+
+  if (!options.library) {
+    out << "%main = OpFunction %void None %void_fn\n"
+        << "%main_entry = OpLabel\n";
+    for (uint32_t i = 0; i < options.num_functions; ++i) {
+      out << "%main_r" << i << " = OpFunctionCall %float %f" << i
+          << " %float_1\n"
+          << "OpStore %result %main_r" << i << "\n";
+    }
+    out << "OpReturn\n"
+        << "OpFunctionEnd\n";
+  }
+  out << functions.str();
+  return out.str();
+}
+
+bool GenerateModule(const ModuleGeneratorOptions& options,
+                    std::vector<uint32_t>* binary,
+                    spvtools::MessageConsumer consumer) {
+  spvtools::SpirvTools tools(kGeneratorEnv);
+  tools.SetMessageConsumer(std::move(consumer));
+  binary->clear();
+  return tools.Assemble(GenerateModuleText(options), binary);
+}
+
+std::unique_ptr<spvtools::ir::Module> GenerateIRModule(
+    const ModuleGeneratorOptions& options, spvtools::MessageConsumer consumer) {
+  return spvtools::BuildModule(kGeneratorEnv, std::move(consumer),
+                               GenerateModuleText(options));
+}
+
+}  // namespace spvbench
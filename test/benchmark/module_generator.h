@@ -0,0 +1,76 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_TEST_BENCHMARK_MODULE_GENERATOR_H_
+#define LIBSPIRV_TEST_BENCHMARK_MODULE_GENERATOR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "opt/module.h"
+#include "spirv-tools/libspirv.hpp"
+
+namespace spvbench {
+
+// Parameters of a synthetic module. Every combination of values produces a
+// valid module for the Universal 1.2 environment.
+struct ModuleGeneratorOptions {
+  // The number of functions besides the entry point.
+  uint32_t num_functions = 1;
+  // The number of blocks in each function. The last control construct of a
+  // function may take it over this number by a few blocks.
+  uint32_t blocks_per_function = 8;
+  // The deepest nesting of loops and selections. At 0 every function is a
+  // single block.
+  uint32_t nesting_depth = 2;
+  // The number of arithmetic instructions, and so of result ids, in each
+  // block besides those implementing control flow.
+  uint32_t instructions_per_block = 4;
+  // The number of array types, and of struct types wrapping them, declared
+  // on top of the ones the functions need.
+  uint32_t num_types = 0;
+  // The number of RelaxedPrecision decorations. They are spread over the
+  // arithmetic results, and repeat when there are more decorations than
+  // results.
+  uint32_t num_decorations = 0;
+  // The longest chain of calls between functions. At 0 or 1 functions call
+  // no other function.
+  uint32_t call_depth = 4;
+  // If true, the module has the Linkage capability and no entry point, and
+  // each function is exported under a name starting with |export_prefix|.
+  bool library = false;
+  std::string export_prefix;
+  // The seed choosing between loops and selections.
+  uint32_t seed = 1;
+};
+
+// Returns the assembly of the module described by |options|.
+std::string GenerateModuleText(const ModuleGeneratorOptions& options);
+
+// Assembles the module described by |options| into |binary|. Returns false
+// and sends the diagnostic to |consumer| on failure.
+bool GenerateModule(const ModuleGeneratorOptions& options,
+                    std::vector<uint32_t>* binary,
+                    spvtools::MessageConsumer consumer);
+
+// Returns the in-memory representation of the module described by
+// |options|, or nullptr after sending the diagnostic to |consumer|.
+std::unique_ptr<spvtools::ir::Module> GenerateIRModule(
+    const ModuleGeneratorOptions& options, spvtools::MessageConsumer consumer);
+
+}  // namespace spvbench
+
+#endif  // LIBSPIRV_TEST_BENCHMARK_MODULE_GENERATOR_H_
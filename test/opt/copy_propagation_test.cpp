@@ -0,0 +1,212 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using CopyPropagationTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+%void = OpTypeVoid
+%5 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_4 = OpConstant %int 4
+)";
+
+TEST_F(CopyPropagationTest, PropagateChainOfCopies) {
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+%18 = OpCopyObject %float %17
+%19 = OpCopyObject %float %18
+%20 = OpFAdd %float %19 %float_1
+OpStore %out %20
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+%20 = OpFAdd %float %17 %float_1
+OpStore %out %20
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::CopyPropagationPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(CopyPropagationTest, RemovePhiOfSameValue) {
+  // The phi takes a copy of x and x itself.
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+%18 = OpFOrdLessThan %bool %17 %float_0
+OpSelectionMerge %19 None
+OpBranchConditional %18 %20 %21
+%20 = OpLabel
+%22 = OpCopyObject %float %17
+OpBranch %19
+%21 = OpLabel
+OpBranch %19
+%19 = OpLabel
+%23 = OpPhi %float %22 %20 %17 %21
+OpStore %out %23
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+%18 = OpFOrdLessThan %bool %17 %float_0
+OpSelectionMerge %19 None
+OpBranchConditional %18 %20 %21
+%20 = OpLabel
+OpBranch %19
+%21 = OpLabel
+OpBranch %19
+%19 = OpLabel
+OpStore %out %17
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::CopyPropagationPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(CopyPropagationTest, RemovePhiCycle) {
+  // float v = in;
+  // for (int i = 0; i < 4; ++i)
+  //   if (v < 0.0) {}
+  // out = v;
+  //
+  // The loop header phi and the phi of the selection merge block only take
+  // values from each other and the value of in.
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+OpBranch %18
+%18 = OpLabel
+%19 = OpPhi %float %17 %16 %20 %21
+%22 = OpPhi %int %int_0 %16 %23 %21
+%24 = OpSLessThan %bool %22 %int_4
+OpLoopMerge %25 %21 None
+OpBranchConditional %24 %26 %25
+%26 = OpLabel
+%27 = OpFOrdLessThan %bool %19 %float_0
+OpSelectionMerge %28 None
+OpBranchConditional %27 %29 %28
+%29 = OpLabel
+OpBranch %28
+%28 = OpLabel
+%20 = OpPhi %float %19 %26 %19 %29
+OpBranch %21
+%21 = OpLabel
+%23 = OpIAdd %int %22 %int_1
+OpBranch %18
+%25 = OpLabel
+OpStore %out %19
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+OpBranch %18
+%18 = OpLabel
+%22 = OpPhi %int %int_0 %16 %23 %21
+%24 = OpSLessThan %bool %22 %int_4
+OpLoopMerge %25 %21 None
+OpBranchConditional %24 %26 %25
+%26 = OpLabel
+%27 = OpFOrdLessThan %bool %17 %float_0
+OpSelectionMerge %28 None
+OpBranchConditional %27 %29 %28
+%29 = OpLabel
+OpBranch %28
+%28 = OpLabel
+OpBranch %21
+%21 = OpLabel
+%23 = OpIAdd %int %22 %int_1
+OpBranch %18
+%25 = OpLabel
+OpStore %out %17
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::CopyPropagationPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(CopyPropagationTest, KeepPhiOfDifferentValues) {
+  // The value is changed by the loop.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %float %in
+OpBranch %18
+%18 = OpLabel
+%19 = OpPhi %float %17 %16 %20 %21
+%22 = OpPhi %int %int_0 %16 %23 %21
+%24 = OpSLessThan %bool %22 %int_4
+OpLoopMerge %25 %21 None
+OpBranchConditional %24 %21 %25
+%21 = OpLabel
+%20 = OpFAdd %float %19 %float_1
+%23 = OpIAdd %int %22 %int_1
+OpBranch %18
+%25 = OpLabel
+OpStore %out %19
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::CopyPropagationPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true);
+}
+
+}  // anonymous namespace
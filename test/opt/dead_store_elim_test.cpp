@@ -0,0 +1,247 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using DeadStoreElimTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %p "p"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+%_struct_10 = OpTypeStruct %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Function__struct_10 = OpTypePointer Function %_struct_10
+%_ptr_Private_float = OpTypePointer Private %float
+%p = OpVariable %_ptr_Private_float Private
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%float_3 = OpConstant %float 3
+)";
+
+TEST_F(DeadStoreElimTest, RemoveStoreOverwrittenOnAllPaths) {
+  // float v = 1.0;
+  // if (in < 0.0) v = 2.0; else v = 3.0;
+  // out = v;
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function_float Function
+OpStore %23 %float_1
+%24 = OpLoad %float %in
+%25 = OpFOrdLessThan %bool %24 %float_0
+OpSelectionMerge %26 None
+OpBranchConditional %25 %27 %28
+%27 = OpLabel
+OpStore %23 %float_2
+OpBranch %26
+%28 = OpLabel
+OpStore %23 %float_3
+OpBranch %26
+%26 = OpLabel
+%29 = OpLoad %float %23
+OpStore %out %29
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function_float Function
+%24 = OpLoad %float %in
+%25 = OpFOrdLessThan %bool %24 %float_0
+OpSelectionMerge %26 None
+OpBranchConditional %25 %27 %28
+%27 = OpLabel
+OpStore %23 %float_2
+OpBranch %26
+%28 = OpLabel
+OpStore %23 %float_3
+OpBranch %26
+%26 = OpLabel
+%29 = OpLoad %float %23
+OpStore %out %29
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::DeadStoreElimPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(DeadStoreElimTest, KeepStoreReadOnSomePath) {
+  // float v = 1.0;
+  // if (in < 0.0) v = 2.0;
+  // out = v;
+  const std::string assembly =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function_float Function
+OpStore %23 %float_1
+%24 = OpLoad %float %in
+%25 = OpFOrdLessThan %bool %24 %float_0
+OpSelectionMerge %26 None
+OpBranchConditional %25 %27 %26
+%27 = OpLabel
+OpStore %23 %float_2
+OpBranch %26
+%26 = OpLabel
+%28 = OpLoad %float %23
+OpStore %out %28
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::DeadStoreElimPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true);
+}
+
+TEST_F(DeadStoreElimTest, RemovePartialStoresOverwritten) {
+  // s.x = in; s.y = 1.0;
+  // s = S(2.0, in);
+  // s.y = 3.0;
+  // out = s.x;
+  //
+  // The partial stores are overwritten by the store of the whole struct, and
+  // the last store is never read.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function__struct_10 Function
+%24 = OpLoad %float %in
+%25 = OpAccessChain %_ptr_Function_float %23 %int_0
+OpStore %25 %24
+%26 = OpAccessChain %_ptr_Function_float %23 %int_1
+OpStore %26 %float_1
+%27 = OpCompositeConstruct %_struct_10 %float_2 %24
+OpStore %23 %27
+%28 = OpAccessChain %_ptr_Function_float %23 %int_1
+OpStore %28 %float_3
+%29 = OpAccessChain %_ptr_Function_float %23 %int_0
+%30 = OpLoad %float %29
+OpStore %out %30
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function__struct_10 Function
+%24 = OpLoad %float %in
+%27 = OpCompositeConstruct %_struct_10 %float_2 %24
+OpStore %23 %27
+%29 = OpAccessChain %_ptr_Function_float %23 %int_0
+%30 = OpLoad %float %29
+OpStore %out %30
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::DeadStoreElimPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(DeadStoreElimTest, RemoveUnreadVariable) {
+  // The only store to s is never read, so s is removed with it.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%23 = OpVariable %_ptr_Function__struct_10 Function
+%24 = OpLoad %float %in
+%25 = OpAccessChain %_ptr_Function_float %23 %int_0
+OpStore %25 %24
+OpStore %out %24
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+%24 = OpLoad %float %in
+OpStore %out %24
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::DeadStoreElimPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(DeadStoreElimTest, PrivateVariables) {
+  // A private variable may be read by a called function, and is dead once
+  // the entry point returns.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+OpStore %p %float_1
+OpStore %p %float_2
+%23 = OpFunctionCall %void %24
+OpStore %p %float_3
+OpReturn
+OpFunctionEnd
+%24 = OpFunction %void None %6
+%25 = OpLabel
+%26 = OpLoad %float %p
+OpStore %out %26
+OpStore %p %float_0
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%22 = OpLabel
+OpStore %p %float_2
+%23 = OpFunctionCall %void %24
+OpReturn
+OpFunctionEnd
+%24 = OpFunction %void None %6
+%25 = OpLabel
+%26 = OpLoad %float %p
+OpStore %out %26
+OpStore %p %float_0
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::DeadStoreElimPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+}  // anonymous namespace
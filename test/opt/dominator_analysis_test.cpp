@@ -0,0 +1,190 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "opt/build_module.h"
+#include "opt/dominator_analysis.h"
+#include "opt/ir_context.h"
+
+namespace {
+
+using spvtools::ir::BasicBlock;
+using spvtools::ir::IRContext;
+using spvtools::opt::DominatorAnalysis;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// A selection followed by a loop, with one unreachable block. Edges:
+//   1 -> 2, 3    selection
+//   2, 3 -> 4    merge
+//   4 -> 5       loop header
+//   5 -> 6, 7    6 is the continue target, 7 the merge block
+//   6 -> 5       back edge
+//   8 -> 7       8 is unreachable
+const char kShader[] = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+          %9 = OpTypeFunction %void
+       %bool = OpTypeBool
+       %true = OpConstantTrue %bool
+       %main = OpFunction %void None %9
+          %1 = OpLabel
+               OpSelectionMerge %4 None
+               OpBranchConditional %true %2 %3
+          %2 = OpLabel
+               OpBranch %4
+          %3 = OpLabel
+               OpBranch %4
+          %4 = OpLabel
+               OpBranch %5
+          %5 = OpLabel
+               OpLoopMerge %7 %6 None
+               OpBranchConditional %true %6 %7
+          %6 = OpLabel
+               OpBranch %5
+          %7 = OpLabel
+               OpReturn
+          %8 = OpLabel
+               OpBranch %7
+               OpFunctionEnd
+)";
+
+class DominatorAnalysisTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    context_.reset(new IRContext(spvtools::BuildModule(
+        SPV_ENV_UNIVERSAL_1_1, nullptr, kShader,
+        SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS)));
+    ASSERT_NE(nullptr, context_->module());
+    function_ = &*context_->module()->begin();
+    for (auto& blk : *function_) blocks_.push_back(&blk);
+  }
+
+  // Returns the block with label |id|.
+  BasicBlock* Block(uint32_t id) const {
+    for (auto blk : blocks_)
+      if (blk->id() == id) return blk;
+    return nullptr;
+  }
+
+  // Returns the labels of |blocks|.
+  static std::vector<uint32_t> Ids(const std::vector<BasicBlock*>& blocks) {
+    std::vector<uint32_t> ids;
+    for (auto blk : blocks) ids.push_back(blk->id());
+    return ids;
+  }
+
+  std::unique_ptr<IRContext> context_;
+  spvtools::ir::Function* function_ = nullptr;
+  std::vector<BasicBlock*> blocks_;
+};
+
+TEST_F(DominatorAnalysisTest, ImmediateDominators) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  EXPECT_FALSE(dom->IsPostDominator());
+  EXPECT_EQ(nullptr, dom->ImmediateDominator(1));
+  EXPECT_EQ(Block(1), dom->ImmediateDominator(2));
+  EXPECT_EQ(Block(1), dom->ImmediateDominator(3));
+  EXPECT_EQ(Block(1), dom->ImmediateDominator(4));
+  EXPECT_EQ(Block(4), dom->ImmediateDominator(5));
+  EXPECT_EQ(Block(5), dom->ImmediateDominator(6));
+  EXPECT_EQ(Block(5), dom->ImmediateDominator(7));
+  EXPECT_EQ(nullptr, dom->ImmediateDominator(8));
+  EXPECT_THAT(Ids(dom->Children(Block(1))), ElementsAre(2, 3, 4));
+  EXPECT_THAT(Ids(dom->Children(Block(5))), ElementsAre(6, 7));
+}
+
+TEST_F(DominatorAnalysisTest, Dominates) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  for (uint32_t id = 1; id <= 7; ++id) {
+    EXPECT_TRUE(dom->Dominates(1, id)) << id;
+    EXPECT_TRUE(dom->Dominates(id, id)) << id;
+    EXPECT_FALSE(dom->StrictlyDominates(id, id)) << id;
+  }
+  EXPECT_TRUE(dom->StrictlyDominates(Block(4), Block(6)));
+  EXPECT_TRUE(dom->Dominates(5, 7));
+  EXPECT_FALSE(dom->Dominates(2, 4));
+  EXPECT_FALSE(dom->Dominates(6, 7));
+  EXPECT_FALSE(dom->Dominates(7, 5));
+  // The unreachable block has no node.
+  EXPECT_FALSE(dom->Dominates(1, 8));
+  EXPECT_FALSE(dom->Dominates(8, 8));
+  EXPECT_FALSE(dom->Dominates(1, 100));
+}
+
+TEST_F(DominatorAnalysisTest, Preorder) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  EXPECT_THAT(Ids(dom->Preorder()), ElementsAre(1, 2, 3, 4, 5, 6, 7));
+}
+
+TEST_F(DominatorAnalysisTest, DominanceFrontiers) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(1))), IsEmpty());
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(2))), ElementsAre(4));
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(3))), ElementsAre(4));
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(4))), IsEmpty());
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(5))), ElementsAre(5));
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(6))), ElementsAre(5));
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(7))), IsEmpty());
+  EXPECT_THAT(Ids(dom->DominanceFrontier(Block(8))), IsEmpty());
+}
+
+TEST_F(DominatorAnalysisTest, IteratedDominanceFrontier) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  std::vector<BasicBlock*> idf;
+  dom->IteratedDominanceFrontier({Block(2), Block(6)}, &idf);
+  EXPECT_THAT(Ids(idf), ElementsAre(4, 5));
+  dom->IteratedDominanceFrontier({Block(1)}, &idf);
+  EXPECT_THAT(Ids(idf), IsEmpty());
+}
+
+TEST_F(DominatorAnalysisTest, PostDominators) {
+  DominatorAnalysis* pdom = context_->GetPostDominatorAnalysis(function_);
+  EXPECT_TRUE(pdom->IsPostDominator());
+  EXPECT_EQ(Block(4), pdom->ImmediateDominator(1));
+  EXPECT_EQ(Block(4), pdom->ImmediateDominator(2));
+  EXPECT_EQ(Block(5), pdom->ImmediateDominator(4));
+  EXPECT_EQ(Block(5), pdom->ImmediateDominator(6));
+  EXPECT_EQ(Block(7), pdom->ImmediateDominator(5));
+  EXPECT_EQ(Block(7), pdom->ImmediateDominator(8));
+  EXPECT_EQ(nullptr, pdom->ImmediateDominator(7));
+  EXPECT_TRUE(pdom->Dominates(7, 1));
+  EXPECT_TRUE(pdom->Dominates(7, 8));
+  EXPECT_FALSE(pdom->Dominates(2, 1));
+  // Control dependence: 2 and 3 depend on the branch in 1; 6 and 5 on the
+  // loop's branch in 5.
+  EXPECT_THAT(Ids(pdom->DominanceFrontier(Block(2))), ElementsAre(1));
+  EXPECT_THAT(Ids(pdom->DominanceFrontier(Block(6))), ElementsAre(5));
+  EXPECT_THAT(Ids(pdom->DominanceFrontier(Block(5))), ElementsAre(5));
+  EXPECT_THAT(Ids(pdom->DominanceFrontier(Block(4))), IsEmpty());
+}
+
+TEST_F(DominatorAnalysisTest, ContextCachesUntilInvalidated) {
+  DominatorAnalysis* dom = context_->GetDominatorAnalysis(function_);
+  EXPECT_EQ(dom, context_->GetDominatorAnalysis(function_));
+  EXPECT_NE(dom, context_->GetPostDominatorAnalysis(function_));
+  context_->InvalidateDominatorAnalyses();
+  dom = context_->GetDominatorAnalysis(function_);
+  EXPECT_TRUE(dom->Dominates(1, 7));
+}
+
+}  // anonymous namespace
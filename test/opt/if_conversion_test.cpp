@@ -0,0 +1,319 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using IfConversionTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out %vout
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %vout "vout"
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%vout = OpVariable %_ptr_Output_v4float Output
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%float_3 = OpConstant %float 3
+%18 = OpConstantComposite %v4float %float_1 %float_1 %float_1 %float_1
+)";
+
+TEST_F(IfConversionTest, ConvertIfElse) {
+  // float r;
+  // if (in < 0.0) r = in * 2.0; else r = sqrt(in + 1.0);
+  // out = r;
+  const std::string before =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+OpSelectionMerge %22 None
+OpBranchConditional %21 %23 %24
+%23 = OpLabel
+%25 = OpFMul %float %20 %float_2
+OpBranch %22
+%24 = OpLabel
+%26 = OpFAdd %float %20 %float_1
+%27 = OpExtInst %float %1 Sqrt %26
+OpBranch %22
+%22 = OpLabel
+%28 = OpPhi %float %25 %23 %27 %24
+OpStore %out %28
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+%25 = OpFMul %float %20 %float_2
+%26 = OpFAdd %float %20 %float_1
+%27 = OpExtInst %float %1 Sqrt %26
+%29 = OpSelect %float %21 %25 %27
+OpStore %out %29
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(
+      kPredefs + before, kPredefs + after, true, true, 8u);
+}
+
+TEST_F(IfConversionTest, ConvertIfWithVectorValue) {
+  // vec4 v = vec4(in);
+  // if (in < 0.0) v = v + vec4(1.0);
+  // vout = v;
+  //
+  // The condition is turned into a vector of booleans, whose type is added.
+  const std::string before =
+      R"(OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out %vout
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %vout "vout"
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%vout = OpVariable %_ptr_Output_v4float Output
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%float_3 = OpConstant %float 3
+%18 = OpConstantComposite %v4float %float_1 %float_1 %float_1 %float_1
+%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpCompositeConstruct %v4float %20 %20 %20 %20
+%22 = OpFOrdLessThan %bool %20 %float_0
+OpSelectionMerge %23 None
+OpBranchConditional %22 %24 %23
+%24 = OpLabel
+%25 = OpFAdd %v4float %21 %18
+OpBranch %23
+%23 = OpLabel
+%26 = OpPhi %v4float %25 %24 %21 %19
+OpStore %vout %26
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(OpCapability Shader
+%1 = OpExtInstImport "GLSL.std.450"
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out %vout
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %out "out"
+OpName %vout "vout"
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%v4float = OpTypeVector %float 4
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%_ptr_Output_v4float = OpTypePointer Output %v4float
+%vout = OpVariable %_ptr_Output_v4float Output
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%float_3 = OpConstant %float 3
+%18 = OpConstantComposite %v4float %float_1 %float_1 %float_1 %float_1
+%v4bool = OpTypeVector %bool 4
+%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpCompositeConstruct %v4float %20 %20 %20 %20
+%22 = OpFOrdLessThan %bool %20 %float_0
+%25 = OpFAdd %v4float %21 %18
+%27 = OpCompositeConstruct %v4bool %22 %22 %22 %22
+%29 = OpSelect %v4float %27 %25 %21
+OpStore %vout %29
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(before, after, true, true, 8u);
+}
+
+TEST_F(IfConversionTest, ConvertNestedSelections) {
+  // float r;
+  // if (in < 0.0) r = in < 1.0 ? 1.0 : 2.0; else r = 3.0;
+  // out = r;
+  //
+  // Once the inner selection is converted and its merge block merged into
+  // the arm, the outer selection is converted too.
+  const std::string before =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+OpSelectionMerge %22 None
+OpBranchConditional %21 %23 %24
+%23 = OpLabel
+%25 = OpFOrdLessThan %bool %20 %float_1
+OpSelectionMerge %26 None
+OpBranchConditional %25 %27 %28
+%27 = OpLabel
+OpBranch %26
+%28 = OpLabel
+OpBranch %26
+%26 = OpLabel
+%29 = OpPhi %float %float_1 %27 %float_2 %28
+OpBranch %22
+%24 = OpLabel
+OpBranch %22
+%22 = OpLabel
+%30 = OpPhi %float %29 %26 %float_3 %24
+OpStore %out %30
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+%25 = OpFOrdLessThan %bool %20 %float_1
+%31 = OpSelect %float %25 %float_1 %float_2
+%32 = OpSelect %float %21 %31 %float_3
+OpStore %out %32
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(
+      kPredefs + before, kPredefs + after, true, true, 8u);
+}
+
+TEST_F(IfConversionTest, KeepArmWithSideEffect) {
+  const std::string assembly =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+OpSelectionMerge %22 None
+OpBranchConditional %21 %23 %22
+%23 = OpLabel
+OpStore %out %20
+OpBranch %22
+%22 = OpLabel
+%24 = OpPhi %float %20 %23 %float_0 %19
+OpStore %out %24
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 8u);
+}
+
+TEST_F(IfConversionTest, KeepArmsOverSizeLimit) {
+  // The arms have three instructions.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %float %in
+%21 = OpFOrdLessThan %bool %20 %float_0
+OpSelectionMerge %22 None
+OpBranchConditional %21 %23 %24
+%23 = OpLabel
+%25 = OpFMul %float %20 %float_2
+OpBranch %22
+%24 = OpLabel
+%26 = OpFAdd %float %20 %float_1
+%27 = OpExtInst %float %1 Sqrt %26
+OpBranch %22
+%22 = OpLabel
+%28 = OpPhi %float %25 %23 %27 %24
+OpStore %out %28
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 2u);
+}
+
+TEST_F(IfConversionTest, KeepGuardedIntegerDivision) {
+  // int d = int(in);
+  // int r;
+  // if (d != 0) r = 100 / d; else r = 0;
+  // out = float(r);
+  // The division is undefined when the arm is not taken.
+  const std::string assembly =
+      R"(%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_100 = OpConstant %int 100
+%main = OpFunction %void None %7
+%22 = OpLabel
+%23 = OpLoad %float %in
+%24 = OpConvertFToS %int %23
+%25 = OpINotEqual %bool %24 %int_0
+OpSelectionMerge %26 None
+OpBranchConditional %25 %27 %26
+%27 = OpLabel
+%28 = OpSDiv %int %int_100 %24
+OpBranch %26
+%26 = OpLabel
+%29 = OpPhi %int %28 %27 %int_0 %22
+%30 = OpConvertSToF %float %29
+OpStore %out %30
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::IfConversionPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 8u);
+}
+
+}  // anonymous namespace
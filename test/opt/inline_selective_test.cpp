@@ -0,0 +1,372 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using InlineSelectiveTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %in "in"
+OpName %out "out"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%8 = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+)";
+
+TEST_F(InlineSelectiveTest, InlineSmallFunction) {
+  // A callee no larger than the call is inlined at each call site, without
+  // using the budget.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+%16 = OpFunctionCall %float %f %15
+OpStore %out %16
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+OpReturnValue %19
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %6
+%13 = OpLabel
+%23 = OpVariable %_ptr_Function_float Function
+%21 = OpVariable %_ptr_Function_float Function
+%14 = OpLoad %float %in
+%22 = OpFAdd %float %14 %float_1
+OpStore %21 %22
+%15 = OpLoad %float %21
+%24 = OpFAdd %float %15 %float_1
+OpStore %23 %24
+%16 = OpLoad %float %23
+OpStore %out %16
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+OpReturnValue %19
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + before, kPredefs + after, true, true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, KeepLargeFunctionOutOfBudget) {
+  // Inlining a callee of 6 instructions called twice grows the module, and
+  // there is no budget for it.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+%16 = OpFunctionCall %float %f %15
+OpStore %out %16
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+%20 = OpFMul %float %19 %19
+%21 = OpFSub %float %20 %17
+%22 = OpFMul %float %21 %float_2
+%23 = OpFAdd %float %22 %19
+OpReturnValue %23
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, InlineLargeFunctionWithinBudget) {
+  // The module has 11 instructions, so the budget of 100% allows inlining
+  // the first call, which grows the module by 4 instructions. The second call
+  // is then the only call of the function, which becomes dead.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+%16 = OpFunctionCall %float %f %15
+OpStore %out %16
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+%20 = OpFMul %float %19 %19
+%21 = OpFSub %float %20 %17
+%22 = OpFMul %float %21 %float_2
+%23 = OpFAdd %float %22 %19
+OpReturnValue %23
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %6
+%13 = OpLabel
+%31 = OpVariable %_ptr_Function_float Function
+%25 = OpVariable %_ptr_Function_float Function
+%14 = OpLoad %float %in
+%26 = OpFAdd %float %14 %float_1
+%27 = OpFMul %float %26 %26
+%28 = OpFSub %float %27 %14
+%29 = OpFMul %float %28 %float_2
+%30 = OpFAdd %float %29 %26
+OpStore %25 %30
+%15 = OpLoad %float %25
+%32 = OpFAdd %float %15 %float_1
+%33 = OpFMul %float %32 %32
+%34 = OpFSub %float %33 %15
+%35 = OpFMul %float %34 %float_2
+%36 = OpFAdd %float %35 %32
+OpStore %31 %36
+%16 = OpLoad %float %31
+OpStore %out %16
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+%20 = OpFMul %float %19 %19
+%21 = OpFSub %float %20 %17
+%22 = OpFMul %float %21 %float_2
+%23 = OpFAdd %float %22 %19
+OpReturnValue %23
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + before, kPredefs + after, true, true, 100u);
+}
+
+TEST_F(InlineSelectiveTest, InlineSingleCallSite) {
+  // The only call of a function is inlined regardless of the budget. The
+  // function is left for dead function elimination.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+OpStore %out %15
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%16 = OpFunctionParameter %float
+%17 = OpLabel
+%18 = OpFAdd %float %16 %float_1
+%19 = OpFMul %float %18 %18
+%20 = OpFSub %float %19 %16
+%21 = OpFMul %float %20 %float_2
+%22 = OpFAdd %float %21 %18
+OpReturnValue %22
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %6
+%13 = OpLabel
+%24 = OpVariable %_ptr_Function_float Function
+%14 = OpLoad %float %in
+%25 = OpFAdd %float %14 %float_1
+%26 = OpFMul %float %25 %25
+%27 = OpFSub %float %26 %14
+%28 = OpFMul %float %27 %float_2
+%29 = OpFAdd %float %28 %25
+OpStore %24 %29
+%15 = OpLoad %float %24
+OpStore %out %15
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%16 = OpFunctionParameter %float
+%17 = OpLabel
+%18 = OpFAdd %float %16 %float_1
+%19 = OpFMul %float %18 %18
+%20 = OpFSub %float %19 %16
+%21 = OpFMul %float %20 %float_2
+%22 = OpFAdd %float %21 %18
+OpReturnValue %22
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + before, kPredefs + after, true, true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, InlineCallWithConstantArgument) {
+  // The call with a constant argument is expected to fold, so it is inlined
+  // without using the budget. The other two calls are kept.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+%16 = OpFunctionCall %float %f %float_2
+%17 = OpFunctionCall %float %f %15
+%18 = OpFAdd %float %16 %17
+OpStore %out %18
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%19 = OpFunctionParameter %float
+%20 = OpLabel
+%21 = OpFAdd %float %19 %float_1
+%22 = OpFMul %float %21 %21
+%23 = OpFSub %float %22 %19
+%24 = OpFMul %float %23 %float_2
+%25 = OpFAdd %float %24 %21
+OpReturnValue %25
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %6
+%13 = OpLabel
+%27 = OpVariable %_ptr_Function_float Function
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %f %14
+%28 = OpFAdd %float %float_2 %float_1
+%29 = OpFMul %float %28 %28
+%30 = OpFSub %float %29 %float_2
+%31 = OpFMul %float %30 %float_2
+%32 = OpFAdd %float %31 %28
+OpStore %27 %32
+%16 = OpLoad %float %27
+%17 = OpFunctionCall %float %f %15
+%18 = OpFAdd %float %16 %17
+OpStore %out %18
+OpReturn
+OpFunctionEnd
+%f = OpFunction %float None %8
+%19 = OpFunctionParameter %float
+%20 = OpLabel
+%21 = OpFAdd %float %19 %float_1
+%22 = OpFMul %float %21 %21
+%23 = OpFSub %float %22 %19
+%24 = OpFMul %float %23 %float_2
+%25 = OpFAdd %float %24 %21
+OpReturnValue %25
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + before, kPredefs + after, true, true, 0u);
+}
+
+TEST_F(InlineSelectiveTest, InlineCallsOfInlinedCode) {
+  // The only call of %16 is inlined. The calls of %f it brings into %main
+  // take ids defined by the inlined code, and the second one takes the
+  // result of the first. Both are kept for lack of budget.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %float %in
+%15 = OpFunctionCall %float %16 %14
+OpStore %out %15
+OpReturn
+OpFunctionEnd
+%16 = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+%20 = OpFunctionCall %float %f %19
+%21 = OpFunctionCall %float %f %20
+OpReturnValue %21
+OpFunctionEnd
+%f = OpFunction %float None %8
+%22 = OpFunctionParameter %float
+%23 = OpLabel
+%24 = OpFAdd %float %22 %float_1
+%25 = OpFMul %float %24 %24
+%26 = OpFSub %float %25 %22
+%27 = OpFMul %float %26 %float_2
+%28 = OpFAdd %float %27 %24
+OpReturnValue %28
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%_ptr_Function_float = OpTypePointer Function %float
+%main = OpFunction %void None %6
+%13 = OpLabel
+%30 = OpVariable %_ptr_Function_float Function
+%14 = OpLoad %float %in
+%31 = OpFAdd %float %14 %float_1
+%32 = OpFunctionCall %float %f %31
+%33 = OpFunctionCall %float %f %32
+OpStore %30 %33
+%15 = OpLoad %float %30
+OpStore %out %15
+OpReturn
+OpFunctionEnd
+%16 = OpFunction %float None %8
+%17 = OpFunctionParameter %float
+%18 = OpLabel
+%19 = OpFAdd %float %17 %float_1
+%20 = OpFunctionCall %float %f %19
+%21 = OpFunctionCall %float %f %20
+OpReturnValue %21
+OpFunctionEnd
+%f = OpFunction %float None %8
+%22 = OpFunctionParameter %float
+%23 = OpLabel
+%24 = OpFAdd %float %22 %float_1
+%25 = OpFMul %float %24 %24
+%26 = OpFSub %float %25 %22
+%27 = OpFMul %float %26 %float_2
+%28 = OpFAdd %float %27 %24
+OpReturnValue %28
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InlineSelectivePass>(
+      kPredefs + before, kPredefs + after, true, true, 0u);
+}
+
+}  // anonymous namespace
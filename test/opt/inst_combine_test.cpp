@@ -0,0 +1,235 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using InstCombineTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %iin %out %iout %vout
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %in "in"
+OpName %iin "iin"
+OpName %out "out"
+OpName %iout "iout"
+OpName %vout "vout"
+OpDecorate %iin Flat
+%void = OpTypeVoid
+%8 = OpTypeFunction %void
+%bool = OpTypeBool
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+%v2float = OpTypeVector %float 2
+%v2int = OpTypeVector %int 2
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Input_int = OpTypePointer Input %int
+%iin = OpVariable %_ptr_Input_int Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%_ptr_Output_int = OpTypePointer Output %int
+%iout = OpVariable %_ptr_Output_int Output
+%_ptr_Output_v2float = OpTypePointer Output %v2float
+%vout = OpVariable %_ptr_Output_v2float Output
+%true = OpConstantTrue %bool
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_3 = OpConstant %int 3
+%26 = OpConstantComposite %v2int %int_1 %int_3
+)";
+
+TEST_F(InstCombineTest, FoldConstantExpressions) {
+  // The integer, vector, float, comparison and conversion instructions fold
+  // to constants, and the select of a constant condition to one of them.
+  // Only the constants of the final results are added.
+  const std::string before =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpIAdd %int %int_1 %int_3
+%29 = OpIMul %int %28 %int_3
+%30 = OpIAdd %v2int %26 %26
+%31 = OpCompositeExtract %int %30 1
+%32 = OpISub %int %29 %31
+OpStore %iout %32
+%33 = OpFAdd %float %float_1 %float_2
+%34 = OpConvertSToF %float %int_3
+%35 = OpFMul %float %33 %34
+%36 = OpFOrdLessThan %bool %35 %float_2
+%37 = OpSelect %float %36 %float_0 %35
+OpStore %out %37
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%int_6 = OpConstant %int 6
+%float_9 = OpConstant %float 9
+%main = OpFunction %void None %8
+%27 = OpLabel
+OpStore %iout %int_6
+OpStore %out %float_9
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InstCombinePass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(InstCombineTest, ApplyIdentities) {
+  // ((i + 0) * 1) is i, as well as -(-i) & -(-i). Then (i - i) is 0 and the
+  // sum is i. For floats x * 1.0 is x, but x + 0.0 is kept: it is not x for
+  // x = -0.0.
+  const std::string before =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpLoad %float %in
+%29 = OpLoad %int %iin
+%30 = OpIAdd %int %29 %int_0
+%31 = OpIMul %int %int_1 %30
+%32 = OpSNegate %int %31
+%33 = OpSNegate %int %32
+%34 = OpBitwiseAnd %int %33 %33
+%35 = OpISub %int %34 %29
+%36 = OpIAdd %int %34 %35
+OpStore %iout %36
+%37 = OpFMul %float %28 %float_1
+%38 = OpFAdd %float %37 %float_0
+%39 = OpSelect %float %true %38 %28
+OpStore %out %39
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpLoad %float %in
+%29 = OpLoad %int %iin
+%32 = OpSNegate %int %29
+OpStore %iout %29
+%38 = OpFAdd %float %28 %float_0
+OpStore %out %38
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InstCombinePass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(InstCombineTest, ExtractFromConstructAndInsert) {
+  // The first element comes from the construct under the insert, the second
+  // one is the inserted value.
+  const std::string before =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpLoad %float %in
+%29 = OpCompositeConstruct %v2float %28 %float_1
+%30 = OpCompositeInsert %v2float %float_2 %29 1
+%31 = OpCompositeExtract %float %30 0
+%32 = OpCompositeExtract %float %30 1
+%33 = OpFAdd %float %31 %32
+OpStore %out %33
+OpStore %vout %30
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpLoad %float %in
+%29 = OpCompositeConstruct %v2float %28 %float_1
+%30 = OpCompositeInsert %v2float %float_2 %29 1
+%33 = OpFAdd %float %28 %float_2
+OpStore %out %33
+OpStore %vout %30
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InstCombinePass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(InstCombineTest, KeepUndefinedOrInexactResults) {
+  // A division by zero is not folded, and x + 0.0 is kept.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %8
+%27 = OpLabel
+%28 = OpLoad %float %in
+%29 = OpSDiv %int %int_1 %int_0
+OpStore %iout %29
+%30 = OpFAdd %float %28 %float_0
+OpStore %out %30
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InstCombinePass>(
+      kPredefs + assembly, kPredefs + assembly, true, true);
+}
+
+TEST_F(InstCombineTest, KeepWideValues) {
+  // Only 32-bit integers and floats are folded, and identities are only
+  // recognized on their constants.
+  const std::string assembly =
+      R"(OpCapability Shader
+OpCapability Int64
+OpCapability Float64
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %out %lout
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %out "out"
+OpName %lout "lout"
+%void = OpTypeVoid
+%5 = OpTypeFunction %void
+%double = OpTypeFloat 64
+%long = OpTypeInt 64 1
+%_ptr_Output_double = OpTypePointer Output %double
+%out = OpVariable %_ptr_Output_double Output
+%_ptr_Output_long = OpTypePointer Output %long
+%lout = OpVariable %_ptr_Output_long Output
+%double_1 = OpConstant %double 1
+%double_2 = OpConstant %double 2
+%long_0 = OpConstant %long 0
+%long_3 = OpConstant %long 3
+%main = OpFunction %void None %5
+%14 = OpLabel
+%15 = OpFAdd %double %double_1 %double_2
+OpStore %out %15
+%16 = OpIAdd %long %long_3 %long_3
+%17 = OpIAdd %long %16 %long_0
+OpStore %lout %17
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::InstCombinePass>(assembly, assembly, true, true);
+}
+
+}  // anonymous namespace
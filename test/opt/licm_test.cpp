@@ -0,0 +1,216 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using LICMTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %b %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %o "o"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%_ptr_Input_int = OpTypePointer Input %int
+%a = OpVariable %_ptr_Input_int Input
+%b = OpVariable %_ptr_Input_int Input
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+)";
+
+TEST_F(LICMTest, HoistOutOfNestedLoops) {
+  // for (int i = 0; i < b; ++i)
+  //   for (int j = 0; j < a * b + i; j += b / a)
+  //     o = a / b;
+  //
+  // a * b is hoisted out of both loops, a * b + i out of the inner one. The
+  // division in the inner header moves to the inner preheader, but not
+  // further: the outer loop might be left before reaching it. The division
+  // in the inner body stays where it is.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %int %a
+%15 = OpLoad %int %b
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %13 %18 %19
+%20 = OpSLessThan %bool %17 %15
+OpLoopMerge %21 %19 None
+OpBranchConditional %20 %22 %21
+%22 = OpLabel
+OpBranch %23
+%23 = OpLabel
+%24 = OpPhi %int %int_0 %22 %25 %26
+%27 = OpIMul %int %14 %15
+%28 = OpIAdd %int %27 %17
+%29 = OpSDiv %int %14 %15
+%30 = OpSLessThan %bool %24 %28
+OpLoopMerge %31 %26 None
+OpBranchConditional %30 %26 %31
+%26 = OpLabel
+OpStore %o %29
+%32 = OpSDiv %int %15 %14
+%25 = OpIAdd %int %24 %32
+OpBranch %23
+%31 = OpLabel
+OpBranch %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%21 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %int %a
+%15 = OpLoad %int %b
+%27 = OpIMul %int %14 %15
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %13 %18 %19
+%20 = OpSLessThan %bool %17 %15
+OpLoopMerge %21 %19 None
+OpBranchConditional %20 %22 %21
+%22 = OpLabel
+%28 = OpIAdd %int %27 %17
+%29 = OpSDiv %int %14 %15
+OpBranch %23
+%23 = OpLabel
+%24 = OpPhi %int %int_0 %22 %25 %26
+%30 = OpSLessThan %bool %24 %28
+OpLoopMerge %31 %26 None
+OpBranchConditional %30 %26 %31
+%26 = OpLabel
+OpStore %o %29
+%32 = OpSDiv %int %15 %14
+%25 = OpIAdd %int %24 %32
+OpBranch %23
+%31 = OpLabel
+OpBranch %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%21 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LICMPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(LICMTest, HoistIntoEnclosingLoopHeader) {
+  // The preheader of the inner loop is the outer loop's header, so the
+  // hoisted instruction goes before its OpLoopMerge. The load is not moved.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+OpBranch %14
+%14 = OpLabel
+%15 = OpPhi %int %int_0 %13 %16 %17
+OpLoopMerge %18 %17 None
+OpBranch %19
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpIAdd %int %15 %int_1
+OpStore %o %21
+%22 = OpSLessThan %bool %20 %21
+OpLoopMerge %23 %19 None
+OpBranchConditional %22 %19 %23
+%23 = OpLabel
+OpBranch %17
+%17 = OpLabel
+%16 = OpIAdd %int %15 %int_1
+%24 = OpSLessThan %bool %16 %int_1
+OpBranchConditional %24 %14 %18
+%18 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+OpBranch %14
+%14 = OpLabel
+%15 = OpPhi %int %int_0 %13 %16 %17
+%21 = OpIAdd %int %15 %int_1
+OpLoopMerge %18 %17 None
+OpBranch %19
+%19 = OpLabel
+%20 = OpLoad %int %a
+OpStore %o %21
+%22 = OpSLessThan %bool %20 %21
+OpLoopMerge %23 %19 None
+OpBranchConditional %22 %19 %23
+%23 = OpLabel
+OpBranch %17
+%17 = OpLabel
+%16 = OpIAdd %int %15 %int_1
+%24 = OpSLessThan %bool %16 %int_1
+OpBranchConditional %24 %14 %18
+%18 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LICMPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(LICMTest, NoPreheader) {
+  // The loop header is also the merge block of a selection, so it has two
+  // predecessors outside the loop and nothing is moved.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %6
+%13 = OpLabel
+%14 = OpLoad %int %a
+%15 = OpSLessThan %bool %14 %int_1
+OpSelectionMerge %16 None
+OpBranchConditional %15 %17 %16
+%17 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%18 = OpIAdd %int %14 %int_1
+OpStore %o %18
+OpLoopMerge %19 %16 None
+OpBranchConditional %15 %16 %19
+%19 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LICMPass>(kPredefs + assembly,
+                                       kPredefs + assembly, true, true);
+}
+
+}  // anonymous namespace
@@ -255,14 +255,12 @@ OpFunctionEnd
 )";
 
   const std::string after =
-      R"(%46 = OpUndef %float
-%main = OpFunction %void None %9
+      R"(%main = OpFunction %void None %9
 %23 = OpLabel
 OpBranch %24
 %24 = OpLabel
-%44 = OpPhi %float %float_0 %23 %48 %26
+%44 = OpPhi %float %float_0 %23 %46 %26
 %45 = OpPhi %int %int_0 %23 %42 %26
-%47 = OpPhi %float %46 %23 %33 %26
 OpLoopMerge %25 %26 None
 OpBranch %27
 %27 = OpLabel
@@ -280,7 +278,7 @@ OpBranch %26
 %40 = OpFAdd %float %44 %33
 OpBranch %26
 %26 = OpLabel
-%48 = OpPhi %float %44 %37 %40 %36
+%46 = OpPhi %float %44 %37 %40 %36
 %42 = OpIAdd %int %45 %int_1
 OpBranch %24
 %25 = OpLabel
@@ -404,14 +402,12 @@ OpFunctionEnd
 )";
 
   const std::string after =
-      R"(%47 = OpUndef %float
-%main = OpFunction %void None %9
+      R"(%main = OpFunction %void None %9
 %24 = OpLabel
 OpBranch %25
 %25 = OpLabel
 %45 = OpPhi %float %float_0 %24 %36 %27
 %46 = OpPhi %int %int_0 %24 %43 %27
-%48 = OpPhi %float %47 %24 %36 %27
 OpLoopMerge %26 %27 None
 OpBranch %28
 %28 = OpLabel
@@ -432,7 +428,6 @@ OpBranch %27
 %43 = OpIAdd %int %46 %int_1
 OpBranch %25
 %26 = OpLabel
-%49 = OpPhi %float %48 %28 %36 %40
 OpStore %fo %45
 OpReturn
 OpFunctionEnd
@@ -551,8 +546,7 @@ OpFunctionEnd
 )";
 
   const std::string after =
-      R"(%43 = OpUndef %float
-%main = OpFunction %void None %11
+      R"(%main = OpFunction %void None %11
 %23 = OpLabel
 %24 = OpLoad %float %fe
 %25 = OpConvertFToS %int %24
@@ -561,7 +555,6 @@ OpBranch %26
 %40 = OpPhi %float %float_0 %23 %41 %28
 %41 = OpPhi %float %float_1 %23 %40 %28
 %42 = OpPhi %int %int_0 %23 %38 %28
-%44 = OpPhi %float %43 %23 %40 %28
 OpLoopMerge %27 %28 None
 OpBranch %29
 %29 = OpLabel
@@ -722,9 +715,8 @@ OpBranch %27
 %43 = OpIAdd %int %46 %int_1
 OpBranch %25
 %26 = OpLabel
-%49 = OpPhi %float %45 %28 %37 %41
-%50 = OpPhi %float %48 %28 %45 %41
-OpStore %fo %50
+%49 = OpPhi %float %48 %28 %45 %41
+OpStore %fo %49
 OpReturn
 OpFunctionEnd
 )";
@@ -1258,6 +1250,163 @@ OpFunctionEnd
                                                       true);
 }
 
+TEST_F(LocalSSAElimTest, NoPhiForVariableDeadAtMerge) {
+  // %x is stored on both sides of the selection, but is not loaded after
+  // the merge, so the merge block needs no phi for it.
+
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %fo
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %fo "fo"
+OpName %x "x"
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%fo = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %3
+%4 = OpLabel
+%x = OpVariable %_ptr_Function_float Function
+OpSelectionMerge %7 None
+OpBranchConditional %true %5 %6
+%5 = OpLabel
+OpStore %x %float_0
+%8 = OpLoad %float %x
+OpStore %fo %8
+OpBranch %7
+%6 = OpLabel
+OpStore %x %float_1
+%9 = OpLoad %float %x
+OpStore %fo %9
+OpBranch %7
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %fo
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %fo "fo"
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%fo = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %3
+%4 = OpLabel
+OpSelectionMerge %7 None
+OpBranchConditional %true %5 %6
+%5 = OpLabel
+OpStore %fo %float_0
+OpBranch %7
+%6 = OpLabel
+OpStore %fo %float_1
+OpBranch %7
+%7 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SinglePassRunAndCheck<opt::LocalMultiStoreElimPass>(before, after, true,
+                                                      true);
+}
+
+TEST_F(LocalSSAElimTest, LoadInUnreachableBlock) {
+  // The load in unreachable block %8 is replaced with undef, and the value
+  // stored there flows into the phi of its reachable successor.
+
+  const std::string before = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %fo
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %fo "fo"
+OpName %x "x"
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%fo = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %3
+%4 = OpLabel
+%x = OpVariable %_ptr_Function_float Function
+OpStore %x %float_0
+OpSelectionMerge %7 None
+OpBranchConditional %true %5 %7
+%5 = OpLabel
+OpStore %x %float_1
+OpBranch %7
+%8 = OpLabel
+%9 = OpLoad %float %x
+%10 = OpFAdd %float %9 %float_1
+OpStore %x %10
+OpBranch %7
+%7 = OpLabel
+%11 = OpLoad %float %x
+OpStore %fo %11
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after = R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %fo
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %fo "fo"
+%void = OpTypeVoid
+%3 = OpTypeFunction %void
+%bool = OpTypeBool
+%true = OpConstantTrue %bool
+%float = OpTypeFloat 32
+%float_0 = OpConstant %float 0
+%float_1 = OpConstant %float 1
+%_ptr_Function_float = OpTypePointer Function %float
+%_ptr_Output_float = OpTypePointer Output %float
+%fo = OpVariable %_ptr_Output_float Output
+%21 = OpUndef %float
+%main = OpFunction %void None %3
+%4 = OpLabel
+OpSelectionMerge %7 None
+OpBranchConditional %true %5 %7
+%5 = OpLabel
+OpBranch %7
+%8 = OpLabel
+%10 = OpFAdd %float %21 %float_1
+OpBranch %7
+%7 = OpLabel
+%20 = OpPhi %float %float_0 %4 %float_1 %5 %10 %8
+OpStore %fo %20
+OpReturn
+OpFunctionEnd
+)";
+
+  SetAssembleOptions(SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS);
+  SinglePassRunAndCheck<opt::LocalMultiStoreElimPass>(before, after, true,
+                                                      true);
+}
+
 // TODO(greg-lunarg): Add tests to verify handling of these cases:
 //
 //    No optimization in the presence of
@@ -0,0 +1,180 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+#include "opt/build_module.h"
+#include "opt/ir_context.h"
+#include "opt/loop_descriptor.h"
+
+namespace {
+
+using spvtools::ir::BasicBlock;
+using spvtools::ir::IRContext;
+using spvtools::opt::Loop;
+using spvtools::opt::LoopDescriptor;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+// Two loops in sequence, the first one containing a nested loop. Edges:
+//   1 -> 2        entry
+//   2 -> 3        outer loop header, merge 8, continue 7
+//   3 -> 4, 8     break out of the outer loop
+//   4 -> 5, 6     inner loop header, merge 6, continue 5
+//   5 -> 4        inner back edge
+//   6 -> 7
+//   7 -> 2        outer back edge
+//   8 -> 9
+//   9 -> 10       second loop header, merge 11, continue 10
+//   10 -> 9, 11   back edge of the second loop
+const char kShader[] = R"(
+               OpCapability Shader
+               OpMemoryModel Logical GLSL450
+               OpEntryPoint Fragment %main "main"
+               OpExecutionMode %main OriginUpperLeft
+       %void = OpTypeVoid
+         %20 = OpTypeFunction %void
+       %bool = OpTypeBool
+       %true = OpConstantTrue %bool
+       %main = OpFunction %void None %20
+          %1 = OpLabel
+               OpBranch %2
+          %2 = OpLabel
+               OpLoopMerge %8 %7 None
+               OpBranch %3
+          %3 = OpLabel
+               OpBranchConditional %true %4 %8
+          %4 = OpLabel
+               OpLoopMerge %6 %5 None
+               OpBranchConditional %true %5 %6
+          %5 = OpLabel
+               OpBranch %4
+          %6 = OpLabel
+               OpBranch %7
+          %7 = OpLabel
+               OpBranch %2
+          %8 = OpLabel
+               OpBranch %9
+          %9 = OpLabel
+               OpLoopMerge %11 %10 None
+               OpBranch %10
+         %10 = OpLabel
+               OpBranchConditional %true %9 %11
+         %11 = OpLabel
+               OpReturn
+               OpFunctionEnd
+)";
+
+class LoopDescriptorTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    context_.reset(new IRContext(spvtools::BuildModule(
+        SPV_ENV_UNIVERSAL_1_1, nullptr, kShader,
+        SPV_TEXT_TO_BINARY_OPTION_PRESERVE_NUMERIC_IDS)));
+    ASSERT_NE(nullptr, context_->module());
+    loops_ = context_->GetLoopDescriptor(&*context_->module()->begin());
+  }
+
+  // Returns the labels of |blocks|.
+  static std::vector<uint32_t> Ids(const std::vector<BasicBlock*>& blocks) {
+    std::vector<uint32_t> ids;
+    for (auto blk : blocks) ids.push_back(blk->id());
+    return ids;
+  }
+
+  // Returns the labels of the headers of |loops|.
+  static std::vector<uint32_t> HeaderIds(const std::vector<Loop*>& loops) {
+    std::vector<uint32_t> ids;
+    for (auto loop : loops) ids.push_back(loop->header()->id());
+    return ids;
+  }
+
+  std::unique_ptr<IRContext> context_;
+  LoopDescriptor* loops_ = nullptr;
+};
+
+TEST_F(LoopDescriptorTest, NestingTree) {
+  EXPECT_EQ(3u, loops_->NumLoops());
+  EXPECT_THAT(HeaderIds(loops_->TopLevelLoops()), ElementsAre(2, 9));
+  EXPECT_THAT(HeaderIds(loops_->PostOrder()), ElementsAre(4, 2, 9));
+  Loop* outer = loops_->TopLevelLoops()[0];
+  Loop* second = loops_->TopLevelLoops()[1];
+  ASSERT_EQ(1u, outer->children().size());
+  Loop* inner = outer->children()[0];
+  EXPECT_EQ(nullptr, outer->parent());
+  EXPECT_EQ(outer, inner->parent());
+  EXPECT_THAT(inner->children(), IsEmpty());
+  EXPECT_THAT(second->children(), IsEmpty());
+  EXPECT_EQ(1u, outer->depth());
+  EXPECT_EQ(2u, inner->depth());
+  EXPECT_EQ(1u, second->depth());
+}
+
+TEST_F(LoopDescriptorTest, LoopBlocks) {
+  Loop* outer = loops_->TopLevelLoops()[0];
+  Loop* inner = outer->children()[0];
+  Loop* second = loops_->TopLevelLoops()[1];
+  EXPECT_THAT(Ids(outer->blocks()), ElementsAre(2, 3, 4, 5, 6, 7));
+  EXPECT_THAT(Ids(inner->blocks()), ElementsAre(4, 5));
+  EXPECT_THAT(Ids(second->blocks()), ElementsAre(9, 10));
+  EXPECT_THAT(Ids(outer->latches()), ElementsAre(7));
+  EXPECT_THAT(Ids(inner->latches()), ElementsAre(5));
+  EXPECT_THAT(Ids(second->latches()), ElementsAre(10));
+  EXPECT_TRUE(outer->Contains(5));
+  EXPECT_FALSE(outer->Contains(8));
+  EXPECT_FALSE(inner->Contains(6));
+}
+
+TEST_F(LoopDescriptorTest, MergeContinueAndPreheader) {
+  Loop* outer = loops_->TopLevelLoops()[0];
+  Loop* inner = outer->children()[0];
+  Loop* second = loops_->TopLevelLoops()[1];
+  EXPECT_EQ(8u, outer->merge_id());
+  EXPECT_EQ(7u, outer->continue_id());
+  EXPECT_EQ(6u, inner->merge_id());
+  EXPECT_EQ(5u, inner->continue_id());
+  ASSERT_NE(nullptr, outer->preheader());
+  EXPECT_EQ(1u, outer->preheader()->id());
+  // The inner loop is entered through a conditional branch.
+  EXPECT_EQ(nullptr, inner->preheader());
+  ASSERT_NE(nullptr, second->preheader());
+  EXPECT_EQ(8u, second->preheader()->id());
+}
+
+TEST_F(LoopDescriptorTest, InnermostLoop) {
+  Loop* outer = loops_->TopLevelLoops()[0];
+  Loop* inner = outer->children()[0];
+  Loop* second = loops_->TopLevelLoops()[1];
+  EXPECT_EQ(nullptr, loops_->InnermostLoop(1));
+  EXPECT_EQ(outer, loops_->InnermostLoop(2));
+  EXPECT_EQ(inner, loops_->InnermostLoop(5));
+  EXPECT_EQ(outer, loops_->InnermostLoop(6));
+  EXPECT_EQ(nullptr, loops_->InnermostLoop(8));
+  EXPECT_EQ(second, loops_->InnermostLoop(10));
+  EXPECT_EQ(nullptr, loops_->InnermostLoop(nullptr));
+}
+
+TEST_F(LoopDescriptorTest, ContextCachesUntilInvalidated) {
+  spvtools::ir::Function* func = loops_->function();
+  EXPECT_EQ(loops_, context_->GetLoopDescriptor(func));
+  context_->InvalidateDominatorAnalyses();
+  LoopDescriptor* loops = context_->GetLoopDescriptor(func);
+  EXPECT_EQ(3u, loops->NumLoops());
+}
+
+}  // anonymous namespace
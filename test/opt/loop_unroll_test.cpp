@@ -0,0 +1,374 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using LoopUnrollTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %b %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %o "o"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%int_3 = OpConstant %int 3
+%_ptr_Input_int = OpTypePointer Input %int
+%a = OpVariable %_ptr_Input_int Input
+%b = OpVariable %_ptr_Input_int Input
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+)";
+
+TEST_F(LoopUnrollTest, FullyUnrollConstantTripCount) {
+  // for (int i = 0; i < 3; ++i)
+  //   o = i;
+  // o = i;
+  //
+  // Each iteration gets a copy of the loop, in which i is a constant. The
+  // last test is kept for the value of i after the loop.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %15 %18 %19
+%20 = OpSLessThan %bool %17 %int_3
+OpLoopMerge %21 %19 None
+OpBranchConditional %20 %22 %21
+%22 = OpLabel
+OpStore %o %17
+OpBranch %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%21 = OpLabel
+OpStore %o %17
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %23
+%23 = OpLabel
+%24 = OpSLessThan %bool %int_0 %int_3
+OpBranch %25
+%25 = OpLabel
+OpStore %o %int_0
+OpBranch %26
+%26 = OpLabel
+%27 = OpIAdd %int %int_0 %int_1
+OpBranch %28
+%28 = OpLabel
+%29 = OpSLessThan %bool %27 %int_3
+OpBranch %30
+%30 = OpLabel
+OpStore %o %27
+OpBranch %31
+%31 = OpLabel
+%32 = OpIAdd %int %27 %int_1
+OpBranch %33
+%33 = OpLabel
+%34 = OpSLessThan %bool %32 %int_3
+OpBranch %35
+%35 = OpLabel
+OpStore %o %32
+OpBranch %36
+%36 = OpLabel
+%37 = OpIAdd %int %32 %int_1
+OpBranch %38
+%38 = OpLabel
+%39 = OpSLessThan %bool %37 %int_3
+OpBranch %21
+%21 = OpLabel
+OpStore %o %37
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LoopUnrollPass>(
+      kPredefs + before, kPredefs + after, true, true, 256u);
+}
+
+TEST_F(LoopUnrollTest, FullyUnrollNestedLoops) {
+  // for (int i = 0; i < 2; ++i)
+  //   for (int j = 0; j < 2; ++j)
+  //     o = i + j;
+  //
+  // The inner loop is unrolled first, then the outer loop, whose test is in
+  // the block following its header.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %15 %18 %19
+OpLoopMerge %20 %19 None
+OpBranch %21
+%21 = OpLabel
+%22 = OpSLessThan %bool %17 %int_2
+OpBranchConditional %22 %23 %20
+%23 = OpLabel
+OpBranch %24
+%24 = OpLabel
+%25 = OpPhi %int %int_0 %23 %26 %27
+%28 = OpSLessThan %bool %25 %int_2
+OpLoopMerge %29 %27 None
+OpBranchConditional %28 %27 %29
+%27 = OpLabel
+%30 = OpIAdd %int %17 %25
+OpStore %o %30
+%26 = OpIAdd %int %25 %int_1
+OpBranch %24
+%29 = OpLabel
+OpBranch %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%20 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %43
+%43 = OpLabel
+OpBranch %44
+%44 = OpLabel
+%45 = OpSLessThan %bool %int_0 %int_2
+OpBranch %46
+%46 = OpLabel
+OpBranch %47
+%47 = OpLabel
+%48 = OpSLessThan %bool %int_0 %int_2
+OpBranch %49
+%49 = OpLabel
+%50 = OpIAdd %int %int_0 %int_0
+OpStore %o %50
+%51 = OpIAdd %int %int_0 %int_1
+OpBranch %52
+%52 = OpLabel
+%53 = OpSLessThan %bool %51 %int_2
+OpBranch %54
+%54 = OpLabel
+%55 = OpIAdd %int %int_0 %51
+OpStore %o %55
+%56 = OpIAdd %int %51 %int_1
+OpBranch %57
+%57 = OpLabel
+%58 = OpSLessThan %bool %56 %int_2
+OpBranch %59
+%59 = OpLabel
+OpBranch %60
+%60 = OpLabel
+%61 = OpIAdd %int %int_0 %int_1
+OpBranch %62
+%62 = OpLabel
+OpBranch %63
+%63 = OpLabel
+%64 = OpSLessThan %bool %61 %int_2
+OpBranch %65
+%65 = OpLabel
+OpBranch %66
+%66 = OpLabel
+%67 = OpSLessThan %bool %int_0 %int_2
+OpBranch %68
+%68 = OpLabel
+%69 = OpIAdd %int %61 %int_0
+OpStore %o %69
+%70 = OpIAdd %int %int_0 %int_1
+OpBranch %71
+%71 = OpLabel
+%72 = OpSLessThan %bool %70 %int_2
+OpBranch %73
+%73 = OpLabel
+%74 = OpIAdd %int %61 %70
+OpStore %o %74
+%75 = OpIAdd %int %70 %int_1
+OpBranch %76
+%76 = OpLabel
+%77 = OpSLessThan %bool %75 %int_2
+OpBranch %78
+%78 = OpLabel
+OpBranch %79
+%79 = OpLabel
+%80 = OpIAdd %int %61 %int_1
+OpBranch %81
+%81 = OpLabel
+OpBranch %82
+%82 = OpLabel
+%83 = OpSLessThan %bool %80 %int_2
+OpBranch %20
+%20 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LoopUnrollPass>(
+      kPredefs + before, kPredefs + after, true, true, 256u);
+}
+
+TEST_F(LoopUnrollTest, PartiallyUnrollUnknownTripCount) {
+  // int i = 0;
+  // for (; i < a; ++i)
+  //   o = i;
+  //
+  // With a budget of 24 instructions the loop of 8 instructions is copied
+  // three times. Every copy of the test can leave the loop, so the value of
+  // i after the loop comes from a phi of the merge block.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+%16 = OpLoad %int %a
+OpBranch %17
+%17 = OpLabel
+%18 = OpPhi %int %int_0 %15 %19 %20
+%21 = OpSLessThan %bool %18 %16
+OpLoopMerge %22 %20 None
+OpBranchConditional %21 %23 %22
+%23 = OpLabel
+OpStore %o %18
+OpBranch %20
+%20 = OpLabel
+%19 = OpIAdd %int %18 %int_1
+OpBranch %17
+%22 = OpLabel
+%24 = OpPhi %int %18 %17
+OpStore %o %24
+OpStore %o %18
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+%16 = OpLoad %int %a
+OpBranch %17
+%17 = OpLabel
+%18 = OpPhi %int %int_0 %15 %34 %33
+%21 = OpSLessThan %bool %18 %16
+OpLoopMerge %22 %33 None
+OpBranchConditional %21 %23 %22
+%23 = OpLabel
+OpStore %o %18
+OpBranch %20
+%20 = OpLabel
+%19 = OpIAdd %int %18 %int_1
+OpBranch %25
+%25 = OpLabel
+%26 = OpSLessThan %bool %19 %16
+OpBranchConditional %26 %27 %22
+%27 = OpLabel
+OpStore %o %19
+OpBranch %28
+%28 = OpLabel
+%29 = OpIAdd %int %19 %int_1
+OpBranch %30
+%30 = OpLabel
+%31 = OpSLessThan %bool %29 %16
+OpBranchConditional %31 %32 %22
+%32 = OpLabel
+OpStore %o %29
+OpBranch %33
+%33 = OpLabel
+%34 = OpIAdd %int %29 %int_1
+OpBranch %17
+%22 = OpLabel
+%24 = OpPhi %int %18 %17 %19 %25 %29 %30
+%35 = OpPhi %int %18 %17 %19 %25 %29 %30
+OpStore %o %24
+OpStore %o %35
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LoopUnrollPass>(
+      kPredefs + before, kPredefs + after, true, true, 24u);
+}
+
+TEST_F(LoopUnrollTest, BudgetTooSmall) {
+  // Three iterations of 8 instructions do not fit, and a second copy of the
+  // body would not fit either.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %15 %18 %19
+%20 = OpSLessThan %bool %17 %int_3
+OpLoopMerge %21 %19 None
+OpBranchConditional %20 %22 %21
+%22 = OpLabel
+OpStore %o %17
+OpBranch %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%21 = OpLabel
+OpStore %o %17
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LoopUnrollPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 15u);
+}
+
+TEST_F(LoopUnrollTest, EarlyExit) {
+  // The body can leave the loop before the test, so the loop is left alone.
+  const std::string assembly =
+      R"(%main = OpFunction %void None %6
+%15 = OpLabel
+OpBranch %16
+%16 = OpLabel
+%17 = OpPhi %int %int_0 %15 %18 %19
+%20 = OpSLessThan %bool %17 %int_3
+OpLoopMerge %21 %19 None
+OpBranchConditional %20 %22 %21
+%22 = OpLabel
+%23 = OpLoad %int %a
+%24 = OpSLessThan %bool %23 %17
+OpBranchConditional %24 %21 %19
+%19 = OpLabel
+%18 = OpIAdd %int %17 %int_1
+OpBranch %16
+%21 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::LoopUnrollPass>(
+      kPredefs + assembly, kPredefs + assembly, true, true, 256u);
+}
+
+}  // anonymous namespace
@@ -0,0 +1,212 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using MergeIdenticalFunctionsTest = PassTest<::testing::Test>;
+
+TEST_F(MergeIdenticalFunctionsTest, MergeIdenticalCallTrees) {
+  // f1 and f2 are identical, f3 adds a different constant. Once the call of
+  // g2 to f2 calls f1, g2 is identical to g1 in turn.
+  const std::string predefs =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %f3 "f3"
+OpName %g1 "g1"
+OpName %g2 "g2"
+OpName %in "in"
+OpName %out "out"
+%void = OpTypeVoid
+%10 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%12 = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+)";
+
+  const std::string before =
+      R"(%main = OpFunction %void None %10
+%17 = OpLabel
+%18 = OpLoad %float %in
+%19 = OpFunctionCall %float %g1 %18
+%20 = OpFunctionCall %float %g2 %19
+%21 = OpFunctionCall %float %f3 %20
+OpStore %out %21
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %12
+%22 = OpFunctionParameter %float
+%23 = OpLabel
+%24 = OpFAdd %float %22 %float_1
+OpReturnValue %24
+OpFunctionEnd
+%f2 = OpFunction %float None %12
+%25 = OpFunctionParameter %float
+%26 = OpLabel
+%27 = OpFAdd %float %25 %float_1
+OpReturnValue %27
+OpFunctionEnd
+%f3 = OpFunction %float None %12
+%28 = OpFunctionParameter %float
+%29 = OpLabel
+%30 = OpFAdd %float %28 %float_2
+OpReturnValue %30
+OpFunctionEnd
+%g1 = OpFunction %float None %12
+%31 = OpFunctionParameter %float
+%32 = OpLabel
+%33 = OpFunctionCall %float %f1 %31
+OpReturnValue %33
+OpFunctionEnd
+%g2 = OpFunction %float None %12
+%34 = OpFunctionParameter %float
+%35 = OpLabel
+%36 = OpFunctionCall %float %f2 %34
+OpReturnValue %36
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %10
+%17 = OpLabel
+%18 = OpLoad %float %in
+%19 = OpFunctionCall %float %g1 %18
+%20 = OpFunctionCall %float %g1 %19
+%21 = OpFunctionCall %float %f3 %20
+OpStore %out %21
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %12
+%22 = OpFunctionParameter %float
+%23 = OpLabel
+%24 = OpFAdd %float %22 %float_1
+OpReturnValue %24
+OpFunctionEnd
+%f2 = OpFunction %float None %12
+%25 = OpFunctionParameter %float
+%26 = OpLabel
+%27 = OpFAdd %float %25 %float_1
+OpReturnValue %27
+OpFunctionEnd
+%f3 = OpFunction %float None %12
+%28 = OpFunctionParameter %float
+%29 = OpLabel
+%30 = OpFAdd %float %28 %float_2
+OpReturnValue %30
+OpFunctionEnd
+%g1 = OpFunction %float None %12
+%31 = OpFunctionParameter %float
+%32 = OpLabel
+%33 = OpFunctionCall %float %f1 %31
+OpReturnValue %33
+OpFunctionEnd
+%g2 = OpFunction %float None %12
+%34 = OpFunctionParameter %float
+%35 = OpLabel
+%36 = OpFunctionCall %float %f1 %34
+OpReturnValue %36
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::MergeIdenticalFunctionsPass>(
+      predefs + before, predefs + after, true, true);
+}
+
+TEST_F(MergeIdenticalFunctionsTest, KeepFunctionWithDecoratedIds) {
+  // The result of the addition in f2 is decorated, so f2 is kept, and so is
+  // g2 which calls it.
+  const std::string assembly =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %in %out
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f1 "f1"
+OpName %f2 "f2"
+OpName %f3 "f3"
+OpName %g1 "g1"
+OpName %g2 "g2"
+OpName %in "in"
+OpName %out "out"
+OpDecorate %9 RelaxedPrecision
+%void = OpTypeVoid
+%11 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%13 = OpTypeFunction %float %float
+%_ptr_Input_float = OpTypePointer Input %float
+%in = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%out = OpVariable %_ptr_Output_float Output
+%float_1 = OpConstant %float 1
+%float_2 = OpConstant %float 2
+%main = OpFunction %void None %11
+%18 = OpLabel
+%19 = OpLoad %float %in
+%20 = OpFunctionCall %float %g1 %19
+%21 = OpFunctionCall %float %g2 %20
+%22 = OpFunctionCall %float %f3 %21
+OpStore %out %22
+OpReturn
+OpFunctionEnd
+%f1 = OpFunction %float None %13
+%23 = OpFunctionParameter %float
+%24 = OpLabel
+%25 = OpFAdd %float %23 %float_1
+OpReturnValue %25
+OpFunctionEnd
+%f2 = OpFunction %float None %13
+%26 = OpFunctionParameter %float
+%27 = OpLabel
+%9 = OpFAdd %float %26 %float_1
+OpReturnValue %9
+OpFunctionEnd
+%f3 = OpFunction %float None %13
+%28 = OpFunctionParameter %float
+%29 = OpLabel
+%30 = OpFAdd %float %28 %float_2
+OpReturnValue %30
+OpFunctionEnd
+%g1 = OpFunction %float None %13
+%31 = OpFunctionParameter %float
+%32 = OpLabel
+%33 = OpFunctionCall %float %f1 %31
+OpReturnValue %33
+OpFunctionEnd
+%g2 = OpFunction %float None %13
+%34 = OpFunctionParameter %float
+%35 = OpLabel
+%36 = OpFunctionCall %float %f2 %34
+OpReturnValue %36
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::MergeIdenticalFunctionsPass>(assembly, assembly,
+                                                          true, true);
+}
+
+}  // anonymous namespace
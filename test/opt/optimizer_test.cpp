@@ -22,6 +22,7 @@
 namespace {
 
 using spvtools::CreateNullPass;
+using spvtools::CreateSetSpecConstantDefaultValuePass;
 using spvtools::CreateStripDebugInfoPass;
 using spvtools::Optimizer;
 using spvtools::SpirvTools;
@@ -106,4 +107,110 @@ TEST(Optimizer, CanRunTransformingPassWithAliasedVectors) {
   EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
 }
 
+// Returns the result of running |opt| on |binary|, checking that it succeeds.
+std::vector<uint32_t> RunOptimizer(const Optimizer& opt,
+                                   const std::vector<uint32_t>& binary) {
+  std::vector<uint32_t> result;
+  EXPECT_TRUE(opt.Run(binary.data(), binary.size(), &result));
+  return result;
+}
+
+TEST(Optimizer, ResultCacheReturnsFreshResult) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+
+  Optimizer fresh(SPV_ENV_UNIVERSAL_1_0);
+  fresh.RegisterPass(CreateStripDebugInfoPass());
+  const std::vector<uint32_t> expected = RunOptimizer(fresh, binary);
+
+  Optimizer cached(SPV_ENV_UNIVERSAL_1_0);
+  cached.RegisterPass(CreateStripDebugInfoPass())
+      .SetResultCache("optimizer_cache_fresh", 1 << 20);
+  EXPECT_THAT(RunOptimizer(cached, binary), Eq(expected));
+  EXPECT_THAT(RunOptimizer(cached, binary), Eq(expected));
+
+  // Aliased vectors.
+  std::vector<uint32_t> aliased = binary;
+  EXPECT_TRUE(cached.Run(aliased.data(), aliased.size(), &aliased));
+  EXPECT_THAT(aliased, Eq(expected));
+}
+
+TEST(Optimizer, ResultCacheDistinguishesPasses) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &binary);
+
+  Optimizer null_pass(SPV_ENV_UNIVERSAL_1_0);
+  null_pass.RegisterPass(CreateNullPass())
+      .SetResultCache("optimizer_cache_passes", 1 << 20);
+  Optimizer strip(SPV_ENV_UNIVERSAL_1_0);
+  strip.RegisterPass(CreateStripDebugInfoPass())
+      .SetResultCache("optimizer_cache_passes", 1 << 20);
+  for (int i = 0; i < 2; ++i) {
+    std::string disassembly;
+    tools.Disassemble(RunOptimizer(null_pass, binary), &disassembly);
+    EXPECT_THAT(disassembly, Eq("OpName %foo \"foo\"\n%foo = OpTypeVoid\n"));
+    tools.Disassemble(RunOptimizer(strip, binary), &disassembly);
+    EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+  }
+}
+
+TEST(Optimizer, ResultCacheDistinguishesPassParameters) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> binary;
+  tools.Assemble(
+      "OpDecorate %1 SpecId 0\n%int = OpTypeInt 32 1\n"
+      "%1 = OpSpecConstant %int 0\n",
+      &binary);
+
+  for (int i = 0; i < 2; ++i) {
+    for (const char* value : {"1", "2"}) {
+      Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+      opt.RegisterPass(CreateSetSpecConstantDefaultValuePass({{0, value}}))
+          .SetResultCache("optimizer_cache_parameters", 1 << 20);
+      std::string disassembly;
+      tools.Disassemble(RunOptimizer(opt, binary), &disassembly);
+      EXPECT_THAT(disassembly,
+                  Eq(std::string("OpDecorate %1 SpecId 0\n"
+                                 "%int = OpTypeInt 32 1\n"
+                                 "%1 = OpSpecConstant %int ") +
+                     value + "\n"));
+    }
+  }
+}
+
+TEST(Optimizer, ResultCacheAfterSeveralRuns) {
+  // Each run applies all the passes registered so far, and its result is
+  // stored as that of these passes.
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_0);
+  std::vector<uint32_t> foo;
+  tools.Assemble("OpName %foo \"foo\"\n%foo = OpTypeVoid", &foo);
+  std::vector<uint32_t> bar;
+  tools.Assemble("OpName %bar \"bar\"\n%bar = OpTypeVoid", &bar);
+
+  Optimizer opt(SPV_ENV_UNIVERSAL_1_0);
+  opt.RegisterPass(CreateStripDebugInfoPass())
+      .SetResultCache("optimizer_cache_several_runs", 1 << 20);
+  std::string disassembly;
+  RunOptimizer(opt, foo);
+  tools.Disassemble(RunOptimizer(opt, bar), &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+  opt.RegisterPass(CreateNullPass());
+  tools.Disassemble(RunOptimizer(opt, bar), &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+
+  Optimizer strip(SPV_ENV_UNIVERSAL_1_0);
+  strip.RegisterPass(CreateStripDebugInfoPass())
+      .SetResultCache("optimizer_cache_several_runs", 1 << 20);
+  Optimizer strip_null(SPV_ENV_UNIVERSAL_1_0);
+  strip_null.RegisterPass(CreateStripDebugInfoPass())
+      .RegisterPass(CreateNullPass())
+      .SetResultCache("optimizer_cache_several_runs", 1 << 20);
+  tools.Disassemble(RunOptimizer(strip, bar), &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+  tools.Disassemble(RunOptimizer(strip_null, bar), &disassembly);
+  EXPECT_THAT(disassembly, Eq("%void = OpTypeVoid\n"));
+}
+
 }  // namespace
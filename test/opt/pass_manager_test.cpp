@@ -18,6 +18,7 @@
 
 #include "module_utils.h"
 #include "opt/make_unique.h"
+#include "opt/result_cache.h"
 #include "pass_fixture.h"
 
 namespace {
@@ -182,4 +183,334 @@ TEST(PassManager, RecomputeIdBoundAutomatically) {
   EXPECT_THAT(GetIdBound(*context.module()), Eq(201u));
 }
 
+// Runs |pass| on the functions of the module assembled from |text| using
+// |num_threads| threads, and returns the disassembly of the result.
+template <typename PassT>
+std::string RunOnThreads(const std::string& text, uint32_t num_threads) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  EXPECT_NE(nullptr, module);
+  ir::IRContext context(std::move(module));
+  opt::PassManager manager;
+  manager.SetNumThreads(num_threads);
+  manager.AddPass<PassT>();
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  std::vector<uint32_t> binary;
+  context.module()->ToBinary(&binary, /* skip_nop = */ true);
+  std::string disassembly;
+  EXPECT_TRUE(SpirvTools(SPV_ENV_UNIVERSAL_1_1)
+                  .Disassemble(binary, &disassembly,
+                               SPV_BINARY_TO_TEXT_OPTION_NO_HEADER |
+                                   SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES));
+  return disassembly;
+}
+
+// Three functions that each fold to new constants, two of them the same.
+const std::string kFoldingFunctions =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f("
+OpName %g "g("
+OpName %o "o"
+OpName %a "a"
+OpName %b "b"
+OpName %c "c"
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%9 = OpTypeFunction %int
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+%main = OpFunction %void None %6
+%15 = OpLabel
+%16 = OpFunctionCall %int %f
+%17 = OpFunctionCall %int %g
+%18 = OpIAdd %int %16 %17
+%a = OpIAdd %int %int_1 %int_2
+%19 = OpIAdd %int %18 %a
+OpStore %o %19
+OpReturn
+OpFunctionEnd
+%f = OpFunction %int None %9
+%20 = OpLabel
+%b = OpIAdd %int %int_2 %int_1
+%21 = OpIMul %int %b %int_2
+OpReturnValue %21
+OpFunctionEnd
+%g = OpFunction %int None %9
+%22 = OpLabel
+%c = OpIMul %int %int_2 %int_2
+%23 = OpIAdd %int %c %int_1
+OpReturnValue %23
+OpFunctionEnd
+)";
+
+TEST(PassManager, ParallelFunctionsMergeNewConstants) {
+  const std::string expected =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f_ "f("
+OpName %g_ "g("
+OpName %o "o"
+OpDecorate %o Location 0
+%void = OpTypeVoid
+%9 = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%11 = OpTypeFunction %int
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+%int_3 = OpConstant %int 3
+%int_6 = OpConstant %int 6
+%int_5 = OpConstant %int 5
+%main = OpFunction %void None %9
+%15 = OpLabel
+%16 = OpFunctionCall %int %f_
+%17 = OpFunctionCall %int %g_
+%18 = OpIAdd %int %16 %17
+%19 = OpIAdd %int %18 %int_3
+OpStore %o %19
+OpReturn
+OpFunctionEnd
+%f_ = OpFunction %int None %11
+%20 = OpLabel
+OpReturnValue %int_6
+OpFunctionEnd
+%g_ = OpFunction %int None %11
+%22 = OpLabel
+OpReturnValue %int_5
+OpFunctionEnd
+)";
+  EXPECT_EQ(expected,
+            RunOnThreads<opt::InstCombinePass>(kFoldingFunctions, 4));
+}
+
+TEST(PassManager, ParallelFunctionsIndependentOfThreadCount) {
+  const std::string two =
+      RunOnThreads<opt::InstCombinePass>(kFoldingFunctions, 2);
+  EXPECT_EQ(two, RunOnThreads<opt::InstCombinePass>(kFoldingFunctions, 3));
+  EXPECT_EQ(two, RunOnThreads<opt::InstCombinePass>(kFoldingFunctions, 8));
+}
+
+TEST(PassManager, ParallelFunctionsRunsOtherPassesOnModule) {
+  const std::string stripped =
+      RunOnThreads<opt::StripDebugInfoPass>(kFoldingFunctions, 4);
+  EXPECT_EQ(std::string::npos, stripped.find("OpName"));
+  EXPECT_NE(std::string::npos, stripped.find("OpIMul"));
+}
+
+// Runs |pass| on the functions of the module assembled from |text|, reusing
+// the results in the cache directory |cache_dir|, and returns the disassembly
+// of the result.
+template <typename PassT>
+std::string RunIncrementally(const std::string& text,
+                             const std::string& cache_dir) {
+  std::unique_ptr<ir::Module> module =
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, text);
+  EXPECT_NE(nullptr, module);
+  ir::IRContext context(std::move(module));
+  const opt::ResultCache cache(cache_dir, 1 << 20);
+  opt::PassManager manager;
+  manager.AddPass<PassT>();
+  manager.SetFunctionCache(&cache, SPV_ENV_UNIVERSAL_1_1, {"test-pass"});
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  std::vector<uint32_t> binary;
+  context.module()->ToBinary(&binary, /* skip_nop = */ true);
+  std::string disassembly;
+  EXPECT_TRUE(SpirvTools(SPV_ENV_UNIVERSAL_1_1)
+                  .Disassemble(binary, &disassembly,
+                               SPV_BINARY_TO_TEXT_OPTION_NO_HEADER |
+                                   SPV_BINARY_TO_TEXT_OPTION_FRIENDLY_NAMES));
+  return disassembly;
+}
+
+// Returns the name of an empty cache directory named after |name|.
+std::string EmptyCacheDir(const std::string& name) {
+  const std::string dir = "pass_manager_cache_" + name;
+  // Storing an entry in a cache of size 0 removes every entry.
+  opt::ResultCache(dir, 0).Store({0}, {});
+  return dir;
+}
+
+TEST(PassManager, IncrementalFunctionsReuseCachedResults) {
+  const std::string dir = EmptyCacheDir("reuse");
+  const std::string cold =
+      RunIncrementally<opt::InstCombinePass>(kFoldingFunctions, dir);
+  EXPECT_NE(std::string::npos, cold.find("%19 = OpIAdd %int %18 %int_3"));
+  EXPECT_NE(std::string::npos, cold.find("OpReturnValue %int_6"));
+  EXPECT_NE(std::string::npos, cold.find("OpReturnValue %int_5"));
+  // Again, with every result in the cache.
+  EXPECT_EQ(cold,
+            RunIncrementally<opt::InstCombinePass>(kFoldingFunctions, dir));
+}
+
+TEST(PassManager, IncrementalFunctionsAfterEditingOneFunction) {
+  const std::string dir = EmptyCacheDir("edit");
+  RunIncrementally<opt::InstCombinePass>(kFoldingFunctions, dir);
+
+  // Only %g changes; %main and %f are found in the cache.
+  std::string edited = kFoldingFunctions;
+  const std::string old_c = "%c = OpIMul %int %int_2 %int_2";
+  edited.replace(edited.find(old_c), old_c.size(),
+                 "%c = OpIMul %int %int_2 %int_1");
+  const std::string warm =
+      RunIncrementally<opt::InstCombinePass>(edited, dir);
+  EXPECT_EQ(warm, RunIncrementally<opt::InstCombinePass>(
+                      edited, EmptyCacheDir("edit_cold")));
+  EXPECT_NE(std::string::npos, warm.find("OpReturnValue %int_3"));
+  EXPECT_NE(std::string::npos, warm.find("OpReturnValue %int_6"));
+}
+
+TEST(PassManager, IncrementalFunctionsWithDecorationGroups) {
+  std::string text = kFoldingFunctions;
+  const std::string old_decorate = "OpDecorate %o Location 0\n";
+  text.replace(text.find(old_decorate), old_decorate.size(),
+               "OpDecorate %o Location 0\nOpDecorate %group Flat\n"
+               "%group = OpDecorationGroup\n");
+  const std::string result = RunIncrementally<opt::InstCombinePass>(
+      text, EmptyCacheDir("groups"));
+  EXPECT_EQ(std::string::npos, result.find("OpIMul"));
+  EXPECT_NE(std::string::npos, result.find("OpDecorationGroup"));
+}
+
+// A function-local pass that records the ids of the functions it processes,
+// and claims to modify the function |changed_id| the first |num_changes|
+// times it processes it.
+class RecordingPass : public opt::Pass {
+ public:
+  RecordingPass(std::vector<uint32_t>* processed, uint32_t changed_id,
+                uint32_t* num_changes)
+      : processed_(processed),
+        changed_id_(changed_id),
+        num_changes_(num_changes) {}
+
+  const char* name() const override { return "recording"; }
+  Status Process(ir::IRContext* irContext) override {
+    InitializeProcessing(irContext);
+    ProcessFunction pfn = [this](ir::Function* fp) {
+      processed_->push_back(fp->result_id());
+      if (fp->result_id() != changed_id_ || *num_changes_ == 0) return false;
+      --*num_changes_;
+      return true;
+    };
+    return ProcessReachableCallTree(pfn, irContext)
+               ? Status::SuccessWithChange
+               : Status::SuccessWithoutChange;
+  }
+  std::unique_ptr<Pass> CloneFunctionLocal() const override {
+    return MakeUnique<RecordingPass>(processed_, changed_id_, num_changes_);
+  }
+
+ private:
+  std::vector<uint32_t>* processed_;
+  uint32_t changed_id_;
+  uint32_t* num_changes_;
+};
+
+// A pass that is not function-local and claims to modify the module the
+// first |num_changes| times it runs.
+class ChangingPass : public opt::Pass {
+ public:
+  explicit ChangingPass(uint32_t num_changes) : num_changes_(num_changes) {}
+
+  const char* name() const override { return "changing"; }
+  Status Process(ir::IRContext*) override {
+    if (num_changes_ == 0) return Status::SuccessWithoutChange;
+    --num_changes_;
+    return Status::SuccessWithChange;
+  }
+
+ private:
+  uint32_t num_changes_;
+};
+
+// Returns the ids of the functions of the module of |context|, in order.
+std::vector<uint32_t> FunctionIds(ir::IRContext* context) {
+  std::vector<uint32_t> ids;
+  for (auto& fn : *context->module()) ids.push_back(fn.result_id());
+  return ids;
+}
+
+TEST(PassManager, FixedPointGroupSkipsUnchangedFunctions) {
+  ir::IRContext context(
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kFoldingFunctions));
+  const std::vector<uint32_t> ids = FunctionIds(&context);
+  const uint32_t main = ids[0], f = ids[1], g = ids[2];
+  std::vector<uint32_t> first, second;
+  uint32_t first_changes = 1, second_changes = 0;
+  opt::PassManager manager;
+  manager.BeginFixedPointGroup(4);
+  manager.AddPass<RecordingPass>(&first, f, &first_changes);
+  manager.AddPass<RecordingPass>(&second, f, &second_changes);
+  manager.EndFixedPointGroup();
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  // The second iteration only runs the first pass, on the function it
+  // changed in the first iteration.
+  EXPECT_THAT(first, Eq(std::vector<uint32_t>{main, f, g, f}));
+  EXPECT_THAT(second, Eq(std::vector<uint32_t>{main, f, g}));
+}
+
+TEST(PassManager, FixedPointGroupStopsAfterMaxIterations) {
+  ir::IRContext context(
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kFoldingFunctions));
+  const std::vector<uint32_t> ids = FunctionIds(&context);
+  const uint32_t main = ids[0], f = ids[1], g = ids[2];
+  std::vector<uint32_t> processed;
+  uint32_t num_changes = 10;
+  opt::PassManager manager;
+  manager.BeginFixedPointGroup(3);
+  manager.AddPass<RecordingPass>(&processed, g, &num_changes);
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  EXPECT_THAT(processed, Eq(std::vector<uint32_t>{main, f, g, g, g}));
+  EXPECT_EQ(7u, num_changes);
+}
+
+TEST(PassManager, FixedPointGroupRerunsAfterOtherPassChanges) {
+  ir::IRContext context(
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kFoldingFunctions));
+  const std::vector<uint32_t> ids = FunctionIds(&context);
+  const uint32_t main = ids[0], f = ids[1], g = ids[2];
+  std::vector<uint32_t> processed;
+  uint32_t num_changes = 0;
+  opt::PassManager manager;
+  manager.AddPass<RecordingPass>(&processed, f, &num_changes);
+  manager.BeginFixedPointGroup(4);
+  manager.AddPass<RecordingPass>(&processed, f, &num_changes);
+  manager.AddPass<ChangingPass>(1);
+  manager.EndFixedPointGroup();
+  manager.AddPass<RecordingPass>(&processed, f, &num_changes);
+  EXPECT_EQ(opt::Pass::Status::SuccessWithChange, manager.Run(&context));
+
+  // The pass before the group, the two iterations of the group, and the pass
+  // after the group each process every function.
+  EXPECT_THAT(processed, Eq(std::vector<uint32_t>{main, f, g, main, f, g,
+                                                  main, f, g, main, f, g}));
+}
+
+TEST(PassManager, FixedPointGroupWithoutChange) {
+  ir::IRContext context(
+      BuildModule(SPV_ENV_UNIVERSAL_1_1, nullptr, kFoldingFunctions));
+  std::vector<uint32_t> processed;
+  uint32_t num_changes = 0;
+  opt::PassManager manager;
+  manager.BeginFixedPointGroup(4);
+  manager.AddPass<RecordingPass>(&processed, 0, &num_changes);
+  EXPECT_EQ(opt::Pass::Status::SuccessWithoutChange, manager.Run(&context));
+  EXPECT_EQ(3u, processed.size());
+}
+
 }  // anonymous namespace
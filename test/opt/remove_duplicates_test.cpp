@@ -0,0 +1,79 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using RemoveDuplicatesTest = PassTest<::testing::Test>;
+
+TEST_F(RemoveDuplicatesTest, RemoveDuplicateTypesAndDecorations) {
+  // The second int and vector are the same as the first ones, and so is the
+  // second struct once its vector is replaced, since both structs have the
+  // same decorations. The third struct has no decorations and is kept.
+  const std::string before =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %_struct_1 Block
+OpDecorate %_struct_2 Block
+OpMemberDecorate %_struct_1 0 Offset 0
+OpMemberDecorate %_struct_2 0 Offset 0
+%uint = OpTypeInt 32 0
+%uint_0 = OpTypeInt 32 0
+%v2uint = OpTypeVector %uint 2
+%v2uint_0 = OpTypeVector %uint_0 2
+%_struct_1 = OpTypeStruct %v2uint
+%_struct_2 = OpTypeStruct %v2uint_0
+%_struct_7 = OpTypeStruct %v2uint_0
+%_ptr_Uniform__struct_2 = OpTypePointer Uniform %_struct_2
+%_ptr_Uniform__struct_7 = OpTypePointer Uniform %_struct_7
+)";
+
+  const std::string after =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %_struct_1 Block
+OpMemberDecorate %_struct_1 0 Offset 0
+%uint = OpTypeInt 32 0
+%v2uint = OpTypeVector %uint 2
+%_struct_1 = OpTypeStruct %v2uint
+%_struct_7 = OpTypeStruct %v2uint
+%_ptr_Uniform__struct_1 = OpTypePointer Uniform %_struct_1
+%_ptr_Uniform__struct_7 = OpTypePointer Uniform %_struct_7
+)";
+
+  SinglePassRunAndCheck<opt::RemoveDuplicatesPass>(before, after, true);
+}
+
+TEST_F(RemoveDuplicatesTest, KeepTypesWithDifferentDecorations) {
+  const std::string assembly =
+      R"(OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+OpDecorate %_runtimearr_float ArrayStride 4
+OpDecorate %_runtimearr_float_0 ArrayStride 8
+%float = OpTypeFloat 32
+%_runtimearr_float = OpTypeRuntimeArray %float
+%_runtimearr_float_0 = OpTypeRuntimeArray %float
+)";
+
+  SinglePassRunAndCheck<opt::RemoveDuplicatesPass>(assembly, assembly, true);
+}
+
+}  // anonymous namespace
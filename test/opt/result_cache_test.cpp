@@ -0,0 +1,116 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <gmock/gmock.h>
+
+#include <string>
+#include <vector>
+
+#include "opt/result_cache.h"
+
+namespace {
+
+using spvtools::opt::ResultCache;
+using ::testing::Eq;
+
+// Returns the name of a cache directory for the current test, holding only
+// the entry {0} of EntrySize(1, 0) bytes.
+std::string EmptyCacheDir() {
+  const std::string dir =
+      std::string("result_cache_") +
+      ::testing::UnitTest::GetInstance()->current_test_info()->name();
+  // Storing an entry in a cache of size 0 removes every other entry.
+  ResultCache(dir, 0).Store({0}, {});
+  return dir;
+}
+
+// Size of the file of an entry with |key_size| and |value_size| words.
+uint64_t EntrySize(uint64_t key_size, uint64_t value_size) {
+  return 4 * (3 + key_size + value_size);
+}
+
+TEST(ResultCache, LookupOfStoredEntry) {
+  ResultCache cache(EmptyCacheDir(), 1 << 20);
+  cache.Store({1, 2, 3}, {4, 5});
+  std::vector<uint32_t> value;
+  EXPECT_TRUE(cache.Lookup({1, 2, 3}, &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{4, 5}));
+}
+
+TEST(ResultCache, LookupOfEmptyValue) {
+  ResultCache cache(EmptyCacheDir(), 1 << 20);
+  cache.Store({1}, {});
+  std::vector<uint32_t> value = {7};
+  EXPECT_TRUE(cache.Lookup({1}, &value));
+  EXPECT_TRUE(value.empty());
+}
+
+TEST(ResultCache, LookupOfOtherKeyFails) {
+  ResultCache cache(EmptyCacheDir(), 1 << 20);
+  cache.Store({1, 2, 3}, {4, 5});
+  std::vector<uint32_t> value;
+  EXPECT_FALSE(cache.Lookup({1, 2}, &value));
+  EXPECT_FALSE(cache.Lookup({1, 2, 3, 4}, &value));
+  EXPECT_FALSE(cache.Lookup({3, 2, 1}, &value));
+}
+
+TEST(ResultCache, StoreReplacesValue) {
+  ResultCache cache(EmptyCacheDir(), 1 << 20);
+  cache.Store({1}, {2});
+  cache.Store({1}, {3, 4});
+  std::vector<uint32_t> value;
+  EXPECT_TRUE(cache.Lookup({1}, &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{3, 4}));
+}
+
+TEST(ResultCache, EntriesPersistAcrossInstances) {
+  const std::string dir = EmptyCacheDir();
+  ResultCache(dir, 1 << 20).Store({1}, {2});
+  std::vector<uint32_t> value;
+  EXPECT_TRUE(ResultCache(dir, 1 << 20).Lookup({1}, &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{2}));
+}
+
+TEST(ResultCache, EvictionKeepsNewestEntry) {
+  // Room for two entries besides the one left by EmptyCacheDir().
+  ResultCache cache(EmptyCacheDir(), 2 * EntrySize(1, 1) + EntrySize(1, 0));
+  cache.Store({1}, {10});
+  cache.Store({2}, {20});
+  cache.Store({3}, {30});
+
+  std::vector<uint32_t> value;
+  EXPECT_TRUE(cache.Lookup({3}, &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{30}));
+  const int old_entries =
+      int(cache.Lookup({1}, &value)) + int(cache.Lookup({2}, &value));
+  EXPECT_THAT(old_entries, Eq(1));
+}
+
+TEST(ResultCache, EntryLargerThanCacheIsKept) {
+  ResultCache cache(EmptyCacheDir(), EntrySize(1, 1));
+  cache.Store({1}, {10});
+  cache.Store({2}, {20, 21});
+
+  std::vector<uint32_t> value;
+  EXPECT_TRUE(cache.Lookup({2}, &value));
+  EXPECT_THAT(value, Eq(std::vector<uint32_t>{20, 21}));
+  EXPECT_FALSE(cache.Lookup({1}, &value));
+
+  // It is removed once another entry is stored.
+  cache.Store({3}, {30});
+  EXPECT_TRUE(cache.Lookup({3}, &value));
+  EXPECT_FALSE(cache.Lookup({2}, &value));
+}
+
+}  // namespace
@@ -0,0 +1,191 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using ScalarReplacementTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %S "S"
+OpName %a "a"
+OpName %o "o"
+%void = OpTypeVoid
+%6 = OpTypeFunction %void
+%int = OpTypeInt 32 1
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%v2int = OpTypeVector %int 2
+%12 = OpConstantComposite %v2int %int_1 %int_2
+%_arr_int_int_2 = OpTypeArray %int %int_2
+%S = OpTypeStruct %int %_arr_int_int_2
+%_ptr_Function_S = OpTypePointer Function %S
+%_ptr_Function__arr_int_int_2 = OpTypePointer Function %_arr_int_int_2
+%_ptr_Function_v2int = OpTypePointer Function %v2int
+%_ptr_Function_int = OpTypePointer Function %int
+%_ptr_Input_int = OpTypePointer Input %int
+%a = OpVariable %_ptr_Input_int Input
+%_ptr_Output_S = OpTypePointer Output %S
+%o = OpVariable %_ptr_Output_S Output
+)";
+
+TEST_F(ScalarReplacementTest, SplitNestedAggregates) {
+  // struct S { int x; int y[2]; } s;
+  // s.x = a;
+  // s.y[1] = a;
+  // s.y[0] = 0;
+  // o = s;
+  //
+  // The struct is split into x and y, then y into its two elements. The load
+  // of the whole struct is rebuilt from the loads of the three elements.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%21 = OpVariable %_ptr_Function_S Function
+%22 = OpLoad %int %a
+%23 = OpAccessChain %_ptr_Function_int %21 %int_0
+OpStore %23 %22
+%24 = OpAccessChain %_ptr_Function_int %21 %int_1 %int_1
+OpStore %24 %22
+%25 = OpAccessChain %_ptr_Function_int %21 %int_1 %int_0
+OpStore %25 %int_0
+%26 = OpLoad %S %21
+OpStore %o %26
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%27 = OpVariable %_ptr_Function_int Function
+%34 = OpVariable %_ptr_Function_int Function
+%35 = OpVariable %_ptr_Function_int Function
+%22 = OpLoad %int %a
+OpStore %27 %22
+OpStore %35 %22
+OpStore %34 %int_0
+%31 = OpLoad %int %27
+%36 = OpLoad %int %34
+%37 = OpLoad %int %35
+%38 = OpCompositeConstruct %_arr_int_int_2 %36 %37
+%33 = OpCompositeConstruct %S %31 %38
+OpStore %o %33
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ScalarReplacementPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(ScalarReplacementTest, KeepDynamicallyIndexedArray) {
+  // struct S { int x; int y[2]; } s;
+  // s.y[a] = 1;
+  // s.x = a;
+  // o = s;
+  //
+  // The struct is split, but not y, which is accessed with a non-constant
+  // index.
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%21 = OpVariable %_ptr_Function_S Function
+%22 = OpLoad %int %a
+%23 = OpAccessChain %_ptr_Function_int %21 %int_1 %22
+OpStore %23 %int_1
+%24 = OpAccessChain %_ptr_Function_int %21 %int_0
+OpStore %24 %22
+%25 = OpLoad %S %21
+OpStore %o %25
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%26 = OpVariable %_ptr_Function_int Function
+%27 = OpVariable %_ptr_Function__arr_int_int_2 Function
+%22 = OpLoad %int %a
+%28 = OpAccessChain %_ptr_Function_int %27 %22
+OpStore %28 %int_1
+OpStore %26 %22
+%29 = OpLoad %int %26
+%30 = OpLoad %_arr_int_int_2 %27
+%31 = OpCompositeConstruct %S %29 %30
+OpStore %o %31
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ScalarReplacementPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+TEST_F(ScalarReplacementTest, SplitInitializer) {
+  // ivec2 v = ivec2(1, 2);
+  // v.y = a;
+  // o = S(a, int[2](v.x, v.y));
+  const std::string before =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%21 = OpVariable %_ptr_Function_v2int Function %12
+%22 = OpLoad %int %a
+%23 = OpAccessChain %_ptr_Function_int %21 %int_1
+OpStore %23 %22
+%24 = OpLoad %v2int %21
+%25 = OpCompositeExtract %int %24 0
+%26 = OpCompositeExtract %int %24 1
+%27 = OpCompositeConstruct %_arr_int_int_2 %25 %26
+%28 = OpCompositeConstruct %S %22 %27
+OpStore %o %28
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %6
+%20 = OpLabel
+%29 = OpVariable %_ptr_Function_int Function %int_1
+%30 = OpVariable %_ptr_Function_int Function %int_2
+%22 = OpLoad %int %a
+OpStore %30 %22
+%31 = OpLoad %int %29
+%32 = OpLoad %int %30
+%33 = OpCompositeConstruct %v2int %31 %32
+%25 = OpCompositeExtract %int %33 0
+%26 = OpCompositeExtract %int %33 1
+%27 = OpCompositeConstruct %_arr_int_int_2 %25 %26
+%28 = OpCompositeConstruct %S %22 %27
+OpStore %o %28
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ScalarReplacementPass>(
+      kPredefs + before, kPredefs + after, true, true);
+}
+
+}  // anonymous namespace
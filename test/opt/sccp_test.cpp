@@ -0,0 +1,323 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using SCCPTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %o %in
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %o "o"
+OpName %in "in"
+%void = OpTypeVoid
+%5 = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%v2int = OpTypeVector %int 2
+%int_0 = OpConstant %int 0
+%int_1 = OpConstant %int 1
+%int_2 = OpConstant %int 2
+%int_3 = OpConstant %int 3
+%int_10 = OpConstant %int 10
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+%_ptr_Input_int = OpTypePointer Input %int
+%in = OpVariable %_ptr_Input_int Input
+)";
+
+TEST_F(SCCPTest, FoldArithmeticAndBranch) {
+  // int x = 2 + 3;
+  // int r = 3;
+  // if (x < 10)
+  //   r = x * 2;
+  // o = r;
+
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpIAdd %int %int_2 %int_3
+%18 = OpSLessThan %bool %17 %int_10
+OpSelectionMerge %19 None
+OpBranchConditional %18 %20 %19
+%20 = OpLabel
+%21 = OpIMul %int %17 %int_2
+OpBranch %19
+%19 = OpLabel
+%22 = OpPhi %int %21 %20 %int_3 %16
+OpStore %o %22
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+OpBranch %20
+%20 = OpLabel
+OpBranch %19
+%19 = OpLabel
+OpStore %o %int_10
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(SCCPTest, UnreachableEdgeDoesNotSpoilPhi) {
+  // int r = 1;
+  // for (int i = 0; i < in; ++i) {
+  //   if (r != 1)
+  //     r = 2;
+  // }
+  // o = r;
+  //
+  // The store of 2 is never executed, so r is 1 throughout the loop.
+
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %int %in
+OpBranch %18
+%18 = OpLabel
+%19 = OpPhi %int %int_1 %16 %20 %21
+%22 = OpPhi %int %int_0 %16 %23 %21
+OpLoopMerge %24 %21 None
+OpBranch %25
+%25 = OpLabel
+%26 = OpSLessThan %bool %22 %17
+OpBranchConditional %26 %27 %24
+%27 = OpLabel
+%28 = OpINotEqual %bool %19 %int_1
+OpSelectionMerge %29 None
+OpBranchConditional %28 %30 %29
+%30 = OpLabel
+OpBranch %29
+%29 = OpLabel
+%20 = OpPhi %int %int_2 %30 %19 %27
+OpBranch %21
+%21 = OpLabel
+%23 = OpIAdd %int %22 %int_1
+OpBranch %18
+%24 = OpLabel
+OpStore %o %19
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %int %in
+OpBranch %18
+%18 = OpLabel
+%22 = OpPhi %int %int_0 %16 %23 %21
+OpLoopMerge %24 %21 None
+OpBranch %25
+%25 = OpLabel
+%26 = OpSLessThan %bool %22 %17
+OpBranchConditional %26 %27 %24
+%27 = OpLabel
+OpBranch %29
+%29 = OpLabel
+OpBranch %21
+%21 = OpLabel
+%23 = OpIAdd %int %22 %int_1
+OpBranch %18
+%24 = OpLabel
+OpStore %o %int_1
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(SCCPTest, SwitchOnExtractedConstant) {
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpCompositeConstruct %v2int %int_2 %int_3
+%18 = OpCompositeInsert %v2int %int_1 %17 0
+%19 = OpCompositeExtract %int %18 0
+OpSelectionMerge %20 None
+OpSwitch %19 %21 0 %22 1 %23
+%21 = OpLabel
+OpStore %o %int_0
+OpBranch %20
+%22 = OpLabel
+OpStore %o %int_10
+OpBranch %20
+%23 = OpLabel
+%24 = OpCompositeExtract %int %18 1
+OpStore %o %24
+OpBranch %20
+%20 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+OpBranch %23
+%23 = OpLabel
+OpStore %o %int_3
+OpBranch %20
+%20 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(SCCPTest, SelectOnFoldedCondition) {
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %int %in
+%18 = OpSGreaterThan %bool %int_2 %int_3
+%19 = OpLogicalNot %bool %18
+%20 = OpSelect %int %19 %int_10 %17
+OpStore %o %20
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %int %in
+OpStore %o %int_10
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(SCCPTest, LoopHeaderKeepsLoopMerge) {
+  // while (1 > 2) { o = 3; }
+
+  const std::string before =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+OpBranch %17
+%17 = OpLabel
+%18 = OpSGreaterThan %bool %int_1 %int_2
+OpLoopMerge %19 %20 None
+OpBranchConditional %18 %21 %19
+%21 = OpLabel
+OpStore %o %int_3
+OpBranch %20
+%20 = OpLabel
+OpBranch %17
+%19 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+OpBranch %17
+%17 = OpLabel
+OpLoopMerge %19 %20 None
+OpBranch %19
+%20 = OpLabel
+OpBranch %17
+%19 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + before, kPredefs + after,
+                                       true, true);
+}
+
+TEST_F(SCCPTest, NoFoldOfUndefinedResults) {
+  // Division by zero, and branches on values that are not constant, are
+  // left alone.
+
+  const std::string assembly =
+      R"(%main = OpFunction %void None %5
+%16 = OpLabel
+%17 = OpLoad %int %in
+%18 = OpSDiv %int %int_2 %int_0
+%19 = OpSLessThan %bool %17 %18
+OpSelectionMerge %20 None
+OpBranchConditional %19 %21 %20
+%21 = OpLabel
+OpStore %o %int_1
+OpBranch %20
+%20 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(kPredefs + assembly,
+                                       kPredefs + assembly, true, true);
+}
+
+TEST_F(SCCPTest, NoFoldOfWideIntegers) {
+  // Arithmetic and switches on integers wider than 32 bits are left alone.
+  const std::string assembly =
+      R"(OpCapability Shader
+OpCapability Int64
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %o
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %o "o"
+%void = OpTypeVoid
+%4 = OpTypeFunction %void
+%long = OpTypeInt 64 1
+%long_1 = OpConstant %long 1
+%long_2 = OpConstant %long 2
+%_ptr_Output_long = OpTypePointer Output %long
+%o = OpVariable %_ptr_Output_long Output
+%main = OpFunction %void None %4
+%9 = OpLabel
+%10 = OpIAdd %long %long_1 %long_2
+OpSelectionMerge %11 None
+OpSwitch %long_1 %12 1 %13
+%12 = OpLabel
+OpStore %o %10
+OpBranch %11
+%13 = OpLabel
+OpStore %o %long_2
+OpBranch %11
+%11 = OpLabel
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::SCCPPass>(assembly, assembly, true, true);
+}
+
+}  // anonymous namespace
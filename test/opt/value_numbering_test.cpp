@@ -0,0 +1,252 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "pass_fixture.h"
+#include "pass_utils.h"
+
+namespace {
+
+using namespace spvtools;
+
+using ValueNumberingTest = PassTest<::testing::Test>;
+
+const std::string kPredefs =
+    R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %a %b %o %arr
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %a "a"
+OpName %b "b"
+OpName %o "o"
+OpName %arr "arr"
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%bool = OpTypeBool
+%int = OpTypeInt 32 1
+%float = OpTypeFloat 32
+%uint = OpTypeInt 32 0
+%uint_4 = OpConstant %uint 4
+%_arr_float_uint_4 = OpTypeArray %float %uint_4
+%_ptr_Input_int = OpTypePointer Input %int
+%a = OpVariable %_ptr_Input_int Input
+%b = OpVariable %_ptr_Input_int Input
+%_ptr_Output_int = OpTypePointer Output %int
+%o = OpVariable %_ptr_Output_int Output
+%_ptr_Output__arr_float_uint_4 = OpTypePointer Output %_arr_float_uint_4
+%arr = OpVariable %_ptr_Output__arr_float_uint_4 Output
+%_ptr_Output_float = OpTypePointer Output %float
+%float_1 = OpConstant %float 1
+)";
+
+TEST_F(ValueNumberingTest, RedundantArithmetic) {
+  // The second sum has its operands swapped, and the product of the second
+  // sum is then equal to the first product as well.
+  const std::string before =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpLoad %int %b
+%22 = OpIAdd %int %20 %21
+%23 = OpIMul %int %22 %22
+%24 = OpIAdd %int %21 %20
+%25 = OpIMul %int %24 %24
+%26 = OpISub %int %23 %25
+%27 = OpISub %int %25 %23
+%28 = OpIAdd %int %26 %27
+OpStore %o %28
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpLoad %int %b
+%22 = OpIAdd %int %20 %21
+%23 = OpIMul %int %22 %22
+%26 = OpISub %int %23 %23
+%28 = OpIAdd %int %26 %26
+OpStore %o %28
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ValueNumberingPass>(kPredefs + before,
+                                                 kPredefs + after, true, true);
+}
+
+TEST_F(ValueNumberingTest, OnlyDominatingComputationsAreReused) {
+  // The sum in the entry block is reused in both arms of the selection and
+  // after it. The product in the then-block does not dominate the else-block
+  // or the merge block, so the products there are kept; the one in the
+  // merge block is not redundant with the one in the else-block either.
+  const std::string before =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpLoad %int %b
+%22 = OpIAdd %int %20 %21
+%23 = OpSLessThan %bool %20 %21
+OpSelectionMerge %24 None
+OpBranchConditional %23 %25 %26
+%25 = OpLabel
+%27 = OpIAdd %int %20 %21
+%28 = OpIMul %int %27 %21
+OpStore %o %28
+OpBranch %24
+%26 = OpLabel
+%29 = OpIMul %int %22 %21
+OpStore %o %29
+OpBranch %24
+%24 = OpLabel
+%30 = OpIAdd %int %21 %20
+%31 = OpIMul %int %30 %21
+OpStore %o %31
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpLoad %int %b
+%22 = OpIAdd %int %20 %21
+%23 = OpSLessThan %bool %20 %21
+OpSelectionMerge %24 None
+OpBranchConditional %23 %25 %26
+%25 = OpLabel
+%28 = OpIMul %int %22 %21
+OpStore %o %28
+OpBranch %24
+%26 = OpLabel
+%29 = OpIMul %int %22 %21
+OpStore %o %29
+OpBranch %24
+%24 = OpLabel
+%31 = OpIMul %int %22 %21
+OpStore %o %31
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ValueNumberingPass>(kPredefs + before,
+                                                 kPredefs + after, true, true);
+}
+
+TEST_F(ValueNumberingTest, AccessChainsAndLoads) {
+  // The access chains are equal, but the loads through them are not
+  // numbered: the store in between may change the value read.
+  const std::string before =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpAccessChain %_ptr_Output_float %arr %20
+%22 = OpLoad %float %21
+%23 = OpFAdd %float %22 %float_1
+OpStore %21 %23
+%24 = OpAccessChain %_ptr_Output_float %arr %20
+%25 = OpLoad %float %24
+%26 = OpFAdd %float %25 %float_1
+OpStore %24 %26
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string after =
+      R"(%main = OpFunction %void None %7
+%19 = OpLabel
+%20 = OpLoad %int %a
+%21 = OpAccessChain %_ptr_Output_float %arr %20
+%22 = OpLoad %float %21
+%23 = OpFAdd %float %22 %float_1
+OpStore %21 %23
+%25 = OpLoad %float %21
+%26 = OpFAdd %float %25 %float_1
+OpStore %21 %26
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ValueNumberingPass>(kPredefs + before,
+                                                 kPredefs + after, true, true);
+}
+
+TEST_F(ValueNumberingTest, DecorationsMustMatch) {
+  // Only the products with the same decorations are merged.
+  const std::string assembly =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %f %g
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %g "g"
+OpDecorate %4 NoContraction
+OpDecorate %5 NoContraction
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%f = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%g = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %7
+%11 = OpLabel
+%12 = OpLoad %float %f
+%4 = OpFMul %float %12 %12
+%13 = OpFMul %float %12 %12
+%5 = OpFMul %float %12 %12
+%14 = OpFAdd %float %4 %13
+%15 = OpFAdd %float %14 %5
+OpStore %g %15
+OpReturn
+OpFunctionEnd
+)";
+
+  const std::string expected =
+      R"(OpCapability Shader
+OpMemoryModel Logical GLSL450
+OpEntryPoint Fragment %main "main" %f %g
+OpExecutionMode %main OriginUpperLeft
+OpName %main "main"
+OpName %f "f"
+OpName %g "g"
+OpDecorate %4 NoContraction
+%void = OpTypeVoid
+%7 = OpTypeFunction %void
+%float = OpTypeFloat 32
+%_ptr_Input_float = OpTypePointer Input %float
+%f = OpVariable %_ptr_Input_float Input
+%_ptr_Output_float = OpTypePointer Output %float
+%g = OpVariable %_ptr_Output_float Output
+%main = OpFunction %void None %7
+%11 = OpLabel
+%12 = OpLoad %float %f
+%4 = OpFMul %float %12 %12
+%13 = OpFMul %float %12 %12
+%14 = OpFAdd %float %4 %13
+%15 = OpFAdd %float %14 %4
+OpStore %g %15
+OpReturn
+OpFunctionEnd
+)";
+
+  SinglePassRunAndCheck<opt::ValueNumberingPass>(assembly, expected, true,
+                                                 true);
+}
+
+}  // anonymous namespace
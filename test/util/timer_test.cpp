@@ -0,0 +1,73 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <memory>
+#include <sstream>
+#include <string>
+
+#include "gmock/gmock.h"
+
+#include "util/alloc_counter.h"
+#include "util/timer.h"
+
+namespace {
+
+using ::testing::HasSubstr;
+using ::testing::MatchesRegex;
+using spvutils::AllocationCountingEnabled;
+using spvutils::AllocationStats;
+using spvutils::GetAllocationStats;
+using spvutils::ScopedTimer;
+
+TEST(ScopedTimerTest, NullStreamPrintsNothing) {
+  // Must not crash.
+  ScopedTimer timer(nullptr, "phase");
+}
+
+TEST(ScopedTimerTest, ReportsOneLineOnDestruction) {
+  std::ostringstream out;
+  {
+    ScopedTimer timer(&out, "phase");
+    EXPECT_EQ("", out.str());
+  }
+  const std::string report = out.str();
+  EXPECT_THAT(report, MatchesRegex("phase: [0-9]+\\.[0-9]{3} ms.*\n"));
+  if (AllocationCountingEnabled()) {
+    EXPECT_THAT(report, HasSubstr(" allocations, "));
+  } else {
+    EXPECT_THAT(report, ::testing::Not(HasSubstr("allocations")));
+  }
+}
+
+TEST(ScopedTimerTest, RestoresStreamFormat) {
+  std::ostringstream out;
+  { ScopedTimer timer(&out, "phase"); }
+  out << 1.5;
+  EXPECT_THAT(out.str(), HasSubstr("\n1.5"));
+}
+
+TEST(AllocationCounterTest, CountsAllocationsWhenEnabled) {
+  const AllocationStats before = GetAllocationStats();
+  std::unique_ptr<int> p(new int(1));
+  const AllocationStats allocated = GetAllocationStats() - before;
+  if (AllocationCountingEnabled()) {
+    EXPECT_LE(1u, allocated.count);
+    EXPECT_LE(sizeof(int), allocated.bytes);
+  } else {
+    EXPECT_EQ(0u, allocated.count);
+    EXPECT_EQ(0u, allocated.bytes);
+  }
+}
+
+}  // anonymous namespace
@@ -0,0 +1,100 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+// Tests for splitting the inputs of spirv-val into modules.
+
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "spirv-tools/libspirv.hpp"
+#include "spirv/1.2/spirv.h"
+#include "tools/val/module_split.h"
+
+namespace {
+
+using spvtools::SpirvTools;
+
+std::vector<uint32_t> Assemble(const char* text) {
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+  std::vector<uint32_t> binary;
+  EXPECT_TRUE(tools.Assemble(text, &binary));
+  return binary;
+}
+
+const char kFirst[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%void = OpTypeVoid
+)";
+
+const char kSecond[] = R"(
+OpCapability Shader
+OpCapability Linkage
+OpMemoryModel Logical GLSL450
+%float = OpTypeFloat 32
+%int = OpTypeInt 32 1
+)";
+
+TEST(SplitModules, SingleModule) {
+  const std::vector<uint32_t> words = Assemble(kFirst);
+  std::vector<ModuleSlice> slices;
+  SplitModules(3, words, &slices);
+  ASSERT_EQ(1u, slices.size());
+  EXPECT_EQ(3u, slices[0].file_index);
+  EXPECT_EQ(0u, slices[0].offset);
+  EXPECT_EQ(words.size(), slices[0].size);
+}
+
+TEST(SplitModules, TwoModuleContainer) {
+  const std::vector<uint32_t> first = Assemble(kFirst);
+  const std::vector<uint32_t> second = Assemble(kSecond);
+  std::vector<uint32_t> words = first;
+  words.insert(words.end(), second.begin(), second.end());
+
+  std::vector<ModuleSlice> slices;
+  SplitModules(0, words, &slices);
+  ASSERT_EQ(2u, slices.size());
+  EXPECT_EQ(0u, slices[0].offset);
+  EXPECT_EQ(first.size(), slices[0].size);
+  EXPECT_EQ(first.size(), slices[1].offset);
+  EXPECT_EQ(second.size(), slices[1].size);
+
+  SpirvTools tools(SPV_ENV_UNIVERSAL_1_2);
+  for (const auto& slice : slices) {
+    EXPECT_TRUE(tools.Validate(words.data() + slice.offset, slice.size));
+  }
+}
+
+TEST(SplitModules, GarbageStaysWithModule) {
+  std::vector<uint32_t> words = Assemble(kFirst);
+  const size_t module_size = words.size();
+  words.push_back(0);
+  words.push_back(SpvMagicNumber);
+
+  std::vector<ModuleSlice> slices;
+  SplitModules(0, words, &slices);
+  ASSERT_EQ(1u, slices.size());
+  EXPECT_EQ(module_size + 2, slices[0].size);
+}
+
+TEST(SplitModules, NotSpirv) {
+  const std::vector<uint32_t> words = {1, 2, 3};
+  std::vector<ModuleSlice> slices;
+  SplitModules(0, words, &slices);
+  ASSERT_EQ(1u, slices.size());
+  EXPECT_EQ(3u, slices[0].size);
+}
+
+}  // anonymous namespace
@@ -14,19 +14,29 @@
 
 #include <spirv_validator_options.h>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <memory>
+#include <mutex>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "opt/set_spec_constant_default_value_pass.h"
 #include "spirv-tools/optimizer.hpp"
+#include "util/timer.h"
 
 #include "message.h"
 #include "tools/io.h"
+#include "tuner.h"
 
 using namespace spvtools;
 
@@ -40,6 +50,29 @@ struct OptStatus {
   int code;
 };
 
+// The flags -Os stands for, in order.
+const char* const kSizeFlags[] = {
+    "--merge-identical-functions",
+    "--inline-entry-points-selective",
+    "--eliminate-dead-functions",
+    "--convert-local-access-chains",
+    "--eliminate-local-single-block",
+    "--eliminate-local-single-store",
+    "--eliminate-insert-extract",
+    "--eliminate-dead-code-aggressive",
+    "--eliminate-dead-branches",
+    "--merge-blocks",
+    "--eliminate-local-multi-store",
+    "--copy-propagation",
+    "--combine-instructions",
+    "--eliminate-insert-extract",
+    "--eliminate-common-uniform",
+    "--eliminate-dead-variables",
+};
+
+bool RegisterPasses(const std::vector<std::string>& pass_flags,
+                    Optimizer* optimizer);
+
 std::string GetListOfPassesAsString(const spvtools::Optimizer& optimizer) {
   std::stringstream ss;
   for (const auto& name : optimizer.GetPassNames()) {
@@ -56,7 +89,7 @@ std::string GetOptimizationPasses() {
 
 std::string GetSizePasses() {
   spvtools::Optimizer optimizer(SPV_ENV_UNIVERSAL_1_2);
-  optimizer.RegisterSizePasses();
+  RegisterPasses({std::begin(kSizeFlags), std::end(kSizeFlags)}, &optimizer);
   return GetListOfPassesAsString(optimizer);
 }
 
@@ -65,12 +98,17 @@ void PrintUsage(const char* program) {
       R"(%s - Optimize a SPIR-V binary file.
 
 USAGE: %s [options] [<input>] -o <output>
+       %s [options] [<input>...] [--batch <list-file>] --out-dir <dir>
 
 The SPIR-V binary is read from <input>. If no file is specified,
 or if <input> is "-", then the binary is read from standard input.
 if <output> is "-", then the optimized output is written to
 standard output.
 
+In batch mode, every <input> and every file named in <list-file> is
+optimized with the same passes, and the result is written to a file
+with the same base name in <dir>. Modules are optimized concurrently.
+
 NOTE: The optimizer is a work in progress.
 
 Options:
@@ -108,6 +146,13 @@ Options:
                Exhaustively inline all function calls in entry point call tree
                functions. Currently does not inline calls to functions with
                early return in a loop.
+  --inline-entry-points-selective[=<percent>]
+               Inline function calls in entry point call tree functions,
+               callees first, when they do not grow the module, when they
+               have opaque arguments or return type, or when the growth fits
+               in a budget of <percent> percent of the module size, 25 by
+               default. Calls with constant arguments and calls to functions
+               called only once are favored.
   --convert-local-access-chains
                Convert constant index access chain loads/stores into
                equivalent load/stores with inserts and extracts. Performed
@@ -154,12 +199,120 @@ Options:
                call tree functions.
   --strength-reduction
                Replaces instructions with equivalent and less expensive ones.
+  --sccp
+               Propagate constants through SSA values and the control flow
+               edges that can be taken, replace constant results with
+               constants, and delete the code made unreachable. Performed
+               on entry point call tree functions and exported functions.
+  --value-numbering
+               Replace computations without side effects that repeat the
+               computation of a dominating instruction with its result.
+               Performed on entry point call tree functions and exported
+               functions.
+  --loop-invariant-code-motion
+               Move the computations of a loop that do not depend on values
+               computed in the loop to the block before the loop. Performed
+               on entry point call tree functions and exported functions.
+  --loop-unroll[=<budget>]
+               Unroll structured loops. Loops with a constant number of
+               iterations are replaced by a copy of their body per iteration
+               when the copies have at most <budget> instructions, 256 by
+               default. Other innermost loops get up to four copies of their
+               body within the budget. Performed on entry point call tree
+               functions and exported functions.
+  --scalar-replacement
+               Replace each function scope variable of composite type that
+               is only accessed with constant indices by one variable per
+               element, so that the local store elimination passes can
+               handle them. Performed on entry point call tree functions and
+               exported functions.
+  --merge-identical-functions
+               Make the calls to functions that are identical up to the
+               renaming of their ids call the first of them, leaving the
+               others for --eliminate-dead-functions to remove. Entry points
+               and functions with decorations are not merged.
+  --eliminate-dead-stores
+               Delete stores to function and private variables that are
+               overwritten on every path before being read, or never read,
+               including stores to parts of variables through access chains
+               with constant indices. Performed on entry point call tree
+               functions and exported functions.
+  --if-conversion[=<size>]
+               Replace structured selections whose arms are at most one
+               block without side effects, and have at most <size>
+               instructions, 8 by default, by OpSelect instructions, then
+               merge the merge block into the header of the selection.
+               Performed on entry point call tree functions and exported
+               functions.
+  --copy-propagation
+               Replace the uses of OpCopyObject instructions and of phis
+               taking a single value, possibly through other phis, by that
+               value. Performed on entry point call tree functions and
+               exported functions.
+  --combine-instructions
+               Replace arithmetic, logical, comparison and conversion
+               instructions with constant operands by their value, and
+               apply algebraic identities such as x + 0 = x, until no more
+               instruction changes. Performed on entry point call tree
+               functions and exported functions.
   --eliminate-dead-variables
                Deletes module scope variables that are not referenced.
+  --fixed-point-begin[=<n>]
+               Repeat the transformations given after this flag, up to the
+               next --fixed-point-begin or --fixed-point-end flag, until
+               they no longer change the module, at most <n> times, 4 by
+               default. Repeated transformations performed on call tree
+               functions skip the functions they left unchanged, unless
+               another transformation changed them since.
+  --fixed-point-end
+               End the transformations repeated by --fixed-point-begin.
   --relax-store-struct
                Allow store from one struct type to a different type with
                compatible layout and members. This option is forwarded to the
                validator.
+  --batch <list-file>
+               Optimize the modules named in <list-file>, one file name per
+               line, in addition to those given on the command line. Blank
+               lines and lines starting with '#' are ignored. Requires
+               --out-dir.
+  --out-dir <dir>
+               Write the optimized version of each input to <dir>, under the
+               input's base name. Enables batch mode.
+  -j <N>
+               Use <N> worker threads. In batch mode, they optimize several
+               modules at once, and default to the number of hardware
+               threads. Otherwise, function-local passes process several
+               functions of the module at once, and the default is 1.
+  --time-report
+               Print the wall time of validation, of building the module, of
+               each pass and of writing the result to standard error. In a
+               build configured with SPIRV_COUNT_ALLOCATIONS=ON, also print
+               the number and size of the heap allocations of each of them.
+               Cannot be used in batch mode.
+  --cache-dir <dir>
+               Keep the optimized modules in <dir>, and reuse them when the
+               same module is optimized again with the same options, instead
+               of optimizing it. The cache is limited to 256 MiB, dropping
+               the least recently used modules first.
+  --incremental
+               With --cache-dir, also keep the result of each sequence of
+               function-local passes on each function, and reuse it for the
+               functions that did not change, so that small edits of large
+               modules are optimized quickly.
+  --tune=<metric>
+               Instead of optimizing, search for a sequence of the
+               transformations given by the other flags, in any order and
+               possibly repeated, minimizing <metric> over the input
+               modules: "words" for their size, or "instructions" for their
+               number of instructions. Each flag is a candidate, and -O and
+               -Os are candidates as a whole. Without other flags, the
+               transformations of -Os, --eliminate-dead-stores,
+               --if-conversion and --scalar-replacement are candidates. The
+               inputs are given as in batch mode. The sequence found is
+               written to the -o file, or to standard output, in the format
+               of -Oconfig files, and the progress of the search to standard
+               error. Candidates are tried on -j threads at once, by
+               default the number of hardware threads.
   -O
                Optimize for performance. Apply a sequence of transformations
                in an attempt to improve the performance of the generated
@@ -208,7 +361,7 @@ Options:
   --version
                Display optimizer version information.
 )",
-      program, program, GetOptimizationPasses().c_str(),
+      program, program, program, GetOptimizationPasses().c_str(),
       GetSizePasses().c_str());
 }
 
@@ -246,19 +399,43 @@ bool ReadFlagsFromFile(const char* oconfig_flag,
   return true;
 }
 
-OptStatus ParseFlags(int argc, const char** argv, Optimizer* optimizer,
-                     const char** in_file, const char** out_file,
+// Command-line settings other than the optimization passes themselves.
+struct OptSettings {
+  OptSettings() : out_file(nullptr), batch_file(nullptr), out_dir(nullptr),
+                  cache_dir(nullptr), tune_metric(nullptr), num_jobs(0),
+                  time_report(false), incremental(false) {}
+
+  std::vector<std::string> in_files;  // Input files, in command-line order.
+  const char* out_file;    // Output file, when optimizing a single module.
+  const char* batch_file;  // File listing the inputs of a batch, if any.
+  const char* out_dir;     // Output directory, when optimizing a batch.
+  const char* cache_dir;   // Result cache directory, if any.
+  const char* tune_metric;  // Metric minimized by --tune, if given.
+  uint32_t num_jobs;       // Number of worker threads; 0 picks a default.
+  bool time_report;        // Whether to report the cost of each phase.
+  bool incremental;        // Whether to cache the results for functions.
+};
+
+// Maximum size of the result cache, in bytes.
+const uint64_t kResultCacheSize = 256 << 20;
+
+// Serializes diagnostics written by concurrently running optimizations.
+std::mutex output_mutex;
+
+OptStatus ParseFlags(int argc, const char** argv, OptSettings* settings,
+                     std::vector<std::string>* pass_flags,
                      spv_validator_options options);
 
 // Parses and handles the -Oconfig flag. |prog_name| contains the name of
 // the spirv-opt binary (used to build a new argv vector for the recursive
 // invocation to ParseFlags). |opt_flag| contains the -Oconfig=FILENAME flag.
-// |optimizer|, |in_file| and |out_file| are as in ParseFlags.
+// |settings|, |pass_flags| and |options| are as in ParseFlags.
 //
 // This returns the same OptStatus instance returned by ParseFlags.
 OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
-                           Optimizer* optimizer, const char** in_file,
-                           const char** out_file) {
+                           OptSettings* settings,
+                           std::vector<std::string>* pass_flags,
+                           spv_validator_options options) {
   std::vector<std::string> flags;
   flags.push_back(prog_name);
 
@@ -270,7 +447,7 @@ OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
   }
   flags.insert(flags.end(), file_flags.begin(), file_flags.end());
 
-  const char** new_argv = new const char*[flags.size()];
+  std::vector<const char*> new_argv(flags.size());
   for (size_t i = 0; i < flags.size(); i++) {
     if (flags[i].find("-Oconfig=") != std::string::npos) {
       fprintf(stderr,
@@ -281,20 +458,20 @@ OptStatus ParseOconfigFlag(const char* prog_name, const char* opt_flag,
     new_argv[i] = flags[i].c_str();
   }
 
-  return ParseFlags(static_cast<int>(flags.size()), new_argv, optimizer,
-                    in_file, out_file, nullptr);
+  return ParseFlags(static_cast<int>(flags.size()), new_argv.data(), settings,
+                    pass_flags, options);
 }
 
 // Parses command-line flags. |argc| contains the number of command-line flags.
-// |argv| points to an array of strings holding the flags. |optimizer| is the
-// Optimizer instance used to optimize the program.
+// |argv| points to an array of strings holding the flags.
 //
-// On return, this function stores the name of the input program in |in_file|.
-// The name of the output file in |out_file|. The return value indicates whether
-// optimization should continue and a status code indicating an error or
-// success.
-OptStatus ParseFlags(int argc, const char** argv, Optimizer* optimizer,
-                     const char** in_file, const char** out_file,
+// On return, the input and output files and the batch settings are stored in
+// |settings|, and the flags naming optimization passes are appended to
+// |pass_flags| in the order they must be applied. Pass flags are checked by
+// RegisterPasses(). The return value indicates whether optimization should
+// continue and a status code indicating an error or success.
+OptStatus ParseFlags(int argc, const char** argv, OptSettings* settings,
+                     std::vector<std::string>* pass_flags,
                      spv_validator_options options) {
   for (int argi = 1; argi < argc; ++argi) {
     const char* cur_arg = argv[argi];
@@ -306,170 +483,312 @@ OptStatus ParseFlags(int argc, const char** argv, Optimizer* optimizer,
         PrintUsage(argv[0]);
         return {OPT_STOP, 0};
       } else if (0 == strcmp(cur_arg, "-o")) {
-        if (!*out_file && argi + 1 < argc) {
-          *out_file = argv[++argi];
+        if (!settings->out_file && argi + 1 < argc) {
+          settings->out_file = argv[++argi];
         } else {
           PrintUsage(argv[0]);
           return {OPT_STOP, 1};
         }
-      } else if (0 == strcmp(cur_arg, "--strip-debug")) {
-        optimizer->RegisterPass(CreateStripDebugInfoPass());
+      } else if (0 == strcmp(cur_arg, "--batch")) {
+        if (!settings->batch_file && argi + 1 < argc) {
+          settings->batch_file = argv[++argi];
+        } else {
+          fprintf(stderr, "error: Expected one list file after --batch\n");
+          return {OPT_STOP, 1};
+        }
+      } else if (0 == strcmp(cur_arg, "--out-dir")) {
+        if (!settings->out_dir && argi + 1 < argc) {
+          settings->out_dir = argv[++argi];
+        } else {
+          fprintf(stderr, "error: Expected one directory after --out-dir\n");
+          return {OPT_STOP, 1};
+        }
+      } else if (0 == strcmp(cur_arg, "--cache-dir")) {
+        if (!settings->cache_dir && argi + 1 < argc) {
+          settings->cache_dir = argv[++argi];
+        } else {
+          fprintf(stderr, "error: Expected one directory after --cache-dir\n");
+          return {OPT_STOP, 1};
+        }
+      } else if (0 == strcmp(cur_arg, "--incremental")) {
+        settings->incremental = true;
+      } else if (0 == strncmp(cur_arg, "--tune=", sizeof("--tune=") - 1)) {
+        settings->tune_metric = cur_arg + sizeof("--tune=") - 1;
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        int num_jobs = 0;
+        if (argi + 1 < argc) num_jobs = atoi(argv[++argi]);
+        if (num_jobs <= 0) {
+          fprintf(stderr, "error: Expected a positive number after -j\n");
+          return {OPT_STOP, 1};
+        }
+        settings->num_jobs = static_cast<uint32_t>(num_jobs);
       } else if (0 == strcmp(cur_arg, "--set-spec-const-default-value")) {
         if (++argi < argc) {
-          auto spec_ids_vals =
-              opt::SetSpecConstantDefaultValuePass::ParseDefaultValuesString(
-                  argv[argi]);
-          if (!spec_ids_vals) {
-            fprintf(stderr,
-                    "error: Invalid argument for "
-                    "--set-spec-const-default-value: %s\n",
-                    argv[argi]);
-            return {OPT_STOP, 1};
-          }
-          optimizer->RegisterPass(
-              CreateSetSpecConstantDefaultValuePass(std::move(*spec_ids_vals)));
+          pass_flags->push_back(cur_arg);
+          pass_flags->push_back(argv[argi]);
         } else {
           fprintf(
               stderr,
               "error: Expected a string of <spec id>:<default value> pairs.");
           return {OPT_STOP, 1};
         }
-      } else if (0 == strcmp(cur_arg, "--freeze-spec-const")) {
-        optimizer->RegisterPass(CreateFreezeSpecConstantValuePass());
-      } else if (0 == strcmp(cur_arg, "--inline-entry-points-exhaustive")) {
-        optimizer->RegisterPass(CreateInlineExhaustivePass());
-      } else if (0 == strcmp(cur_arg, "--inline-entry-points-opaque")) {
-        optimizer->RegisterPass(CreateInlineOpaquePass());
-      } else if (0 == strcmp(cur_arg, "--convert-local-access-chains")) {
-        optimizer->RegisterPass(CreateLocalAccessChainConvertPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-dead-code-aggressive")) {
-        optimizer->RegisterPass(CreateAggressiveDCEPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-insert-extract")) {
-        optimizer->RegisterPass(CreateInsertExtractElimPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-local-single-block")) {
-        optimizer->RegisterPass(CreateLocalSingleBlockLoadStoreElimPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-local-single-store")) {
-        optimizer->RegisterPass(CreateLocalSingleStoreElimPass());
-      } else if (0 == strcmp(cur_arg, "--merge-blocks")) {
-        optimizer->RegisterPass(CreateBlockMergePass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-dead-branches")) {
-        optimizer->RegisterPass(CreateDeadBranchElimPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-dead-functions")) {
-        optimizer->RegisterPass(CreateEliminateDeadFunctionsPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-local-multi-store")) {
-        optimizer->RegisterPass(CreateLocalMultiStoreElimPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-common-uniform")) {
-        optimizer->RegisterPass(CreateCommonUniformElimPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-dead-const")) {
-        optimizer->RegisterPass(CreateEliminateDeadConstantPass());
-      } else if (0 == strcmp(cur_arg, "--eliminate-dead-variables")) {
-        optimizer->RegisterPass(CreateDeadVariableEliminationPass());
-      } else if (0 == strcmp(cur_arg, "--fold-spec-const-op-composite")) {
-        optimizer->RegisterPass(CreateFoldSpecConstantOpAndCompositePass());
-      } else if (0 == strcmp(cur_arg, "--strength-reduction")) {
-        optimizer->RegisterPass(CreateStrengthReductionPass());
-      } else if (0 == strcmp(cur_arg, "--unify-const")) {
-        optimizer->RegisterPass(CreateUnifyConstantPass());
-      } else if (0 == strcmp(cur_arg, "--flatten-decorations")) {
-        optimizer->RegisterPass(CreateFlattenDecorationPass());
-      } else if (0 == strcmp(cur_arg, "--compact-ids")) {
-        optimizer->RegisterPass(CreateCompactIdsPass());
-      } else if (0 == strcmp(cur_arg, "--cfg-cleanup")) {
-        optimizer->RegisterPass(CreateCFGCleanupPass());
       } else if (0 == strcmp(cur_arg, "--relax-store-struct")) {
         options->relax_struct_store = true;
-      } else if (0 == strcmp(cur_arg, "-O")) {
-        optimizer->RegisterPerformancePasses();
-      } else if (0 == strcmp(cur_arg, "-Os")) {
-        optimizer->RegisterSizePasses();
+      } else if (0 == strcmp(cur_arg, "--time-report")) {
+        settings->time_report = true;
       } else if (0 == strncmp(cur_arg, "-Oconfig=", sizeof("-Oconfig=") - 1)) {
-        OptStatus status =
-            ParseOconfigFlag(argv[0], cur_arg, optimizer, in_file, out_file);
+        OptStatus status = ParseOconfigFlag(argv[0], cur_arg, settings,
+                                            pass_flags, options);
         if (status.action != OPT_CONTINUE) {
           return status;
         }
       } else if ('\0' == cur_arg[1]) {
         // Setting a filename of "-" to indicate stdin.
-        if (!*in_file) {
-          *in_file = cur_arg;
-        } else {
-          fprintf(stderr, "error: More than one input file specified\n");
-          return {OPT_STOP, 1};
-        }
+        settings->in_files.push_back(cur_arg);
       } else {
-        fprintf(
-            stderr,
-            "error: Unknown flag '%s'. Use --help for a list of valid flags\n",
-            cur_arg);
-        return {OPT_STOP, 1};
+        pass_flags->push_back(cur_arg);
       }
     } else {
-      if (!*in_file) {
-        *in_file = cur_arg;
-      } else {
-        fprintf(stderr, "error: More than one input file specified\n");
-        return {OPT_STOP, 1};
-      }
+      settings->in_files.push_back(cur_arg);
     }
   }
 
   return {OPT_CONTINUE, 0};
 }
 
-}  // namespace
-
-int main(int argc, const char** argv) {
-  const char* in_file = nullptr;
-  const char* out_file = nullptr;
+// Registers the passes named by |pass_flags| with |optimizer|, in order.
+// Returns false and reports an error if a flag is not recognized.
+bool RegisterPasses(const std::vector<std::string>& pass_flags,
+                    Optimizer* optimizer) {
+  for (size_t i = 0; i < pass_flags.size(); ++i) {
+    const char* cur_arg = pass_flags[i].c_str();
+    if (0 == strcmp(cur_arg, "--strip-debug")) {
+      optimizer->RegisterPass(CreateStripDebugInfoPass());
+    } else if (0 == strcmp(cur_arg, "--set-spec-const-default-value")) {
+      const char* spec_arg = pass_flags[++i].c_str();
+      auto spec_ids_vals =
+          opt::SetSpecConstantDefaultValuePass::ParseDefaultValuesString(
+              spec_arg);
+      if (!spec_ids_vals) {
+        fprintf(stderr,
+                "error: Invalid argument for "
+                "--set-spec-const-default-value: %s\n",
+                spec_arg);
+        return false;
+      }
+      optimizer->RegisterPass(
+          CreateSetSpecConstantDefaultValuePass(std::move(*spec_ids_vals)));
+    } else if (0 == strcmp(cur_arg, "--freeze-spec-const")) {
+      optimizer->RegisterPass(CreateFreezeSpecConstantValuePass());
+    } else if (0 == strcmp(cur_arg, "--inline-entry-points-exhaustive")) {
+      optimizer->RegisterPass(CreateInlineExhaustivePass());
+    } else if (0 == strcmp(cur_arg, "--inline-entry-points-opaque")) {
+      optimizer->RegisterPass(CreateInlineOpaquePass());
+    } else if (0 == strcmp(cur_arg, "--inline-entry-points-selective")) {
+      optimizer->RegisterPass(CreateInlineSelectivePass());
+    } else if (0 == strncmp(cur_arg, "--inline-entry-points-selective=",
+                            sizeof("--inline-entry-points-selective=") - 1)) {
+      const char* percent_arg =
+          cur_arg + sizeof("--inline-entry-points-selective=") - 1;
+      char* end = nullptr;
+      const unsigned long percent = strtoul(percent_arg, &end, 10);
+      if (*percent_arg == '\0' || *end != '\0' || percent > UINT32_MAX) {
+        fprintf(stderr,
+                "error: Invalid argument for "
+                "--inline-entry-points-selective: %s\n",
+                percent_arg);
+        return false;
+      }
+      optimizer->RegisterPass(
+          CreateInlineSelectivePass(static_cast<uint32_t>(percent)));
+    } else if (0 == strcmp(cur_arg, "--convert-local-access-chains")) {
+      optimizer->RegisterPass(CreateLocalAccessChainConvertPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-code-aggressive")) {
+      optimizer->RegisterPass(CreateAggressiveDCEPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-insert-extract")) {
+      optimizer->RegisterPass(CreateInsertExtractElimPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-local-single-block")) {
+      optimizer->RegisterPass(CreateLocalSingleBlockLoadStoreElimPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-local-single-store")) {
+      optimizer->RegisterPass(CreateLocalSingleStoreElimPass());
+    } else if (0 == strcmp(cur_arg, "--merge-blocks")) {
+      optimizer->RegisterPass(CreateBlockMergePass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-branches")) {
+      optimizer->RegisterPass(CreateDeadBranchElimPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-functions")) {
+      optimizer->RegisterPass(CreateEliminateDeadFunctionsPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-local-multi-store")) {
+      optimizer->RegisterPass(CreateLocalMultiStoreElimPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-common-uniform")) {
+      optimizer->RegisterPass(CreateCommonUniformElimPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-const")) {
+      optimizer->RegisterPass(CreateEliminateDeadConstantPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-variables")) {
+      optimizer->RegisterPass(CreateDeadVariableEliminationPass());
+    } else if (0 == strcmp(cur_arg, "--fold-spec-const-op-composite")) {
+      optimizer->RegisterPass(CreateFoldSpecConstantOpAndCompositePass());
+    } else if (0 == strcmp(cur_arg, "--strength-reduction")) {
+      optimizer->RegisterPass(CreateStrengthReductionPass());
+    } else if (0 == strcmp(cur_arg, "--sccp")) {
+      optimizer->RegisterPass(CreateSCCPPass());
+    } else if (0 == strcmp(cur_arg, "--value-numbering")) {
+      optimizer->RegisterPass(CreateValueNumberingPass());
+    } else if (0 == strcmp(cur_arg, "--loop-invariant-code-motion")) {
+      optimizer->RegisterPass(CreateLICMPass());
+    } else if (0 == strcmp(cur_arg, "--loop-unroll")) {
+      optimizer->RegisterPass(CreateLoopUnrollPass());
+    } else if (0 == strncmp(cur_arg, "--loop-unroll=",
+                            sizeof("--loop-unroll=") - 1)) {
+      const char* budget_arg = cur_arg + sizeof("--loop-unroll=") - 1;
+      char* end = nullptr;
+      const unsigned long budget = strtoul(budget_arg, &end, 10);
+      if (*budget_arg == '\0' || *end != '\0' || budget > UINT32_MAX) {
+        fprintf(stderr, "error: Invalid argument for --loop-unroll: %s\n",
+                budget_arg);
+        return false;
+      }
+      optimizer->RegisterPass(
+          CreateLoopUnrollPass(static_cast<uint32_t>(budget)));
+    } else if (0 == strcmp(cur_arg, "--scalar-replacement")) {
+      optimizer->RegisterPass(CreateScalarReplacementPass());
+    } else if (0 == strcmp(cur_arg, "--merge-identical-functions")) {
+      optimizer->RegisterPass(CreateMergeIdenticalFunctionsPass());
+    } else if (0 == strcmp(cur_arg, "--eliminate-dead-stores")) {
+      optimizer->RegisterPass(CreateDeadStoreElimPass());
+    } else if (0 == strcmp(cur_arg, "--if-conversion")) {
+      optimizer->RegisterPass(CreateIfConversionPass());
+    } else if (0 == strncmp(cur_arg, "--if-conversion=",
+                            sizeof("--if-conversion=") - 1)) {
+      const char* size_arg = cur_arg + sizeof("--if-conversion=") - 1;
+      char* end = nullptr;
+      const unsigned long size = strtoul(size_arg, &end, 10);
+      if (*size_arg == '\0' || *end != '\0' || size > UINT32_MAX) {
+        fprintf(stderr, "error: Invalid argument for --if-conversion: %s\n",
+                size_arg);
+        return false;
+      }
+      optimizer->RegisterPass(
+          CreateIfConversionPass(static_cast<uint32_t>(size)));
+    } else if (0 == strcmp(cur_arg, "--copy-propagation")) {
+      optimizer->RegisterPass(CreateCopyPropagationPass());
+    } else if (0 == strcmp(cur_arg, "--combine-instructions")) {
+      optimizer->RegisterPass(CreateInstCombinePass());
+    } else if (0 == strcmp(cur_arg, "--unify-const")) {
+      optimizer->RegisterPass(CreateUnifyConstantPass());
+    } else if (0 == strcmp(cur_arg, "--flatten-decorations")) {
+      optimizer->RegisterPass(CreateFlattenDecorationPass());
+    } else if (0 == strcmp(cur_arg, "--compact-ids")) {
+      optimizer->RegisterPass(CreateCompactIdsPass());
+    } else if (0 == strcmp(cur_arg, "--cfg-cleanup")) {
+      optimizer->RegisterPass(CreateCFGCleanupPass());
+    } else if (0 == strcmp(cur_arg, "--fixed-point-begin")) {
+      optimizer->BeginFixedPointGroup();
+    } else if (0 == strncmp(cur_arg, "--fixed-point-begin=",
+                            sizeof("--fixed-point-begin=") - 1)) {
+      const char* max_arg = cur_arg + sizeof("--fixed-point-begin=") - 1;
+      char* end = nullptr;
+      const unsigned long max_iterations = strtoul(max_arg, &end, 10);
+      if (*max_arg == '\0' || *end != '\0' || max_iterations > UINT32_MAX) {
+        fprintf(stderr,
+                "error: Invalid argument for --fixed-point-begin: %s\n",
+                max_arg);
+        return false;
+      }
+      optimizer->BeginFixedPointGroup(static_cast<uint32_t>(max_iterations));
+    } else if (0 == strcmp(cur_arg, "--fixed-point-end")) {
+      optimizer->EndFixedPointGroup();
+    } else if (0 == strcmp(cur_arg, "-O")) {
+      optimizer->RegisterPerformancePasses();
+    } else if (0 == strcmp(cur_arg, "-Os")) {
+      if (!RegisterPasses({std::begin(kSizeFlags), std::end(kSizeFlags)},
+                          optimizer)) {
+        return false;
+      }
+    } else {
+      fprintf(
+          stderr,
+          "error: Unknown flag '%s'. Use --help for a list of valid flags\n",
+          cur_arg);
+      return false;
+    }
+  }
 
-  spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
-  spv_validator_options options = spvValidatorOptionsCreate();
+  return true;
+}
 
-  spvtools::Optimizer optimizer(target_env);
-  optimizer.SetMessageConsumer([](spv_message_level_t level, const char* source,
-                                  const spv_position_t& position,
-                                  const char* message) {
-    std::cerr << StringifyMessage(level, source, position, message)
+// Returns a message consumer that writes to standard error. When |prefix| is
+// not empty, each message is preceded by it, so that messages from different
+// modules of a batch can be told apart.
+MessageConsumer MakeConsumer(const std::string& prefix) {
+  return [prefix](spv_message_level_t level, const char* source,
+                  const spv_position_t& position, const char* message) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cerr << prefix << StringifyMessage(level, source, position, message)
               << std::endl;
-  });
-
-  OptStatus status =
-      ParseFlags(argc, argv, &optimizer, &in_file, &out_file, options);
+  };
+}
 
-  if (status.action == OPT_STOP) {
-    return status.code;
+// Validates the module |binary|, reporting errors preceded by |prefix|. The
+// time it takes is reported to |time_report| unless it is null. Returns the
+// result of validation.
+spv_result_t ValidateBinary(const std::vector<uint32_t>& binary,
+                            spv_const_context context,
+                            spv_const_validator_options options,
+                            const std::string& prefix,
+                            std::ostream* time_report) {
+  spv_diagnostic diagnostic = nullptr;
+  spv_const_binary_t binary_struct = {binary.data(), binary.size()};
+  spv_result_t error;
+  {
+    spvutils::ScopedTimer timer(time_report, "Validate");
+    error =
+        spvValidateWithOptions(context, options, &binary_struct, &diagnostic);
+  }
+  if (error) {
+    std::lock_guard<std::mutex> lock(output_mutex);
+    std::cerr << prefix;
+    spvDiagnosticPrint(diagnostic);
   }
+  spvDiagnosticDestroy(diagnostic);
+  return error;
+}
 
-  if (out_file == nullptr) {
-    fprintf(stderr, "error: -o required\n");
-    return 1;
+// Sets up |optimizer| to use |num_threads| threads and the result cache of
+// |settings|, if any.
+void SetUpOptimizer(const OptSettings& settings, uint32_t num_threads,
+                    Optimizer* optimizer) {
+  optimizer->SetNumThreads(num_threads);
+  if (settings.cache_dir) {
+    optimizer->SetResultCache(settings.cache_dir, kResultCacheSize);
   }
+  optimizer->SetIncremental(settings.incremental);
+}
 
+// Validates the module in |in_file|, optimizes it with |optimizer| and writes
+// the result to |out_file|. |context| and |options| are only read, so they may
+// be shared by concurrent calls. Diagnostics are preceded by |prefix|. The
+// cost of validation is reported to |time_report| unless it is null. Returns
+// the exit code for this module.
+int OptimizeFile(const char* in_file, const char* out_file,
+                 spv_const_context context,
+                 spv_const_validator_options options, Optimizer* optimizer,
+                 const std::string& prefix, std::ostream* time_report) {
   std::vector<uint32_t> binary;
   if (!ReadFile<uint32_t>(in_file, "rb", &binary)) {
     return 1;
   }
 
   // Let's do validation first.
-  spv_context context = spvContextCreate(target_env);
-  spv_diagnostic diagnostic = nullptr;
-  spv_const_binary_t binary_struct = {binary.data(), binary.size()};
-  spv_result_t error =
-      spvValidateWithOptions(context, options, &binary_struct, &diagnostic);
-  if (error) {
-    spvDiagnosticPrint(diagnostic);
-    spvDiagnosticDestroy(diagnostic);
-    spvValidatorOptionsDestroy(options);
-    spvContextDestroy(context);
+  if (spv_result_t error =
+          ValidateBinary(binary, context, options, prefix, time_report)) {
     return error;
   }
-  spvDiagnosticDestroy(diagnostic);
-  spvValidatorOptionsDestroy(options);
-  spvContextDestroy(context);
+
+  optimizer->SetMessageConsumer(MakeConsumer(prefix));
 
   // By using the same vector as input and output, we save time in the case
   // that there was no change.
-  bool ok = optimizer.Run(binary.data(), binary.size(), &binary);
+  bool ok = optimizer->Run(binary.data(), binary.size(), &binary);
 
   if (!WriteFile<uint32_t>(out_file, "wb", binary.data(), binary.size())) {
     return 1;
@@ -477,3 +796,270 @@ int main(int argc, const char** argv) {
 
   return ok ? 0 : 1;
 }
+
+// Appends to |in_files| the file names listed in |list_file|, one per line.
+// Blank lines and lines starting with '#' are ignored. Returns false if
+// |list_file| cannot be read.
+bool ReadBatchFile(const char* list_file, std::vector<std::string>* in_files) {
+  std::ifstream input_file(list_file);
+  if (input_file.fail()) {
+    fprintf(stderr, "error: Could not open file '%s'\n", list_file);
+    return false;
+  }
+
+  std::string line;
+  while (std::getline(input_file, line)) {
+    while (!line.empty() && isspace(static_cast<unsigned char>(line.back()))) {
+      line.pop_back();
+    }
+    if (!line.empty() && line[0] != '#') in_files->push_back(line);
+  }
+  return true;
+}
+
+// Returns the name of the file in |out_dir| receiving the optimized version
+// of |in_file|.
+std::string BatchOutputFile(const std::string& out_dir,
+                            const std::string& in_file) {
+  const size_t slash = in_file.find_last_of("/\\");
+  return out_dir + "/" +
+         (slash == std::string::npos ? in_file : in_file.substr(slash + 1));
+}
+
+// Optimizes every input of |settings| into its output directory using
+// |settings.num_jobs| worker threads. The calling thread runs |optimizer|, in
+// which the passes named by |pass_flags| are registered. The other workers
+// register them once in an Optimizer of their own, so that modules optimized
+// at the same time do not share any IR state. Returns the exit code of the
+// whole batch.
+int RunBatch(const OptSettings& settings,
+             const std::vector<std::string>& pass_flags,
+             spv_target_env target_env, spv_const_validator_options options,
+             Optimizer* optimizer) {
+  std::vector<std::string> in_files = settings.in_files;
+  if (settings.batch_file &&
+      !ReadBatchFile(settings.batch_file, &in_files)) {
+    return 1;
+  }
+
+  // Inputs with the same base name would overwrite each other's output.
+  std::vector<std::string> out_files;
+  std::unordered_map<std::string, std::string> out_to_in;
+  for (const auto& in_file : in_files) {
+    if (in_file == "-") {
+      fprintf(stderr, "error: Standard input cannot be part of a batch\n");
+      return 1;
+    }
+    out_files.push_back(BatchOutputFile(settings.out_dir, in_file));
+    auto inserted = out_to_in.insert({out_files.back(), in_file});
+    if (!inserted.second) {
+      fprintf(stderr, "error: '%s' and '%s' would both be written to '%s'\n",
+              inserted.first->second.c_str(), in_file.c_str(),
+              out_files.back().c_str());
+      return 1;
+    }
+  }
+
+  uint32_t num_jobs = settings.num_jobs;
+  if (num_jobs == 0) num_jobs = std::thread::hardware_concurrency();
+  if (num_jobs == 0) num_jobs = 1;
+  if (num_jobs > in_files.size())
+    num_jobs = std::max(1u, static_cast<uint32_t>(in_files.size()));
+
+  // The context only holds the grammar tables, which are never written after
+  // creation, so a single one serves all workers.
+  spv_context context = spvContextCreate(target_env);
+
+  std::atomic<size_t> next_file(0);
+  std::atomic<uint32_t> num_failures(0);
+  auto worker = [&](Optimizer* worker_optimizer) {
+    SetUpOptimizer(settings, 1, worker_optimizer);
+    for (size_t i = next_file++; i < in_files.size(); i = next_file++) {
+      const int code = OptimizeFile(in_files[i].c_str(), out_files[i].c_str(),
+                                    context, options, worker_optimizer,
+                                    in_files[i] + ": ", nullptr);
+      if (code != 0) ++num_failures;
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < num_jobs; ++i) {
+    workers.emplace_back([&]() {
+      // The flags were checked when registering them in |optimizer|.
+      Optimizer worker_optimizer(target_env);
+      RegisterPasses(pass_flags, &worker_optimizer);
+      worker(&worker_optimizer);
+    });
+  }
+  worker(optimizer);
+  for (auto& t : workers) t.join();
+
+  spvContextDestroy(context);
+
+  if (num_failures != 0) {
+    std::cerr << "error: " << num_failures << " of " << in_files.size()
+              << " modules failed to optimize" << std::endl;
+    return 1;
+  }
+  return 0;
+}
+
+// The candidates of --tune without other pass flags besides those of
+// kSizeFlags: other transformations which make modules smaller.
+const char* const kMoreTuneFlags[] = {
+    "--eliminate-dead-stores",
+    "--if-conversion",
+    "--scalar-replacement",
+};
+
+// Maximum number of steps of the search of --tune.
+const uint32_t kTuneMaxSteps = 32;
+
+// Searches for the sequence of the passes named by |pass_flags| minimizing
+// the metric given by |settings| over its inputs, and writes it to its output
+// file. Returns the exit code.
+int RunTuner(const OptSettings& settings,
+             const std::vector<std::string>& pass_flags,
+             spv_target_env target_env, spv_const_validator_options options) {
+  TuneMetric metric;
+  if (0 == strcmp(settings.tune_metric, "words")) {
+    metric = TuneMetric::kWords;
+  } else if (0 == strcmp(settings.tune_metric, "instructions")) {
+    metric = TuneMetric::kInstructions;
+  } else {
+    fprintf(stderr, "error: Invalid argument for --tune: %s\n",
+            settings.tune_metric);
+    return 1;
+  }
+
+  std::vector<PipelineTuner::Flags> candidates;
+  for (size_t i = 0; i < pass_flags.size(); ++i) {
+    if (0 == pass_flags[i].compare(0, sizeof("--fixed-point-") - 1,
+                                   "--fixed-point-")) {
+      fprintf(stderr, "error: %s cannot be used with --tune\n",
+              pass_flags[i].c_str());
+      return 1;
+    }
+    candidates.push_back({pass_flags[i]});
+    if (pass_flags[i] == "--set-spec-const-default-value")
+      candidates.back().push_back(pass_flags[++i]);
+  }
+  if (candidates.empty()) {
+    for (const char* flag : kSizeFlags) {
+      const PipelineTuner::Flags candidate = {flag};
+      if (std::find(candidates.begin(), candidates.end(), candidate) ==
+          candidates.end()) {
+        candidates.push_back(candidate);
+      }
+    }
+    for (const char* flag : kMoreTuneFlags) candidates.push_back({flag});
+  }
+
+  std::vector<std::string> in_files = settings.in_files;
+  if (settings.batch_file &&
+      !ReadBatchFile(settings.batch_file, &in_files)) {
+    return 1;
+  }
+  if (in_files.empty()) {
+    fprintf(stderr, "error: --tune requires input modules\n");
+    return 1;
+  }
+
+  PipelineTuner tuner(target_env, options, metric, RegisterPasses);
+  spv_context context = spvContextCreate(target_env);
+  for (const auto& in_file : in_files) {
+    std::vector<uint32_t> binary;
+    if (in_file == "-" || !ReadFile<uint32_t>(in_file.c_str(), "rb", &binary) ||
+        ValidateBinary(binary, context, options, in_file + ": ", nullptr)) {
+      fprintf(stderr, "error: Cannot tune with '%s'\n", in_file.c_str());
+      spvContextDestroy(context);
+      return 1;
+    }
+    tuner.AddModule(std::move(binary));
+  }
+  spvContextDestroy(context);
+
+  uint32_t num_jobs = settings.num_jobs;
+  if (num_jobs == 0) num_jobs = std::thread::hardware_concurrency();
+  if (num_jobs == 0) num_jobs = 1;
+
+  std::cerr << "initial: " << tuner.InitialCost() << std::endl;
+  PipelineTuner::Flags pipeline;
+  tuner.Tune(candidates, kTuneMaxSteps, num_jobs, &pipeline, &std::cerr);
+  std::string config;
+  for (const auto& flag : pipeline) config += flag + "\n";
+  return WriteFile<char>(settings.out_file, "w", config.data(), config.size())
+             ? 0
+             : 1;
+}
+
+}  // namespace
+
+int main(int argc, const char** argv) {
+  spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
+  spv_validator_options options = spvValidatorOptionsCreate();
+
+  OptSettings settings;
+  std::vector<std::string> pass_flags;
+  OptStatus status = ParseFlags(argc, argv, &settings, &pass_flags, options);
+
+  if (status.action == OPT_STOP) {
+    spvValidatorOptionsDestroy(options);
+    return status.code;
+  }
+
+  // Register the passes before reading any module, so that errors in the pass
+  // flags are reported once, not for every module of a batch.
+  Optimizer optimizer(target_env);
+  if (!RegisterPasses(pass_flags, &optimizer)) {
+    spvValidatorOptionsDestroy(options);
+    return 1;
+  }
+
+  int code = 0;
+  if (settings.incremental && !settings.cache_dir) {
+    fprintf(stderr, "error: --incremental requires --cache-dir\n");
+    code = 1;
+  } else if (settings.tune_metric) {
+    if (settings.out_dir || settings.cache_dir || settings.time_report) {
+      fprintf(stderr,
+              "error: --tune cannot be used with --out-dir, --cache-dir or "
+              "--time-report\n");
+      code = 1;
+    } else {
+      code = RunTuner(settings, pass_flags, target_env, options);
+    }
+  } else if (settings.batch_file || settings.out_dir) {
+    if (!settings.out_dir) {
+      fprintf(stderr, "error: --out-dir required with --batch\n");
+      code = 1;
+    } else if (settings.out_file) {
+      fprintf(stderr, "error: -o cannot be used with --out-dir\n");
+      code = 1;
+    } else if (settings.time_report) {
+      fprintf(stderr, "error: --time-report cannot be used with --out-dir\n");
+      code = 1;
+    } else {
+      code = RunBatch(settings, pass_flags, target_env, options, &optimizer);
+    }
+  } else if (settings.in_files.size() > 1) {
+    fprintf(stderr, "error: More than one input file specified\n");
+    code = 1;
+  } else if (settings.out_file == nullptr) {
+    fprintf(stderr, "error: -o required\n");
+    code = 1;
+  } else {
+    const char* in_file =
+        settings.in_files.empty() ? nullptr : settings.in_files[0].c_str();
+    std::ostream* time_report = settings.time_report ? &std::cerr : nullptr;
+    SetUpOptimizer(settings, settings.num_jobs, &optimizer);
+    optimizer.SetTimeReport(time_report);
+    spv_context context = spvContextCreate(target_env);
+    code = OptimizeFile(in_file, settings.out_file, context, options,
+                        &optimizer, "", time_report);
+    spvContextDestroy(context);
+  }
+
+  spvValidatorOptionsDestroy(options);
+  return code;
+}
@@ -0,0 +1,194 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "tuner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace {
+
+// The total of a trial that failed on some module.
+const uint64_t kFailed = UINT64_MAX;
+// The index of the second candidate of a trial of a single candidate.
+const size_t kNone = SIZE_MAX;
+
+// A sequence of one or two candidates tried by a step, and its total.
+struct Trial {
+  uint64_t cost;
+  size_t first;
+  size_t second;
+};
+
+// Returns the sum of the |count| costs of |costs| starting at |begin|, or
+// kFailed if one of them is kFailed.
+uint64_t Sum(const std::vector<uint64_t>& costs, size_t begin, size_t count) {
+  uint64_t sum = 0;
+  for (size_t i = begin; i < begin + count; ++i) {
+    if (costs[i] == kFailed) return kFailed;
+    sum += costs[i];
+  }
+  return sum;
+}
+
+// Calls |work| with each index from 0 to |count| excluded, on up to
+// |num_threads| threads, each taking the next index not yet taken.
+void ParallelFor(size_t count, uint32_t num_threads,
+                 const std::function<void(size_t)>& work) {
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) work(i);
+  };
+  const size_t num_workers = std::min<size_t>(num_threads, count);
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < num_workers; ++i) workers.emplace_back(worker);
+  worker();
+  for (auto& t : workers) t.join();
+}
+
+}  // namespace
+
+PipelineTuner::PipelineTuner(spv_target_env env,
+                             spv_const_validator_options options,
+                             TuneMetric metric,
+                             RegisterFunction register_passes)
+    : env_(env),
+      options_(options),
+      metric_(metric),
+      register_passes_(std::move(register_passes)),
+      context_(spvContextCreate(env)) {}
+
+PipelineTuner::~PipelineTuner() { spvContextDestroy(context_); }
+
+uint64_t PipelineTuner::InitialCost() const {
+  uint64_t cost = 0;
+  for (const auto& binary : modules_) cost += Cost(binary);
+  return cost;
+}
+
+uint64_t PipelineTuner::Tune(const std::vector<Flags>& candidates,
+                             uint32_t max_steps, uint32_t num_threads,
+                             Flags* pipeline, std::ostream* log) const {
+  const size_t n = candidates.size();
+  const size_t m = modules_.size();
+  std::vector<std::vector<uint32_t>> snapshots = modules_;
+  uint64_t cost = InitialCost();
+  pipeline->clear();
+  for (uint32_t step = 0; step < max_steps; ++step) {
+    // Run every candidate on every snapshot, keeping the results.
+    std::vector<std::vector<uint32_t>> singles(n * m);
+    std::vector<uint64_t> single_costs(n * m, kFailed);
+    ParallelFor(n * m, num_threads, [&](size_t i) {
+      if (Optimize(candidates[i / m], snapshots[i % m], &singles[i]))
+        single_costs[i] = Cost(singles[i]);
+    });
+    std::vector<Trial> trials;
+    // The candidates that succeed on every snapshot and change one of them.
+    // The others are not worth trying before another candidate.
+    std::vector<size_t> changing;
+    for (size_t c = 0; c < n; ++c) {
+      trials.push_back({Sum(single_costs, c * m, m), c, kNone});
+      if (trials.back().cost == kFailed) continue;
+      for (size_t k = 0; k < m; ++k) {
+        if (singles[c * m + k] != snapshots[k]) {
+          changing.push_back(c);
+          break;
+        }
+      }
+    }
+
+    // Run every candidate after each of those, keeping only the costs.
+    std::vector<uint64_t> pair_costs(changing.size() * n * m, kFailed);
+    ParallelFor(pair_costs.size(), num_threads, [&](size_t i) {
+      const size_t first = changing[i / (n * m)];
+      std::vector<uint32_t> result;
+      if (Optimize(candidates[i / m % n], singles[first * m + i % m],
+                   &result))
+        pair_costs[i] = Cost(result);
+    });
+    for (size_t i = 0; i < changing.size(); ++i)
+      for (size_t second = 0; second < n; ++second)
+        trials.push_back(
+            {Sum(pair_costs, (i * n + second) * m, m), changing[i], second});
+
+    // Take the best trial whose results are valid. The sort is stable so
+    // that single candidates come first on ties.
+    std::stable_sort(trials.begin(), trials.end(),
+                     [](const Trial& a, const Trial& b) {
+                       return a.cost < b.cost;
+                     });
+    bool improved = false;
+    for (const Trial& trial : trials) {
+      if (trial.cost >= cost) break;
+      std::vector<std::vector<uint32_t>> results(m);
+      std::atomic<bool> valid(true);
+      ParallelFor(m, num_threads, [&](size_t k) {
+        results[k] = singles[trial.first * m + k];
+        if (trial.second != kNone)
+          Optimize(candidates[trial.second], singles[trial.first * m + k],
+                   &results[k]);
+        if (!Validate(results[k])) valid = false;
+      });
+      if (!valid) continue;
+
+      snapshots = std::move(results);
+      cost = trial.cost;
+      Flags flags = candidates[trial.first];
+      if (trial.second != kNone)
+        flags.insert(flags.end(), candidates[trial.second].begin(),
+                     candidates[trial.second].end());
+      pipeline->insert(pipeline->end(), flags.begin(), flags.end());
+      if (log) {
+        *log << "step " << step + 1 << ":";
+        for (const auto& flag : flags) *log << " " << flag;
+        *log << " -> " << cost << std::endl;
+      }
+      improved = true;
+      break;
+    }
+    if (!improved) break;
+  }
+  return cost;
+}
+
+uint64_t PipelineTuner::Cost(const std::vector<uint32_t>& binary) const {
+  if (metric_ == TuneMetric::kWords) return binary.size();
+  // Instructions follow the header of 5 words, and start with their word
+  // count in the high half-word.
+  uint64_t count = 0;
+  for (size_t i = 5; i < binary.size(); ++count) {
+    const uint32_t word_count = binary[i] >> 16;
+    if (word_count == 0) break;
+    i += word_count;
+  }
+  return count;
+}
+
+bool PipelineTuner::Optimize(const Flags& flags,
+                             const std::vector<uint32_t>& binary,
+                             std::vector<uint32_t>* result) const {
+  spvtools::Optimizer optimizer(env_);
+  if (!register_passes_(flags, &optimizer)) return false;
+  return optimizer.Run(binary.data(), binary.size(), result);
+}
+
+bool PipelineTuner::Validate(const std::vector<uint32_t>& binary) const {
+  spv_const_binary_t binary_struct = {binary.data(), binary.size()};
+  spv_diagnostic diagnostic = nullptr;
+  const spv_result_t error =
+      spvValidateWithOptions(context_, options_, &binary_struct, &diagnostic);
+  spvDiagnosticDestroy(diagnostic);
+  return error == SPV_SUCCESS;
+}
@@ -0,0 +1,101 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_TOOLS_OPT_TUNER_H_
+#define LIBSPIRV_TOOLS_OPT_TUNER_H_
+
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "spirv-tools/libspirv.h"
+#include "spirv-tools/optimizer.hpp"
+
+// What PipelineTuner minimizes, summed over the modules of the corpus.
+enum class TuneMetric {
+  kWords,         // Number of words of the optimized modules.
+  kInstructions,  // Number of instructions of the optimized modules.
+};
+
+// Searches for a sequence of passes minimizing a metric of the modules of a
+// corpus once optimized by it.
+//
+// The sequence grows by steps. A step tries every candidate and every pair
+// of candidates on the modules optimized by the sequence found so far, and
+// appends the one giving the lowest total, preferring a single candidate
+// on ties. A candidate may thus be repeated, and pairs find passes that only
+// pay off once another one ran after them. The modules after each step are
+// kept as snapshots, so that every candidate of the next step runs its own
+// passes alone, on the same input. Candidates that fail on a module, or
+// whose result fails validation, are not chosen. The search stops when no
+// candidate lowers the total.
+class PipelineTuner {
+ public:
+  // The flags of one candidate, as accepted by spirv-opt.
+  using Flags = std::vector<std::string>;
+  // Registers the passes named by flags with an optimizer. Returns false if
+  // a flag is not recognized. Must be callable from several threads at once.
+  using RegisterFunction =
+      std::function<bool(const Flags&, spvtools::Optimizer*)>;
+
+  // Optimizes modules for |env| with passes registered by |register_passes|,
+  // and validates the results with |options|.
+  PipelineTuner(spv_target_env env, spv_const_validator_options options,
+                TuneMetric metric, RegisterFunction register_passes);
+  ~PipelineTuner();
+
+  PipelineTuner(const PipelineTuner&) = delete;
+  PipelineTuner& operator=(const PipelineTuner&) = delete;
+
+  // Adds the valid module |binary| to the corpus.
+  void AddModule(std::vector<uint32_t> binary) {
+    modules_.push_back(std::move(binary));
+  }
+
+  // Returns the total of the metric over the corpus before optimization.
+  uint64_t InitialCost() const;
+
+  // Searches for a sequence of |candidates| for at most |max_steps| steps,
+  // running up to |num_threads| optimizations at once, and sets |pipeline|
+  // to the flags of the sequence found. Reports the total after each step
+  // to |log| unless it is null. Returns the total for |pipeline|.
+  uint64_t Tune(const std::vector<Flags>& candidates, uint32_t max_steps,
+                uint32_t num_threads, Flags* pipeline,
+                std::ostream* log) const;
+
+ private:
+  // Returns the metric of the module |binary|.
+  uint64_t Cost(const std::vector<uint32_t>& binary) const;
+
+  // Optimizes |binary| into |result| with the passes named by |flags|.
+  // Returns false on failure.
+  bool Optimize(const Flags& flags, const std::vector<uint32_t>& binary,
+                std::vector<uint32_t>* result) const;
+
+  // Returns true if the module |binary| is valid.
+  bool Validate(const std::vector<uint32_t>& binary) const;
+
+  const spv_target_env env_;
+  const spv_const_validator_options options_;
+  const TuneMetric metric_;
+  const RegisterFunction register_passes_;
+  // The context used for validation, which is only read.
+  spv_context context_;
+  // The modules of the corpus.
+  std::vector<std::vector<uint32_t>> modules_;
+};
+
+#endif  // LIBSPIRV_TOOLS_OPT_TUNER_H_
@@ -0,0 +1,38 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "module_split.h"
+
+#include "spirv/1.2/spirv.h"
+
+void SplitModules(size_t file_index, const std::vector<uint32_t>& words,
+                  std::vector<ModuleSlice>* slices) {
+  const size_t kHeaderWords = 5;
+  size_t start = 0;
+  if (words.size() > kHeaderWords && words[0] == SpvMagicNumber) {
+    size_t i = kHeaderWords;
+    while (i < words.size()) {
+      if (words[i] == SpvMagicNumber) {
+        slices->push_back({file_index, start, i - start});
+        start = i;
+        i += kHeaderWords;
+        continue;
+      }
+      const uint32_t word_count = words[i] >> SpvWordCountShift;
+      if (word_count == 0) break;
+      i += word_count;
+    }
+  }
+  slices->push_back({file_index, start, words.size() - start});
+}
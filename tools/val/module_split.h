@@ -0,0 +1,37 @@
+// Copyright (c) 2017 Google Inc.
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef LIBSPIRV_TOOLS_VAL_MODULE_SPLIT_H_
+#define LIBSPIRV_TOOLS_VAL_MODULE_SPLIT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A module to validate, as a slice of the words of an input file.
+struct ModuleSlice {
+  size_t file_index;  // Index of the file in the list of inputs.
+  size_t offset;      // Offset of the module's first word in the file.
+  size_t size;        // Number of words in the module.
+};
+
+// Appends to |slices| the modules held in |words|, the contents of the
+// |file_index|th input. Modules stored one after the other are told apart by
+// the magic number found at an instruction boundary. Words that cannot be
+// walked as instructions stay with the module they follow, so that the
+// validator reports them.
+void SplitModules(size_t file_index, const std::vector<uint32_t>& words,
+                  std::vector<ModuleSlice>* slices);
+
+#endif  // LIBSPIRV_TOOLS_VAL_MODULE_SPLIT_H_
@@ -12,26 +12,51 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cctype>
+#include <chrono>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(SPIRV_WINDOWS)
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
 #include "source/spirv_target_env.h"
 #include "source/spirv_validator_options.h"
 #include "spirv-tools/libspirv.hpp"
+#include "spirv/1.2/spirv.h"
 #include "tools/io.h"
+#include "tools/val/module_split.h"
+#include "util/timer.h"
 
 void print_usage(char* argv0) {
   printf(
       R"(%s - Validate a SPIR-V binary file.
 
-USAGE: %s [options] [<filename>]
+USAGE: %s [options] [<filename>...]
 
 The SPIR-V binary is read from <filename>. If no file is specified,
 or if the filename is "-", then the binary is read from standard input.
 
+When more than one module is given, the modules are validated
+concurrently and a result line is printed for each of them, followed
+by a summary. A <filename> naming a directory stands for all the
+files with the .spv extension in that directory. A file holding
+several modules one after the other is split into its modules.
+
 NOTE: The validator is a work in progress.
 
 Options:
@@ -48,14 +73,210 @@ Options:
                                    different type with compatible layout and
                                    members.
   --version                        Display validator version information.
+  --list <file>                    Also validate the modules named in <file>,
+                                   one file name per line.
+  -j <N>                           Use <N> worker threads when validating
+                                   many modules. Defaults to the number of
+                                   hardware threads.
+  --time-report                    Print the wall time of validation to
+                                   standard error, with the number and size of
+                                   its heap allocations in a build configured
+                                   with SPIRV_COUNT_ALLOCATIONS=ON. Only for a
+                                   single module.
   --target-env                     {vulkan1.0|spv1.0|spv1.1|spv1.2}
                                    Use Vulkan1.0/SPIR-V1.0/SPIR-V1.1/SPIR-V1.2 validation rules.
 )",
       argv0, argv0);
 }
 
+namespace {
+
+// The input files of a corpus and the modules they hold.
+struct Corpus {
+  std::vector<std::string> files;
+  std::vector<std::vector<uint32_t>> contents;
+  std::vector<bool> read_ok;
+  std::vector<ModuleSlice> slices;
+};
+
+// Adds |file| to |corpus|, with its |contents| if it could be read as told
+// by |read_ok|.
+void AddToCorpus(const std::string& file, bool read_ok,
+                 std::vector<uint32_t>&& contents, Corpus* corpus) {
+  const size_t file_index = corpus->files.size();
+  corpus->files.push_back(file);
+  corpus->contents.push_back(std::move(contents));
+  corpus->read_ok.push_back(read_ok);
+  if (read_ok) {
+    SplitModules(file_index, corpus->contents.back(), &corpus->slices);
+  }
+}
+
+// The outcome of validating one module.
+struct ValidationResult {
+  spv_result_t status;
+  std::string message;
+};
+
+// Returns true if |path| names a directory.
+bool IsDirectory(const std::string& path) {
+#if defined(SPIRV_WINDOWS)
+  const DWORD attributes = GetFileAttributesA(path.c_str());
+  return attributes != INVALID_FILE_ATTRIBUTES &&
+         (attributes & FILE_ATTRIBUTE_DIRECTORY);
+#else
+  struct stat info;
+  return stat(path.c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+#endif
+}
+
+// Appends to |files| the files of directory |dir| with the .spv extension,
+// in lexicographical order. Subdirectories are not visited. Returns false if
+// |dir| cannot be read.
+bool ListSpvFiles(const std::string& dir, std::vector<std::string>* files) {
+  std::vector<std::string> names;
+#if defined(SPIRV_WINDOWS)
+  WIN32_FIND_DATAA entry;
+  HANDLE handle = FindFirstFileA((dir + "\\*.spv").c_str(), &entry);
+  if (handle == INVALID_HANDLE_VALUE) return false;
+  do {
+    if (!(entry.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY))
+      names.push_back(entry.cFileName);
+  } while (FindNextFileA(handle, &entry));
+  FindClose(handle);
+#else
+  DIR* handle = opendir(dir.c_str());
+  if (!handle) return false;
+  while (const struct dirent* entry = readdir(handle)) {
+    const std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(name.size() - 4, 4, ".spv") == 0 &&
+        !IsDirectory(dir + "/" + name))
+      names.push_back(name);
+  }
+  closedir(handle);
+#endif
+  std::sort(names.begin(), names.end());
+  for (const auto& name : names) files->push_back(dir + "/" + name);
+  return true;
+}
+
+// Appends to |files| the file names listed in |list_file|, one per line.
+// Blank lines and lines starting with '#' are ignored. Returns false if
+// |list_file| cannot be read.
+bool ReadListFile(const char* list_file, std::vector<std::string>* files) {
+  std::ifstream input(list_file);
+  if (input.fail()) return false;
+  std::string line;
+  while (std::getline(input, line)) {
+    while (!line.empty() && isspace(static_cast<unsigned char>(line.back())))
+      line.pop_back();
+    if (!line.empty() && line[0] != '#') files->push_back(line);
+  }
+  return true;
+}
+
+// Returns the message for the validation |diagnostic|, in the same form as
+// the one printed when validating a single module.
+std::string DiagnosticMessage(spv_diagnostic diagnostic) {
+  if (!diagnostic) return "";
+  return std::to_string(diagnostic->position.index) + ": " +
+         diagnostic->error;
+}
+
+// Validates all the modules of |corpus| with |num_jobs| worker threads, then
+// prints one result line per module and a summary. The modules share the
+// same context and |options|. Returns the exit code of the tool.
+int ValidateCorpus(const Corpus& corpus, spv_target_env target_env,
+                   spv_const_validator_options options, uint32_t num_jobs) {
+  const auto start_time = std::chrono::steady_clock::now();
+
+  const std::vector<std::string>& files = corpus.files;
+  const std::vector<std::vector<uint32_t>>& contents = corpus.contents;
+  const std::vector<bool>& read_ok = corpus.read_ok;
+  const std::vector<ModuleSlice>& slices = corpus.slices;
+
+  // The context only holds the grammar tables, which validation never
+  // writes, so one context serves all the workers.
+  spv_context context = spvContextCreate(target_env);
+
+  std::vector<ValidationResult> results(slices.size());
+  std::atomic<size_t> next_slice(0);
+  auto worker = [&]() {
+    for (size_t i = next_slice++; i < slices.size(); i = next_slice++) {
+      const ModuleSlice& slice = slices[i];
+      spv_const_binary_t binary = {
+          contents[slice.file_index].data() + slice.offset, slice.size};
+      spv_diagnostic diagnostic = nullptr;
+      results[i].status =
+          spvValidateWithOptions(context, options, &binary, &diagnostic);
+      results[i].message = DiagnosticMessage(diagnostic);
+      spvDiagnosticDestroy(diagnostic);
+    }
+  };
+
+  if (num_jobs == 0) num_jobs = std::thread::hardware_concurrency();
+  num_jobs = static_cast<uint32_t>(
+      std::max<size_t>(1, std::min<size_t>(num_jobs, slices.size())));
+  std::vector<std::thread> workers;
+  for (uint32_t i = 1; i < num_jobs; ++i) workers.emplace_back(worker);
+  worker();
+  for (auto& t : workers) t.join();
+
+  spvContextDestroy(context);
+
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start_time);
+
+  // Report in input order, so that the output does not depend on the
+  // scheduling of the workers.
+  size_t num_unread = 0;
+  size_t num_failed = 0;
+  size_t num_words = 0;
+  size_t slice_index = 0;
+  for (size_t i = 0; i < files.size(); ++i) {
+    if (!read_ok[i]) {
+      ++num_unread;
+      continue;
+    }
+    size_t module_number = 0;
+    for (; slice_index < slices.size() && slices[slice_index].file_index == i;
+         ++slice_index, ++module_number) {
+      const ModuleSlice& slice = slices[slice_index];
+      const ValidationResult& result = results[slice_index];
+      num_words += slice.size;
+      std::string name = files[i];
+      if (module_number != 0 ||
+          (slice_index + 1 < slices.size() &&
+           slices[slice_index + 1].file_index == i)) {
+        name += "[" + std::to_string(module_number) + "]";
+      }
+      if (result.status == SPV_SUCCESS) {
+        std::cout << name << ": ok" << std::endl;
+      } else {
+        ++num_failed;
+        std::cout << name << ": error: " << result.message << std::endl;
+      }
+    }
+  }
+
+  std::cout << slices.size() << " modules (" << num_words << " words) in "
+            << files.size() << " files validated in " << elapsed.count()
+            << " ms with " << num_jobs << " threads: "
+            << slices.size() - num_failed << " passed, " << num_failed
+            << " failed";
+  if (num_unread) std::cout << ", " << num_unread << " files unreadable";
+  std::cout << std::endl;
+
+  return num_failed == 0 && num_unread == 0 ? 0 : 1;
+}
+
+}  // anonymous namespace
+
 int main(int argc, char** argv) {
-  const char* inFile = nullptr;
+  std::vector<std::string> inFiles;
+  std::vector<const char*> listFiles;
+  uint32_t num_jobs = 0;
+  bool time_report = false;
   spv_target_env target_env = SPV_ENV_UNIVERSAL_1_2;
   spvtools::ValidatorOptions options;
   bool continue_processing = true;
@@ -114,28 +335,35 @@ int main(int argc, char** argv) {
         }
       } else if (0 == strcmp(cur_arg, "--relax-struct-store")) {
         options.SetRelaxStructStore(true);
-      } else if (0 == cur_arg[1]) {
-        // Setting a filename of "-" to indicate stdin.
-        if (!inFile) {
-          inFile = cur_arg;
+      } else if (0 == strcmp(cur_arg, "--time-report")) {
+        time_report = true;
+      } else if (0 == strcmp(cur_arg, "--list")) {
+        if (argi + 1 < argc) {
+          listFiles.push_back(argv[++argi]);
         } else {
-          fprintf(stderr, "error: More than one input file specified\n");
+          fprintf(stderr, "error: Missing argument to --list\n");
           continue_processing = false;
           return_code = 1;
         }
+      } else if (0 == strcmp(cur_arg, "-j")) {
+        const int jobs = argi + 1 < argc ? atoi(argv[++argi]) : 0;
+        if (jobs > 0) {
+          num_jobs = static_cast<uint32_t>(jobs);
+        } else {
+          fprintf(stderr, "error: Expected a positive number after -j\n");
+          continue_processing = false;
+          return_code = 1;
+        }
+      } else if (0 == cur_arg[1]) {
+        // Setting a filename of "-" to indicate stdin.
+        inFiles.push_back(cur_arg);
       } else {
         print_usage(argv[0]);
         continue_processing = false;
         return_code = 1;
       }
     } else {
-      if (!inFile) {
-        inFile = cur_arg;
-      } else {
-        fprintf(stderr, "error: More than one input file specified\n");
-        continue_processing = false;
-        return_code = 1;
-      }
+      inFiles.push_back(cur_arg);
     }
   }
 
@@ -144,8 +372,61 @@ int main(int argc, char** argv) {
     return return_code;
   }
 
-  std::vector<uint32_t> contents;
-  if (!ReadFile<uint32_t>(inFile, "rb", &contents)) return 1;
+  // Validate a corpus of modules when more than one may be given.
+  const bool several_files = inFiles.size() > 1 || !listFiles.empty() ||
+                             (inFiles.size() == 1 && IsDirectory(inFiles[0]));
+  if (several_files) {
+    if (time_report) {
+      fprintf(stderr,
+              "error: --time-report cannot be used with several modules\n");
+      return 1;
+    }
+    std::vector<std::string> files;
+    for (const auto& file : inFiles) {
+      if (file == "-") {
+        fprintf(stderr,
+                "error: Standard input cannot be read with other modules\n");
+        return 1;
+      }
+      if (!IsDirectory(file)) {
+        files.push_back(file);
+      } else if (!ListSpvFiles(file, &files)) {
+        fprintf(stderr, "error: Could not read directory '%s'\n",
+                file.c_str());
+        return 1;
+      }
+    }
+    for (const char* list_file : listFiles) {
+      if (!ReadListFile(list_file, &files)) {
+        fprintf(stderr, "error: Could not open file '%s'\n", list_file);
+        return 1;
+      }
+    }
+    Corpus corpus;
+    for (const auto& file : files) {
+      std::vector<uint32_t> contents;
+      const bool read_ok = ReadFile<uint32_t>(file.c_str(), "rb", &contents);
+      AddToCorpus(file, read_ok, std::move(contents), &corpus);
+    }
+    return ValidateCorpus(corpus, target_env, options, num_jobs);
+  }
+
+  const char* inFile = inFiles.empty() ? nullptr : inFiles[0].c_str();
+  std::vector<uint32_t> file_contents;
+  if (!ReadFile<uint32_t>(inFile, "rb", &file_contents)) return 1;
+
+  // A single file may still hold several modules one after the other.
+  Corpus corpus;
+  AddToCorpus(inFile ? inFile : "-", true, std::move(file_contents), &corpus);
+  if (corpus.slices.size() > 1) {
+    if (time_report) {
+      fprintf(stderr,
+              "error: --time-report cannot be used with several modules\n");
+      return 1;
+    }
+    return ValidateCorpus(corpus, target_env, options, num_jobs);
+  }
+  const std::vector<uint32_t>& contents = corpus.contents[0];
 
   spvtools::SpirvTools tools(target_env);
   tools.SetMessageConsumer([](spv_message_level_t level, const char*,
@@ -170,7 +451,12 @@ int main(int argc, char** argv) {
     }
   });
 
-  bool succeed = tools.Validate(contents.data(), contents.size(), options);
+  bool succeed;
+  {
+    spvutils::ScopedTimer timer(time_report ? &std::cerr : nullptr,
+                                "Validate");
+    succeed = tools.Validate(contents.data(), contents.size(), options);
+  }
 
   return !succeed;
 }